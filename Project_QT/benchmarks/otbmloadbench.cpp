@@ -0,0 +1,184 @@
+// Times walking the node tree of an OTBM map with the Qt OTBMNodeReader and with the wx
+// editor's DiskNodeFileReadHandle/BinaryNode, on the same file.
+//
+//     otbmloadbench <map.otbm> [runs]
+//
+// Both walks visit every node and decode the same fields (tile area base positions, tile
+// offsets and item ids), so the node counts and checksums printed for them have to match.
+// The first run of each reader also warms the OS file cache; the best and median of the
+// remaining runs are reported.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/utility.hpp> // boost::noncopyable, normally pulled in by the wx editor's main.h
+#include "filehandle.h"
+#include "otbmnodereader.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+    enum MapNodeType : quint8 {
+        TileArea = 4,
+        Tile = 5,
+        Item = 6,
+        HouseTile = 14
+    };
+
+    struct WalkStats {
+        quint64 nodes = 0;
+        quint64 tiles = 0;
+        quint64 items = 0;
+        quint64 checksum = 0;
+
+        bool operator==(const WalkStats& other) const {
+            return nodes == other.nodes && tiles == other.tiles && items == other.items && checksum == other.checksum;
+        }
+    };
+
+    // Decodes the leading fields of one node, N is OTBMNode or BinaryNode
+    template <typename N>
+    void decode(N& node, quint8 type, WalkStats& stats) {
+        ++stats.nodes;
+        switch (type) {
+            case TileArea: {
+                uint16_t x = 0, y = 0;
+                uint8_t z = 0;
+                node.getU16(x);
+                node.getU16(y);
+                node.getU8(z);
+                stats.checksum += x * 31u + y * 17u + z;
+                break;
+            }
+            case Tile:
+            case HouseTile: {
+                uint8_t x = 0, y = 0;
+                node.getU8(x);
+                node.getU8(y);
+                ++stats.tiles;
+                stats.checksum += x * 7u + y;
+                break;
+            }
+            case Item: {
+                uint16_t id = 0;
+                node.getU16(id);
+                ++stats.items;
+                stats.checksum += id;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void walkQt(OTBMNodeReader& reader, OTBMNode& parent, WalkStats& stats) {
+        OTBMNode child;
+        for (bool ok = reader.firstChild(parent, child); ok; ok = reader.nextChild(parent, child)) {
+            decode(child, child.type(), stats);
+            walkQt(reader, child, stats);
+        }
+    }
+
+    bool loadQt(const QString& filename, WalkStats& stats) {
+        OTBMNodeReader reader;
+        OTBMNode root;
+        if (!reader.open(filename, "OTBM") || !reader.readRoot(root)) {
+            return false;
+        }
+        decode(root, root.type(), stats);
+        walkQt(reader, root, stats);
+        return !reader.hasError();
+    }
+
+    void walkWx(BinaryNode* parent, WalkStats& stats) {
+        for (BinaryNode* child = parent->getChild(); child != nullptr; child = child->advance()) {
+            uint8_t type = 0;
+            child->getU8(type);
+            decode(*child, type, stats);
+            walkWx(child, stats);
+        }
+    }
+
+    bool loadWx(const QString& filename, WalkStats& stats) {
+        DiskNodeFileReadHandle file(QFile::encodeName(filename).toStdString(), std::vector<std::string>(1, "OTBM"));
+        if (!file.isOk()) {
+            return false;
+        }
+        BinaryNode* root = file.getRootNode();
+        if (!root) {
+            return false;
+        }
+        uint8_t type = 0;
+        root->getU8(type);
+        decode(*root, type, stats);
+        walkWx(root, stats);
+        return file.isOk();
+    }
+
+    struct Timing {
+        QVector<double> runs; // milliseconds
+        WalkStats stats;
+        bool ok = true;
+    };
+
+    template <typename F>
+    Timing measure(int runs, F load) {
+        Timing timing;
+        for (int run = 0; run <= runs; ++run) {
+            WalkStats stats;
+            QElapsedTimer timer;
+            timer.start();
+            timing.ok = load(stats) && timing.ok;
+            const double elapsed = timer.nsecsElapsed() / 1e6;
+            if (run > 0) {
+                timing.runs.append(elapsed);
+            }
+            timing.stats = stats;
+        }
+        std::sort(timing.runs.begin(), timing.runs.end());
+        return timing;
+    }
+
+    void report(QTextStream& out, const char* name, const Timing& timing) {
+        out << name << ": best " << timing.runs.first() << " ms, median " << timing.runs[timing.runs.size() / 2] << " ms"
+            << " (" << timing.stats.nodes << " nodes, " << timing.stats.tiles << " tiles, " << timing.stats.items
+            << " items, checksum " << timing.stats.checksum << ")" << Qt::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList args = app.arguments();
+    if (args.size() < 2) {
+        out << "usage: otbmloadbench <map.otbm> [runs]" << Qt::endl;
+        return 2;
+    }
+    const QString filename = args[1];
+    const int runs = args.size() > 2 ? std::max(1, args[2].toInt()) : 5;
+
+    const Timing qt = measure(runs, [&](WalkStats& stats) { return loadQt(filename, stats); });
+    const Timing wx = measure(runs, [&](WalkStats& stats) { return loadWx(filename, stats); });
+
+    if (!qt.ok || !wx.ok) {
+        out << "Could not read " << filename << (qt.ok ? " with the wx reader" : " with OTBMNodeReader") << Qt::endl;
+        return 1;
+    }
+
+    report(out, "OTBMNodeReader   ", qt);
+    report(out, "wx BinaryNode    ", wx);
+    out << "speedup: " << wx.runs.first() / std::max(qt.runs.first(), 1e-6) << "x" << Qt::endl;
+
+    if (!(qt.stats == wx.stats)) {
+        out << "MISMATCH: the readers decoded different trees" << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
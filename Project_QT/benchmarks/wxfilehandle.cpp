@@ -0,0 +1,20 @@
+// Builds the wx editor's node file reader (wxwidgets/filehandle.cpp) into the benchmark
+// without wxWidgets. That file only needs a few standard headers plus ASSERT and i2s from the
+// editor's precompiled main.h, so they are provided here and main.h is kept out by its guard.
+
+#include <assert.h>
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+#define RME_MAIN_H_
+#define ASSERT assert
+
+inline std::string i2s(int value) {
+    return std::to_string(value);
+}
+
+#include "filehandle.cpp"
@@ -1,275 +1,271 @@
 #include "floodfillbrush.h"
+#include "floodfillcommand.h" // For undo/redo support
 #include "mapview.h"
 #include "map.h"
 #include "tile.h"
 #include "item.h"
+#include "mainwindow.h" // For access to undo stack
+
 #include <QPainter>
+#include <QMessageBox>
 #include <QMouseEvent>
 #include <QDebug>
-#include <QStack>
-#include <QSet>
+#include <QBitArray>
+#include <QHash>
+
+namespace {
 
-FloodFillBrush::FloodFillBrush(QObject *parent) : Brush(parent)
-    , currentItem(nullptr)
-    , currentLayer(Tile::Layer::Ground)
+// Id of the first item of 'layer' on the tile, 0 for none (same rule the old recursive fill used).
+int layerItemId(const Tile* tile, int layer)
 {
-    setCursor(Qt::CrossCursor);
+    if (!tile) return 0;
+    for (const Item& item : tile->getItems()) {
+        if (item.getLayer() == layer) {
+            return item.getId();
+        }
+    }
+    return 0;
 }
 
-FloodFillBrush::~FloodFillBrush()
+// Visited bits kept per 64x64 block of tiles, only for blocks the fill reaches
+class VisitedSet
+{
+public:
+    bool test(int x, int y) const
+    {
+        const auto it = blocks.constFind(blockKey(x, y));
+        return it != blocks.constEnd() && it->testBit(bitIndex(x, y));
+    }
+
+    // Marks x0..x1 (inclusive) of row y
+    void markRow(int y, int x0, int x1)
+    {
+        for (int x = x0; x <= x1; ++x) {
+            QBitArray& bits = blocks[blockKey(x, y)];
+            if (bits.isEmpty()) {
+                bits.resize(BlockSize * BlockSize);
+            }
+            bits.setBit(bitIndex(x, y));
+        }
+    }
+
+private:
+    static const int BlockShift = 6;
+    static const int BlockSize = 1 << BlockShift;
+
+    static quint64 blockKey(int x, int y)
+    {
+        return (quint64(quint32(x) >> BlockShift) << 32) | (quint32(y) >> BlockShift);
+    }
+    static int bitIndex(int x, int y)
+    {
+        return (y & (BlockSize - 1)) * BlockSize + (x & (BlockSize - 1));
+    }
+
+    QHash<quint64, QBitArray> blocks;
+};
+
+} // namespace
+
+FloodFillBrush::FloodFillBrush(QObject* parent)
+    : Brush(parent),
+      currentItem(nullptr),
+      currentLayer(static_cast<int>(Layer::Type::Ground)),
+      maxFillTiles(DefaultMaxFillTiles),
+      previewPos(-1, -1)
 {
+    previewTimer.setSingleShot(true);
+    previewTimer.setInterval(PreviewDelayMilliseconds);
+    connect(&previewTimer, &QTimer::timeout, this, &FloodFillBrush::computePreview);
+
+    setType(Type::FloodFill);
+    setName(tr("Flood Fill"));
+    setIcon(QIcon(":/images/floodfill.png"));
+    setCursor(Qt::CrossCursor);
 }
 
 void FloodFillBrush::mousePressEvent(QMouseEvent* event, MapView* view)
 {
-    if (!view || !view->getMap() || !view->getCurrentItem()) return;
+    if (!view || !view->getMap()) return;
 
     if (event->button() == Qt::LeftButton) {
-        QPoint startPos = view->mapToTile(event->pos());
-        floodFill(view, startPos, *view->getCurrentItem(), view->getCurrentLayer());
+        if (!currentItem) {
+            qDebug() << "FloodFillBrush: No item selected. Cannot fill.";
+            return;
+        }
+        fill(view, view->mapToTile(event->pos()));
+        event->accept();
     }
 }
 
 void FloodFillBrush::mouseMoveEvent(QMouseEvent* event, MapView* view)
 {
-    // Nie potrzebujemy implementacji dla wypełniania
+    if (!view || !view->getMap()) return;
+
+    // Only preview while hovering, a fill is a single click.
+    if (event->buttons() == Qt::NoButton) {
+        updatePreview(view, view->mapToTile(event->pos()));
+    }
 }
 
 void FloodFillBrush::mouseReleaseEvent(QMouseEvent* event, MapView* view)
 {
-    // Nie potrzebujemy implementacji dla wypełniania
+    Q_UNUSED(view);
+    event->accept();
 }
 
-void FloodFillBrush::draw(QPainter* painter, MapView* view)
+FloodFillBrush::FillRegion FloodFillBrush::computeRegion(const Map* map, const QPoint& start, int layer, int maxTiles)
 {
-    // Podgląd pędzla (np. obramowanie kafelka pod kursorem)
-    if (!view) return;
-    QPoint mouse = view->mapFromGlobal(QCursor::pos());
-    QPoint tile = view->mapToTile(mouse);
-    QRect rect(tile.x() * view->tileSize, tile.y() * view->tileSize, view->tileSize, view->tileSize);
-    painter->setPen(QPen(Qt::green, 2, Qt::DashLine));
-    painter->setBrush(Qt::NoBrush);
-    painter->drawRect(rect);
-}
+    FillRegion region;
+    if (!map) return region;
 
-void FloodFillBrush::floodFill(MapView* view, const QPoint& startPos, const Item& fillItem, int fillLayer)
-{
-    Map* map = view->getMap();
-    if (!map) return;
-
-    Tile* startTile = map->getTile(startPos.x(), startPos.y(), fillLayer);
-    if (!startTile) {
-        // Jeśli kafelek startowy nie istnieje, a wypełniamy pustką, tworzymy go
-        if (fillItem.getId() == 0) {
-             map->addItem(startPos.x(), startPos.y(), fillLayer, fillItem);
-             view->update();
-        }
-        return;
+    const int width = map->getSize().width();
+    const int height = map->getSize().height();
+    if (start.x() < 0 || start.x() >= width || start.y() < 0 || start.y() >= height) {
+        return region;
     }
 
-    // Pobierz ID przedmiotu na pozycji startowej (lub 0 jeśli kafelek pusty na tej warstwie)
-    int targetItemId = 0;
-    if (!startTile->getItems().isEmpty()) {
-         // Get the item on the current fill layer
-         for (const Item& item : startTile->getItems()) {
-             // Check if the item is on the correct layer for flood fill
-             if (item.getLayer() == fillLayer) {
-                 targetItemId = item.getId();
-                 break; // Take the first item on the correct layer
-             }
-         }
-    }
+    const int targetId = layerItemId(map->getTile(start.x(), start.y(), layer), layer);
+    auto matches = [&](int x, int y) {
+        return layerItemId(map->getTile(x, y, layer), layer) == targetId && map->isLoaded(QPoint(x, y));
+    };
 
-     // Jeśli przedmiot do wypełnienia jest taki sam jak przedmiot docelowy, nic nie robimy
-     if (fillItem.getId() == targetItemId) {
-         return;
-     }
-
-    QStack<QPoint> stack;
-    stack.push(startPos);
-    QSet<QPoint> visited;
-    visited.insert(startPos);
-
-    while (!stack.isEmpty()) {
-        QPoint currentPos = stack.pop();
-
-        // Sprawdź, czy kafelek na aktualnej pozycji ma ten sam przedmiot docelowy
-        Tile* currentTile = map->getTile(currentPos.x(), currentPos.y(), fillLayer);
-        bool shouldFill = false;
-
-        if (currentTile) {
-            int currentItemId = 0;
-            if (!currentTile->getItems().isEmpty()) {
-                 for (const Item& item : currentTile->getItems()) {
-                    // Check if the item is on the correct layer for flood fill
-                    if (item.getLayer() == fillLayer) {
-                        currentItemId = item.getId();
-                        break;
-                    }
-                 }
-            }
-             shouldFill = (currentItemId == targetItemId);
-        } else {
-            // Jeśli kafelek nie istnieje, a targetItemId to 0 (pustka), to możemy wypełnić
-            shouldFill = (targetItemId == 0);
+    VisitedSet visited;
+    auto isVisited = [&](int x, int y) { return visited.test(x, y); };
+
+    QVector<QPoint> seeds;
+    seeds.append(start);
+
+    while (!seeds.isEmpty()) {
+        const QPoint seed = seeds.takeLast();
+        const int y = seed.y();
+        if (isVisited(seed.x(), y) || !matches(seed.x(), y)) {
+            continue;
         }
 
-        if (shouldFill) {
-             // Usuń istniejące przedmioty na tej warstwie
-            if (currentTile) {
-                map->clearItems(currentPos.x(), currentPos.y(), fillLayer);
-            } else if (fillItem.getId() != 0) {
-                 // Jeśli kafelek nie istniał, a dodajemy przedmiot, stwórz kafelek
-                 map->addItem(currentPos.x(), currentPos.y(), fillLayer, fillItem);
-            }
+        // Grow the span left and right as far as the row allows.
+        int x0 = seed.x();
+        while (x0 > 0 && !isVisited(x0 - 1, y) && matches(x0 - 1, y)) {
+            --x0;
+        }
+        int x1 = seed.x();
+        while (x1 + 1 < width && !isVisited(x1 + 1, y) && matches(x1 + 1, y)) {
+            ++x1;
+        }
 
-             // Dodaj nowy przedmiot, jeśli fillItem nie jest pustką
-            if (fillItem.getId() != 0 && currentTile) {
-                 map->addItem(currentPos.x(), currentPos.y(), fillLayer, fillItem);
-            } else if (fillItem.getId() != 0 && !currentTile) {
-                 // Już dodaliśmy wyżej
-            }
+        visited.markRow(y, x0, x1);
+        region.spans.append({ y, x0, x1 });
+        region.tileCount += x1 - x0 + 1;
+        if (region.tileCount > maxTiles) {
+            region.exceeded = true;
+            return region;
+        }
 
-            // Dodaj sąsiadów do stosu, jeśli są w granicach mapy i nieodwiedzeni
-            QPoint neighbors[] = {
-                QPoint(currentPos.x() + 1, currentPos.y()),
-                QPoint(currentPos.x() - 1, currentPos.y()),
-                QPoint(currentPos.x(), currentPos.y() + 1),
-                QPoint(currentPos.x(), currentPos.y() - 1)
-            };
-
-            for (const QPoint& neighbor : neighbors) {
-                if (neighbor.x() >= 0 && neighbor.x() < map->getWidth() &&
-                    neighbor.y() >= 0 && neighbor.y() < map->getHeight() &&
-                    !visited.contains(neighbor))
-                {
-                    stack.push(neighbor);
-                    visited.insert(neighbor);
+        // Queue one seed per run of fillable tiles directly above and below the span.
+        for (int ny = y - 1; ny <= y + 1; ny += 2) {
+            if (ny < 0 || ny >= height) continue;
+
+            bool inRun = false;
+            for (int x = x0; x <= x1; ++x) {
+                const bool open = !isVisited(x, ny) && matches(x, ny);
+                if (open && !inRun) {
+                    seeds.append(QPoint(x, ny));
                 }
+                inRun = open;
             }
         }
     }
-    view->update();
+    return region;
 }
 
-void FloodFillBrush::drawPreview(QPainter& painter, const QPoint& pos, double zoom)
+void FloodFillBrush::updatePreview(MapView* view, const QPoint& tilePos)
 {
-    if (!currentItem) return;
-
-    // Rysowanie podglądu elementu
-    currentItem->draw(painter, pos, zoom);
+    if (tilePos == previewPos) return;
 
-    // Rysowanie obramowania
-    QRect rect(pos.x(), pos.y(), 32 * zoom, 32 * zoom);
-    painter.setPen(QPen(Qt::green, 2));
-    painter.setBrush(QColor(0, 255, 0, 50));
-    painter.drawRect(rect);
+    // Searching a region can take a while, wait until the cursor stops moving
+    previewPos = tilePos;
+    previewView = view;
+    previewRegion = FillRegion();
+    previewTimer.start();
 }
 
-void FloodFillBrush::start(const QPoint& pos)
+void FloodFillBrush::computePreview()
 {
-    if (!map) {
-        qDebug() << "Brak mapy dla pędzla";
-        return;
-    }
+    if (!previewView || !previewView->getMap()) return;
 
-    startPos = pos;
-    isActive = true;
-    fill(pos);
+    previewRegion = computeRegion(previewView->getMap(), previewPos, currentLayer, maxFillTiles);
+    previewView->viewport()->update();
 }
 
-void FloodFillBrush::move(const QPoint& pos)
+void FloodFillBrush::fill(MapView* view, const QPoint& tilePos)
 {
-    // Wypełnianie nie reaguje na ruch myszy
-}
+    Map* map = view ? view->getMap() : nullptr;
+    if (!map || !currentItem) return;
 
-void FloodFillBrush::end(const QPoint& pos)
-{
-    if (!isActive) {
-        return;
+    const int startId = layerItemId(map->getTile(tilePos.x(), tilePos.y(), currentLayer), currentLayer);
+    if (startId == currentItem->getId()) {
+        return; // Filling with the item that is already there does nothing
     }
 
-    isActive = false;
-}
+    FillRegion region = computeRegion(map, tilePos, currentLayer, maxFillTiles);
+    previewTimer.stop();
+    previewPos = tilePos;
+    previewRegion = region;
 
-void FloodFillBrush::fill(const QPoint& pos)
-{
-    if (!map) {
+    if (region.spans.isEmpty()) {
         return;
     }
-
-    // Pobierz płytkę na pozycji startowej
-    Tile* startTile = map->getTile(pos.x(), pos.y(), currentLayer);
-    if (!startTile) {
-        return;
+    if (region.exceeded) {
+        // The preview turns red for the capped region while the user decides
+        view->viewport()->update();
+        const QMessageBox::StandardButton answer = QMessageBox::question(view, tr("Fill Area"),
+            tr("The area is larger than the fill limit of %1 tiles.\nFill only the first %1 tiles?").arg(maxFillTiles));
+        if (answer != QMessageBox::Yes) {
+            return;
+        }
+        // Only the last span went past the cap, cut it back
+        region.spans.last().x1 -= region.tileCount - maxFillTiles;
+        region.tileCount = maxFillTiles;
     }
 
-    // Pobierz przedmiot do wypełnienia
-    Item targetItem;
-    if (!startTile->getItems(currentLayer).isEmpty()) {
-        targetItem = startTile->getItems(currentLayer).first();
+    FloodFillCommand* command = new FloodFillCommand(map, currentLayer, region.spans, *currentItem);
+    MainWindow* mainWin = qobject_cast<MainWindow*>(view->parentWidget());
+    if (mainWin && mainWin->getUndoStack()) {
+        mainWin->getUndoStack()->push(command); // QUndoStack::push calls redo()
+    } else {
+        command->redo();
+        delete command;
+        qDebug() << "FloodFillBrush: Filled" << region.tileCount << "tiles directly. No Undo support.";
     }
-
-    // Wypełnij obszar
-    QSet<QPoint> visited;
-    fillRecursive(pos.x(), pos.y(), currentLayer, targetItem, visited);
 }
 
-void FloodFillBrush::fillRecursive(int x, int y, int z, const Item& targetItem, QSet<QPoint>& visited)
+void FloodFillBrush::drawPreview(QPainter& painter, const QPoint& pos, double zoom)
 {
-    // Sprawdź granice mapy
-    if (x < 0 || x >= map->getWidth() || y < 0 || y >= map->getHeight()) {
-        return;
-    }
+    Q_UNUSED(pos);
 
-    // Sprawdź czy pozycja była już odwiedzona
-    QPoint pos(x, y);
-    if (visited.contains(pos)) {
-        return;
-    }
-    visited.insert(pos);
-
-    // Pobierz płytkę na aktualnej pozycji
-    Tile* tile = map->getTile(x, y, z);
-    if (!tile) {
-        return;
-    }
-
-    // Sprawdź czy płytka zawiera ten sam przedmiot co płytka startowa
-    bool shouldFill = false;
-    if (tile->getItems(z).isEmpty()) {
-        shouldFill = targetItem.getId() == 0;
-    } else {
-        shouldFill = tile->getItems(z).first().getId() == targetItem.getId();
-    }
-
-    if (shouldFill) {
-        // Usuń istniejące przedmioty
-        for (const Item& item : tile->getItems(z)) {
-            map->removeItem(x, y, z, item);
-        }
-
-        // Dodaj nowy przedmiot
-        if (targetItem.getId() != 0) {
-            map->addItem(x, y, z, targetItem);
-        }
-
-        // Rekurencyjnie wypełnij sąsiednie płytki
-        fillRecursive(x + 1, y, z, targetItem, visited);
-        fillRecursive(x - 1, y, z, targetItem, visited);
-        fillRecursive(x, y + 1, z, targetItem, visited);
-        fillRecursive(x, y - 1, z, targetItem, visited);
+    painter.setOpacity(0.6); // Semi-transparent for preview.
+    if (currentItem) {
+        currentItem->draw(painter, QPoint(0, 0), 1.0);
     }
+    painter.setOpacity(1.0);
+
+    // Green when the hovered region can be filled, red when it is over the cap.
+    const int tileSize = static_cast<int>(MapTileItem::TilePixelSize * zoom);
+    const QColor color = previewRegion.exceeded ? Qt::red : Qt::green;
+    painter.setPen(QPen(color, 2));
+    painter.setBrush(QColor(color.red(), color.green(), color.blue(), 50));
+    painter.drawRect(0, 0, tileSize - 1, tileSize - 1);
+
+    const QString count = previewRegion.exceeded
+        ? QString(">%1").arg(maxFillTiles)
+        : QString::number(previewRegion.tileCount);
+    painter.drawText(QRect(0, 0, tileSize, tileSize), Qt::AlignCenter, count);
 }
 
-bool FloodFillBrush::shouldFill(const QPoint& pos) const
+QIcon FloodFillBrush::getIcon()
 {
-    Map* map = Map::getInstance();
-    if (!map) return false;
-
-    Tile* tile = map->getTile(pos);
-    if (!tile) return false;
-
-    // Sprawdź, czy kafelek jest pusty w danej warstwie
-    return tile->getItems(currentLayer).isEmpty();
-} 
\ No newline at end of file
+    if (icon.isNull()) {
+        icon = QIcon(":/images/floodfill.png");
+    }
+    return icon;
+}
@@ -3,47 +3,83 @@
 
 #include "brush.h"
 #include "item.h"
+#include "floodfillcommand.h" // For FillSpan
 #include <QPoint>
-#include <QStack>
-#include <QSet>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
 
+class MapView;
+class Map;
+
+/**
+ * @brief The FloodFillBrush class fills a contiguous area of equal tiles on the current layer.
+ * The region is found with an iterative scanline fill over a sparse visited bitmap (one
+ * block of bits per 64x64 tiles reached), so it never recurses, never touches a tile twice
+ * and its memory grows with the region rather than with the map. The whole fill is pushed as one FloodFillCommand.
+ */
 class FloodFillBrush : public Brush
 {
     Q_OBJECT
 
 public:
-    explicit FloodFillBrush(QObject *parent = nullptr);
-    ~FloodFillBrush();
+    // Default upper bound of tiles a single fill may change.
+    static const int DefaultMaxFillTiles = 1000000;
+
+    /**
+     * @brief Result of a region search: the spans to fill and whether the cap stopped it early.
+     */
+    struct FillRegion {
+        QVector<FillSpan> spans;
+        int tileCount = 0;
+        bool exceeded = false;
+    };
 
-    // Implementacja metod z klasy Brush
-    void onMousePress(QMouseEvent* event, MapView* view) override;
-    void onMouseMove(QMouseEvent* event, MapView* view) override;
-    void onMouseRelease(QMouseEvent* event, MapView* view) override;
+    explicit FloodFillBrush(QObject* parent = nullptr);
+    virtual ~FloodFillBrush() = default;
+
+    // Override virtual methods from Brush base class
+    void mousePressEvent(QMouseEvent* event, MapView* view) override;
+    void mouseMoveEvent(QMouseEvent* event, MapView* view) override;
+    void mouseReleaseEvent(QMouseEvent* event, MapView* view) override;
     void drawPreview(QPainter& painter, const QPoint& pos, double zoom) override;
 
-    // Ustawianie aktualnego elementu
+    // Item used to fill (set from palette, not owned)
     void setCurrentItem(Item* item) { currentItem = item; }
     Item* getCurrentItem() const { return currentItem; }
 
-    // Ustawianie aktualnej warstwy
-    void setCurrentLayer(Tile::Layer layer) { currentLayer = layer; }
-    Tile::Layer getCurrentLayer() const { return currentLayer; }
+    // Layer the fill operates on
+    void setCurrentLayer(int layer) { currentLayer = layer; }
+    int getCurrentLayer() const { return currentLayer; }
+
+    // Fills bigger than this are previewed in red and only done, capped, once the user agrees
+    void setMaxFillTiles(int maxTiles) { maxFillTiles = qMax(1, maxTiles); }
+    int getMaxFillTiles() const { return maxFillTiles; }
 
-    Type getType() const override { return Type::FloodFill; }
-    QString getName() const override { return tr("Wypełnianie"); }
-    QIcon getIcon() const override;
+    QIcon getIcon() override;
 
-    void start(const QPoint& pos) override;
-    void move(const QPoint& pos) override;
-    void end(const QPoint& pos) override;
+    // Fills the region under 'tilePos' with the current item, as a click does
+    void fill(MapView* view, const QPoint& tilePos);
+
+    // Finds the region reachable from 'start' whose top item on 'layer' has the same id,
+    // stopping once more than 'maxTiles' tiles were found. Areas of the map that are still
+    // loading are a border, nothing may be written there yet.
+    static FillRegion computeRegion(const Map* map, const QPoint& start, int layer, int maxTiles);
 
 private:
-    Item* currentItem;
-    Tile::Layer currentLayer;
-    void floodFill(const QPoint& startPos);
-    bool shouldFill(const QPoint& pos) const;
-    void fill(const QPoint& pos);
-    void fillRecursive(int x, int y, int z, const Item& targetItem, QSet<QPoint>& visited);
+    Item* currentItem;   // Item to fill with (not owned)
+    int currentLayer;
+    int maxFillTiles;
+
+    // Hover preview: region under the cursor, recomputed once the cursor rests on a tile
+    static const int PreviewDelayMilliseconds = 150;
+    QPoint previewPos;
+    FillRegion previewRegion;
+    QTimer previewTimer;
+    QPointer<MapView> previewView;
+
+    void updatePreview(MapView* view, const QPoint& tilePos);
+    void computePreview();
 };
 
-#endif // FLOODFILLBRUSH_H 
\ No newline at end of file
+#endif // FLOODFILLBRUSH_H
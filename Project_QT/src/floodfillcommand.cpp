@@ -0,0 +1,106 @@
+#include "floodfillcommand.h"
+#include "tile.h"
+#include "bordersystem.h"
+
+#include <QBitArray>
+
+FloodFillCommand::FloodFillCommand(Map* map, int layer, const QVector<FillSpan>& spans, const Item& fillItem, QUndoCommand* parent)
+    : MapCommand(parent)
+    , map(map)
+    , layer(layer)
+    , spans(spans)
+    , fillItem(fillItem)
+    , count(0)
+{
+    // Snapshot each tile's whole stack, so undo puts every item back where it was.
+    for (const FillSpan& span : spans) {
+        bounds |= QRect(span.x0, span.y, span.x1 - span.x0 + 1, 1);
+        count += span.x1 - span.x0 + 1;
+    }
+    previousItems.reserve(count);
+
+    if (map) {
+        for (const FillSpan& span : spans) {
+            for (int x = span.x0; x <= span.x1; ++x) {
+                const Tile* tile = map->getTile(x, span.y, layer);
+                previousItems.append(tile ? tile->getItems() : QVector<Item>());
+            }
+        }
+    }
+    setText(QString("Flood Fill %1 tiles with %2").arg(count).arg(fillItem.getId()));
+}
+
+void FloodFillCommand::undo()
+{
+    if (!map) return;
+
+    int index = 0;
+    for (const FillSpan& span : spans) {
+        for (int x = span.x0; x <= span.x1; ++x, ++index) {
+            Tile* tile = map->getTile(x, span.y, layer);
+            if (!tile) continue;
+
+            tile->setItems(previousItems.at(index));
+        }
+    }
+    applyBorders();
+    map->notifyAreaChanged(bounds);
+}
+
+void FloodFillCommand::redo()
+{
+    if (!map) return;
+
+    int index = 0;
+    for (const FillSpan& span : spans) {
+        for (int x = span.x0; x <= span.x1; ++x, ++index) {
+            Tile* tile = map->getTile(x, span.y, layer);
+            if (!tile) continue;
+
+            // Items of the filled layer are replaced, the rest of the stack keeps its order
+            QVector<Item> items;
+            for (const Item& item : previousItems.at(index)) {
+                if (item.getLayer() != layer) {
+                    items.append(item);
+                }
+            }
+            if (fillItem.getId() != 0) {
+                items.append(fillItem);
+            }
+            tile->setItems(items);
+        }
+    }
+    applyBorders();
+    map->notifyAreaChanged(bounds);
+}
+
+// Borders can only change where the filled region meets something else, so only
+// the frontier (filled tiles with an unfilled 4-neighbour) is borderized.
+void FloodFillCommand::applyBorders()
+{
+    BorderSystem* borderSystem = map->getBorderSystem();
+    if (!borderSystem || !borderSystem->isEnabled() || bounds.isEmpty()) return;
+
+    const int width = bounds.width();
+    QBitArray filled(width * bounds.height());
+    for (const FillSpan& span : spans) {
+        for (int x = span.x0; x <= span.x1; ++x) {
+            filled.setBit((span.y - bounds.top()) * width + (x - bounds.left()));
+        }
+    }
+
+    auto isFilled = [&](int x, int y) {
+        return bounds.contains(x, y) && filled.testBit((y - bounds.top()) * width + (x - bounds.left()));
+    };
+
+    QVector<QPoint> frontier;
+    for (const FillSpan& span : spans) {
+        for (int x = span.x0; x <= span.x1; ++x) {
+            if (!isFilled(x - 1, span.y) || !isFilled(x + 1, span.y) ||
+                !isFilled(x, span.y - 1) || !isFilled(x, span.y + 1)) {
+                frontier.append(QPoint(x, span.y));
+            }
+        }
+    }
+    borderSystem->applyBordersToRegion(frontier, layer);
+}
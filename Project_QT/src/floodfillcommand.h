@@ -0,0 +1,46 @@
+#ifndef FLOODFILLCOMMAND_H
+#define FLOODFILLCOMMAND_H
+
+#include "mapcommand.h"
+#include "map.h"
+#include "item.h"
+#include <QRect>
+#include <QVector>
+
+/**
+ * @brief A horizontal run of tiles [x0, x1] on row y, produced by the scanline flood fill.
+ */
+struct FillSpan {
+    int y;
+    int x0;
+    int x1;
+};
+
+/**
+ * @brief Undoable flood fill of one layer.
+ * The whole region is applied as a single command and the map is notified once
+ * through Map::notifyAreaChanged() instead of once per tile.
+ */
+class FloodFillCommand : public MapCommand
+{
+public:
+    FloodFillCommand(Map* map, int layer, const QVector<FillSpan>& spans, const Item& fillItem, QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+    int tileCount() const { return count; }
+
+private:
+    Map* map;
+    int layer;
+    QVector<FillSpan> spans;
+    Item fillItem;
+    QVector<QVector<Item>> previousItems; // Whole item stack per filled tile, in span order
+    QRect bounds;
+    int count;
+
+    void applyBorders();
+};
+
+#endif // FLOODFILLCOMMAND_H
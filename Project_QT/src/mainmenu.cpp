@@ -67,6 +67,7 @@ void MainMenu::createFileMenu()
     // New, Open, Save, Save As
     createAndAddAction(fileMenu, tr("&New Map"), this, SLOT(onNewMap()), QKeySequence("P")); // Hotkey from XML
     createAndAddAction(fileMenu, tr("&Open Map..."), this, SLOT(onOpenMap()), QKeySequence::Open); // Ctrl+O
+    createAndAddAction(fileMenu, tr("Open Map at &Position..."), this, SLOT(onOpenMapAtPosition()));
     createAndAddAction(fileMenu, tr("&Save Map"), this, SLOT(onSaveMap()), QKeySequence::Save); // Ctrl+S
     createAndAddAction(fileMenu, tr("Save Map &As..."), this, SLOT(onSaveMapAs()), QKeySequence("Ctrl+Alt+S")); // Hotkey from XML
     generateMapAction = createAndAddAction(fileMenu, tr("&Generate Map"), this, SLOT(onGenerateMap()), QKeySequence("Ctrl+Shift+G"));
@@ -504,6 +505,7 @@ void MainMenu::updateToolActions(Brush::Type currentToolType)
 
 void MainMenu::onNewMap() { parentWindow->createNewMap(); }
 void MainMenu::onOpenMap() { parentWindow->openMap(); }
+void MainMenu::onOpenMapAtPosition() { parentWindow->openMapAtPosition(); }
 void MainMenu::onOpenRecent() {
     QAction* action = qobject_cast<QAction*>(sender());
     if (action) {
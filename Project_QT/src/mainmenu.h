@@ -52,6 +52,7 @@ private slots:
     // File Menu Slots (from Source/src/main_menubar.cpp)
     void onNewMap();
     void onOpenMap();
+    void onOpenMapAtPosition();
     void onOpenRecent(); // Submenu handler for recent files
     void onSaveMap();
     void onSaveMapAs();
@@ -10,6 +10,8 @@
 #include "bordersystem.h" // For automagic (already included from Map)
 #include "clientversion.h" // For ClientVersion to load item/sprite data
 #include "settingsmanager.h"
+#include "gotopositiondialog.h"
+#include "progressivemaploader.h"
 
 #include <QApplication> // For qApp->quit()
 #include <QFileDialog>  // For file dialogs
@@ -18,6 +20,15 @@
 #include <QDebug>       // For debugging output
 #include <QStatusBar>   // Ensure QLabel and QStatusBar functions correctly
 #include <QSettings> // For saving/loading window state, last paths etc. (later integration)
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
 
 // Dummy implementations for MapCommand (for compilation, will be fully integrated by QUndoStack later)
 // This simplifies immediate compilation but relies on the actual Undo Commands later.
@@ -51,7 +62,8 @@ MainWindow::MainWindow(QWidget *parent) :
     undoStack(new QUndoStack(this)), // Undo stack owned by MainWindow
     currentMap(&Map::getInstance()), // Get singleton instance
     currentLayer(static_cast<int>(Layer::Type::Ground)), // Initial layer set
-    isPasting(false)
+    isPasting(false),
+    progressiveLoader(nullptr)
 {
     // Initialize common managers once (these are singletons but need to be instantiated)
     ItemManager::getInstance();
@@ -350,12 +362,114 @@ void MainWindow::showFindSimilarItemsDialog() { QMessageBox::information(this, t
 void MainWindow::showBorderSystemDialog() { QMessageBox::information(this, tr("Border System Settings"), tr("Border System Dialog is not yet fully implemented.")); }
 
 
+// --- Map I/O on worker threads ---
+namespace {
+    struct LoadedMap {
+        Map* map = nullptr; // Owned by the receiver, lives in the GUI thread
+        bool ok = false;
+        QString error;
+    };
+
+    using CancelFlag = std::shared_ptr<std::atomic_bool>;
+
+    // Reads 'filePath' into a new Map on the global thread pool. The map is moved to the
+    // calling (GUI) thread before it is handed over, or deleted when cancelled; the load stops at
+    // the next tile area once 'cancelled' is raised.
+    QFuture<LoadedMap> startMapLoad(const QString& filePath, const CancelFlag& cancelled)
+    {
+        auto promise = std::make_shared<QPromise<LoadedMap>>();
+        QFuture<LoadedMap> future = promise->future();
+        promise->setProgressRange(0, 100);
+        promise->start();
+
+        QThread* receiverThread = QThread::currentThread();
+        QThreadPool::globalInstance()->start([promise, filePath, cancelled, receiverThread]() {
+            LoadedMap result;
+            auto* map = new Map();
+            QObject::connect(map, &Map::loadProgress, [progress = promise.get()](int value) {
+                progress->setProgressValue(value);
+            });
+            result.ok = map->loadFromFile(filePath, [cancelled]() { return cancelled->load(); });
+            result.error = map->getError();
+            if (*cancelled) {
+                delete map;
+            } else {
+                map->moveToThread(receiverThread);
+                result.map = map;
+            }
+            promise->addResult(result);
+            promise->finish();
+        });
+        return future;
+    }
+
+    // Writes 'map' to 'filePath' on the global thread pool. The map must not change until the
+    // future finished, waitForMapTask() keeps the main window blocked for that long.
+    QFuture<bool> startMapSave(const Map* map, const QString& filePath, const CancelFlag& cancelled)
+    {
+        auto promise = std::make_shared<QPromise<bool>>();
+        QFuture<bool> future = promise->future();
+        promise->setProgressRange(0, 100);
+        promise->start();
+
+        QThreadPool::globalInstance()->start([promise, map, filePath, cancelled]() {
+            const QMetaObject::Connection progress = QObject::connect(map, &Map::saveProgress,
+                [target = promise.get()](int value) { target->setProgressValue(value); });
+            const bool ok = map->saveToFile(filePath, [cancelled]() { return cancelled->load(); });
+            QObject::disconnect(progress);
+            promise->addResult(ok);
+            promise->finish();
+        });
+        return future;
+    }
+
+    // Keeps the event loop running (painting, the Cancel button) behind a window modal progress
+    // dialog until 'future' finished. Cancelling only raises 'cancelled' and still waits for the
+    // task, so the caller always gets its result. Returns false when the user cancelled.
+    template <typename T>
+    bool waitForMapTask(QWidget* parent, const QString& label, const QFuture<T>& future, const CancelFlag& cancelled)
+    {
+        QProgressDialog progress(label, MainWindow::tr("Cancel"), 0, 100, parent);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(300); // Quick saves/loads don't flash a dialog
+        progress.setAutoClose(false);
+        progress.setAutoReset(false);
+
+        QFutureWatcher<T> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, &QFutureWatcherBase::progressValueChanged, &progress, &QProgressDialog::setValue);
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        QObject::connect(&progress, &QProgressDialog::canceled, &progress, [&progress, cancelled]() {
+            *cancelled = true;
+            progress.setLabelText(MainWindow::tr("Cancelling..."));
+            progress.setCancelButton(nullptr);
+            progress.show();
+        });
+        watcher.setFuture(future);
+        if (!future.isFinished()) {
+            loop.exec();
+        }
+        return !*cancelled;
+    }
+
+    // Maps can hold millions of tiles, delete them off the GUI thread
+    void disposeMap(Map* map)
+    {
+        if (!map) {
+            return;
+        }
+        map->moveToThread(nullptr);
+        QThreadPool::globalInstance()->start([map]() { delete map; });
+    }
+}
+
 // --- File Operations ---
 void MainWindow::createNewMap()
 {
     if (currentMap->isModified()) {
         if (!maybeSave()) return; // Ask to save, if cancelled, return.
     }
+    if (progressiveLoader) progressiveLoader->cancel();
     currentMap->clear();
     currentMap->setSize(QSize(100,100)); // Default map size.
     mapView->setMap(currentMap); // Ensure map is refreshed in view.
@@ -371,10 +485,36 @@ bool MainWindow::loadMap(const QString& filePath)
         if (!maybeSave()) return false;
     }
 
-    if (!currentMap->loadFromFile(filePath)) {
-        QMessageBox::critical(this, tr("Error Loading Map"), tr("Could not load map from '%1'.").arg(filePath));
+    // The file is read into a separate Map on a worker thread, the current map stays as it is
+    // (and keeps being painted) until the new one is complete and swapped in.
+    const CancelFlag cancelled = std::make_shared<std::atomic_bool>(false);
+    QFuture<LoadedMap> future = startMapLoad(filePath, cancelled);
+    const bool completed = waitForMapTask(this, tr("Loading %1...").arg(QFileInfo(filePath).fileName()), future, cancelled);
+    const LoadedMap loaded = future.result();
+
+    if (!completed) {
+        disposeMap(loaded.map);
+        statusBar()->showMessage(tr("Loading cancelled"), 2000);
         return false;
     }
+    if (!loaded.ok) {
+        disposeMap(loaded.map);
+        QString message = tr("Could not load map from '%1'.").arg(filePath);
+        if (!loaded.error.isEmpty()) {
+            message += QLatin1Char('\n') + loaded.error;
+        }
+        QMessageBox::critical(this, tr("Error Loading Map"), message);
+        return false;
+    }
+
+    if (progressiveLoader) progressiveLoader->cancel();
+    currentMap->swapContents(*loaded.map);
+    disposeMap(loaded.map); // Now holds the previous map
+    // The commands hold tile snapshots of the previous map
+    undoStack->clear();
+    undoStack->setClean();
+    currentMap->setModified(false);
+
     setCurrentFile(filePath);
     mapView->setMap(currentMap); // Ensure map is refreshed in view.
     updateWindowTitle();
@@ -382,10 +522,108 @@ bool MainWindow::loadMap(const QString& filePath)
     return true;
 }
 
+void MainWindow::openMapAtPosition()
+{
+    if (currentMap->isModified()) {
+        if (!maybeSave()) return;
+    }
+
+    const QString filePath = QFileDialog::getOpenFileName(this, tr("Open Map at Position"),
+                                                          QDir::homePath(), tr("OTBM Maps (*.otbm);;All Files (*)"));
+    if (filePath.isEmpty()) return;
+
+    GotoPositionDialog dialog(this);
+    if (dialog.exec() != QDialog::Accepted) return;
+    loadMapAt(filePath, dialog.getPosition());
+}
+
+bool MainWindow::loadMapAt(const QString& filePath, const QPoint& position)
+{
+    if (currentMap->isModified()) {
+        if (!maybeSave()) return false;
+    }
+
+    if (!progressiveLoader) {
+        progressiveLoader = new ProgressiveMapLoader(currentMap, this);
+        connect(progressiveLoader, &ProgressiveMapLoader::progressChanged, this, [this](int percent) {
+            statusBar()->showMessage(tr("Loading map... %1%").arg(percent));
+        });
+        connect(progressiveLoader, &ProgressiveMapLoader::finished, this, &MainWindow::onProgressiveLoadFinished);
+    }
+
+    // Unlike loadMap() the tiles are read into the live map, from the event loop, so the
+    // previous map goes away first
+    progressiveLoader->cancel();
+    currentMap->clear();
+    undoStack->clear();
+
+    if (!progressiveLoader->open(filePath)) {
+        QMessageBox::critical(this, tr("Error Loading Map"),
+                              tr("Could not load map from '%1'.\n%2").arg(filePath, progressiveLoader->errorString()));
+        return false;
+    }
+
+    setCurrentFile(filePath);
+    mapView->setMap(currentMap);
+    mapView->centerOnTile(position);
+    if (!progressiveLoader->start(mapView->visibleTileRect())) {
+        QMessageBox::critical(this, tr("Error Loading Map"),
+                              tr("Could not load map from '%1'.\n%2").arg(filePath, progressiveLoader->errorString()));
+        currentMap->clear();
+        setCurrentFile(QString());
+        return false;
+    }
+
+    updateWindowTitle();
+    updateStatusBar();
+    return true;
+}
+
+void MainWindow::onProgressiveLoadFinished(bool success)
+{
+    if (!success) {
+        // A map with holes must not be saved over the original file
+        QMessageBox::critical(this, tr("Error Loading Map"),
+                              tr("Could not load map from '%1'.\n%2").arg(currentMapFile, progressiveLoader->errorString()));
+        currentMap->clear();
+        undoStack->clear();
+        setCurrentFile(QString());
+    } else {
+        // Adding the loaded items marked the map as modified, only edits made meanwhile count
+        currentMap->setModified(!undoStack->isClean());
+        statusBar()->showMessage(tr("Map loaded"), 2000);
+    }
+    updateWindowTitle();
+    updateStatusBar();
+}
+
+bool MainWindow::writeMap(const QString& filePath)
+{
+    if (currentMap->hasPendingAreas()) {
+        QMessageBox::information(this, tr("Save Map"), tr("The map is still loading, it can be saved once it has loaded completely."));
+        return false;
+    }
+
+    const CancelFlag cancelled = std::make_shared<std::atomic_bool>(false);
+    QFuture<bool> future = startMapSave(currentMap, filePath, cancelled);
+    const bool completed = waitForMapTask(this, tr("Saving %1...").arg(QFileInfo(filePath).fileName()), future, cancelled);
+
+    if (!completed) {
+        statusBar()->showMessage(tr("Saving cancelled, '%1' was not changed").arg(filePath), 3000);
+        return false;
+    }
+    if (!future.result()) {
+        QMessageBox::critical(this, tr("Error Saving Map"), tr("Could not save map to '%1'.").arg(filePath));
+        return false;
+    }
+    currentMap->setModified(false);
+    return true;
+}
+
 bool MainWindow::saveMap()
 {
     if (currentMap->hasFile()) {
-        return currentMap->saveToFile(currentMapFile);
+        return writeMap(currentMapFile);
     } else {
         return saveMapAs();
     }
@@ -393,7 +631,7 @@ bool MainWindow::saveMap()
 
 bool MainWindow::saveMapAs()
 {
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Map As),
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Map As"),
                                                      QDir::homePath(), tr("OTBM Maps (*.otbm);;All Files (*)"));
     if (fileName.isEmpty()) return false;
     
@@ -402,7 +640,7 @@ bool MainWindow::saveMapAs()
         fileName += ".otbm";
     }
 
-    if (currentMap->saveToFile(fileName)) {
+    if (writeMap(fileName)) {
         setCurrentFile(fileName);
         updateWindowTitle();
         setUnifiedTitleAndToolBarOnMac(true); // Mac specific UI hint
@@ -418,8 +656,20 @@ void MainWindow::redo() { undoStack->redo(); updateStatusBar(); mapView->getScen
 // MapView `copyRequest` / `cutRequest` / `pasteRequest` / `deleteRequest` are connected to these slots.
 void MainWindow::onMapViewCopyRequest(const QRect& selectionRect) { copySelection(); }
 void MainWindow::onMapViewCutRequest(const QRect& selectionRect) { cutSelection(); }
-void MainWindow::onMapViewPasteRequest(const QPoint& targetPos) { pasteSelection(); }
-void MainWindow::onMapViewDeleteRequest(const QRect& selectionRect) { deleteSelection(); }
+void MainWindow::onMapViewPasteRequest(const QPoint& targetPos) {
+    if (!currentMap->isLoaded(targetPos)) {
+        statusBar()->showMessage(tr("This part of the map is still loading."), 2000);
+        return;
+    }
+    pasteSelection();
+}
+void MainWindow::onMapViewDeleteRequest(const QRect& selectionRect) {
+    if (!currentMap->isLoaded(selectionRect)) {
+        statusBar()->showMessage(tr("This part of the map is still loading."), 2000);
+        return;
+    }
+    deleteSelection();
+}
 
 void MainWindow::cutSelection() { copySelection(); deleteSelection(); } // Simple implementation: copy then delete
 void MainWindow::copySelection() {
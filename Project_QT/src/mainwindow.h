@@ -33,6 +33,7 @@ class ToolsPanel; // Already included
 class PropertyEditorDock; // Already included
 class Brush; // Already included
 class BorderSystem; // For access to border automagic (part of Map class now)
+class ProgressiveMapLoader;
 
 
 class MainWindow : public QMainWindow
@@ -56,8 +57,13 @@ public:
     void createNewMap();
     void openMap();
     bool loadMap(const QString& filePath); // Actual loading logic
+    void openMapAtPosition();
+    // Opens 'filePath' centered on 'position': the areas on screen load first, the rest streams in
+    bool loadMapAt(const QString& filePath, const QPoint& position);
     bool saveMap();
     bool saveMapAs();
+    // Saves the current map to 'filePath' on a worker thread, see Map::saveToFile
+    bool writeMap(const QString& filePath);
     
     void undo();
     void redo();
@@ -225,6 +231,8 @@ public slots: // Slots connected to various UI signals or map signals
     void onMapViewPasteRequest(const QPoint& targetPos);
     void onMapViewDeleteRequest(const QRect& selectionRect);
 
+    void onProgressiveLoadFinished(bool success);
+
 
 protected:
     void setupUi();            // Initializes all main UI components
@@ -269,6 +277,7 @@ private:
     QString currentMapFile; // Current map file path
     int currentLayer; // Tracks current active layer, matches LayerWidget value
     bool isPasting; // Flag for paste preview mode
+    ProgressiveMapLoader* progressiveLoader; // Created by the first loadMapAt()
 
     BorderSystem* borderSystem; // The automagic border system from Map
 
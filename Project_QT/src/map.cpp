@@ -3,14 +3,18 @@
 #include "item.h"
 #include "layer.h"
 #include "bordersystem.h"
-#include "otbmfile.h"
+#include "otbm.h"
 #include "itemmanager.h" // For ItemManager (used in cleanDuplicateItems for properties).
 #include "spawn.h"       // Added for Spawn class integration
+#include "selectionregion.h"
 
 #include <QDebug>
+#include <QDir>
 #include <QFileInfo>
+#include <QTemporaryFile>
 #include <QVector>
 #include <algorithm> // For std::sort, std::remove
+#include <filesystem> // For std::filesystem::rename (atomic replace)
 #include <functional> // For std::function
 
 Map* Map::s_instance = nullptr;
@@ -74,6 +78,7 @@ void Map::clear() {
     waypoints.clear();
     towns.clear();
     houses.clear();
+    clearPendingAreas();
 
     // Clear spawns (assuming Map owns Spawn objects, which it will eventually)
     // For now, just clearing the list as Spawn definition is pending.
@@ -180,6 +185,51 @@ QList<Item> Map::getItems(int x, int y, Layer::Type layer) const {
     return QList<Item>();
 }
 
+void Map::notifyAreaChanged(const QRect& area) {
+    if (area.isEmpty()) return;
+    setModified(true);
+    emit areaChanged(area);
+}
+
+template <typename F>
+void Map::forEachCell(const QRect& area, F function) {
+    const QRect r = area.normalized();
+    for (int cx = qMax(0, r.left()) >> PendingCellShift; cx <= (qMax(0, r.right()) >> PendingCellShift); ++cx) {
+        for (int cy = qMax(0, r.top()) >> PendingCellShift; cy <= (qMax(0, r.bottom()) >> PendingCellShift); ++cy) {
+            function((quint32(cx) << 16) | quint32(cy));
+        }
+    }
+}
+
+void Map::addPendingArea(const QRect& area) {
+    if (area.isEmpty()) return;
+    forEachCell(area, [this](quint32 key) { ++pendingCells[key]; });
+}
+
+void Map::markAreaLoaded(const QRect& area) {
+    if (area.isEmpty()) return;
+    forEachCell(area, [this](quint32 key) {
+        auto it = pendingCells.find(key);
+        if (it != pendingCells.end() && --it.value() <= 0) {
+            pendingCells.erase(it);
+        }
+    });
+    emit areaChanged(area);
+}
+
+void Map::clearPendingAreas() {
+    pendingCells.clear();
+}
+
+bool Map::isLoaded(const QRect& area) const {
+    if (pendingCells.isEmpty()) return true;
+    bool loaded = true;
+    forEachCell(area, [this, &loaded](quint32 key) {
+        if (pendingCells.contains(key)) loaded = false;
+    });
+    return loaded;
+}
+
 Layer* Map::getLayer(Layer::Type type) {
     if (static_cast<int>(type) >= 0 && static_cast<int>(type) < layers.size()) {
         return layers[static_cast<int>(type)];
@@ -227,68 +277,84 @@ bool Map::convert(MapVersion to, bool showdialog) {
     return true;
 }
 
-bool Map::loadFromFile(const QString& filename) {
-    OTBMFile loader;
-    connect(&loader, &OTBMFile::loadProgress, this, &Map::loadProgress);
-    // Capture errors from loader into m_error
-    connect(&loader, &OTBMFile::error, this, [this](const QString& msg){ 
-        qDebug() << "Map load error:" << msg; 
-        setError(msg); // Store the error message
-    });
-    
+bool Map::loadFromFile(const QString& filename, const std::function<bool()>& isCanceled) {
     clearError(); // Clear previous errors before loading
     clearWarnings(); // Clear previous warnings
 
-    // Pass this map instance so the loader can fill it directly
-    bool success = loader.load(filename, this);
-    
+    // The reader fills this map only, so a map being loaded off the GUI thread doesn't touch the
+    // live one until MainWindow swaps it in.
+    OTBMMapReader reader(this);
+    bool success = reader.open(filename);
     if (success) {
-        // Assuming OTBMFile has methods to get version and warnings after load
-        // For now, these are placeholders until OTBMFile is updated
-        // MapVersion loadedVersion = loader.getMapVersion(); // Placeholder
-        // setVersion(loadedVersion); // Placeholder
-        
-        // QStringList loadedWarnings = loader.getWarnings(); // Placeholder
-        // for(const QString& warning : loadedWarnings) { // Placeholder
-        //     addWarning(warning); // Placeholder
-        // }
+        const QVector<OTBMTileArea>& areas = reader.getTileAreas();
+        int reported = -1;
+        for (int i = 0; i < areas.size(); ++i) {
+            if (isCanceled && isCanceled()) {
+                qDebug() << "Map load from" << filename << "cancelled";
+                reader.close();
+                return false;
+            }
+            if (!reader.loadTileArea(areas[i])) {
+                success = false;
+                break;
+            }
+            const int percent = int(qint64(i + 1) * 100 / areas.size());
+            if (percent != reported) {
+                reported = percent;
+                emit loadProgress(percent);
+            }
+        }
+        reader.close();
+    }
 
+    if (success) {
         qDebug() << "Map loaded from" << filename;
         setName(QFileInfo(filename).baseName().toStdString());
         setModified(false);
         unnamed = false;
         this->filename = filename;
-        this->setSize(QSize(loader.getWidth(), loader.getHeight()));
-        this->setDescription(loader.getDescription());
-        this->setSpawnFile(loader.getSpawnFile());
-        this->setHouseFile(loader.getHouseFile());
-        this->setTowns(loader.getTowns());
-        this->setHouses(loader.getHouses());
-        this->setWaypoints(loader.getWaypoints());
-
-        ensureTilesExist(); // Creates/ensures all 16 layers of tiles.
-        // OTBMFile's `readTile` typically calls `Map::addItem` implicitly,
-        // which now populates the `tiles` vector using the layer-aware `Tile::addItem`.
-
         emit mapChanged();
     } else {
-        qDebug() << "Failed to load map from" << filename;
-        // m_error should already be set by the loader via the connected signal
+        const QString reason = reader.errorString();
+        setError(reason.isEmpty() ? tr("'%1' is not a valid OTBM map.").arg(filename) : reason);
+        qDebug() << "Failed to load map from" << filename << getError();
     }
     return success;
 }
 
-bool Map::saveToFile(const QString& filename) const {
-    OTBMFile saver;
-    // OTBMFile::save does not have direct access to internal map tiles.
-    // The saver must receive all tiles for writing.
-    // The `OTBMFile::save(filename, const Map* mapInstance)` must iterate map and write all its tiles and items.
-    
-    connect(&saver, &OTBMFile::saveProgress, this, &Map::saveProgress);
-    connect(&saver, &OTBMFile::error, this, [this](const QString& msg){ qDebug() << "Map save error:" << msg; });
-    
-    // Passes a const pointer to this Map instance for the saver to read.
-    bool success = saver.save(filename, this);
+bool Map::saveToFile(const QString& filename, const std::function<bool()>& isCanceled) const {
+    const QFileInfo target(filename);
+    QTemporaryFile temp(target.absoluteDir().filePath(target.fileName() + QStringLiteral(".XXXXXX")));
+    if (!temp.open()) {
+        qDebug() << "Map save error: could not create a temporary file next to" << filename << temp.errorString();
+        return false;
+    }
+    const QString tempName = temp.fileName();
+    temp.close(); // Keeps the name reserved; removed again on failure (autoRemove)
+
+    OTBMMapWriter writer(this);
+    bool success = writer.save(tempName, [this](int percent) { emit saveProgress(percent); }, isCanceled);
+    if (!success) {
+        qDebug() << "Map save error:" << writer.errorString();
+    } else if (isCanceled && isCanceled()) {
+        qDebug() << "Map save to" << filename << "cancelled";
+        return false;
+    }
+
+    if (success) {
+        // QTemporaryFile creates owner-only files, keep the permissions of the file we replace
+        QFile::setPermissions(tempName, target.exists() ? QFile::permissions(filename)
+            : QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup | QFile::ReadOther);
+
+        // Unlike QFile::rename, this replaces an existing target in one step (rename(2) / MoveFileEx)
+        std::error_code ec;
+        std::filesystem::rename(std::filesystem::path(tempName.toStdWString()),
+                                std::filesystem::path(target.absoluteFilePath().toStdWString()), ec);
+        if (ec) {
+            qDebug() << "Map save error: could not replace" << filename << QString::fromStdString(ec.message());
+            success = false;
+        }
+    }
 
     if (success) {
         qDebug() << "Map saved to" << filename;
@@ -298,6 +364,52 @@ bool Map::saveToFile(const QString& filename) const {
     return success;
 }
 
+void Map::swapContents(Map& other) {
+    Q_ASSERT(other.thread() == thread());
+
+    clearSelection();
+    other.clearSelection();
+
+    tiles.swap(other.tiles);
+    std::swap(size, other.size);
+    std::swap(m_version, other.m_version);
+    m_warnings.swap(other.m_warnings);
+    m_error.swap(other.m_error);
+    m_spawns.swap(other.m_spawns);
+
+    name.swap(other.name);
+    filename.swap(other.filename);
+    description.swap(other.description);
+    spawnFile.swap(other.spawnFile);
+    houseFile.swap(other.houseFile);
+    waypointFile.swap(other.waypointFile);
+    towns.swap(other.towns);
+    houses.swap(other.houses);
+    waypoints.swap(other.waypoints);
+    std::swap(modified, other.modified);
+    std::swap(unnamed, other.unnamed);
+    pendingCells.swap(other.pendingCells);
+
+    // Tiles are QObject children of their map. Reparenting in creation order (x, y, z) removes
+    // each one from the front of the old parent's child list, which keeps this linear.
+    auto adopt = [](QVector<QVector<QVector<Tile*>>>& grid, Map* owner) {
+        for (auto& column : grid) {
+            for (auto& stack : column) {
+                for (Tile* tile : stack) {
+                    if (tile) {
+                        tile->setParent(owner);
+                    }
+                }
+            }
+        }
+    };
+    adopt(tiles, this);
+    adopt(other.tiles, &other);
+
+    emit mapChanged();
+    emit other.mapChanged();
+}
+
 bool Map::importFromOTBM(const QString& filename) { Q_UNUSED(filename); return false; /* Placeholder */ }
 bool Map::exportToOTBM(const QString& filename) { Q_UNUSED(filename); return false; /* Placeholder */ }
 bool Map::importFromJSON(const QString& filename) { Q_UNUSED(filename); return false; /* Placeholder */ }
@@ -315,146 +427,147 @@ void Map::setWaypoints(const QMap<QString, Position>& w) { waypoints = w; setMod
 void Map::setSelection(const QRect& newSelection) {
     if (selectionRect == newSelection) return;
     selectionRect = newSelection;
-    selectedPositions.clear(); // Clear individual selection for rect.
-    for (int x = selectionRect.left(); x < selectionRect.left() + selectionRect.width(); ++x) {
-        for (int y = selectionRect.top(); y < selectionRect.top() + selectionRect.height(); ++y) {
-            // Check bounds to ensure points are actually within the map dimensions.
-            if (x >= 0 && x < size.width() && y >= 0 && y < size.height()) {
-                 selectedPositions.insert(QPoint(x, y)); // Use QPoint for selected positions set.
-            }
-        }
-    }
+    selection.clear();
+    // Only positions actually within the map dimensions are selectable.
+    selection.addRect(newSelection.normalized() & QRect(QPoint(0, 0), size));
     emit selectionChanged(selectionRect);
 }
 
 void Map::addToSelection(const QRect& rect) {
-    for (int x = rect.left(); x < rect.left() + rect.width(); ++x) {
-        for (int y = rect.top(); y < rect.top() + rect.height(); ++y) {
-            if (x >= 0 && x < size.width() && y >= 0 && y < size.height()) {
-                selectedPositions.insert(QPoint(x, y));
-            }
-        }
-    }
-    if (selectionRect.isNull() || selectionRect.isEmpty()) {
-        selectionRect = rect;
-    } else {
-        selectionRect = selectionRect.united(rect);
-    }
+    selection.addRect(rect.normalized() & QRect(QPoint(0, 0), size));
+    selectionRect = selection.boundingRect();
     emit selectionChanged(selectionRect);
 }
 
 void Map::removeFromSelection(const QRect& rect) {
-    for (int x = rect.left(); x < rect.left() + rect.width(); ++x) {
-        for (int y = rect.top(); y < rect.top() + rect.height(); ++y) {
-            if (x >= 0 && x < size.width() && y >= 0 && y < size.height()) {
-                selectedPositions.remove(QPoint(x, y));
-            }
-        }
-    }
-    if (selectedPositions.isEmpty()) {
-        selectionRect = QRect();
-    } else {
-        // To maintain `selectionRect` as a bounding box of possibly fragmented `selectedPositions`
-        // we'd need to recompute its bounds (min x,y to max x,y of all `selectedPositions`).
-        // For simplicity for now, it's just `currentRect` and may not reflect fragmentation exactly.
-        int minX=size.width(), minY=size.height(), maxX=0, maxY=0;
-        bool first = true;
-        for(const QPoint& p : selectedPositions) {
-            if (first) {
-                minX=p.x(); minY=p.y(); maxX=p.x(); maxY=p.y();
-                first=false;
-            } else {
-                minX = qMin(minX, p.x()); minY = qMin(minY, p.y());
-                maxX = qMax(maxX, p.x()); maxY = qMax(maxY, p.y());
-            }
-        }
-        selectionRect = QRect(minX, minY, maxX - minX + 1, maxY - minY + 1);
-    }
+    selection.subtractRect(rect.normalized());
+    selectionRect = selection.boundingRect();
     emit selectionChanged(selectionRect);
 }
 
-void Map::toggleSelectionAt(const QPoint& point) {
-    if (selectedPositions.contains(point)) {
-        selectedPositions.remove(point);
-    } else {
-        selectedPositions.insert(point);
-    }
-    if (selectedPositions.isEmpty()) {
-        selectionRect = QRect();
-    } else {
-        int minX=size.width(), minY=size.height(), maxX=0, maxY=0;
-        bool first = true;
-        for(const QPoint& p : selectedPositions) {
-            if (first) {
-                minX=p.x(); minY=p.y(); maxX=p.x(); maxY=p.y();
-                first=false;
-            } else {
-                minX = qMin(minX, p.x()); minY = qMin(minY, p.y());
-                maxX = qMax(maxX, p.x()); maxY = qMax(maxY, p.y());
-            }
-        }
-        selectionRect = QRect(minX, minY, maxX - minX + 1, maxY - minY + 1);
-    }
+void Map::toggleSelection(const QRect& rect) {
+    selection.toggleRect(rect.normalized() & QRect(QPoint(0, 0), size));
+    selectionRect = selection.boundingRect();
     emit selectionChanged(selectionRect);
 }
 
+void Map::toggleSelectionAt(const QPoint& point) {
+    toggleSelection(QRect(point, QSize(1, 1)));
+}
+
 bool Map::isSelected(const QPoint& point) const {
-    return selectedPositions.contains(point);
+    return selection.contains(point);
 }
 
 void Map::clearSelection() {
     selectionRect = QRect();
-    selectedPositions.clear();
+    selection.clear();
     emit selectionChanged(selectionRect);
 }
 
 QVector<Tile*> Map::getSelectedTiles() const {
     QVector<Tile*> selectedTiles;
-    for (const QPoint& pos : selectedPositions) {
-        Tile* tile = getTile(pos.x(), pos.y(), currentLayer); // At current active layer.
-        if (tile) selectedTiles.append(tile);
-    }
+    selectedTiles.reserve(static_cast<int>(selection.count()));
+    selection.forEachSpan([&](int y, int x0, int x1) {
+        for (int x = x0; x <= x1; ++x) {
+            Tile* tile = getTile(x, y, currentLayer); // At current active layer.
+            if (tile) selectedTiles.append(tile);
+        }
+    });
     return selectedTiles;
 }
 
-// Selection Transformation: Placeholder implementations, actual logic will be done through Commands
-// These functions in original RME typically would trigger the actual map data manipulation through Editor/Actions.
-// They modify the `Map` instance's tile data (not just the selection rect itself).
+void Map::setSelectionRegion(const SelectionRegion& region) {
+    selection = region.intersected(QRect(QPoint(0, 0), size));
+    selectionRect = selection.boundingRect();
+    emit selectionChanged(selectionRect);
+}
+
+// Selection Transformations
+// Every selected position is mapped through 'target'; the contents of all layers move with it
+// and the destination becomes the new selection. A moved layer replaces that layer at the
+// destination, layers the selection doesn't carry are kept. Positions whose target falls outside
+// the map stay where they are. The change is reported once for the whole touched area.
+void Map::relocateSelection(const SelectionTransform& target, bool copy) {
+    if (selection.isEmpty() || !target) return;
+
+    struct MovedTile {
+        QPoint to;
+        int z;
+        QVector<Item> items;
+    };
+
+    const QRect mapRect(QPoint(0, 0), size);
+    QVector<MovedTile> moved;
+    SelectionRegion destination;
+    QRect touched = selection.boundingRect();
 
-void Map::moveSelection(const QPoint& offset, bool copy) {
-    qDebug() << "Map: Move selection by" << offset << ", copy:" << copy << ". (Stub).";
-    // This implies creating AddItemCommands/RemoveItemCommands for affected tiles.
-    // Update selectedPositions set as well to reflect new positions.
-    // selectionRect also updates.
-    // Example: This should use a MapCommand macro like the original `Editor::moveSelection`.
+    // Lift everything first so overlapping source and destination areas don't clobber each other.
+    selection.forEachSpan([&](int y, int x0, int x1) {
+        for (int x = x0; x <= x1; ++x) {
+            const QPoint to = target(x, y);
+            if (!mapRect.contains(to)) continue;
+
+            destination.add(to);
+            for (int z = 0; z < Map::LayerCount; ++z) {
+                Tile* tile = getTile(x, y, z);
+                if (!tile || tile->getItems().isEmpty()) continue;
+
+                moved.append({ to, z, tile->getItems() });
+                if (!copy) {
+                    tile->clearItems();
+                }
+            }
+        }
+    });
+
+    for (const MovedTile& entry : moved) {
+        Tile* tile = tiles[entry.to.x()][entry.to.y()][entry.z];
+        tile->clearItems();
+        for (const Item& item : entry.items) {
+            tile->addItem(item);
+        }
+    }
+
+    selection = destination;
+    selectionRect = selection.boundingRect();
     setModified(true);
-    // After moving, update selection. For now: just clear for visual indication of move.
-    clearSelection();
-    emit mapChanged(); // Trigger full redraw.
+    notifyAreaChanged(touched.united(selectionRect));
+    emit selectionChanged(selectionRect);
 }
 
-void Map::rotateSelection(int degrees) {
-    qDebug() << "Map: Rotate selection by" << degrees << "degrees. (Stub).";
-    // Similar to move, actual tile/item manipulation.
-    // Rotate every `Item` on selected tiles that is rotatable, then update tile visuals.
-    setModified(true);
-    // After rotation, clear selection for visual simplicity of action.
-    clearSelection();
-    emit mapChanged();
+Map::SelectionTransform Map::moveTransform(const QPoint& offset) const {
+    if (offset.isNull() || selection.isEmpty()) return {};
+    return [offset](int x, int y) { return QPoint(x + offset.x(), y + offset.y()); };
 }
 
-void Map::flipSelectionHorizontally() {
-    qDebug() << "Map: Flip selection horizontally. (Stub).";
-    setModified(true);
-    clearSelection();
-    emit mapChanged();
+Map::SelectionTransform Map::rotateTransform(int degrees) const {
+    // Rotates clockwise around the selection's bounding box, in steps of 90 degrees.
+    const int steps = ((degrees / 90) % 4 + 4) % 4;
+    if (steps == 0 || selection.isEmpty()) return {};
+
+    const QRect bounds = selection.boundingRect();
+    const int left = bounds.left(), top = bounds.top();
+    const int right = bounds.right(), bottom = bounds.bottom();
+    return [=](int x, int y) {
+        switch (steps) {
+            case 1: return QPoint(left + (bottom - y), top + (x - left));
+            case 2: return QPoint(left + right - x, top + bottom - y);
+            default: return QPoint(left + (y - top), top + (right - x));
+        }
+    };
 }
 
-void Map::flipSelectionVertically() {
-    qDebug() << "Map: Flip selection vertically. (Stub).";
-    setModified(true);
-    clearSelection();
-    emit mapChanged();
+Map::SelectionTransform Map::flipTransform(Qt::Orientation orientation) const {
+    if (selection.isEmpty()) return {};
+
+    const QRect bounds = selection.boundingRect();
+    if (orientation == Qt::Horizontal) {
+        const int mirror = bounds.left() + bounds.right();
+        return [mirror](int x, int y) { return QPoint(mirror - x, y); };
+    }
+    const int mirror = bounds.top() + bounds.bottom();
+    return [mirror](int x, int y) { return QPoint(x, mirror - y); };
 }
 
 uint32_t Map::cleanDuplicateItems(const std::vector<std::pair<uint16_t, uint16_t>>& ranges, const PropertyFlags& flags) {
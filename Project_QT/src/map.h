@@ -9,6 +9,7 @@
 #include <QString>
 #include <QRect>
 #include <QSet>
+#include <QHash>
 #include <QStringList> // Added for m_warnings
 #include <vector>
 
@@ -17,6 +18,8 @@
 #include "layer.h"
 #include "bordersystem.h"
 #include "spawn.h" // Include the full definition of Spawn
+#include "selectionregion.h"
+#include <functional>
 
 // Forward declarations for specific structures
 // class Spawn; // No longer needed, spawn.h is included
@@ -100,6 +103,10 @@ public:
     void clearLayer(int x, int y, Layer::Type layer);
     QList<Item> getItems(int x, int y, Layer::Type layer) const;
 
+    // Batched edits (flood fill, paste...) change tiles directly and then report the
+    // whole area once, instead of one tileChanged per tile.
+    void notifyAreaChanged(const QRect& area);
+
     Layer* getLayer(Layer::Type type);
     const Layer* getLayer(Layer::Type type) const;
     void setLayerVisible(Layer::Type type, bool visible);
@@ -111,13 +118,22 @@ public:
 
     bool convert(MapVersion to, bool showdialog);
 
-    bool loadFromFile(const QString& filename);
-    bool saveToFile(const QString& filename);
+    // 'isCanceled' is polled between tile areas; a cancelled load returns false with no error set
+    bool loadFromFile(const QString& filename, const std::function<bool()>& isCanceled = nullptr);
+    // Writes a temporary file next to 'filename' and renames it over the target once it is
+    // complete, so a failed or cancelled save leaves the previous map file intact.
+    // 'isCanceled' is polled between tile areas and before the rename.
+    bool saveToFile(const QString& filename, const std::function<bool()>& isCanceled = nullptr) const;
+    // Exchanges tiles, spawns and map properties with 'other' (both must live in this thread).
+    // Used to swap in a map that was loaded into a separate Map on a worker thread; the
+    // selection is cleared and layer visibility/lock state stays with this map.
+    void swapContents(Map& other);
     
 signals:
     void loadProgress(int progress);
-    void saveProgress(int progress);
+    void saveProgress(int progress) const; // Emitted by the const saveToFile()
     void tileChanged(const QPoint& position);
+    void areaChanged(const QRect& area);
     void mapChanged();
     void selectionChanged(const QRect& selectionRect);
 
@@ -145,15 +161,23 @@ signals:
     QRect getSelection() const { return selectionRect; }
     void addToSelection(const QRect& rect);
     void removeFromSelection(const QRect& rect);
+    void toggleSelection(const QRect& rect);
     void toggleSelectionAt(const QPoint& point);
     bool isSelected(const QPoint& point) const;
     void clearSelection();
     QVector<Tile*> getSelectedTiles() const;
+    const SelectionRegion& getSelectionRegion() const { return selection; }
+
+    void setSelectionRegion(const SelectionRegion& region);
 
-    void moveSelection(const QPoint& offset, bool copy = false);
-    void rotateSelection(int degrees);
-    void flipSelectionHorizontally();
-    void flipSelectionVertically();
+    // Selection transforms map every selected position to where its contents end up. An empty
+    // transform means there is nothing to do. They are applied through TransformSelectionCommand,
+    // which calls relocateSelection and keeps what it overwrote for undo.
+    using SelectionTransform = std::function<QPoint(int, int)>;
+    SelectionTransform moveTransform(const QPoint& offset) const;
+    SelectionTransform rotateTransform(int degrees) const;
+    SelectionTransform flipTransform(Qt::Orientation orientation) const;
+    void relocateSelection(const SelectionTransform& target, bool copy);
 
     // From Source/map.h: Map cleanup, needs PropertyFlags
     uint32_t cleanDuplicateItems(const std::vector<std::pair<uint16_t, uint16_t>>& ranges, const PropertyFlags& flags);
@@ -183,6 +207,16 @@ signals:
 
 
     BorderSystem* getBorderSystem() const { return borderSystem; }
+
+    // Progressive loading: areas announced as pending are still being read from the file and
+    // must not be edited yet. Tracked per 256x256 cell, the size of an OTBM tile area.
+    void addPendingArea(const QRect& area);
+    // Drops 'area' from the pending set and reports it through areaChanged so it gets drawn
+    void markAreaLoaded(const QRect& area);
+    void clearPendingAreas();
+    bool hasPendingAreas() const { return !pendingCells.isEmpty(); }
+    bool isLoaded(const QPoint& position) const { return isLoaded(QRect(position, QSize(1, 1))); }
+    bool isLoaded(const QRect& area) const;
     
 private:
     static Map* s_instance; // The singleton instance
@@ -212,14 +246,18 @@ private:
     bool unnamed;
 
     QRect selectionRect;
-    QSet<QPoint> selectedPositions;
+    SelectionRegion selection; // Selected positions as per-chunk bitsets
     bool multiSelectionMode;
 
     int currentLayer;
 
     BorderSystem* borderSystem;
 
+    static const int PendingCellShift = 8; // 256x256 tiles
+    QHash<quint32, int> pendingCells; // Cell key -> number of pending areas overlapping it
+
     void ensureTilesExist();
+    template <typename F> static void forEachCell(const QRect& area, F function);
 };
 
 #endif // MAP_H
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "selectionbrush.h"
 #include "normalbrush.h"
 #include "floodfillbrush.h"
+#include "transformselectioncommand.h"
 #include "itemmanager.h" // For ItemManager::getSprite() (client/server IDs)
 #include "clientversion.h" // For ClientVersion data
 
@@ -13,6 +14,7 @@
 #include <QTimer>
 #include <QDebug>
 #include <QScrollBar>
+#include <QStatusBar>
 #include <QGraphicsSceneMouseEvent>
 #include <QClipboard>
 #include <QMessageBox>
@@ -88,6 +90,7 @@ void MapView::setMap(Map* map)
     if (currentMap) {
         // Disconnect existing map signals before assigning a new map.
         disconnect(currentMap, &Map::tileChanged, mapScene, &MapScene::updateTile);
+        disconnect(currentMap, &Map::areaChanged, this, &MapView::updateVisibleTiles);
         disconnect(currentMap, &Map::selectionChanged, this, &MapView::onSelectionChanged);
         disconnect(currentMap, &Map::mapChanged, static_cast<MainWindow*>(parentWidget()), &MainWindow::updateWindowTitle);
         disconnect(currentMap, &Map::selectionChanged, static_cast<MainWindow*>(parentWidget()), &MainWindow::onSelectionChanged);
@@ -108,6 +111,7 @@ void MapView::setMap(Map* map)
     if (currentMap) {
         // Connect new map signals.
         connect(currentMap, &Map::tileChanged, mapScene, &MapScene::updateTile);
+        connect(currentMap, &Map::areaChanged, this, &MapView::updateVisibleTiles);
         connect(currentMap, &Map::selectionChanged, this, &MapView::onSelectionChanged);
         connect(currentMap, &Map::mapChanged, static_cast<MainWindow*>(parentWidget()), &MainWindow::updateWindowTitle);
         connect(currentMap, &Map::selectionChanged, static_cast<MainWindow*>(parentWidget()), &MainWindow::onSelectionChanged);
@@ -147,7 +151,7 @@ void MapView::setBrush(Brush* brush)
                  normalBrush->setCurrentItem(currentItem);
              } else if (FloodFillBrush* floodBrush = qobject_cast<FloodFillBrush*>(currentBrush)) {
                  floodBrush->setCurrentItem(currentItem);
-                 floodBrush->setCurrentLayer(static_cast<Tile::Layer>(currentLayer)); // Flood fill cares about Tile layer for context
+                 floodBrush->setCurrentLayer(currentLayer); // Flood fill cares about Tile layer for context
              }
         }
         setCursor(currentBrush->getCursor()); // Update system cursor based on selected brush.
@@ -256,6 +260,57 @@ QPoint MapView::tileToMap(const QPoint& pos) const
     return mapFromScene(scenePos).toPoint();
 }
 
+void MapView::centerOnTile(const QPoint& tile)
+{
+    centerOn((tile.x() + 0.5) * MapTileItem::TilePixelSize, (tile.y() + 0.5) * MapTileItem::TilePixelSize);
+}
+
+QRect MapView::visibleTileRect() const
+{
+    const QRect area = viewport()->rect();
+    return QRect(mapToTile(area.topLeft()), mapToTile(area.bottomRight()));
+}
+
+void MapView::transformSelection(const Map::SelectionTransform& transform, bool copy, const QString& text)
+{
+    if (!currentMap || !transform) return;
+
+    // The transforms are affine, the corners of the selection's bounds map onto the destination's
+    const QRect source = currentMap->getSelectionRegion().boundingRect();
+    const QPoint a = transform(source.left(), source.top());
+    const QPoint b = transform(source.right(), source.bottom());
+    const QRect destination = QRect(a, b).normalized();
+    if (!canEditAt(source.united(destination))) {
+        return;
+    }
+
+    MainWindow* mainWin = qobject_cast<MainWindow*>(parentWidget());
+    if (mainWin && mainWin->getUndoStack()) {
+        mainWin->getUndoStack()->push(new TransformSelectionCommand(currentMap, transform, copy, text));
+    } else {
+        // Fallback for no undo stack
+        currentMap->relocateSelection(transform, copy);
+    }
+    mapScene->update();
+}
+
+bool MapView::canEditAt(const QPoint& tilePos)
+{
+    return canEditAt(QRect(tilePos, QSize(1, 1)));
+}
+
+bool MapView::canEditAt(const QRect& area)
+{
+    // Progressive loading blocks edits only on the areas that aren't loaded yet
+    if (!currentMap || currentMap->isLoaded(area)) {
+        return true;
+    }
+    if (MainWindow* mainWin = qobject_cast<MainWindow*>(parentWidget())) {
+        mainWin->statusBar()->showMessage(tr("This part of the map is still loading."), 2000);
+    }
+    return false;
+}
+
 void MapView::clearSelection()
 {
     // Clears visual selection and propagates to Map model.
@@ -394,6 +449,10 @@ void MapView::mousePressEvent(QMouseEvent* event)
                 }
                 selBrush->mousePressEvent(event, this); // Let brush handle its internal state
             } else { // Drawing mode
+                if (!canEditAt(tilePos)) {
+                    event->accept();
+                    return;
+                }
                 drawingActive = true;
                 // Logic from MapCanvas::OnMouseActionClick (drawing part)
                 currentBrush->mousePressEvent(event, this); // Brush handles actual drawing
@@ -485,7 +544,9 @@ void MapView::mouseMoveEvent(QMouseEvent* event)
         } else if (drawingActive) {
             // In drawing mode and left button is down
             // Delegate to current drawing brush
-            currentBrush->mouseMoveEvent(event, this);
+            if (canEditAt(currentTilePos)) {
+                currentBrush->mouseMoveEvent(event, this);
+            }
         }
         // mapScene->update(); // Often handled by brush or map signals now
         event->accept();
@@ -672,7 +733,8 @@ void MapView::keyPressEvent(QKeyEvent* event)
             // This is specific to `Item` rotation logic within the map.
             // Delegate to Map/Editor class with current selection context.
             if (currentMap && !currentMap->getSelection().isEmpty()) {
-                 currentMap->rotateSelection((key == Qt::Key_Z) ? -90 : 90); // Z: -90, X: +90 degrees (example)
+                 const int degrees = (key == Qt::Key_Z) ? -90 : 90; // Z: -90, X: +90 degrees
+                 transformSelection(currentMap->rotateTransform(degrees), false, tr("Rotate Selection"));
                  event->accept(); return;
             }
         }
@@ -989,7 +1051,7 @@ void MapView::onRotateItemAction() {
     // Delegate to Map to rotate the current selection (or first item on clicked tile).
     // `Source/editor.cpp::rotateSelection()`
     if (currentMap && !currentMap->getSelection().isEmpty()) {
-        currentMap->rotateSelection(90); // Default 90 degrees rotation.
+        transformSelection(currentMap->rotateTransform(90), false, tr("Rotate Selection")); // Default 90 degrees rotation.
     }
 }
 
@@ -1069,7 +1131,10 @@ void MapView::onFillAction() {
     if (currentBrush && currentBrush->getType() == Brush::Type::FloodFill) {
         // Execute the flood fill starting from the clicked tile.
         QPoint tilePos = mapToTile(mapFromGlobal(QCursor::pos()));
-        static_cast<FloodFillBrush*>(currentBrush)->floodFill(tilePos);
+        if (!canEditAt(tilePos)) {
+            return;
+        }
+        static_cast<FloodFillBrush*>(currentBrush)->fill(this, tilePos);
         mapScene->update(); // Redraw scene.
     } else {
         QMessageBox::information(this, tr("Fill Tool"), tr("Please select the Flood Fill brush to use this action."));
@@ -59,6 +59,10 @@ public:
 
     QPoint mapToTile(const QPoint& pos) const;
     QPoint tileToMap(const QPoint& pos) const;
+    void centerOnTile(const QPoint& tile); // Scrolls so that 'tile' is in the middle of the view
+    QRect visibleTileRect() const; // Tiles currently inside the viewport
+    // Moves/rotates/flips the selection through the undo stack (directly when there is none)
+    void transformSelection(const Map::SelectionTransform& transform, bool copy, const QString& text);
 
     // View state getters/setters
     bool getShowGridState() const { return mapScene ? mapScene->getShowGrid() : false; } // From MapScene
@@ -192,6 +196,8 @@ private:
     // Helper functions for MapView's internal logic
     void updateVisibleTiles(); // Triggers mapScene to update visible items
     void updateCursor(); // Redraws the brush preview cursor
+    bool canEditAt(const QPoint& tilePos); // False (with a status message) while that area is still loading
+    bool canEditAt(const QRect& area);
     void createContextMenu(const QPoint& globalPos); // Creates and displays the right-click context menu
 
     // Right-Click Context Menu Action Handlers (slots) - directly migrate logic from original map_display.cpp
@@ -1,414 +1,330 @@
 #include "otbm.h"
+#include "item.h"
+#include "itemmanager.h"
+#include "layer.h"
 #include <QDebug>
+#include <QSet>
+#include <cstring>
+
+namespace {
+    // TILESTATE_ZONE_BRUSH in the wx editor, the tile flags are followed by zone ids
+    const quint32 TileZoneBrushFlag = 0x0040;
+
+    // Floor the Qt map's tiles are written to, it has no floors of its own yet
+    const quint8 GroundFloor = 7;
+    // Tiles of an area are stored as u8 offsets from its base position
+    const int TileAreaSize = 256;
+    // Bytes the writer buffers before handing them to the file
+    const qsizetype WriteBufferSize = 1 << 20;
+
+    // Types of the values in OTBM_ATTR_ATTRIBUTE_MAP
+    enum AttributeMapType {
+        AttributeString = 1,
+        AttributeInteger = 2,
+        AttributeFloat = 3,
+        AttributeBoolean = 4,
+        AttributeDouble = 5
+    };
+
+    // Layer an item is put on, from the properties of its type
+    Layer::Type layerForItem(quint16 itemId) {
+        const Item* type = ItemManager::getInstance().getItemById(itemId);
+        if (!type) {
+            return Layer::Objects;
+        }
+        if (type->isGroundTile()) {
+            return Layer::Ground;
+        }
+        if (type->isBlocking()) {
+            return Layer::Objects; // Walls, trees, doors...
+        }
+        if (type->isPickupable()) {
+            return Layer::Items;
+        }
+        return Layer::GroundDetail;
+    }
+}
 
-OTBMFile::OTBMFile() : version(OTBM_4), width(0), height(0) {
+OTBMMapReader::OTBMMapReader(Map* map) : map(map), version(OTBM_4), width(0), height(0) {
 }
 
-OTBMFile::~OTBMFile() {
-    file.close();
+OTBMMapReader::~OTBMMapReader() {
+    close();
 }
 
-bool OTBMFile::load(const QString& filePath) {
-    file.setFileName(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qDebug() << "Failed to open file for reading:" << file.errorString();
+bool OTBMMapReader::load(const QString& filePath) {
+    if (!open(filePath)) {
         return false;
     }
 
-    // Read OTBM signature
-    quint32 signature;
-    if (!file.readU32(signature) || signature != OTBM_SIGNATURE) {
-        qDebug() << "Invalid OTBM signature.";
-        file.close();
-        return false;
+    bool success = true;
+    for (const OTBMTileArea& area : tileAreas) {
+        if (!loadTileArea(area)) {
+            success = false;
+            break;
+        }
     }
 
-    // Read OTBM version
-    quint32 versionNum;
-    if (!file.readU32(versionNum)) {
-        qDebug() << "Failed to read OTBM version.";
-        file.close();
+    close();
+    return success;
+}
+
+bool OTBMMapReader::open(const QString& filePath) {
+    close();
+    tileAreas.clear();
+    towns.clear();
+    houses.clear();
+    waypoints.clear();
+
+    if (!reader.open(filePath, "OTBM")) {
+        qDebug() << "Failed to open file for reading:" << reader.errorString();
         return false;
     }
-    version = static_cast<OTBMVersion>(versionNum);
 
-    // Read map data
-    if (!readMapData()) {
-        file.close();
+    OTBMNode root;
+    if (!reader.readRoot(root) || !readHeader(root)) {
+        qDebug() << "Invalid OTBM header:" << reader.errorString();
+        reader.close();
         return false;
     }
 
-    file.close();
-    return true;
-}
+    map->setSize(QSize(width, height));
 
-bool OTBMFile::save(const QString& filePath) {
-    file.setFileName(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qDebug() << "Failed to open file for writing:" << file.errorString();
+    OTBMNode mapData;
+    if (!reader.firstChild(root, mapData) || mapData.type() != OTBM_MAP_DATA) {
+        qDebug() << "Expected OTBM_MAP_DATA node." << reader.errorString();
+        reader.close();
         return false;
     }
 
-    // Write OTBM header
-    if (!file.writeU32(OTBM_SIGNATURE) || !file.writeU32(OTBM_VERSION)) {
-        file.close();
-        return false;
+    bool success = readMapData(mapData);
+    if (reader.hasError()) {
+        qDebug() << "Corrupt map file:" << reader.errorString();
+        success = false;
     }
-
-    // Write map data
-    if (!writeMapData()) {
-        file.close();
+    if (!success) {
+        reader.close();
         return false;
     }
 
-    file.close();
+    map->setDescription(description);
+    map->setSpawnFile(spawnFile);
+    map->setHouseFile(houseFile);
+    map->setTowns(towns);
+    map->setWaypoints(waypoints);
     return true;
 }
 
-bool OTBMFile::writeHouses() {
-    // Write houses node
-    if (!houses.isEmpty()) {
-        if (!file.writeU8(OTBM_HOUSES)) {
-            return false;
-        }
-
-        // Write each house
-        for (auto it = houses.begin(); it != houses.end(); ++it) {
-            if (!file.writeU8(OTBM_HOUSE) || !file.writeU32(it.key()) || !file.writeString(it.value().name) || !file.writePosition(it.value().position)) {
-                return false;
-            }
-        }
-
-        // End of houses node
-        if (!file.writeU8(0xFF)) {
-            return false;
-        }
-    }
-
-    return true;
+void OTBMMapReader::close() {
+    reader.close();
 }
 
-bool OTBMFile::writeHeader() {
-    if (!file.writeU32(version)) {
+bool OTBMMapReader::loadTileArea(const OTBMTileArea& area) {
+    OTBMNode node;
+    if (!reader.readNodeAt(area.offset, node) || node.type() != OTBM_TILE_AREA) {
+        qDebug() << "No tile area at offset" << area.offset << reader.errorString();
         return false;
     }
-
-    if (!file.writeU16(width) || !file.writeU16(height)) {
+    if (!readTileArea(node)) {
+        qDebug() << "Corrupt tile area at" << area.x << area.y << area.z << reader.errorString();
         return false;
     }
-
-    // Zapisujemy wersję items.otb (domyślnie 1.0)
-    if (!file.writeU32(1) || !file.writeU32(0)) {
-        return false;
-    }
-
     return true;
 }
 
-bool OTBMFile::readHeader() {
+bool OTBMMapReader::readHeader(OTBMNode& root) {
     quint32 versionNum;
-    if (!file.readU32(versionNum)) {
+    if (!root.getU32(versionNum)) {
         return false;
     }
     version = static_cast<OTBMVersion>(versionNum);
 
-    if (!file.readU16(width) || !file.readU16(height)) {
+    if (!root.getU16(width) || !root.getU16(height)) {
         return false;
     }
 
     // Pomijamy wersję items.otb
     quint32 majorVersion, minorVersion;
-    if (!file.readU32(majorVersion) || !file.readU32(minorVersion)) {
+    if (!root.getU32(majorVersion) || !root.getU32(minorVersion)) {
         return false;
     }
 
     return true;
 }
 
-bool OTBMFile::writeMapData() {
-    // Write map data node
-    if (!file.writeU8(OTBM_MAP_DATA)) {
+bool OTBMMapReader::readTileArea(OTBMNode& area) {
+    quint16 baseX, baseY;
+    quint8 baseZ;
+    if (!area.getU16(baseX) || !area.getU16(baseY) || !area.getU8(baseZ)) {
+        qDebug() << "Tile area without a base position.";
         return false;
     }
 
-    // Write map dimensions (width, height, depth)
-    // Assuming Map::getInstance().getSize() returns a QSize with width and height
-    // Assuming depth is always 16 for OTBM
-    if (!file.writeU16(Map::getInstance().getSize().width()) ||
-        !file.writeU16(Map::getInstance().getSize().height()) ||
-        !file.writeU8(Map::LayerCount)) { // Depth is always 16 in OTBM
-        qDebug() << "Failed to write map dimensions";
-        return false;
-    }
-
-    // Write map attributes (description, spawn file, house file)
-    if (!description.isEmpty()) {
-        if (!file.writeU8(OTBM_ATTR_DESCRIPTION) || !file.writeString(description)) {
-            return false;
-        }
-    }
-
-    if (!spawnFile.isEmpty()) {
-        if (!file.writeU8(OTBM_ATTR_EXT_SPAWN_FILE) || !file.writeString(spawnFile)) {
-            return false;
+    OTBMNode tile;
+    for (bool ok = reader.firstChild(area, tile); ok; ok = reader.nextChild(area, tile)) {
+        if (tile.type() != OTBM_TILE && tile.type() != OTBM_HOUSETILE) {
+            qDebug() << "Nieznany typ węzła w obszarze:" << tile.type();
+            continue;
         }
-    }
-
-    if (!houseFile.isEmpty()) {
-        if (!file.writeU8(OTBM_ATTR_EXT_HOUSE_FILE) || !file.writeString(houseFile)) {
+        if (!readTile(tile, baseX, baseY, baseZ)) {
             return false;
         }
     }
 
-    // Write tile areas
-    if (!writeTileArea()) {
-        return false;
-    }
-
-    // Write towns
-    if (!writeTowns()) {
-        return false;
-    }
-
-    // Write waypoints
-    if (!writeWaypoints()) {
-        return false;
-    }
-
-    // Write houses
-    if (!writeHouses()) {
-        return false;
-    }
+    return !reader.hasError();
+}
 
-    // End of map data node
-    if (!file.writeU8(0xFF)) {
+bool OTBMMapReader::readTile(OTBMNode& tile, quint16 baseX, quint16 baseY, quint8 baseZ) {
+    quint8 x, y;
+    if (!tile.getU8(x) || !tile.getU8(y)) {
         return false;
     }
 
-    return true;
-}
-
-bool OTBMFile::writeWaypoints() {
-    // Write waypoints node
-    if (!waypoints.isEmpty()) {
-        if (!file.writeU8(OTBM_WAYPOINTS)) {
-            return false;
-        }
-
-        // Write each waypoint
-        for (auto it = waypoints.begin(); it != waypoints.end(); ++it) {
-            if (!file.writeU8(OTBM_WAYPOINT) || !file.writeString(it.key()) || !file.writePosition(it.value())) {
-                return false;
-            }
-        }
+    quint16 tileX = baseX + x;
+    quint16 tileY = baseY + y;
+    quint8 tileZ = baseZ;
 
-        // End of waypoints node
-        if (!file.writeU8(0xFF)) {
+    if (tile.type() == OTBM_HOUSETILE) {
+        quint32 houseId;
+        if (!tile.getU32(houseId)) {
             return false;
         }
+        houses.append({tileX, tileY, tileZ, houseId});
     }
 
-    return true;
-}
-
-bool OTBMFile::writeTowns() {
-    // Write towns node
-    if (!towns.isEmpty()) {
-        if (!file.writeU8(OTBM_TOWNS)) {
-            return false;
-        }
-
-        // Write each town
-        for (auto it = towns.begin(); it != towns.end(); ++it) {
-            if (!file.writeU8(OTBM_TOWN) || !file.writeU32(it.key()) || !file.writeString(it.value())) {
-                return false;
+    // Tile attributes: flags and items stored inline by their id
+    quint32 flags = 0;
+    quint8 attribute;
+    while (tile.getU8(attribute)) {
+        switch (attribute) {
+            case OTBM_ATTR_TILE_FLAGS:
+            {
+                if (!tile.getU32(flags)) return false;
+                if (flags & TileZoneBrushFlag) {
+                    // Zero terminated list of zone ids, not kept by the Qt map yet
+                    quint16 zoneId;
+                    do {
+                        if (!tile.getU16(zoneId)) return false;
+                    } while (zoneId != 0);
+                }
+                break;
             }
+            case OTBM_ATTR_ITEM:
+            {
+                quint16 itemId;
+                if (!tile.getU16(itemId)) return false;
+                Item item(itemId);
+                placeItem(tileX, tileY, item);
+                break;
+            }
+            default:
+                qDebug() << "Nieznany atrybut kafelka:" << attribute;
+                return false;
         }
-
-        // End of towns node
-        if (!file.writeU8(0xFF)) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool OTBMFile::writeTile(const Tile& tile, quint8 relativeX, quint8 relativeY) {
-    // Write relative X and Y coordinates
-    if (!file.writeU8(relativeX) || !file.writeU8(relativeY)) {
-        return false;
     }
 
-    // Write tile properties (if any) - TODO
-
-    // Iterate through items on the tile and write each one
-    // Assuming Tile::getItems() returns a QList<Item*>
-    const QList<Item*>& items = tile.getItems();
-    for (const Item* item : items) {
-        if (!file.writeU8(OTBM_ITEM)) { // Start item node
-            return false;
+    OTBMNode node;
+    for (bool ok = reader.firstChild(tile, node); ok; ok = reader.nextChild(tile, node)) {
+        if (node.type() != OTBM_ITEM) {
+            qDebug() << "Nieznany typ węzła w kafelku:" << node.type();
+            continue;
         }
-        if (!writeItem(*item)) { // Write the item data
+        if (!readItem(node, tileX, tileY, tileZ)) {
             return false;
         }
     }
 
-    // End of tile node
-    if (!file.writeU8(0xFF)) {
-        return false;
+    if (flags != 0) {
+        // The base z is a floor, the Qt map keeps tile flags on the ground layer
+        if (Tile* mapTile = map->getTile(tileX, tileY, static_cast<int>(Layer::Ground))) {
+            mapTile->setMapFlags(static_cast<uint16_t>(flags));
+        }
     }
 
-    return true;
+    return !reader.hasError();
 }
 
-bool OTBMFile::writeTileArea() {
-    // Iterate through 8x8x16 blocks of the map
-    for (quint16 z = 0; z < Map::LayerCount; ++z) {
-        for (quint16 baseY = 0; baseY < Map::getInstance().getSize().height(); baseY += 8) {
-            for (quint16 baseX = 0; baseX < Map::getInstance().getSize().width(); baseX += 8) {
-                bool areaHasTiles = false;
-                // Check if this 8x8x16 area contains any tiles with items
-                for (quint16 y = 0; y < 8; ++y) {
-                    for (quint16 x = 0; x < 8; ++x) {
-                        quint16 tileX = baseX + x;
-                        quint16 tileY = baseY + y;
-                        if (tileX < Map::getInstance().getSize().width() && tileY < Map::getInstance().getSize().height()) {
-                            // Assuming getTile method in Map returns a Tile object or nullptr
-                            Tile* tile = Map::getInstance().getTile(QPoint(tileX, tileY), z); // Assuming getTile takes z
-                            if (tile && !tile->getItems().isEmpty()) { // Assuming getItems() returns a list of items
-                                areaHasTiles = true;
-                                break;
-                            }
-                        }
-                    }
-                    if (areaHasTiles) break;
-                }
-                if (!areaHasTiles) continue; // Skip empty areas
+bool OTBMMapReader::readItem(OTBMNode& node, quint16 tileX, quint16 tileY, quint8 tileZ) {
+    Q_UNUSED(tileZ);
 
-                // Write the tile area node
-                if (!file.writeU8(OTBM_TILE_AREA)) {
-                    return false;
-                }
-                if (!file.writeU16(baseX) || !file.writeU16(baseY) || !file.writeU8(z)) {
-                    return false;
-                }
-
-                // Write tiles within this area
-                for (quint8 y = 0; y < 8; ++y) { // Use quint8 for relative coordinates
-                    for (quint8 x = 0; x < 8; ++x) { // Use quint8 for relative coordinates
-                        quint16 tileX = baseX + x;
-                        quint16 tileY = baseY + y;
-                        if (tileX < Map::getInstance().getSize().width() && tileY < Map::getInstance().getSize().height()) {
-                            Tile* tile = Map::getInstance().getTile(QPoint(tileX, tileY), z); // Assuming getTile takes z
-                            if (tile && !tile->getItems().isEmpty()) {
-                                if (!file.writeU8(OTBM_TILE)) { // Start tile node
-                                    return false;
-                                }
-                                if (!writeTile(*tile, x, y)) { // Pass relative x and y
-                                    return false;
-                                }
-                            }
-                        }
-                    }
-                }
-
-                // End of tile area node
-                if (!file.writeU8(0xFF)) {
-                    return false;
-                }
-            }
-        }
+    quint16 itemId;
+    if (!node.getU16(itemId)) {
+        return false;
     }
 
-    return true;
-}
-
-bool OTBMFile::readTile(quint16 baseX, quint16 baseY, quint8 baseZ) { // Added parameters
-    quint8 x, y;
-    if (!file.readU8(x) || !file.readU8(y)) {
+    // Create an Item object with itemId
+    Item item(itemId);
+    if (!readItemAttributes(node, item)) {
+        qDebug() << "Błędne atrybuty przedmiotu" << itemId << "na" << tileX << tileY;
         return false;
     }
 
-    quint16 tileX = baseX + x;
-    quint16 tileY = baseY + y;
-    quint8 tileZ = baseZ;
+    // Container contents are child item nodes; the Qt map doesn't keep them yet,
+    // so they are left unread and the reader skips them as a whole.
 
-    // TODO: Create or get the Tile object at (tileX, tileY, tileZ)
-    // For now, just read items within this tile node
-
-    quint8 nodeType;
-    while (file.peekU8(nodeType) && nodeType != 0xFF) { // Read until end of node
-        if (nodeType == OTBM_ITEM) {
-            if (!readItem(tileX, tileY, tileZ)) { // Pass tile coordinates to readItem
-                return false;
-            }
-        } else {
-            qDebug() << "Nieznany typ węzła w kafelku:" << nodeType;
-            return false;
-        }
-        if (!file.readU8(nodeType)) return false; // Consume the node type byte
-    }
+    placeItem(tileX, tileY, item);
 
     return true;
 }
 
-bool OTBMFile::readItem(quint16 tileX, quint16 tileY, quint8 tileZ) {
-    quint16 itemId;
-    if (!file.readU16(itemId)) {
-        return false;
+// Straight into the tile: Map::addItem would border, mark and signal every single item
+void OTBMMapReader::placeItem(quint16 x, quint16 y, const Item& item) {
+    if (Tile* tile = map->getTile(x, y, static_cast<int>(layerForItem(item.getId())))) {
+        tile->addItem(item);
     }
+}
 
-    // Create an Item object with itemId
-    Item item(itemId);
-
-    quint8 nodeType;
-    while (file.peekU8(nodeType) && nodeType != 0xFF) { // Read until end of node
-        quint8 attribute;
-        if (!file.readU8(attribute)) return false; // Consume the attribute type byte
-        quint16 size;
-        if (!file.readU16(size)) return false;
-
+bool OTBMMapReader::readItemAttributes(OTBMNode& node, Item& item) {
+    quint8 attribute;
+    while (node.getU8(attribute)) {
         switch (attribute) {
             case OTBM_ATTR_COUNT:
+            case OTBM_ATTR_RUNE_CHARGES:
             {
                 quint8 count;
-                if (!file.readU8(count)) return false;
+                if (!node.getU8(count)) return false;
                 item.setAttribute("count", count);
                 break;
             }
+            case OTBM_ATTR_CHARGES:
+            {
+                quint16 charges;
+                if (!node.getU16(charges)) return false;
+                item.setAttribute("charges", charges);
+                break;
+            }
             case OTBM_ATTR_ACTION_ID:
             {
                 quint16 actionId;
-                if (!file.readU16(actionId)) return false;
+                if (!node.getU16(actionId)) return false;
                 item.setAttribute("actionid", actionId);
                 break;
             }
             case OTBM_ATTR_UNIQUE_ID:
             {
                 quint16 uniqueId;
-                if (!file.readU16(uniqueId)) return false;
+                if (!node.getU16(uniqueId)) return false;
                 item.setAttribute("uid", uniqueId);
                 break;
             }
             case OTBM_ATTR_TEXT:
             {
                 QString text;
-                if (!file.readString(text)) return false;
+                if (!node.getString(text)) return false;
                 item.setAttribute("text", text);
                 break;
             }
             case OTBM_ATTR_DESC:
             {
                 QString desc;
-                if (!file.readString(desc)) return false;
+                if (!node.getString(desc)) return false;
                 item.setAttribute("description", desc);
                 break;
             }
             case OTBM_ATTR_TELE_DEST:
             {
                 OTBMTeleportDest dest;
-                if (!file.readU16(dest.x) || !file.readU16(dest.y) || !file.readU8(dest.z)) return false;
+                if (!node.getU16(dest.x) || !node.getU16(dest.y) || !node.getU8(dest.z)) return false;
                 item.setAttribute("teleport_dest_x", dest.x);
                 item.setAttribute("teleport_dest_y", dest.y);
                 item.setAttribute("teleport_dest_z", dest.z);
@@ -417,313 +333,529 @@ bool OTBMFile::readItem(quint16 tileX, quint16 tileY, quint8 tileZ) {
             case OTBM_ATTR_DEPOT_ID:
             {
                 quint16 depotId;
-                if (!file.readU16(depotId)) return false;
+                if (!node.getU16(depotId)) return false;
                 item.setAttribute("depot_id", depotId);
                 break;
             }
-            case OTBM_ATTR_RUNE_CHARGES:
-            {
-                quint16 charges;
-                if (!file.readU16(charges)) return false;
-                item.setAttribute("rune_charges", charges);
-                break;
-            }
             case OTBM_ATTR_HOUSEDOORID:
             {
-                quint32 houseDoorId;
-                if (!file.readU32(houseDoorId)) return false;
+                quint8 houseDoorId;
+                if (!node.getU8(houseDoorId)) return false;
                 item.setAttribute("house_door_id", houseDoorId);
                 break;
             }
-            case OTBM_ATTR_COUNT:
-            {
-                quint8 count;
-                if (!file.readU8(count)) return false;
-                item.setAttribute("count", count);
-                break;
-            }
             case OTBM_ATTR_DURATION:
             {
                 quint32 duration;
-                if (!file.readU32(duration)) return false;
+                if (!node.getU32(duration)) return false;
                 item.setAttribute("duration", duration);
                 break;
             }
             case OTBM_ATTR_DECAYING_STATE:
             {
                 quint8 state;
-                if (!file.readU8(state)) return false;
+                if (!node.getU8(state)) return false;
                 item.setAttribute("decaying_state", state);
                 break;
             }
             case OTBM_ATTR_WRITTENDATE:
             {
                 quint32 date;
-                if (!file.readU32(date)) return false;
+                if (!node.getU32(date)) return false;
                 item.setAttribute("written_date", date);
                 break;
             }
             case OTBM_ATTR_WRITTENBY:
             {
                 QString writtenBy;
-                if (!file.readString(writtenBy)) return false;
+                if (!node.getString(writtenBy)) return false;
                 item.setAttribute("written_by", writtenBy);
                 break;
             }
             case OTBM_ATTR_SLEEPERGUID:
             {
                 quint32 guid;
-                if (!file.readU32(guid)) return false;
+                if (!node.getU32(guid)) return false;
                 item.setAttribute("sleeper_guid", guid);
                 break;
             }
             case OTBM_ATTR_SLEEPSTART:
             {
                 quint32 start;
-                if (!file.readU32(start)) return false;
+                if (!node.getU32(start)) return false;
                 item.setAttribute("sleep_start", start);
                 break;
             }
-            case OTBM_ATTR_CHARGES:
+            case OTBM_ATTR_TIER:
             {
-                quint16 charges;
-                if (!file.readU16(charges)) return false;
-                item.setAttribute("charges", charges);
+                quint8 tier;
+                if (!node.getU8(tier)) return false;
+                item.setAttribute("tier", tier);
+                break;
+            }
+            case OTBM_ATTR_PODIUMOUTFIT:
+                // Podium outfits aren't edited in the Qt port yet
+                if (!node.skip(15)) return false;
+                break;
+            case OTBM_ATTR_ATTRIBUTE_MAP:
+            {
+                // Custom key/value attributes, as written by the wx editor for OTBM 4
+                quint16 count;
+                if (!node.getU16(count)) return false;
+                while (count--) {
+                    QString key;
+                    quint8 type;
+                    if (!node.getString(key) || !node.getU8(type)) return false;
+                    switch (type) {
+                        case AttributeString:
+                        {
+                            QString value;
+                            if (!node.getLongString(value)) return false;
+                            item.setAttribute(key, value);
+                            break;
+                        }
+                        case AttributeInteger:
+                        {
+                            quint32 value;
+                            if (!node.getU32(value)) return false;
+                            item.setAttribute(key, static_cast<qint32>(value));
+                            break;
+                        }
+                        case AttributeFloat:
+                        {
+                            quint32 bits;
+                            if (!node.getU32(bits)) return false;
+                            float value;
+                            std::memcpy(&value, &bits, sizeof(value));
+                            item.setAttribute(key, double(value));
+                            break;
+                        }
+                        case AttributeBoolean:
+                        {
+                            quint8 value;
+                            if (!node.getU8(value)) return false;
+                            item.setAttribute(key, value != 0);
+                            break;
+                        }
+                        case AttributeDouble:
+                        {
+                            quint64 bits;
+                            if (!node.getU64(bits)) return false;
+                            double value;
+                            std::memcpy(&value, &bits, sizeof(value));
+                            item.setAttribute(key, value);
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                }
                 break;
             }
             default:
+                // Attributes carry no length, an unknown one can't be skipped
                 qDebug() << "Nieznany atrybut przedmiotu:" << attribute;
-                // Skip unknown attribute data
-                if (!file.skip(size)) return false;
-                break;
+                return false;
         }
-         if (!file.readU8(nodeType)) return false; // Consume the node type byte
     }
 
-    // Add the created item to the Map at (tileX, tileY, tileZ)
-    // Need to determine the correct layer for the item based on its type/properties.
-    // For now, adding to a default layer (e.g., Layer::Object)
-    // Map::getInstance().addItem(tileX, tileY, Layer::Object, item);
-
-    // Determine the layer based on item properties (requires ItemManager)
-    Layer::Type layer = Layer::Object; // Default to Object layer
-    ItemProperties props = ItemManager::getInstance()->getItem(itemId);
+    return true;
+}
 
-    // Basic layer determination based on common item properties
-    if (props.isGround()) { // Assuming isGround() method exists or can be derived
-        layer = Layer::Ground;
-    } else if (props.isBorder()) { // Assuming isBorder() method exists or can be derived
-        layer = Layer::Border;
-    } else if (props.isWall()) { // Assuming isWall() method exists or can be derived
-        layer = Layer::Wall;
-    } else if (props.isCreature()) { // Assuming isCreature() method exists or can be derived
-        layer = Layer::Creature;
-    } else if (props.isBlocking()) {
-        layer = Layer::Wall; // Or WallDetail, depending on specific item
-    } else if (props.isWalkable()) {
-        layer = Layer::GroundDetail; // Or ObjectDetail
+bool OTBMMapReader::readMapData(OTBMNode& mapData) {
+    // Map attributes are the properties of the map data node
+    quint8 attribute;
+    while (mapData.getU8(attribute)) {
+        switch (attribute) {
+            case OTBM_ATTR_DESCRIPTION:
+                if (!mapData.getString(description)) return false;
+                break;
+            case OTBM_ATTR_EXT_SPAWN_FILE:
+                if (!mapData.getString(spawnFile)) return false;
+                break;
+            case OTBM_ATTR_EXT_HOUSE_FILE:
+                if (!mapData.getString(houseFile)) return false;
+                break;
+            case OTBM_ATTR_EXT_SPAWN_NPC_FILE:
+            {
+                QString npcFile; // Not supported by the Qt port yet
+                if (!mapData.getString(npcFile)) return false;
+                break;
+            }
+            default:
+                qDebug() << "Unknown map data attribute:" << attribute;
+                return false;
+        }
     }
-    // Add more specific checks if needed based on item ID ranges or other properties
 
-    Map::getInstance().addItem(tileX, tileY, layer, item);
+    // Tile areas, towns and waypoints are its children. Tile areas are only indexed here,
+    // moving past one skips its tiles without decoding them.
+    OTBMNode node;
+    for (bool ok = reader.firstChild(mapData, node); ok; ok = reader.nextChild(mapData, node)) {
+        switch (node.type()) {
+            case OTBM_TILE_AREA:
+            {
+                OTBMTileArea area;
+                if (!node.getU16(area.x) || !node.getU16(area.y) || !node.getU8(area.z)) {
+                    qDebug() << "Tile area without a base position.";
+                    return false;
+                }
+                area.offset = node.position();
+                tileAreas.append(area);
+                break;
+            }
+            case OTBM_TOWNS:
+                if (!readTowns(node)) return false;
+                break;
+            case OTBM_WAYPOINTS:
+                if (!readWaypoints(node)) return false;
+                break;
+            default:
+                // The reader skips the whole subtree when moving to the next node
+                qDebug() << "Skipping unknown node type in map data:" << node.type();
+                break;
+        }
+    }
 
-    return true;
+    return !reader.hasError();
 }
 
-bool OTBMFile::writeItem(const Item& item) {
-    if (!file.writeU16(item.getId())) {
-        return false;
+bool OTBMMapReader::readTowns(OTBMNode& townsNode) {
+    OTBMNode town;
+    for (bool ok = reader.firstChild(townsNode, town); ok; ok = reader.nextChild(townsNode, town)) {
+        if (town.type() != OTBM_TOWN) {
+            qDebug() << "Invalid town node type:" << town.type();
+            continue;
+        }
+
+        quint32 townId;
+        QString townName;
+        OTBMTownTemple temple; // Temple position is not kept, but read to validate the node
+        if (!town.getU32(townId) || !town.getString(townName) ||
+            !town.getU16(temple.x) || !town.getU16(temple.y) || !town.getU8(temple.z)) {
+            qDebug() << "Failed to read town data.";
+            return false;
+        }
+        towns[townId] = townName;
     }
 
-    // Write item attributes
-    QMap<QString, QVariant> attributes = item.getAttributes(); // Assuming getAttributes() method exists in Item class
+    return !reader.hasError();
+}
 
-    if (attributes.contains("count")) {
-        if (!file.writeU8(OTBM_ATTR_COUNT) || !file.writeU16(1) || !file.writeU8(attributes.value("count").toUInt())) return false;
-    }
-    if (attributes.contains("actionid")) {
-        if (!file.writeU8(OTBM_ATTR_ACTION_ID) || !file.writeU16(2) || !file.writeU16(attributes.value("actionid").toUInt())) return false;
-    }
-    if (attributes.contains("uid")) {
-        if (!file.writeU8(OTBM_ATTR_UNIQUE_ID) || !file.writeU16(2) || !file.writeU16(attributes.value("uid").toUInt())) return false;
-    }
-    if (attributes.contains("text")) {
-        QString text = attributes.value("text").toString();
-        if (!file.writeU8(OTBM_ATTR_TEXT) || !file.writeU16(text.length()) || !file.writeString(text)) return false;
-    }
-    if (attributes.contains("description")) {
-        QString desc = attributes.value("description").toString();
-        if (!file.writeU8(OTBM_ATTR_DESC) || !file.writeU16(desc.length()) || !file.writeString(desc)) return false;
-    }
-    if (attributes.contains("teleport_dest_x") && attributes.contains("teleport_dest_y") && attributes.contains("teleport_dest_z")) {
-        if (!file.writeU8(OTBM_ATTR_TELE_DEST) || !file.writeU16(5) ||
-            !file.writeU16(attributes.value("teleport_dest_x").toUInt()) ||
-            !file.writeU16(attributes.value("teleport_dest_y").toUInt()) ||
-            !file.writeU8(attributes.value("teleport_dest_z").toUInt())) return false;
-    }
-    if (attributes.contains("depot_id")) {
-        if (!file.writeU8(OTBM_ATTR_DEPOT_ID) || !file.writeU16(2) || !file.writeU16(attributes.value("depot_id").toUInt())) return false;
-    }
-    if (attributes.contains("rune_charges")) {
-        if (!file.writeU8(OTBM_ATTR_RUNE_CHARGES) || !file.writeU16(2) || !file.writeU16(attributes.value("rune_charges").toUInt())) return false;
-    }
-    if (attributes.contains("house_door_id")) {
-        if (!file.writeU8(OTBM_ATTR_HOUSEDOORID) || !file.writeU16(4) || !file.writeU32(attributes.value("house_door_id").toUInt())) return false;
-    }
-    if (attributes.contains("duration")) {
-        if (!file.writeU8(OTBM_ATTR_DURATION) || !file.writeU16(4) || !file.writeU32(attributes.value("duration").toUInt())) return false;
-    }
-    if (attributes.contains("decaying_state")) {
-        if (!file.writeU8(OTBM_ATTR_DECAYING_STATE) || !file.writeU16(1) || !file.writeU8(attributes.value("decaying_state").toUInt())) return false;
-    }
-    if (attributes.contains("written_date")) {
-        if (!file.writeU8(OTBM_ATTR_WRITTENDATE) || !file.writeU16(4) || !file.writeU32(attributes.value("written_date").toUInt())) return false;
-    }
-    if (attributes.contains("written_by")) {
-        QString writtenBy = attributes.value("written_by").toString();
-        if (!file.writeU8(OTBM_ATTR_WRITTENBY) || !file.writeU16(writtenBy.length()) || !file.writeString(writtenBy)) return false;
-    }
-    if (attributes.contains("sleeper_guid")) {
-        if (!file.writeU8(OTBM_ATTR_SLEEPERGUID) || !file.writeU16(4) || !file.writeU32(attributes.value("sleeper_guid").toUInt())) return false;
-    }
-    if (attributes.contains("sleep_start")) {
-        if (!file.writeU8(OTBM_ATTR_SLEEPSTART) || !file.writeU16(4) || !file.writeU32(attributes.value("sleep_start").toUInt())) return false;
-    }
-    if (attributes.contains("charges")) {
-        if (!file.writeU8(OTBM_ATTR_CHARGES) || !file.writeU16(2) || !file.writeU16(attributes.value("charges").toUInt())) return false;
-    }
+bool OTBMMapReader::readWaypoints(OTBMNode& waypointsNode) {
+    OTBMNode waypoint;
+    for (bool ok = reader.firstChild(waypointsNode, waypoint); ok; ok = reader.nextChild(waypointsNode, waypoint)) {
+        if (waypoint.type() != OTBM_WAYPOINT) {
+            qDebug() << "Invalid waypoint node type:" << waypoint.type();
+            continue;
+        }
 
-    // End of item node
-    if (!file.writeU8(0xFF)) {
-        return false;
+        QString name;
+        quint16 x, y;
+        quint8 z;
+        if (!waypoint.getString(name) || !waypoint.getU16(x) || !waypoint.getU16(y) || !waypoint.getU8(z)) {
+            qDebug() << "Failed to read waypoint data.";
+            return false;
+        }
+        waypoints[name] = Position(x, y, z);
     }
 
-    return true;
+    return !reader.hasError();
 }
 
-bool OTBMFile::readMapData() {
-    quint8 nodeType;
-    if (!file.readU8(nodeType) || nodeType != OTBM_MAP_DATA) {
-        qDebug() << "Expected OTBM_MAP_DATA node, but got:" << nodeType;
-        return false;
-    }
+OTBMMapWriter::OTBMMapWriter(const Map* map) : map(map) {
+}
 
-    // Read map dimensions (width, height, depth)
-    quint16 mapWidth, mapHeight;
-    quint8 mapDepth; // Depth is always 16 in OTBM
-    if (!file.readU16(mapWidth) || !file.readU16(mapHeight) || !file.readU8(mapDepth)) {
-        qDebug() << "Failed to read map dimensions.";
-        return false;
+bool OTBMMapWriter::save(const QString& filename, const std::function<void(int)>& progress, const std::function<bool()>& isCanceled) {
+    lastError.clear();
+    buffer.clear();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        lastError = file.errorString();
+        return false;
+    }
+
+    // Identifier and root node: version, size and the items.otb version the map was made for
+    const MapVersion version = map->getVersion();
+    buffer.append("OTBM", 4);
+    startNode(0);
+    addU32(static_cast<quint32>(version.otbm_version));
+    addU16(static_cast<quint16>(map->getSize().width()));
+    addU16(static_cast<quint16>(map->getSize().height()));
+    addU32(static_cast<quint32>(version.client_version_major));
+    addU32(static_cast<quint32>(version.client_version_minor));
+
+    startNode(OTBM_MAP_DATA);
+    if (!map->getDescription().isEmpty()) {
+        addU8(OTBM_ATTR_DESCRIPTION);
+        addString(map->getDescription());
+    }
+    if (!map->getSpawnFile().isEmpty()) {
+        addU8(OTBM_ATTR_EXT_SPAWN_FILE);
+        addString(map->getSpawnFile());
+    }
+    if (!map->getHouseFile().isEmpty()) {
+        addU8(OTBM_ATTR_EXT_HOUSE_FILE);
+        addString(map->getHouseFile());
+    }
+
+    const int width = map->getSize().width();
+    const int height = map->getSize().height();
+    const int columns = (width + TileAreaSize - 1) / TileAreaSize;
+    const int total = columns * ((height + TileAreaSize - 1) / TileAreaSize);
+    int written = 0;
+    for (int baseY = 0; baseY < height; baseY += TileAreaSize) {
+        for (int baseX = 0; baseX < width; baseX += TileAreaSize) {
+            if (isCanceled && isCanceled()) {
+                lastError = QStringLiteral("Cancelled");
+                file.close();
+                return false;
+            }
+            if (!writeTileArea(baseX, baseY) || !flush()) {
+                file.close();
+                return false;
+            }
+            if (progress) {
+                progress(int(qint64(++written) * 100 / total));
+            }
+        }
     }
 
-    // Resize the map in Map class
-    Map::getInstance().resize(mapWidth, mapHeight);
+    writeTowns();
+    writeWaypoints();
+    endNode(); // Map data
+    endNode(); // Root
 
-    // Read map attributes, tile areas, towns, houses, waypoints
-    while (file.peekU8(nodeType) && nodeType != 0xFF) { // Read until end of node
-        if (!file.readU8(nodeType)) return false; // Consume the node type byte
+    const bool ok = flush(true);
+    file.close();
+    return ok;
+}
 
-        switch (nodeType) {
-            case OTBM_ATTR_DESCRIPTION:
-                if (!file.readString(description)) return false;
-                break;
-            case OTBM_ATTR_EXT_SPAWN_FILE:
-                if (!file.readString(spawnFile)) return false;
-                break;
-            case OTBM_ATTR_EXT_HOUSE_FILE:
-                if (!file.readString(houseFile)) return false;
-                break;
-            case OTBM_TILE_AREA:
-                if (!readTileArea()) return false;
-                break;
-            case OTBM_TOWNS:
-                // Read towns
-                while (file.peekU8(nodeType) && nodeType == OTBM_TOWN) {
-                    if (!file.readU8(nodeType)) return false; // Consume OTBM_TOWN node type
-                    quint32 townId;
-                    QString townName;
-                    OTBMTownTemple temple; // Temple position is not stored in OTBMFile, but read to consume bytes
-                    if (!file.readU32(townId) || !file.readString(townName) ||
-                        !file.readU16(temple.x) || !file.readU16(temple.y) || !file.readU8(temple.z)) {
-                        qDebug() << "Failed to read town data.";
-                        return false;
-                    }
-                    towns[townId] = townName; // Store town name
-                }
-                break;
-            case OTBM_HOUSES:
-                // Read houses
-                while (file.peekU8(nodeType) && nodeType == OTBM_HOUSE) {
-                    if (!file.readU8(nodeType)) return false; // Consume OTBM_HOUSE node type
-                    quint32 houseId;
-                    QString houseName;
-                    Position housePosition;
-                    if (!file.readU32(houseId) || !file.readString(houseName) || !file.readPosition(housePosition)) {
-                        qDebug() << "Failed to read house data.";
-                        return false;
+bool OTBMMapWriter::writeTileArea(int baseX, int baseY) {
+    const int right = qMin(baseX + TileAreaSize, map->getSize().width());
+    const int bottom = qMin(baseY + TileAreaSize, map->getSize().height());
+    bool started = false;
+
+    for (int y = baseY; y < bottom; ++y) {
+        for (int x = baseX; x < right; ++x) {
+            bool hasItems = false;
+            for (int z = 0; z < Map::LayerCount && !hasItems; ++z) {
+                const Tile* tile = map->getTile(x, y, z);
+                hasItems = tile && !tile->getItems().isEmpty();
+            }
+            if (!hasItems) {
+                continue;
+            }
+
+            if (!started) {
+                // Empty areas are left out entirely
+                startNode(OTBM_TILE_AREA);
+                addU16(static_cast<quint16>(baseX));
+                addU16(static_cast<quint16>(baseY));
+                addU8(GroundFloor);
+                started = true;
+            }
+
+            startNode(OTBM_TILE);
+            addU8(static_cast<quint8>(x - baseX));
+            addU8(static_cast<quint8>(y - baseY));
+            const Tile* ground = map->getTile(x, y, static_cast<int>(Layer::Ground));
+            if (ground && ground->getMapFlags() != 0) {
+                addU8(OTBM_ATTR_TILE_FLAGS);
+                addU32(ground->getMapFlags());
+            }
+            for (int z = 0; z < Map::LayerCount; ++z) {
+                if (const Tile* tile = map->getTile(x, y, z)) {
+                    for (const Item& item : tile->getItems()) {
+                        writeItem(item);
                     }
-                    houses[houseId] = {houseName, housePosition}; // Store house name and position
                 }
-                break;
-            case OTBM_WAYPOINTS:
-                // Read waypoints
-                while (file.peekU8(nodeType) && nodeType == OTBM_WAYPOINT) {
-                    if (!file.readU8(nodeType)) return false; // Consume OTBM_WAYPOINT node type
-                    QString waypointName;
-                    Position waypointPosition;
-                    if (!file.readString(waypointName) || !file.readPosition(waypointPosition)) {
-                        qDebug() << "Failed to read waypoint data.";
-                        return false;
-                    }
-                    waypoints[waypointName] = waypointPosition; // Store waypoint name and position
+            }
+            endNode();
+        }
+    }
+
+    if (started) {
+        endNode();
+    }
+    return true;
+}
+
+void OTBMMapWriter::writeItem(const Item& item) {
+    startNode(OTBM_ITEM);
+    addU16(static_cast<quint16>(item.getId()));
+
+    // The attributes OTBMMapReader::readItemAttributes() maps to names, in their OTBM encoding.
+    // Anything else goes into the attribute map.
+    const QMap<QString, QVariant>& attributes = item.getAttributes();
+    QSet<QString> written;
+    auto take = [&](const char* key, quint8 attribute) -> const QVariant* {
+        auto it = attributes.constFind(QLatin1String(key));
+        if (it == attributes.constEnd()) {
+            return nullptr;
+        }
+        written.insert(it.key());
+        addU8(attribute);
+        return &it.value();
+    };
+
+    if (const QVariant* value = take("count", OTBM_ATTR_COUNT)) addU8(static_cast<quint8>(value->toUInt()));
+    if (const QVariant* value = take("charges", OTBM_ATTR_CHARGES)) addU16(static_cast<quint16>(value->toUInt()));
+    if (const QVariant* value = take("actionid", OTBM_ATTR_ACTION_ID)) addU16(static_cast<quint16>(value->toUInt()));
+    if (const QVariant* value = take("uid", OTBM_ATTR_UNIQUE_ID)) addU16(static_cast<quint16>(value->toUInt()));
+    if (const QVariant* value = take("text", OTBM_ATTR_TEXT)) addString(value->toString());
+    if (const QVariant* value = take("description", OTBM_ATTR_DESC)) addString(value->toString());
+    if (attributes.contains(QStringLiteral("teleport_dest_x")) && attributes.contains(QStringLiteral("teleport_dest_y"))
+        && attributes.contains(QStringLiteral("teleport_dest_z"))) {
+        const QVariant* x = take("teleport_dest_x", OTBM_ATTR_TELE_DEST);
+        addU16(static_cast<quint16>(x->toUInt()));
+        addU16(static_cast<quint16>(attributes.value(QStringLiteral("teleport_dest_y")).toUInt()));
+        addU8(static_cast<quint8>(attributes.value(QStringLiteral("teleport_dest_z")).toUInt()));
+        written.insert(QStringLiteral("teleport_dest_y"));
+        written.insert(QStringLiteral("teleport_dest_z"));
+    }
+    if (const QVariant* value = take("depot_id", OTBM_ATTR_DEPOT_ID)) addU16(static_cast<quint16>(value->toUInt()));
+    if (const QVariant* value = take("house_door_id", OTBM_ATTR_HOUSEDOORID)) addU8(static_cast<quint8>(value->toUInt()));
+    if (const QVariant* value = take("duration", OTBM_ATTR_DURATION)) addU32(value->toUInt());
+    if (const QVariant* value = take("decaying_state", OTBM_ATTR_DECAYING_STATE)) addU8(static_cast<quint8>(value->toUInt()));
+    if (const QVariant* value = take("written_date", OTBM_ATTR_WRITTENDATE)) addU32(value->toUInt());
+    if (const QVariant* value = take("written_by", OTBM_ATTR_WRITTENBY)) addString(value->toString());
+    if (const QVariant* value = take("sleeper_guid", OTBM_ATTR_SLEEPERGUID)) addU32(value->toUInt());
+    if (const QVariant* value = take("sleep_start", OTBM_ATTR_SLEEPSTART)) addU32(value->toUInt());
+    if (const QVariant* value = take("tier", OTBM_ATTR_TIER)) addU8(static_cast<quint8>(value->toUInt()));
+
+    if (written.size() < attributes.size()) {
+        addU8(OTBM_ATTR_ATTRIBUTE_MAP);
+        addU16(static_cast<quint16>(attributes.size() - written.size()));
+        for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it) {
+            if (written.contains(it.key())) {
+                continue;
+            }
+            addString(it.key());
+            switch (it.value().typeId()) {
+                case QMetaType::Bool:
+                    addU8(AttributeBoolean);
+                    addU8(it.value().toBool() ? 1 : 0);
+                    break;
+                case QMetaType::Int:
+                case QMetaType::UInt:
+                case QMetaType::LongLong:
+                case QMetaType::ULongLong:
+                    addU8(AttributeInteger);
+                    addU32(static_cast<quint32>(it.value().toLongLong()));
+                    break;
+                case QMetaType::Float:
+                case QMetaType::Double:
+                {
+                    addU8(AttributeDouble);
+                    const double value = it.value().toDouble();
+                    quint64 bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    addU64(bits);
+                    break;
                 }
-                break;
-            default:
-                qDebug() << "Unknown node type in map data:" << nodeType;
-                // TODO: Skip unknown node instead of returning false
-                return false;
+                default:
+                    addU8(AttributeString);
+                    addLongString(it.value().toString());
+                    break;
+            }
         }
     }
 
-    // Consume the end node byte (0xFF)
-    if (nodeType != 0xFF) {
-         qDebug() << "Expected end node (0xFF), but got:" << nodeType;
-         return false;
+    endNode();
+}
+
+void OTBMMapWriter::writeTowns() {
+    if (map->getTowns().isEmpty()) {
+        return;
+    }
+    startNode(OTBM_TOWNS);
+    for (auto it = map->getTowns().constBegin(); it != map->getTowns().constEnd(); ++it) {
+        startNode(OTBM_TOWN);
+        addU32(it.key());
+        addString(it.value());
+        // The Qt map doesn't keep temple positions yet
+        addU16(0);
+        addU16(0);
+        addU8(GroundFloor);
+        endNode();
+    }
+    endNode();
+}
+
+void OTBMMapWriter::writeWaypoints() {
+    if (map->getWaypoints().isEmpty()) {
+        return;
     }
+    startNode(OTBM_WAYPOINTS);
+    for (auto it = map->getWaypoints().constBegin(); it != map->getWaypoints().constEnd(); ++it) {
+        startNode(OTBM_WAYPOINT);
+        addString(it.key());
+        addU16(static_cast<quint16>(it.value().x));
+        addU16(static_cast<quint16>(it.value().y));
+        addU8(static_cast<quint8>(it.value().z));
+        endNode();
+    }
+    endNode();
+}
 
-    return true;
+void OTBMMapWriter::startNode(quint8 type) {
+    buffer.append(char(OTBMNodeReader::Start));
+    addU8(type);
 }
 
-bool OTBMFile::load(const QString& filePath) {
-    file.setFileName(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qDebug() << "Failed to open file for reading:" << file.errorString();
-        return false;
+void OTBMMapWriter::endNode() {
+    buffer.append(char(OTBMNodeReader::End));
+}
+
+void OTBMMapWriter::addU8(quint8 value) {
+    // Data bytes that look like markers are escaped
+    if (value >= OTBMNodeReader::Escape) {
+        buffer.append(char(OTBMNodeReader::Escape));
     }
+    buffer.append(char(value));
+}
 
-    // Read OTBM signature
-    quint32 signature;
-    if (!file.readU32(signature) || signature != OTBM_SIGNATURE) {
-        qDebug() << "Invalid OTBM signature.";
-        file.close();
-        return false;
+void OTBMMapWriter::addU16(quint16 value) {
+    addU8(quint8(value));
+    addU8(quint8(value >> 8));
+}
+
+void OTBMMapWriter::addU32(quint32 value) {
+    addU16(quint16(value));
+    addU16(quint16(value >> 16));
+}
+
+void OTBMMapWriter::addU64(quint64 value) {
+    addU32(quint32(value));
+    addU32(quint32(value >> 32));
+}
+
+void OTBMMapWriter::addString(const QString& value) {
+    const QByteArray bytes = value.toUtf8().left(0xFFFF);
+    addU16(static_cast<quint16>(bytes.size()));
+    for (char c : bytes) {
+        addU8(static_cast<quint8>(c));
     }
+}
 
-    // Read OTBM version
-    quint32 versionNum;
-    if (!file.readU32(versionNum)) {
-        qDebug() << "Failed to read OTBM version.";
-        file.close();
-        return false;
+void OTBMMapWriter::addLongString(const QString& value) {
+    const QByteArray bytes = value.toUtf8();
+    addU32(static_cast<quint32>(bytes.size()));
+    for (char c : bytes) {
+        addU8(static_cast<quint8>(c));
     }
-    version = static_cast<OTBMVersion>(versionNum);
+}
 
-    // Read map data
-    if (!readMapData()) {
-        file.close();
+bool OTBMMapWriter::flush(bool force) {
+    if (buffer.isEmpty() || (!force && buffer.size() < WriteBufferSize)) {
+        return true;
+    }
+    if (file.write(buffer) != buffer.size()) {
+        lastError = file.errorString();
         return false;
     }
-
-    file.close();
+    buffer.clear();
     return true;
-}
\ No newline at end of file
+}
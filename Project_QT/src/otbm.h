@@ -1,10 +1,14 @@
 #ifndef OTBM_H
 #define OTBM_H
 
-#include "binaryfile.h"
+#include "otbmnodereader.h"
+#include "map.h"
+#include <QByteArray>
+#include <QFile>
 #include <QMap>
 #include <QVector>
 #include <QString>
+#include <functional>
 
 // Wersje formatu OTBM
 enum OTBMVersion {
@@ -57,7 +61,11 @@ enum OTBMItemAttribute {
     OTBM_ATTR_WRITTENBY = 19,
     OTBM_ATTR_SLEEPERGUID = 20,
     OTBM_ATTR_SLEEPSTART = 21,
-    OTBM_ATTR_CHARGES = 22
+    OTBM_ATTR_CHARGES = 22,
+    OTBM_ATTR_EXT_SPAWN_NPC_FILE = 23,
+    OTBM_ATTR_PODIUMOUTFIT = 40,
+    OTBM_ATTR_TIER = 41,
+    OTBM_ATTR_ATTRIBUTE_MAP = 128
 };
 
 // Struktury danych OTBM
@@ -69,11 +77,20 @@ struct OTBMTeleportDest {
 };
 
 struct OTBMHouseTile {
-    quint8 x;
-    quint8 y;
+    quint16 x;
+    quint16 y;
+    quint8 z;
     quint32 houseId;
 };
 
+// Tile area node found while indexing a map, see OTBMMapReader::open()
+struct OTBMTileArea {
+    quint16 x;
+    quint16 y;
+    quint8 z;
+    qint64 offset; // Start of the node in the file
+};
+
 struct OTBMTownTemple {
     quint16 x;
     quint16 y;
@@ -81,13 +98,22 @@ struct OTBMTownTemple {
 };
 #pragma pack(pop)
 
-class OTBMFile {
+// Reads OTBM maps with OTBMNodeReader into the Map given to the constructor, which doesn't have to
+// be the live one. OTBMMapWriter writes what it reads.
+class OTBMMapReader {
 public:
-    OTBMFile();
-    ~OTBMFile();
+    explicit OTBMMapReader(Map* map);
+    ~OTBMMapReader();
 
     bool load(const QString& filename);
-    bool save(const QString& filename);
+
+    // Reads the header, map attributes, towns and waypoints into the map and indexes the tile areas
+    // without loading them. The file stays open until close(), so areas can then be loaded in any order.
+    bool open(const QString& filename);
+    void close();
+    const QVector<OTBMTileArea>& getTileAreas() const { return tileAreas; }
+    bool loadTileArea(const OTBMTileArea& area);
+    QString errorString() const { return reader.errorString(); }
 
     // Gettery
     quint16 getWidth() const { return width; }
@@ -97,27 +123,21 @@ public:
     QString getSpawnFile() const { return spawnFile; }
     QString getHouseFile() const { return houseFile; }
 
-    // Settery
-    void setWidth(quint16 w) { width = w; }
-    void setHeight(quint16 h) { height = h; }
-    void setVersion(OTBMVersion v) { version = v; }
-    void setDescription(const QString& desc) { description = desc; }
-    void setSpawnFile(const QString& file) { spawnFile = file; }
-    void setHouseFile(const QString& file) { houseFile = file; }
-
 private:
-    bool readHeader();
-    bool writeHeader();
-    bool readMapData();
-    bool writeMapData();
-    bool readTileArea();
-    bool writeTileArea();
-    bool readTile();
-    bool writeTile();
-    bool readItem();
-    bool writeItem();
-
-    BinaryFile file;
+    bool readHeader(OTBMNode& root);
+    bool readMapData(OTBMNode& mapData);
+    bool readTileArea(OTBMNode& area);
+    bool readTile(OTBMNode& tile, quint16 baseX, quint16 baseY, quint8 baseZ);
+    bool readItem(OTBMNode& node, quint16 tileX, quint16 tileY, quint8 tileZ);
+    bool readItemAttributes(OTBMNode& node, Item& item);
+    bool readTowns(OTBMNode& townsNode);
+    bool readWaypoints(OTBMNode& waypointsNode);
+    void placeItem(quint16 x, quint16 y, const Item& item);
+
+    Map* map;
+    OTBMNodeReader reader;
+    QVector<OTBMTileArea> tileAreas;
+
     OTBMVersion version;
     quint16 width;
     quint16 height;
@@ -126,6 +146,42 @@ private:
     QString houseFile;
     QMap<quint32, QString> towns;
     QVector<OTBMHouseTile> houses;
+    QMap<QString, Position> waypoints;
+};
+
+// Writes a Map as an OTBM node tree that OTBMMapReader (and the wx editor) can read back.
+// The Qt map has no floors, every position is written as one tile on the ground floor with the
+// items of all its layers, bottom layer first.
+class OTBMMapWriter {
+public:
+    explicit OTBMMapWriter(const Map* map);
+
+    // 'progress' gets the percentage of tile areas written, 'isCanceled' is polled between them
+    bool save(const QString& filename, const std::function<void(int)>& progress = nullptr,
+              const std::function<bool()>& isCanceled = nullptr);
+    QString errorString() const { return lastError; }
+
+private:
+    void startNode(quint8 type);
+    void endNode();
+    void addU8(quint8 value);
+    void addU16(quint16 value);
+    void addU32(quint32 value);
+    void addU64(quint64 value);
+    void addString(const QString& value);
+    void addLongString(const QString& value);
+    // Hands the buffered bytes to the file once enough have piled up
+    bool flush(bool force = false);
+
+    bool writeTileArea(int baseX, int baseY);
+    void writeItem(const Item& item);
+    void writeTowns();
+    void writeWaypoints();
+
+    const Map* map;
+    QFile file;
+    QByteArray buffer;
+    QString lastError;
 };
 
 #endif // OTBM_H 
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "otbmnodereader.h"
+
+#include <cstring>
+
+bool OTBMNode::getRaw(QByteArray& value, qint64 length)
+{
+    if (length < 0 || size - offset < length) {
+        offset = size;
+        return false;
+    }
+    value = QByteArray(reinterpret_cast<const char*>(data + offset), int(length));
+    offset += length;
+    return true;
+}
+
+bool OTBMNode::getString(QString& value)
+{
+    quint16 length;
+    if (!getU16(length) || size - offset < length) {
+        offset = size;
+        return false;
+    }
+    value = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), length);
+    offset += length;
+    return true;
+}
+
+bool OTBMNode::getLongString(QString& value)
+{
+    quint32 length;
+    if (!getU32(length) || quint64(size - offset) < length) {
+        offset = size;
+        return false;
+    }
+    value = QString::fromUtf8(reinterpret_cast<const char*>(data + offset), qsizetype(length));
+    offset += length;
+    return true;
+}
+
+bool OTBMNode::skip(qint64 length)
+{
+    if (length < 0 || size - offset < length) {
+        offset = size;
+        return false;
+    }
+    offset += length;
+    return true;
+}
+
+OTBMNodeReader::OTBMNodeReader()
+    : base(nullptr),
+      length(0),
+      lastPos(0)
+{
+}
+
+OTBMNodeReader::~OTBMNodeReader()
+{
+    close();
+}
+
+bool OTBMNodeReader::open(const QString& filename, const char* identifier)
+{
+    close();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+
+    length = file.size();
+    base = file.map(0, length);
+    if (!base) {
+        // Not mappable (e.g. a resource or a pipe), read it in one block instead
+        buffer = file.readAll();
+        file.close();
+        if (buffer.size() != length) {
+            return fail(QStringLiteral("Could not read %1").arg(filename));
+        }
+        base = reinterpret_cast<const uchar*>(buffer.constData());
+    }
+
+    if (length < 5) {
+        return fail(QStringLiteral("File is too short"));
+    }
+    static const char wildcard[4] = {0, 0, 0, 0};
+    if (std::memcmp(base, wildcard, 4) != 0 && std::memcmp(base, identifier, 4) != 0) {
+        return fail(QStringLiteral("Unknown file identifier"));
+    }
+    return true;
+}
+
+void OTBMNodeReader::close()
+{
+    if (file.isOpen()) {
+        if (base && buffer.isEmpty()) {
+            file.unmap(const_cast<uchar*>(base));
+        }
+        file.close();
+    }
+    buffer.clear();
+    base = nullptr;
+    length = 0;
+    lastPos = 0;
+    lastError.clear();
+}
+
+bool OTBMNodeReader::readRoot(OTBMNode& root)
+{
+    if (!base) {
+        return fail(QStringLiteral("No file is open"));
+    }
+    if (base[4] != Start) {
+        return fail(QStringLiteral("Missing root node"));
+    }
+    return readNode(4, root);
+}
+
+bool OTBMNodeReader::readNodeAt(qint64 offset, OTBMNode& node)
+{
+    if (!base) {
+        return fail(QStringLiteral("No file is open"));
+    }
+    if (offset < 4 || offset >= length || base[offset] != Start) {
+        return fail(QStringLiteral("No node starts at offset %1").arg(offset));
+    }
+    return readNode(offset, node);
+}
+
+bool OTBMNodeReader::firstChild(OTBMNode& parent, OTBMNode& child)
+{
+    return readSibling(parent.childrenPos, parent, child);
+}
+
+bool OTBMNodeReader::nextChild(OTBMNode& parent, OTBMNode& child)
+{
+    const qint64 pos = child.endPos >= 0 ? child.endPos : skipChildren(child.childrenPos);
+    if (pos < 0) {
+        return false;
+    }
+    return readSibling(pos, parent, child);
+}
+
+bool OTBMNodeReader::readSibling(qint64 pos, OTBMNode& parent, OTBMNode& child)
+{
+    if (hasError()) {
+        return false;
+    }
+    if (pos >= length) {
+        return fail(QStringLiteral("Unexpected end of file"));
+    }
+
+    if (base[pos] == End) {
+        // Every child was walked, the parent's own end is known now
+        parent.endPos = pos + 1;
+        return false;
+    }
+    if (base[pos] != Start) {
+        return fail(QStringLiteral("Syntax error at offset %1").arg(pos));
+    }
+    return readNode(pos, child);
+}
+
+bool OTBMNodeReader::readNode(qint64 pos, OTBMNode& node)
+{
+    lastPos = pos;
+
+    // Properties run until the next unescaped start or end marker
+    const qint64 begin = pos + 1;
+    qint64 p = begin;
+    while (p < length && base[p] < Escape) {
+        ++p;
+    }
+
+    if (p < length && base[p] == Escape) {
+        // Slow path: copy the runs between escapes into the node's own buffer
+        node.unescaped.clear();
+        qint64 run = begin;
+        while (p < length && base[p] != Start && base[p] != End) {
+            if (base[p] == Escape) {
+                node.unescaped.append(reinterpret_cast<const char*>(base + run), int(p - run));
+                if (++p >= length) {
+                    break;
+                }
+                run = p; // the escaped byte starts the next run
+            }
+            ++p;
+        }
+        node.unescaped.append(reinterpret_cast<const char*>(base + run), int(qMin(p, length) - run));
+        node.data = reinterpret_cast<const uchar*>(node.unescaped.constData());
+        node.size = node.unescaped.size();
+    } else {
+        node.data = base + begin;
+        node.size = p - begin;
+    }
+
+    if (p >= length) {
+        return fail(QStringLiteral("Unexpected end of file"));
+    }
+    if (node.size == 0) {
+        return fail(QStringLiteral("Node without a type at offset %1").arg(pos));
+    }
+
+    node.nodeType = node.data[0];
+    node.offset = 1;
+    node.startPos = pos;
+    node.childrenPos = p;
+    node.endPos = -1;
+    return true;
+}
+
+qint64 OTBMNodeReader::skipChildren(qint64 pos)
+{
+    int depth = 0;
+    qint64 p = pos;
+    while (p < length) {
+        const uchar c = base[p];
+        if (c < Escape) {
+            ++p;
+        } else if (c == Escape) {
+            p += 2;
+        } else if (c == Start) {
+            ++depth;
+            ++p;
+        } else if (depth == 0) {
+            return p + 1;
+        } else {
+            --depth;
+            ++p;
+        }
+    }
+    fail(QStringLiteral("Unexpected end of file"));
+    return -1;
+}
+
+bool OTBMNodeReader::fail(const QString& message)
+{
+    if (lastError.isEmpty()) {
+        lastError = message;
+    }
+    return false;
+}
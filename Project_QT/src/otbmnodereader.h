@@ -0,0 +1,131 @@
+#ifndef OTBMNODEREADER_H
+#define OTBMNODEREADER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QtEndian>
+#include <QtGlobal>
+
+class OTBMNodeReader;
+
+/**
+ * @brief One node of an OTBM (or OTB) file: its type and its unescaped property bytes.
+ * Fields are decoded straight from memory as little-endian values. When the properties
+ * contain no escaped bytes, which is the common case, the node points into the mapped
+ * file and nothing is copied; otherwise they are unescaped once into a buffer the node
+ * keeps, so reusing one OTBMNode for all siblings of a loop also reuses that buffer.
+ */
+class OTBMNode
+{
+public:
+    OTBMNode() = default;
+
+    quint8 type() const { return nodeType; }
+    // File offset of the node's start marker, for OTBMNodeReader::readNodeAt()
+    qint64 position() const { return startPos; }
+
+    bool getU8(quint8& value) { return get(value); }
+    bool getU16(quint16& value) { return get(value); }
+    bool getU32(quint32& value) { return get(value); }
+    bool getU64(quint64& value) { return get(value); }
+    // u16 length followed by that many bytes, decoded as UTF-8
+    bool getString(QString& value);
+    // u32 length followed by that many bytes, decoded as UTF-8
+    bool getLongString(QString& value);
+    bool getRaw(QByteArray& value, qint64 length);
+    bool skip(qint64 length);
+
+    // True once every property byte has been read
+    bool atEnd() const { return offset >= size; }
+
+private:
+    Q_DISABLE_COPY(OTBMNode)
+
+    template <typename T>
+    bool get(T& value)
+    {
+        if (size - offset < qint64(sizeof(T))) {
+            offset = size;
+            return false;
+        }
+        value = qFromLittleEndian<T>(data + offset);
+        offset += sizeof(T);
+        return true;
+    }
+
+    const uchar* data = nullptr; // properties, the type byte included
+    qint64 size = 0;
+    qint64 offset = 0;
+    quint8 nodeType = 0;
+
+    qint64 startPos = 0;
+    qint64 childrenPos = 0; // file offset of the first child's start marker or of our end marker
+    qint64 endPos = -1; // file offset just past our end marker, -1 until our children were walked
+    QByteArray unescaped;
+
+    friend class OTBMNodeReader;
+};
+
+/**
+ * @brief Reads the node tree of an OTBM file the way the wx editor's BinaryNode does,
+ * without a virtual I/O call per field.
+ * The whole file is memory mapped (or read in one block when mapping isn't possible) and
+ * nodes are framed by scanning for the start/end markers with escape handling. Children
+ * are walked with firstChild()/nextChild(); children that weren't walked are skipped
+ * without decoding them.
+ *
+ *     OTBMNode tile;
+ *     for (bool ok = reader.firstChild(area, tile); ok; ok = reader.nextChild(area, tile)) { ... }
+ *     if (reader.hasError()) ...
+ */
+class OTBMNodeReader
+{
+public:
+    enum Marker : uchar {
+        Escape = 0xFD,
+        Start = 0xFE,
+        End = 0xFF
+    };
+
+    OTBMNodeReader();
+    ~OTBMNodeReader();
+
+    // Opens 'filename' and checks its 4 byte identifier, "\0\0\0\0" is accepted for any identifier
+    bool open(const QString& filename, const char* identifier);
+    void close();
+
+    bool readRoot(OTBMNode& root);
+    // Reads the first child of 'parent', false when it has none or on error
+    bool firstChild(OTBMNode& parent, OTBMNode& child);
+    // Replaces 'child' with its next sibling, false after the last one or on error
+    bool nextChild(OTBMNode& parent, OTBMNode& child);
+    // Reads the node starting at 'offset' (an earlier OTBMNode::position()), so indexed nodes
+    // can be revisited in any order; its children are walked with firstChild() as usual
+    bool readNodeAt(qint64 offset, OTBMNode& node);
+
+    bool hasError() const { return !lastError.isEmpty(); }
+    QString errorString() const { return lastError; }
+
+    qint64 size() const { return length; }
+    // Offset of the last node read, for progress reporting
+    qint64 position() const { return lastPos; }
+
+private:
+    Q_DISABLE_COPY(OTBMNodeReader)
+
+    bool readNode(qint64 pos, OTBMNode& node);
+    bool readSibling(qint64 pos, OTBMNode& parent, OTBMNode& child);
+    // Offset just past the end marker of the node whose children start at 'pos', -1 on error
+    qint64 skipChildren(qint64 pos);
+    bool fail(const QString& message);
+
+    QFile file;
+    QByteArray buffer; // file contents when the file couldn't be mapped
+    const uchar* base;
+    qint64 length;
+    qint64 lastPos;
+    QString lastError;
+};
+
+#endif // OTBMNODEREADER_H
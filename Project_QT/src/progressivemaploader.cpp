@@ -0,0 +1,144 @@
+#include "progressivemaploader.h"
+#include "otbm.h"
+#include "map.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+
+namespace {
+    // Tiles of an area are stored as u8 offsets from its base position. The Qt map has no
+    // floors yet, so areas of every floor cover the same rectangle.
+    QRect areaRect(const OTBMTileArea& area)
+    {
+        return QRect(area.x, area.y, 256, 256);
+    }
+
+    // Distance in tiles between the edges of two rectangles, 0 when they overlap
+    int distanceBetween(const QRect& a, const QRect& b)
+    {
+        const int dx = qMax(0, qMax(a.left() - b.right(), b.left() - a.right()));
+        const int dy = qMax(0, qMax(a.top() - b.bottom(), b.top() - a.bottom()));
+        return qMax(dx, dy);
+    }
+}
+
+ProgressiveMapLoader::ProgressiveMapLoader(Map* map, QObject* parent)
+    : QObject(parent),
+      map(map),
+      file(new OTBMMapReader(map)),
+      loadedCount(0)
+{
+    timer.setInterval(0); // One slice per event loop pass
+    connect(&timer, &QTimer::timeout, this, &ProgressiveMapLoader::loadNextSlice);
+}
+
+ProgressiveMapLoader::~ProgressiveMapLoader()
+{
+    cancel();
+    delete file;
+}
+
+bool ProgressiveMapLoader::open(const QString& filename)
+{
+    cancel();
+    lastError.clear();
+
+    if (!file->open(filename)) {
+        lastError = file->errorString();
+        if (lastError.isEmpty()) {
+            lastError = tr("'%1' is not a valid OTBM map.").arg(filename);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ProgressiveMapLoader::start(const QRect& focus)
+{
+    const QVector<OTBMTileArea>& areas = file->getTileAreas();
+
+    QVector<int> distance(areas.size());
+    queue.clear();
+    queue.reserve(areas.size());
+    loadedCount = 0;
+    for (int i = 0; i < areas.size(); ++i) {
+        const QRect rect = areaRect(areas[i]);
+        distance[i] = distanceBetween(focus, rect);
+        queue.append(i);
+        map->addPendingArea(rect);
+    }
+
+    // Farthest first so the next area to load is always taken from the back; stable, so
+    // areas at the same distance keep their file order
+    std::stable_sort(queue.begin(), queue.end(), [&distance](int a, int b) {
+        return distance[a] > distance[b];
+    });
+
+    // Whatever is on screen is there before we return
+    while (!queue.isEmpty() && distance[queue.last()] == 0) {
+        if (!loadArea(areas[queue.takeLast()])) {
+            finish(false);
+            return false;
+        }
+    }
+
+    // Finishing (even with nothing left) always happens from the event loop
+    timer.start();
+    return true;
+}
+
+void ProgressiveMapLoader::cancel()
+{
+    if (timer.isActive() || !queue.isEmpty()) {
+        timer.stop();
+        queue.clear();
+        map->clearPendingAreas();
+    }
+    file->close();
+}
+
+void ProgressiveMapLoader::loadNextSlice()
+{
+    const QVector<OTBMTileArea>& areas = file->getTileAreas();
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (!queue.isEmpty() && elapsed.elapsed() < SliceMilliseconds) {
+        if (!loadArea(areas[queue.takeLast()])) {
+            finish(false);
+            return;
+        }
+    }
+
+    emit progressChanged(areas.isEmpty() ? 100 : int(qint64(loadedCount) * 100 / areas.size()));
+    if (queue.isEmpty()) {
+        finish(true);
+    }
+}
+
+bool ProgressiveMapLoader::loadArea(const OTBMTileArea& area)
+{
+    if (!file->loadTileArea(area)) {
+        lastError = file->errorString();
+        if (lastError.isEmpty()) {
+            lastError = tr("Corrupt tile area at %1, %2, %3.").arg(area.x).arg(area.y).arg(area.z);
+        }
+        return false;
+    }
+    ++loadedCount;
+    map->markAreaLoaded(areaRect(area));
+    return true;
+}
+
+void ProgressiveMapLoader::finish(bool success)
+{
+    timer.stop();
+    queue.clear();
+    file->close();
+    map->clearPendingAreas();
+    if (!success) {
+        qDebug() << "Progressive map load failed:" << lastError;
+    }
+    emit finished(success);
+}
@@ -0,0 +1,64 @@
+#ifndef PROGRESSIVEMAPLOADER_H
+#define PROGRESSIVEMAPLOADER_H
+
+#include <QObject>
+#include <QRect>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+class Map;
+class OTBMMapReader;
+struct OTBMTileArea;
+
+/**
+ * @brief Loads an OTBM map into a Map, starting with the part that is on screen.
+ *
+ * open() reads the map header, towns and waypoints and indexes the tile area nodes by
+ * their base position. start() then loads the areas intersecting the given focus
+ * rectangle right away and streams in the others, nearest first, in short slices from
+ * the event loop, so the view can be drawn and used while the rest arrives. Every area
+ * that is not loaded yet is registered as pending in the Map, which blocks edits on it.
+ */
+class ProgressiveMapLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProgressiveMapLoader(Map* map, QObject* parent = nullptr);
+    ~ProgressiveMapLoader();
+
+    // Opens 'filename' and sets the map size; no tiles are loaded yet
+    bool open(const QString& filename);
+    // Loads the areas intersecting 'focus' and schedules the remaining ones
+    bool start(const QRect& focus);
+    // Stops streaming and closes the file; areas that weren't loaded stay empty
+    void cancel();
+
+    bool isRunning() const { return timer.isActive(); }
+    QString errorString() const { return lastError; }
+
+signals:
+    void progressChanged(int percent);
+    void finished(bool success);
+
+private slots:
+    void loadNextSlice();
+
+private:
+    Q_DISABLE_COPY(ProgressiveMapLoader)
+
+    bool loadArea(const OTBMTileArea& area);
+    void finish(bool success);
+
+    static const int SliceMilliseconds = 8; // Time spent loading per event loop pass
+
+    Map* map;
+    OTBMMapReader* file;
+    QVector<int> queue; // Indexes into the tile area index, nearest to the focus last
+    int loadedCount;
+    QTimer timer;
+    QString lastError;
+};
+
+#endif // PROGRESSIVEMAPLOADER_H
@@ -146,7 +146,7 @@ void SelectionBrush::applySelection(MapView* view, const QRect& newRect, bool is
     if (mainWin && mainWin->getUndoStack()) {
         // Need to encapsulate a complex selection change in a QUndoCommand
         // For simplicity, directly modify Map state (and Map::selectionChanged signal takes care of MapScene visual)
-        // If SelectionCommand supported setting explicit set of points (like Map::selectedPositions) it would be used here.
+        // If SelectionCommand supported setting explicit set of points (like Map::getSelectionRegion()) it would be used here.
     }
 
     if (selectionMode == Replace) {
@@ -191,49 +191,34 @@ void SelectionBrush::drawPreview(QPainter& painter, const QPoint& pos, double zo
     // painter.drawPixmap(pos.x(), pos.y(), icon.pixmap(32, 32)); // Example.
 }
 
-// Global selection operations: (move, rotate, flip) - often pushed onto undo stack.
-// These methods will act on the currently `Map::getSelection()`.
+// Global selection operations: (move, rotate, flip) - pushed onto the undo stack.
+// These methods act on the current `Map::getSelectionRegion()`; the moved area stays selected.
 void SelectionBrush::moveSelection(MapView* view, const QPoint& offset, bool copy)
 {
     if (!view->getMap() || view->getMap()->getSelection().isEmpty()) return;
-    
-    // For Undo/Redo, this would wrap `Map::moveSelection` in a command.
-    // e.g. `mainWin->getUndoStack()->push(new MoveSelectionCommand(view->getMap(), view->getMap()->getSelection(), offset, copy));`
-    view->getMap()->moveSelection(offset, copy); // Actual map data modification (placeholder for full logic).
-    view->getMap()->setModified(true);
-    view->getMap()->clearSelection(); // Clear visual selection after transform for effect.
-    view->getScene()->update(); // Force visual update.
-    qDebug() << "SelectionBrush: Moved selection by" << offset << ", copy:" << copy << ". (Stub logic).";
+    view->transformSelection(view->getMap()->moveTransform(offset), copy, copy ? tr("Copy Selection") : tr("Move Selection"));
+    qDebug() << "SelectionBrush: Moved selection by" << offset << ", copy:" << copy;
 }
 
 void SelectionBrush::rotateSelection(MapView* view, int degrees)
 {
     if (!view->getMap() || view->getMap()->getSelection().isEmpty()) return;
-    view->getMap()->rotateSelection(degrees); // Placeholder for actual rotation logic.
-    view->getMap()->setModified(true);
-    view->getMap()->clearSelection();
-    view->getScene()->update();
-    qDebug() << "SelectionBrush: Rotated selection by" << degrees << "degrees. (Stub logic).";
+    view->transformSelection(view->getMap()->rotateTransform(degrees), false, tr("Rotate Selection"));
+    qDebug() << "SelectionBrush: Rotated selection by" << degrees << "degrees.";
 }
 
 void SelectionBrush::flipSelectionHorizontally(MapView* view)
 {
     if (!view->getMap() || view->getMap()->getSelection().isEmpty()) return;
-    view->getMap()->flipSelectionHorizontally(); // Placeholder for actual flip logic.
-    view->getMap()->setModified(true);
-    view->getMap()->clearSelection();
-    view->getScene()->update();
-    qDebug() << "SelectionBrush: Flipped selection horizontally. (Stub logic).";
+    view->transformSelection(view->getMap()->flipTransform(Qt::Horizontal), false, tr("Flip Selection"));
+    qDebug() << "SelectionBrush: Flipped selection horizontally.";
 }
 
 void SelectionBrush::flipSelectionVertically(MapView* view)
 {
     if (!view->getMap() || view->getMap()->getSelection().isEmpty()) return;
-    view->getMap()->flipSelectionVertically(); // Placeholder for actual flip logic.
-    view->getMap()->setModified(true);
-    view->getMap()->clearSelection();
-    view->getScene()->update();
-    qDebug() << "SelectionBrush: Flipped selection vertically. (Stub logic).";
+    view->transformSelection(view->getMap()->flipTransform(Qt::Vertical), false, tr("Flip Selection"));
+    qDebug() << "SelectionBrush: Flipped selection vertically.";
 }
 
 void SelectionBrush::copySelection(MapView* view)
@@ -94,7 +94,7 @@ signals:
 
 private:
     QRect currentSelection; // The bounding rectangle of the tiles currently *dragged* for selection (for display).
-    // The actual set of selected positions (QSet<QPoint>) is managed by the Map class (`Map::selectedPositions`).
+    // The actual set of selected positions (a SelectionRegion) is managed by the Map class (`Map::getSelectionRegion()`).
     QPoint startDragPos; // The mouse position (tile coordinates) when selection drag started.
     bool isDragging;        // Whether a mouse drag for selection is currently active.
     SelectionMode selectionMode; // Current selection mode.
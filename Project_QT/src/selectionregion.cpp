@@ -0,0 +1,195 @@
+#include "selectionregion.h"
+
+#include <QtAlgorithms> // qPopulationCount
+
+SelectionRegion::SelectionRegion()
+    : tileCount(0),
+      boundsDirty(false)
+{
+}
+
+void SelectionRegion::clear()
+{
+    chunks.clear();
+    tileCount = 0;
+    cachedBounds = QRect();
+    boundsDirty = false;
+}
+
+bool SelectionRegion::contains(int x, int y) const
+{
+    auto it = chunks.constFind(chunkKey(chunkOf(x), chunkOf(y)));
+    if (it == chunks.constEnd()) {
+        return false;
+    }
+    const int bit = x & (ChunkSize - 1);
+    return (it->rows[y & (ChunkSize - 1)] >> bit) & 1;
+}
+
+QRect SelectionRegion::boundingRect() const
+{
+    if (!boundsDirty) {
+        return cachedBounds;
+    }
+
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    bool first = true;
+    for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it) {
+        const int baseX = chunkX(it.key()) * ChunkSize;
+        const int baseY = chunkY(it.key()) * ChunkSize;
+        for (int row = 0; row < ChunkSize; ++row) {
+            const quint64 bits = it->rows[row];
+            if (!bits) continue;
+
+            const int left = baseX + qCountTrailingZeroBits(bits);
+            const int right = baseX + ChunkSize - 1 - qCountLeadingZeroBits(bits);
+            const int y = baseY + row;
+            if (first) {
+                minX = left; maxX = right; minY = y; maxY = y;
+                first = false;
+            } else {
+                minX = qMin(minX, left); maxX = qMax(maxX, right);
+                minY = qMin(minY, y); maxY = qMax(maxY, y);
+            }
+        }
+    }
+
+    cachedBounds = first ? QRect() : QRect(QPoint(minX, minY), QPoint(maxX, maxY));
+    boundsDirty = false;
+    return cachedBounds;
+}
+
+void SelectionRegion::applySpan(int y, int x0, int x1, Op op)
+{
+    if (x1 < x0) return;
+
+    const int cy = chunkOf(y);
+    const int row = y & (ChunkSize - 1);
+    for (int cx = chunkOf(x0); cx <= chunkOf(x1); ++cx) {
+        const int chunkLeft = cx * ChunkSize;
+        const int from = qMax(x0, chunkLeft) - chunkLeft;
+        const int to = qMin(x1, chunkLeft + ChunkSize - 1) - chunkLeft;
+        const quint64 mask = spanMask(from, to);
+
+        const quint64 key = chunkKey(cx, cy);
+        auto it = chunks.find(key);
+        if (it == chunks.end()) {
+            if (op == Op::Clear) continue;
+            it = chunks.insert(key, Chunk());
+        }
+
+        quint64& word = it->rows[row];
+        const int before = qPopulationCount(word);
+        switch (op) {
+            case Op::Set: word |= mask; break;
+            case Op::Clear: word &= ~mask; break;
+            case Op::Flip: word ^= mask; break;
+        }
+        const int delta = qPopulationCount(word) - before;
+        it->count += delta;
+        tileCount += delta;
+        if (it->count == 0) {
+            chunks.erase(it);
+        }
+    }
+    boundsDirty = true;
+}
+
+void SelectionRegion::applyRect(const QRect& rect, Op op)
+{
+    const QRect r = rect.normalized();
+    if (r.isEmpty()) return;
+
+    for (int y = r.top(); y <= r.bottom(); ++y) {
+        applySpan(y, r.left(), r.right(), op);
+    }
+}
+
+void SelectionRegion::applyRegion(const SelectionRegion& other, Op op)
+{
+    if (&other == this) {
+        if (op != Op::Set) clear();
+        return;
+    }
+
+    // Both regions share the same chunk grid, so this is plain word arithmetic.
+    for (auto src = other.chunks.constBegin(); src != other.chunks.constEnd(); ++src) {
+        auto it = chunks.find(src.key());
+        if (it == chunks.end()) {
+            if (op == Op::Clear) continue;
+            chunks.insert(src.key(), src.value());
+            tileCount += src->count;
+            continue;
+        }
+
+        int count = 0;
+        for (int row = 0; row < ChunkSize; ++row) {
+            quint64& word = it->rows[row];
+            switch (op) {
+                case Op::Set: word |= src->rows[row]; break;
+                case Op::Clear: word &= ~src->rows[row]; break;
+                case Op::Flip: word ^= src->rows[row]; break;
+            }
+            count += qPopulationCount(word);
+        }
+        tileCount += count - it->count;
+        it->count = count;
+        if (count == 0) {
+            chunks.erase(it);
+        }
+    }
+    boundsDirty = true;
+}
+
+SelectionRegion SelectionRegion::intersected(const QRect& clip) const
+{
+    SelectionRegion result;
+    const QRect r = clip.normalized();
+    forEachSpan([&](int y, int x0, int x1) {
+        if (y < r.top() || y > r.bottom()) return;
+        result.addSpan(y, qMax(x0, r.left()), qMin(x1, r.right()));
+    });
+    return result;
+}
+
+SelectionRegion SelectionRegion::translated(const QPoint& offset) const
+{
+    SelectionRegion result;
+    forEachSpan([&](int y, int x0, int x1) {
+        result.addSpan(y + offset.y(), x0 + offset.x(), x1 + offset.x());
+    });
+    return result;
+}
+
+bool SelectionRegion::operator==(const SelectionRegion& other) const
+{
+    if (tileCount != other.tileCount || chunks.size() != other.chunks.size()) {
+        return false;
+    }
+    for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it) {
+        auto theirs = other.chunks.constFind(it.key());
+        if (theirs == other.chunks.constEnd()) {
+            return false;
+        }
+        for (int row = 0; row < ChunkSize; ++row) {
+            if (it->rows[row] != theirs->rows[row]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+QVector<quint64> SelectionRegion::sortedKeys() const
+{
+    QVector<quint64> keys;
+    keys.reserve(chunks.size());
+    for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it) {
+        keys.append(it.key());
+    }
+    std::sort(keys.begin(), keys.end(), [](quint64 a, quint64 b) {
+        if (chunkY(a) != chunkY(b)) return chunkY(a) < chunkY(b);
+        return chunkX(a) < chunkX(b);
+    });
+    return keys;
+}
@@ -0,0 +1,131 @@
+#ifndef SELECTIONREGION_H
+#define SELECTIONREGION_H
+
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+#include <QtAlgorithms> // qCountTrailingZeroBits
+#include <QtGlobal>
+#include <algorithm>
+
+/**
+ * @brief The SelectionRegion class is a set of map positions stored as per-chunk bitsets.
+ * The map is cut into 64x64 chunks, each row of a chunk is one 64-bit word, so selecting a
+ * large rectangle costs a few words per row instead of one hash node per tile.
+ * Rectangles and other regions can be added, subtracted and toggled (xor) directly, and
+ * consumers walk the result as horizontal spans rather than as individual points.
+ */
+class SelectionRegion
+{
+public:
+    static const int ChunkShift = 6;
+    static const int ChunkSize = 1 << ChunkShift; // 64, one quint64 per chunk row
+
+    SelectionRegion();
+
+    bool isEmpty() const { return tileCount == 0; }
+    qint64 count() const { return tileCount; }
+    // Bounding box of all selected positions, empty QRect when nothing is selected
+    QRect boundingRect() const;
+
+    bool contains(int x, int y) const;
+    bool contains(const QPoint& point) const { return contains(point.x(), point.y()); }
+
+    void clear();
+
+    // Set algebra with rectangles
+    void addRect(const QRect& rect) { applyRect(rect, Op::Set); }
+    void subtractRect(const QRect& rect) { applyRect(rect, Op::Clear); }
+    void toggleRect(const QRect& rect) { applyRect(rect, Op::Flip); }
+
+    // Single positions
+    void add(const QPoint& point) { applySpan(point.y(), point.x(), point.x(), Op::Set); }
+    void remove(const QPoint& point) { applySpan(point.y(), point.x(), point.x(), Op::Clear); }
+    void toggle(const QPoint& point) { applySpan(point.y(), point.x(), point.x(), Op::Flip); }
+    void addSpan(int y, int x0, int x1) { applySpan(y, x0, x1, Op::Set); }
+
+    // Set algebra with other regions, done word by word
+    void unite(const SelectionRegion& other) { applyRegion(other, Op::Set); }
+    void subtract(const SelectionRegion& other) { applyRegion(other, Op::Clear); }
+    void toggle(const SelectionRegion& other) { applyRegion(other, Op::Flip); }
+    SelectionRegion intersected(const QRect& clip) const;
+
+    // Copy of the region moved by 'offset'
+    SelectionRegion translated(const QPoint& offset) const;
+
+    // Calls fn(y, x0, x1) for every horizontal run of selected positions (x1 inclusive).
+    // Runs never cross a chunk border; chunks are visited top to bottom, left to right.
+    template <typename F>
+    void forEachSpan(F fn) const;
+
+    // Calls fn(x, y) for every selected position
+    template <typename F>
+    void forEachPoint(F fn) const;
+
+    bool operator==(const SelectionRegion& other) const;
+    bool operator!=(const SelectionRegion& other) const { return !(*this == other); }
+
+private:
+    enum class Op { Set, Clear, Flip };
+
+    struct Chunk {
+        quint64 rows[ChunkSize] = {};
+        int count = 0;
+    };
+
+    static quint64 chunkKey(int cx, int cy) {
+        return (static_cast<quint64>(static_cast<quint32>(cy)) << 32) | static_cast<quint32>(cx);
+    }
+    static int chunkX(quint64 key) { return static_cast<qint32>(static_cast<quint32>(key)); }
+    static int chunkY(quint64 key) { return static_cast<qint32>(static_cast<quint32>(key >> 32)); }
+    // Floor division, positions may be negative while a selection is dragged
+    static int chunkOf(int v) { return v >> ChunkShift; }
+    static quint64 spanMask(int from, int to) {
+        // Bits [from, to] set, both within [0, 63]
+        const quint64 upper = (to == ChunkSize - 1) ? ~quint64(0) : ((quint64(1) << (to + 1)) - 1);
+        return upper & ~((quint64(1) << from) - 1);
+    }
+
+    void applySpan(int y, int x0, int x1, Op op);
+    void applyRect(const QRect& rect, Op op);
+    void applyRegion(const SelectionRegion& other, Op op);
+    QVector<quint64> sortedKeys() const;
+
+    QHash<quint64, Chunk> chunks;
+    qint64 tileCount;
+    mutable QRect cachedBounds;
+    mutable bool boundsDirty;
+};
+
+template <typename F>
+void SelectionRegion::forEachSpan(F fn) const
+{
+    for (quint64 key : sortedKeys()) {
+        const Chunk& chunk = *chunks.constFind(key);
+        const int baseX = chunkX(key) * ChunkSize;
+        const int baseY = chunkY(key) * ChunkSize;
+        for (int row = 0; row < ChunkSize; ++row) {
+            quint64 bits = chunk.rows[row];
+            while (bits) {
+                const int start = qCountTrailingZeroBits(bits);
+                const quint64 shifted = bits >> start;
+                const int length = (~shifted == 0) ? (ChunkSize - start) : qCountTrailingZeroBits(~shifted);
+                fn(baseY + row, baseX + start, baseX + start + length - 1);
+                bits = (start + length >= ChunkSize) ? 0 : (bits & ~spanMask(start, start + length - 1));
+            }
+        }
+    }
+}
+
+template <typename F>
+void SelectionRegion::forEachPoint(F fn) const
+{
+    forEachSpan([&fn](int y, int x0, int x1) {
+        for (int x = x0; x <= x1; ++x) {
+            fn(x, y);
+        }
+    });
+}
+
+#endif // SELECTIONREGION_H
@@ -4,18 +4,37 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QBuffer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtEndian>
+
+namespace {
+    const int SpriteSize = 32;
+    const int SpritePixels = SpriteSize * SpriteSize;
+    const int DefaultSpriteCacheKB = 64 * 1024;
+}
 
 TibiaFileHandler::TibiaFileHandler(QObject *parent)
     : QObject(parent)
+    , m_sprMap(nullptr)
+    , m_sprSize(0)
+    , m_spriteCount(0)
+    , m_sprTableOffset(0)
+    , m_sprTransparency(false)
+    , m_spriteCache(DefaultSpriteCacheKB)
     , m_spriteManager(new SpriteManager(this))
 {
     // Initialize default client version
     m_clientVersion = {0, "Unknown"};
+
+    // Prefetching is a background nicety, leave most cores to the UI and the loaders
+    m_prefetchPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
 }
 
 TibiaFileHandler::~TibiaFileHandler()
 {
     // Cleanup is handled by Qt's parent-child hierarchy
+    unloadSprFile();
 }
 
 bool TibiaFileHandler::loadDatFile(const QString &filename)
@@ -52,54 +71,65 @@ bool TibiaFileHandler::loadDatFile(const QString &filename)
     return true;
 }
 
-bool TibiaFileHandler::loadSprFile(const QString &filename)
+bool TibiaFileHandler::loadSprFile(const QString &filename, bool extended, bool transparency)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) {
+    unloadSprFile();
+
+    m_sprFile.setFileName(filename);
+    if (!m_sprFile.open(QIODevice::ReadOnly)) {
         emit errorOccurred(tr("Cannot open SPR file: %1").arg(filename));
         return false;
     }
 
-    QDataStream in(&file);
-    in.setByteOrder(QDataStream::LittleEndian);
-
-    if (!readSprHeader(in)) {
+    // Signature followed by the sprite count, then one u32 offset per sprite
+    const int countSize = extended ? 4 : 2;
+    const QByteArray header = m_sprFile.read(4 + countSize);
+    if (header.size() != 4 + countSize) {
         emit errorOccurred(tr("Invalid SPR file format"));
-        file.close();
+        m_sprFile.close();
         return false;
     }
+    const uchar *counter = reinterpret_cast<const uchar *>(header.constData()) + 4;
+    m_spriteCount = extended ? qFromLittleEndian<quint32>(counter) : qFromLittleEndian<quint16>(counter);
+    m_sprTableOffset = 4 + countSize;
+    m_sprTransparency = transparency;
+    m_sprSize = m_sprFile.size();
 
-    // Read sprite data
-    for (quint32 i = 0; i < m_sprHeader.spriteCount; ++i) {
-        // Read sprite data
-        SpriteData sprite;
-        
-        // Read width and height
-        in >> sprite.width >> sprite.height;
-        
-        // Read pixel data (format depends on SPR version)
-        quint32 dataSize;
-        in >> dataSize;
-        
-        sprite.data.resize(dataSize);
-        in.readRawData(sprite.data.data(), dataSize);
-        
-        // Store sprite
-        m_sprites[i] = sprite;
-        
-        // Update progress
-        if (i % 100 == 0) {
-            emit progressChanged(i, m_sprHeader.spriteCount, 
-                              tr("Loading sprites: %1/%2").arg(i).arg(m_sprHeader.spriteCount));
-        }
+    if (m_sprTableOffset + qint64(m_spriteCount) * 4 > m_sprSize) {
+        emit errorOccurred(tr("Invalid SPR file format"));
+        unloadSprFile();
+        return false;
     }
 
-    file.close();
-    emit progressChanged(m_sprHeader.spriteCount, m_sprHeader.spriteCount, 
+    // Pages of the mapping are only read in when a sprite on them is decoded. If the file
+    // can't be mapped, readSpriteDump() seeks instead.
+    m_sprMap = m_sprFile.map(0, m_sprSize);
+
+    emit progressChanged(m_spriteCount, m_spriteCount,
                         tr("Sprites loaded successfully"));
     return true;
 }
 
+void TibiaFileHandler::unloadSprFile()
+{
+    m_prefetchPool.clear();
+    m_prefetchPool.waitForDone();
+
+    {
+        QMutexLocker locker(&m_spriteCacheMutex);
+        m_spriteCache.clear();
+    }
+
+    QMutexLocker locker(&m_sprFileMutex);
+    if (m_sprMap) {
+        m_sprFile.unmap(const_cast<uchar *>(m_sprMap));
+        m_sprMap = nullptr;
+    }
+    m_sprFile.close();
+    m_sprSize = 0;
+    m_spriteCount = 0;
+}
+
 bool TibiaFileHandler::loadOtbFile(const QString &filename)
 {
     QFile file(filename);
@@ -137,26 +167,123 @@ bool TibiaFileHandler::loadOtbFile(const QString &filename)
 
 QImage TibiaFileHandler::getSprite(quint32 spriteId) const
 {
-    if (!m_sprites.contains(spriteId)) {
+    {
+        QMutexLocker locker(&m_spriteCacheMutex);
+        if (const QImage *cached = m_spriteCache.object(spriteId)) {
+            return *cached;
+        }
+    }
+
+    QByteArray dump;
+    if (!readSpriteDump(spriteId, dump)) {
         qWarning() << "Sprite ID not found:" << spriteId;
         return QImage();
     }
-    
-    // Lazy-load the image if not already loaded
-    SpriteData &sprite = const_cast<SpriteData&>(m_sprites[spriteId]);
-    if (!sprite.loaded) {
-        // Convert raw sprite data to QImage
-        // Implementation depends on the sprite format
-        // sprite.image = convertSpriteData(sprite.data, sprite.width, sprite.height);
-        sprite.loaded = true;
-    }
-    
-    return sprite.image;
+
+    // Decoded outside the lock, two threads racing for the same sprite just decode it twice
+    const QImage image = decodeSprite(dump);
+    QMutexLocker locker(&m_spriteCacheMutex);
+    m_spriteCache.insert(spriteId, new QImage(image), qMax<qsizetype>(1, image.sizeInBytes() / 1024));
+    return image;
 }
 
 bool TibiaFileHandler::hasSprite(quint32 spriteId) const
 {
-    return m_sprites.contains(spriteId);
+    return spriteId >= 1 && spriteId <= m_spriteCount;
+}
+
+void TibiaFileHandler::prefetchSprites(const QVector<quint32> &spriteIds)
+{
+    if (m_spriteCount == 0 || spriteIds.isEmpty()) {
+        return;
+    }
+
+    m_prefetchPool.start([this, spriteIds]() {
+        for (quint32 spriteId : spriteIds) {
+            {
+                QMutexLocker locker(&m_spriteCacheMutex);
+                if (m_spriteCache.contains(spriteId)) {
+                    continue;
+                }
+            }
+            getSprite(spriteId);
+        }
+    });
+}
+
+void TibiaFileHandler::setSpriteCacheLimit(int kilobytes)
+{
+    QMutexLocker locker(&m_spriteCacheMutex);
+    m_spriteCache.setMaxCost(qMax(1, kilobytes));
+}
+
+bool TibiaFileHandler::readSpriteDump(quint32 spriteId, QByteArray &dump) const
+{
+    if (!hasSprite(spriteId)) {
+        return false;
+    }
+
+    const qint64 entry = m_sprTableOffset + qint64(spriteId - 1) * 4;
+    if (m_sprMap) {
+        const quint32 offset = qFromLittleEndian<quint32>(m_sprMap + entry);
+        if (offset == 0) {
+            dump.clear(); // Empty sprite
+            return true;
+        }
+        // 3 bytes of colour key, then the size of the compressed pixels
+        if (qint64(offset) + 5 > m_sprSize) {
+            return false;
+        }
+        const quint16 size = qFromLittleEndian<quint16>(m_sprMap + offset + 3);
+        if (qint64(offset) + 5 + size > m_sprSize) {
+            return false;
+        }
+        dump = QByteArray::fromRawData(reinterpret_cast<const char *>(m_sprMap + offset + 5), size);
+        return true;
+    }
+
+    QMutexLocker locker(&m_sprFileMutex);
+    uchar field[4];
+    if (!m_sprFile.seek(entry) || m_sprFile.read(reinterpret_cast<char *>(field), 4) != 4) {
+        return false;
+    }
+    const quint32 offset = qFromLittleEndian<quint32>(field);
+    if (offset == 0) {
+        dump.clear();
+        return true;
+    }
+    if (!m_sprFile.seek(qint64(offset) + 3) || m_sprFile.read(reinterpret_cast<char *>(field), 2) != 2) {
+        return false;
+    }
+    const quint16 size = qFromLittleEndian<quint16>(field);
+    dump = m_sprFile.read(size);
+    return dump.size() == size;
+}
+
+QImage TibiaFileHandler::decodeSprite(const QByteArray &dump) const
+{
+    QImage image(SpriteSize, SpriteSize, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+
+    // Runs of transparent pixels followed by runs of RGB (or RGBA) pixels, row by row
+    QRgb *pixels = reinterpret_cast<QRgb *>(image.bits());
+    const uchar *data = reinterpret_cast<const uchar *>(dump.constData());
+    const int size = dump.size();
+    const int bpp = m_sprTransparency ? 4 : 3;
+    int read = 0;
+    int write = 0;
+    while (read + 4 <= size && write < SpritePixels) {
+        const int transparent = qFromLittleEndian<quint16>(data + read);
+        const int colored = qFromLittleEndian<quint16>(data + read + 2);
+        read += 4;
+        write += transparent;
+        for (int i = 0; i < colored && write < SpritePixels && read + bpp <= size; ++i) {
+            const int alpha = m_sprTransparency ? data[read + 3] : 0xFF;
+            pixels[write++] = qRgba(data[read], data[read + 1], data[read + 2], alpha);
+            read += bpp;
+        }
+    }
+    return image;
 }
 
 const TibiaFileHandler::ItemProperties* TibiaFileHandler::getItemProperties(quint16 itemId) const
@@ -195,24 +322,6 @@ bool TibiaFileHandler::readDatHeader(QDataStream &in)
     return true;
 }
 
-bool TibiaFileHandler::readSprHeader(QDataStream &in)
-{
-    // Read SPR header based on the specific format version
-    // This is a simplified version - adjust according to actual format
-    quint32 signature;
-    in >> signature;
-    
-    if (signature != 0x4D4D4D4D) { // Example signature
-        return false;
-    }
-    
-    in >> m_sprHeader.version
-       >> m_sprHeader.spriteCount
-       >> m_sprHeader.spriteSize;
-    
-    return true;
-}
-
 bool TibiaFileHandler::readOtbHeader(QDataStream &in)
 {
     // Read OTB header based on the specific format version
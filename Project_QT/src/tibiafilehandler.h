@@ -7,6 +7,9 @@
 #include <QVector>
 #include <QImage>
 #include <QMap>
+#include <QCache>
+#include <QMutex>
+#include <QThreadPool>
 #include <QDebug>
 
 // Forward declarations
@@ -22,12 +25,23 @@ public:
 
     // File loading methods
     bool loadDatFile(const QString &filename);
-    bool loadSprFile(const QString &filename);
+    // Only the header is read here, sprites are decoded from the file when first asked for.
+    // 'extended' files (client 9.60+) store the sprite count as u32, 'transparency' ones
+    // store an alpha byte per pixel.
+    bool loadSprFile(const QString &filename, bool extended = true, bool transparency = false);
+    void unloadSprFile();
     bool loadOtbFile(const QString &filename);
 
-    // Sprite access
+    // Sprite access, ids start at 1. Safe to call from any thread.
     QImage getSprite(quint32 spriteId) const;
     bool hasSprite(quint32 spriteId) const;
+    quint32 getSpriteCount() const { return m_spriteCount; }
+
+    // Decodes the given sprites into the cache on a worker thread, e.g. the ones about to be
+    // shown, so getSprite() finds them ready
+    void prefetchSprites(const QVector<quint32> &spriteIds);
+    // Upper bound of the decoded sprite cache, least recently used sprites are dropped first
+    void setSpriteCacheLimit(int kilobytes);
 
     // Item properties access
     struct ItemProperties {
@@ -71,22 +85,31 @@ private:
         quint32 projectileCount;
     };
 
-    struct SpriteData {
-        QByteArray data;
-        quint32 width;
-        quint32 height;
-        QImage image;
-        bool loaded;
-    };
-
     // File format specific readers
     bool readDatHeader(QDataStream &in);
-    bool readSprHeader(QDataStream &in);
     bool readOtbHeader(QDataStream &in);
 
+    // Compressed pixels of one sprite, read from the mapped file (or from disk when it isn't mapped)
+    bool readSpriteDump(quint32 spriteId, QByteArray &dump) const;
+    QImage decodeSprite(const QByteArray &dump) const;
+
     // Data storage
     QMap<quint16, ItemProperties> m_items;
-    QMap<quint32, SpriteData> m_sprites;
+
+    // Sprite file, indexed through its offset table; nothing is read per sprite at load
+    mutable QFile m_sprFile;
+    const uchar *m_sprMap;
+    qint64 m_sprSize;
+    quint32 m_spriteCount;
+    int m_sprTableOffset; // File offset of the offset table
+    bool m_sprTransparency;
+    mutable QMutex m_sprFileMutex; // Serializes seek/read when the file couldn't be mapped
+
+    // Decoded sprites, cost in kilobytes
+    mutable QCache<quint32, QImage> m_spriteCache;
+    mutable QMutex m_spriteCacheMutex;
+    QThreadPool m_prefetchPool;
+
     QMap<quint16, quint16> m_clientToServerMap;
     QMap<quint16, quint16> m_serverToClientMap;
     ClientVersion m_clientVersion;
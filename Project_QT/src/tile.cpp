@@ -208,6 +208,13 @@ void Tile::clearItems()
     }
 }
 
+void Tile::setItems(const QVector<Item>& newItems)
+{
+    items = newItems;
+    emit itemsChanged();
+    emit changed();
+}
+
 void Tile::draw(QPainter& painter, const QPointF& offset, double zoom, bool showCollisions) const
 {
     // This function acts as the composite renderer for the tile,
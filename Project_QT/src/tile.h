@@ -85,6 +85,7 @@ public:
     void addItem(const Item& item); // Adds a COPY of the item for local tile storage (as in original)
     void removeItem(const Item& item);
     void clearItems();
+    void setItems(const QVector<Item>& newItems); // Replaces the whole stack, order included (undo)
     const QVector<Item>& getItems() const { return items; } // Returns a const ref to the internal list of items
 
     // Drawing the tile content for a QPainter (replacing SFML drawing logic)
@@ -0,0 +1,82 @@
+#include "transformselectioncommand.h"
+#include "tile.h"
+
+TransformSelectionCommand::TransformSelectionCommand(Map* map, const Map::SelectionTransform& transform, bool copy, const QString& text, QUndoCommand* parent)
+    : MapCommand(text, parent)
+    , map(map)
+    , transform(transform)
+    , copy(copy)
+{
+    if (!map || !transform) {
+        return;
+    }
+
+    selectionBefore = map->getSelectionRegion();
+    const QRect mapRect(QPoint(0, 0), map->getSize());
+    selectionBefore.forEachPoint([&](int x, int y) {
+        const QPoint to = transform(x, y);
+        if (mapRect.contains(to)) {
+            area.add(QPoint(x, y));
+            area.add(to);
+        }
+    });
+    before = snapshot();
+}
+
+QVector<TransformSelectionCommand::LayerContents> TransformSelectionCommand::snapshot() const {
+    QVector<LayerContents> contents;
+    area.forEachPoint([&](int x, int y) {
+        for (int z = 0; z < Map::LayerCount; ++z) {
+            const Tile* tile = map->getTile(x, y, z);
+            if (tile && !tile->getItems().isEmpty()) {
+                contents.append({ QPoint(x, y), z, tile->getItems() });
+            }
+        }
+    });
+    return contents;
+}
+
+void TransformSelectionCommand::restore(const QVector<LayerContents>& contents, const SelectionRegion& selection) {
+    area.forEachPoint([&](int x, int y) {
+        for (int z = 0; z < Map::LayerCount; ++z) {
+            if (Tile* tile = map->getTile(x, y, z)) {
+                tile->clearItems();
+            }
+        }
+    });
+    for (const LayerContents& entry : contents) {
+        if (Tile* tile = map->getTile(entry.pos.x(), entry.pos.y(), entry.z)) {
+            for (const Item& item : entry.items) {
+                tile->addItem(item);
+            }
+        }
+    }
+
+    map->setSelectionRegion(selection);
+    map->setModified(true);
+    map->notifyAreaChanged(area.boundingRect());
+}
+
+void TransformSelectionCommand::undo() {
+    if (!map || area.isEmpty()) {
+        return;
+    }
+    restore(before, selectionBefore);
+}
+
+void TransformSelectionCommand::redo() {
+    if (!map || area.isEmpty()) {
+        return;
+    }
+
+    if (!applied) {
+        // First run does the real work, later ones replay its result
+        map->relocateSelection(transform, copy);
+        selectionAfter = map->getSelectionRegion();
+        after = snapshot();
+        transform = nullptr;
+        applied = true;
+    } else {
+        restore(after, selectionAfter);
+    }
+}
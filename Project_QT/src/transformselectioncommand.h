@@ -0,0 +1,44 @@
+#ifndef TRANSFORMSELECTIONCOMMAND_H
+#define TRANSFORMSELECTIONCOMMAND_H
+
+#include "mapcommand.h"
+#include "map.h"
+#include "selectionregion.h"
+#include <QList>
+#include <QPoint>
+#include <QVector>
+
+// Moves, copies, rotates or flips the selection through Map::relocateSelection.
+// Before the first redo it keeps every layer of both the source and the destination positions,
+// so undo puts back what was moved as well as whatever the move overwrote.
+class TransformSelectionCommand : public MapCommand
+{
+public:
+    TransformSelectionCommand(Map* map, const Map::SelectionTransform& transform, bool copy, const QString& text, QUndoCommand* parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    struct LayerContents {
+        QPoint pos;
+        int z;
+        QList<Item> items;
+    };
+
+    QVector<LayerContents> snapshot() const;
+    void restore(const QVector<LayerContents>& contents, const SelectionRegion& selection);
+
+    Map* map;
+    Map::SelectionTransform transform;
+    bool copy;
+    bool applied = false;
+
+    SelectionRegion area; // Sources and destinations, everything relocateSelection may change
+    SelectionRegion selectionBefore;
+    SelectionRegion selectionAfter;
+    QVector<LayerContents> before; // Non-empty layers only, the rest of 'area' was empty
+    QVector<LayerContents> after;
+};
+
+#endif // TRANSFORMSELECTIONCOMMAND_H
@@ -169,6 +169,13 @@ void Action::commit(DirtyList* dirty_list) {
 					}
 				}
 
+				if (editor.map.isUnreadable(pos.x, pos.y)) {
+					// The tiles there are stuck in the page cache file, the change would write over them
+					c->clear();
+					++it;
+					continue;
+				}
+
 				Tile* oldtile = editor.map.swapTile(pos, newtile);
 				TileLocation* location = newtile->getLocation();
 
@@ -178,6 +185,7 @@ void Action::commit(DirtyList* dirty_list) {
 				}
 
 				newtile->update();
+				editor.map.statistics.onTileSwapped(oldtile, newtile);
 
 				// std::cout << "\tSwitched tile at " << pos.x << ";" << pos.y << ";" << pos.z << " from " << (void*)oldtile << " to " << *data <<  std::endl;
 				if (newtile->isSelected()) {
@@ -196,6 +204,11 @@ void Action::commit(DirtyList* dirty_list) {
 						if (house) {
 							house->addTile(newtile);
 						}
+					} else if (newtile->isHouseTile()) {
+						House* house = editor.map.houses.getHouse(newtile->getHouseID());
+						if (house) {
+							house->updateTile(newtile);
+						}
 					}
 					if (oldtile->spawn) {
 						if (newtile->spawn) {
@@ -318,7 +331,15 @@ void Action::undo(DirtyList* dirty_list) {
 					}
 				}
 
+				if (editor.map.isUnreadable(pos.x, pos.y)) {
+					// The tiles there are stuck in the page cache file, the change would write over them
+					c->clear();
+					++it;
+					continue;
+				}
+
 				Tile* newtile = editor.map.swapTile(pos, oldtile);
+				editor.map.statistics.onTileSwapped(newtile, oldtile);
 
 				// Update server side change list (for broadcast)
 				if (editor.IsLiveServer() && dirty_list) {
@@ -346,6 +367,11 @@ void Action::undo(DirtyList* dirty_list) {
 					if (house) {
 						house->addTile(oldtile);
 					}
+				} else if (oldtile->isHouseTile()) {
+					House* house = editor.map.houses.getHouse(oldtile->getHouseID());
+					if (house) {
+						house->updateTile(oldtile);
+					}
 				}
 
 				if (oldtile->spawn) {
@@ -33,6 +33,8 @@
 
 #include "materials.h"
 #include "map.h"
+#include "map_image_exporter.h"
+#include "thumbnail_atlas.h"
 #include "complexitem.h"
 #include "creature.h"
 
@@ -42,6 +44,7 @@
 #include <wx/datetime.h>
 #include <wx/filename.h>
 #include <wx/stdpaths.h>
+#include <wx/tokenzr.h>
 
 #include <wx/snglinst.h>
 
@@ -135,6 +138,7 @@ bool Application::OnInit() {
 	FixVersionDiscrapencies();
 	g_gui.LoadHotkeys();
 	ClientVersion::loadVersions();
+	ParseCommandLineExport();
 
 	// Initialize dark mode manager
 	g_darkMode.Initialize();
@@ -146,7 +150,7 @@ bool Application::OnInit() {
 	m_file_to_open = wxEmptyString;
 	ParseCommandLineMap(m_file_to_open);
 	
-	if (g_settings.getInteger(Config::ONLY_ONE_INSTANCE) && m_single_instance_checker->IsAnotherRunning()) {
+	if (m_export_args.empty() && g_settings.getInteger(Config::ONLY_ONE_INSTANCE) && m_single_instance_checker->IsAnotherRunning()) {
 		RMEProcessClient client;
 		wxConnectionBase* connection = client.MakeConnection("localhost", "rme_host", "rme_talk");
 		if (connection) {
@@ -228,7 +232,9 @@ bool Application::OnInit() {
 	}
 
 	// Show welcome dialog with color-shifted bitmap
-	if (g_settings.getInteger(Config::WELCOME_DIALOG) == 1 && m_file_to_open == wxEmptyString) {
+	if (!m_export_args.empty()) {
+		// Exporting from the command line, the main window stays hidden
+	} else if (g_settings.getInteger(Config::WELCOME_DIALOG) == 1 && m_file_to_open == wxEmptyString) {
 		g_gui.ShowWelcomeDialog(iconBitmap);
 	} else {
 		g_gui.root->Show();
@@ -238,7 +244,7 @@ bool Application::OnInit() {
 	wxIdleEvent::SetMode(wxIDLE_PROCESS_SPECIFIED);
 
 	// Goto RME website?
-	if (g_settings.getInteger(Config::GOTO_WEBSITE_ON_BOOT) == 1) {
+	if (m_export_args.empty() && g_settings.getInteger(Config::GOTO_WEBSITE_ON_BOOT) == 1) {
 		::wxLaunchDefaultBrowser(__SITE_URL__, wxBROWSER_NEW_WINDOW);
 		g_settings.setInteger(Config::GOTO_WEBSITE_ON_BOOT, 0);
 	}
@@ -278,6 +284,12 @@ void Application::OnEventLoopEnter(wxEventLoopBase* loop) {
 	}
 	m_startup = false;
 
+	if (!m_export_args.empty()) {
+		m_export_failed = !RunImageExport();
+		ExitMainLoop();
+		return;
+	}
+
 	// Don't try to create a map if we didn't load the client map.
 	if (ClientVersion::getLatestVersion() == nullptr) {
 		return;
@@ -308,6 +320,11 @@ void Application::OnEventLoopEnter(wxEventLoopBase* loop) {
 	}
 }
 
+int Application::OnRun() {
+	const int result = wxApp::OnRun();
+	return m_export_failed ? EXIT_FAILURE : result;
+}
+
 void Application::MacOpenFiles(const wxArrayString& fileNames) {
 	if (!fileNames.IsEmpty()) {
 		g_gui.LoadMap(FileName(fileNames.Item(0)));
@@ -350,6 +367,7 @@ void Application::Unload() {
 }
 
 int Application::OnExit() {
+	g_thumbnails.clear();
 #ifdef _USE_PROCESS_COM
 	wxDELETE(m_proc_server);
 	wxDELETE(m_single_instance_checker);
@@ -407,6 +425,105 @@ bool Application::ParseCommandLineMap(wxString& fileName) {
 	return false;
 }
 
+bool Application::ParseCommandLineExport() {
+	if (argc < 2 || wxString(argv[1]) != "-export-image") {
+		return false;
+	}
+
+	for (int i = 2; i < argc; ++i) {
+		m_export_args.push_back(wxString(argv[i]));
+	}
+	if (m_export_args.empty()) {
+		// Still quit instead of opening the editor
+		m_export_args.push_back(wxEmptyString);
+	}
+	return true;
+}
+
+bool Application::RunImageExport() {
+	static const char* usage = "Usage: -export-image <map> <folder> [-floors <first>[-<last>]] [-area <x1>,<y1>,<x2>,<y2>] [-zoom <1|2|4|8>] [-tiles] [-no-lower-floors]";
+
+	if (m_export_args.size() < 2 || m_export_args[0].empty()) {
+		std::cerr << usage << std::endl;
+		return false;
+	}
+
+	long first_floor = GROUND_LAYER, last_floor = GROUND_LAYER;
+	long zoom = 1;
+	long area[4] = { 0, 0, 0, 0 };
+	bool has_area = false;
+	bool tiles = false;
+	bool lower_floors = true;
+
+	for (size_t i = 2; i < m_export_args.size(); ++i) {
+		const wxString& arg = m_export_args[i];
+		const bool has_value = i + 1 < m_export_args.size();
+		bool ok = true;
+		if (arg == "-floors" && has_value) {
+			const wxString value = m_export_args[++i];
+			ok = value.BeforeFirst('-').ToLong(&first_floor);
+			if (ok && value.Find('-') != wxNOT_FOUND) {
+				ok = value.AfterFirst('-').ToLong(&last_floor);
+			} else {
+				last_floor = first_floor;
+			}
+		} else if (arg == "-area" && has_value) {
+			wxStringTokenizer tokenizer(m_export_args[++i], ",");
+			for (int n = 0; n < 4 && ok; ++n) {
+				ok = tokenizer.HasMoreTokens() && tokenizer.GetNextToken().ToLong(&area[n]);
+			}
+			has_area = ok;
+		} else if (arg == "-zoom" && has_value) {
+			ok = m_export_args[++i].ToLong(&zoom) && zoom >= 1 && zoom <= MapImageExporter::MAX_ZOOM;
+		} else if (arg == "-tiles") {
+			tiles = true;
+		} else if (arg == "-no-lower-floors") {
+			lower_floors = false;
+		} else {
+			ok = false;
+		}
+
+		if (!ok) {
+			std::cerr << "Bad argument \"" << arg << "\"." << std::endl
+					  << usage << std::endl;
+			return false;
+		}
+	}
+
+	Editor* editor;
+	try {
+		editor = newd Editor(g_gui.copybuffer, FileName(m_export_args[0]));
+	} catch (std::runtime_error& e) {
+		std::cerr << e.what() << std::endl;
+		return false;
+	}
+
+	MapImageExporter exporter(editor->map, tiles ? MapImageExporter::FORMAT_TILES : MapImageExporter::FORMAT_PNG, zoom, lower_floors);
+
+	int min_x = area[0], min_y = area[1], max_x = area[2], max_y = area[3];
+	if (!has_area && !exporter.getUsedArea(first_floor, last_floor, min_x, min_y, max_x, max_y)) {
+		std::cerr << "The floors to export are empty." << std::endl;
+		delete editor;
+		return false;
+	}
+
+	const wxString folder = m_export_args[1];
+	bool ok = wxFileName::Mkdir(folder, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+	if (ok) {
+		ok = exporter.exportArea(FileName::DirName(folder), FileName(m_export_args[0]).GetName(), std::min(min_x, max_x), std::min(min_y, max_y), std::max(min_x, max_x), std::max(min_y, max_y), first_floor, last_floor);
+		if (ok) {
+			std::cout << "Exported floors " << first_floor << " to " << last_floor << " of " << m_export_args[0] << " into " << folder << "." << std::endl;
+		} else {
+			std::cerr << exporter.getError() << std::endl;
+		}
+	} else {
+		std::cerr << "Could not create the folder \"" << folder << "\"." << std::endl;
+	}
+
+	delete editor;
+	return ok;
+}
+
 MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& size) :
 	wxFrame((wxFrame*)nullptr, -1, title, pos, size, wxDEFAULT_FRAME_STYLE) {
 	// Receive idle events
@@ -460,6 +577,7 @@ MainFrame::~MainFrame() = default;
 
 void MainFrame::OnIdle(wxIdleEvent& event) {
 	g_gui.CheckAutoSave();
+	g_gui.TrimMapPages();
 	event.Skip();
 }
 
@@ -40,6 +40,7 @@ public:
 	~Application();
 	virtual bool OnInit();
 	virtual void OnEventLoopEnter(wxEventLoopBase* loop);
+	virtual int OnRun();
 	virtual void MacOpenFiles(const wxArrayString& fileNames);
 	virtual int OnExit();
 	virtual bool OnExceptionInMainLoop();
@@ -51,6 +52,12 @@ private:
 	void FixVersionDiscrapencies();
 	bool ParseCommandLineMap(wxString& fileName);
 
+	// -export-image <map> <folder> [options], renders the map to images and quits without a window
+	wxArrayString m_export_args;
+	bool m_export_failed = false;
+	bool ParseCommandLineExport();
+	bool RunImageExport();
+
 	virtual void OnFatalException();
 
 #ifdef _USE_PROCESS_COM
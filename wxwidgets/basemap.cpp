@@ -20,9 +20,12 @@
 #include "tile.h"
 #include "basemap.h"
 
+std::atomic<uint64_t> BaseMap::revision_counter(0);
+
 BaseMap::BaseMap() :
 	allocator(),
 	tilecount(0),
+	revision(++revision_counter),
 	root(*this) {
 	////
 }
@@ -42,6 +45,35 @@ void BaseMap::clear(bool del) {
 	}
 }
 
+void BaseMap::setPageBudget(uint64_t bytes) {
+	if (bytes == 0) {
+		if (pager) {
+			// Leaves that couldn't be read back only exist in the cache file, which goes with the pager
+			if (pager->pageInAll()) {
+				pager.reset();
+			} else {
+				pager->setBudget(0);
+			}
+		}
+		return;
+	}
+	if (!pager) {
+		pager.reset(newd MapPager(*this));
+		if (!pager->isOk()) {
+			// No cache file, keep everything in memory
+			pager.reset();
+			return;
+		}
+	}
+	pager->setBudget(bytes);
+}
+
+void BaseMap::trimPages() {
+	if (pager) {
+		pager->trim();
+	}
+}
+
 void BaseMap::clearVisible(uint32_t mask) {
 	root.clearVisible(mask);
 }
@@ -132,6 +164,148 @@ Tile* BaseMap::swapTile(int x, int y, int z, Tile* newtile) {
 	return leaf->setTile(x, y, z, newtile);
 }
 
+void BaseMap::getLeaves(std::vector<QTreeNode*>& leaves, uint16_t floor_mask) {
+	collectLeaves(&root, floor_mask, leaves);
+}
+
+void BaseMap::collectLeaves(QTreeNode* node, uint16_t floor_mask, std::vector<QTreeNode*>& leaves) {
+	for (int index = 0; index < MAP_LAYERS; ++index) {
+		QTreeNode* child = node->child[index];
+		if (!child || (child->floor_mask & floor_mask) == 0) {
+			continue;
+		}
+		if (child->isLeaf) {
+			child->use();
+			leaves.push_back(child);
+		} else {
+			collectLeaves(child, floor_mask, leaves);
+		}
+	}
+}
+
+void BaseMap::onTileAdded(int x, int y, int z, bool first_in_leaf) {
+	{
+		std::lock_guard<std::mutex> lock(floor_index_mutex);
+		FloorIndex& index = floor_index[z];
+		if (index.tiles++ == 0) {
+			index.min_x = index.max_x = x;
+			index.min_y = index.max_y = y;
+			index.stale = false;
+		} else if (!index.stale) {
+			index.min_x = std::min(index.min_x, x);
+			index.min_y = std::min(index.min_y, y);
+			index.max_x = std::max(index.max_x, x);
+			index.max_y = std::max(index.max_y, y);
+		}
+	}
+
+	if (first_in_leaf) {
+		// Adding can only set bits, no need to look at the siblings
+		const uint16_t bit = 1 << z;
+		QTreeNode* node = &root;
+		uint32_t cx = x, cy = y;
+		while (node) {
+			node->floor_mask |= bit;
+			if (node->isLeaf) {
+				break;
+			}
+			node = node->child[((cx & 0xC000) >> 14) | ((cy & 0xC000) >> 12)];
+			cx <<= 2;
+			cy <<= 2;
+		}
+	}
+}
+
+void BaseMap::onTileRemoved(int x, int y, int z, bool last_in_leaf) {
+	{
+		std::lock_guard<std::mutex> lock(floor_index_mutex);
+		FloorIndex& index = floor_index[z];
+		if (--index.tiles == 0) {
+			index = FloorIndex();
+		} else if (x == index.min_x || x == index.max_x || y == index.min_y || y == index.max_y) {
+			index.stale = true;
+		}
+	}
+
+	if (last_in_leaf) {
+		updateFloorMasks(x, y);
+	}
+}
+
+void BaseMap::updateFloorMasks(int x, int y) {
+	QTreeNode* path[8];
+	int depth = 0;
+
+	QTreeNode* node = &root;
+	uint32_t cx = x, cy = y;
+	while (node && depth < 8) {
+		path[depth++] = node;
+		if (node->isLeaf) {
+			break;
+		}
+		node = node->child[((cx & 0xC000) >> 14) | ((cy & 0xC000) >> 12)];
+		cx <<= 2;
+		cy <<= 2;
+	}
+
+	// Bottom up, every node is the union of its children
+	for (int i = depth - 1; i >= 0; --i) {
+		QTreeNode* current = path[i];
+		uint16_t mask = 0;
+		for (int j = 0; j < MAP_LAYERS; ++j) {
+			if (current->isLeaf) {
+				mask |= current->occupancy[j] ? (1 << j) : 0;
+			} else if (current->child[j]) {
+				mask |= current->child[j]->floor_mask;
+			}
+		}
+		current->floor_mask = mask;
+	}
+}
+
+bool BaseMap::getFloorBounds(int z, Position& min_pos, Position& max_pos) {
+	// Held through the rebuild, so two threads never rebuild at once and edits wait for it
+	std::lock_guard<std::mutex> lock(floor_index_mutex);
+	const FloorIndex& index = floor_index[z];
+	if (index.tiles == 0) {
+		return false;
+	}
+	if (index.stale) {
+		rebuildFloorBounds(z);
+	}
+
+	min_pos = Position(index.min_x, index.min_y, z);
+	max_pos = Position(index.max_x, index.max_y, z);
+	return true;
+}
+
+void BaseMap::rebuildFloorBounds(int z) {
+	std::vector<QTreeNode*> leaves;
+	getLeaves(leaves, 1 << z);
+
+	FloorIndex& index = floor_index[z];
+	index.min_x = index.min_y = std::numeric_limits<int>::max();
+	index.max_x = index.max_y = -1;
+	for (QTreeNode* leaf : leaves) {
+		const uint16_t occupancy = leaf->occupancy[z];
+		const Floor* floor = leaf->array[z];
+		if (!floor) {
+			// Paged out and couldn't be read back
+			continue;
+		}
+		for (int i = 0; i < MAP_LAYERS; ++i) {
+			if (occupancy & (1 << i)) {
+				const TileLocation& location = floor->locs[i];
+				index.min_x = std::min(index.min_x, location.getX());
+				index.min_y = std::min(index.min_y, location.getY());
+				index.max_x = std::max(index.max_x, location.getX());
+				index.max_y = std::max(index.max_y, location.getY());
+			}
+		}
+	}
+	index.stale = false;
+}
+
 // Iterators
 
 MapIterator::MapIterator(BaseMap* _map) :
@@ -172,6 +346,7 @@ MapIterator BaseMap::begin() {
 			if (QTreeNode* child = node->child[index]) {
 				if (child->isLeaf) {
 					QTreeNode* leaf = child;
+					leaf->use();
 					// printf("\t%p is leaf\n", child);
 					for (it.local_z = 0; it.local_z < MAP_LAYERS; ++it.local_z) {
 						if (Floor* floor = leaf->array[it.local_z]) {
@@ -239,6 +414,7 @@ MapIterator& MapIterator::operator++() {
 			if (QTreeNode* child = node->child[index]) {
 				if (child->isLeaf) {
 					QTreeNode* leaf = child;
+					leaf->use();
 					// printf("\t%p is leaf\n", child);
 					for (; local_z < MAP_LAYERS; ++local_z) {
 						// printf("\t\tIterating over Z:%d of %p", local_z, child);
@@ -23,6 +23,11 @@
 #include "filehandle.h"
 #include "map_allocator.h"
 #include "tile.h"
+#include "map_pager.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 // Class declarations
 class QTreeNode;
@@ -117,6 +122,10 @@ public:
 	QTreeNode* createLeaf(int x, int y) {
 		return root.getLeafForce(x, y);
 	}
+	// Appends every leaf of the tree (4x4 tiles on all floors), used to split whole map passes across threads.
+	// Only leaves with a tile on one of the floors in 'floor_mask' (bit z for floor z) are returned,
+	// empty subtrees are skipped without being walked. The map must not change while the leaves are in use.
+	void getLeaves(std::vector<QTreeNode*>& leaves, uint16_t floor_mask = 0xFFFF);
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
 	void setTile(int _x, int _y, int _z, Tile* newtile, bool remove = false);
@@ -139,17 +148,90 @@ public:
 		return tilecount;
 	}
 
+	// Changes whenever a tile is set, swapped or cleared. Revisions are unique across all maps,
+	// so a map that is reallocated at the same address never reports an old revision.
+	// Edits made to a tile in place, without setting it again, are not seen.
+	uint64_t getRevision() const {
+		return revision;
+	}
+
+	// Per floor occupancy, kept up to date by setTile/swapTile/clear
+	uint64_t getFloorTileCount(int z) const {
+		std::lock_guard<std::mutex> lock(floor_index_mutex);
+		return floor_index[z].tiles;
+	}
+	// Bit z is set if floor z has at least one tile
+	uint16_t getUsedFloors() const {
+		return root.getFloorMask();
+	}
+	// Smallest box holding every tile of floor z, false if the floor is empty.
+	// Removing a tile on the edge only marks the box stale, the next call rebuilds it from the
+	// leaves of that floor. Safe to call from any thread while the main thread edits the map.
+	bool getFloorBounds(int z, Position& min_pos, Position& max_pos);
+
+	// Paged storage: keeps the tiles of the map within about 'bytes' of memory by writing leaves
+	// that weren't used recently to a cache file (see MapPager), 0 reads everything back and turns it off
+	void setPageBudget(uint64_t bytes);
+	// Pages out leaves until the map fits its budget, the tiles of those leaves are deleted.
+	// Main thread only, at a point where nothing holds on to tiles of this map.
+	void trimPages();
+	const MapPager* getPager() const {
+		return pager.get();
+	}
+	// True if the leaf at x, y is paged out and couldn't be read back, its tiles must not be changed
+	bool isUnreadable(int x, int y) {
+		QTreeNode* leaf = pager ? root.getLeaf(x, y) : nullptr;
+		return leaf && leaf->isPagedOut();
+	}
+	// True while a part of the map only exists in an unreadable cache file and can't be saved,
+	// those leaves are tried once more first
+	bool hasUnreadablePages() {
+		return pager && pager->hasFailedLeaves() && !pager->retryFailed();
+	}
+
 public:
 	MapAllocator allocator;
 
 protected:
+	struct FloorIndex {
+		uint64_t tiles = 0;
+		int min_x = 0, min_y = 0;
+		int max_x = -1, max_y = -1;
+		bool stale = false;
+	};
+
+	static void collectLeaves(QTreeNode* node, uint16_t floor_mask, std::vector<QTreeNode*>& leaves);
+
+	// Called by the leaves whenever a position gains or loses its tile
+	void onTileAdded(int x, int y, int z, bool first_in_leaf);
+	void onTileRemoved(int x, int y, int z, bool last_in_leaf);
+	// Rebuilds the floor masks on the path from the root to the leaf at x, y
+	void updateFloorMasks(int x, int y);
+	// Called with 'floor_index_mutex' held
+	void rebuildFloorBounds(int z);
+	void touch() {
+		revision = ++revision_counter;
+	}
+
 	uint64_t tilecount;
+	uint64_t revision;
+	static std::atomic<uint64_t> revision_counter;
+	FloorIndex floor_index[MAP_LAYERS];
+	mutable std::mutex floor_index_mutex; // Taken by the edits and by the threads asking for bounds
 
 	QTreeNode root; // The Quad Tree root
+	std::unique_ptr<MapPager> pager; // nullptr unless a page budget is set
 
 	friend class QTreeNode;
+	friend class MapPager;
 };
 
+inline void QTreeNode::use() {
+	if (map.pager) {
+		map.pager->use(this);
+	}
+}
+
 inline Tile* BaseMap::getTile(int x, int y, int z) {
 	TileLocation* l = getTileL(x, y, z);
 	return l ? l->get() : nullptr;
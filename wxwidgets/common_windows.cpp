@@ -33,6 +33,7 @@
 #include "common_windows.h"
 #include "positionctrl.h"
 #include "string_utils.h"
+#include "minimap_exporter.h"
 
 
 #ifdef _MSC_VER
@@ -533,6 +534,18 @@ ExportMiniMapWindow::ExportMiniMapWindow(wxWindow* parent, Editor& editor) :
 	tmpsizer->Add(floor_number, 0, wxALL, 5);
 	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
 
+	// Format options, the selected area is always exported as png
+	wxArrayString formats;
+	formats.Add("Bitmap (.bmp)");
+	formats.Add("PNG (.png)");
+	formats.Add("PNG tiles (web map)");
+
+	tmpsizer = newd wxStaticBoxSizer(wxHORIZONTAL, this, "Format");
+	format_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, formats);
+	format_options->SetSelection(std::clamp(g_settings.getInteger(Config::MINIMAP_EXPORT_FORMAT), 0, int(formats.size()) - 1));
+	tmpsizer->Add(format_options, 1, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
 	// OK/Cancel buttons
 	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
 	tmpsizer->Add(ok_button = newd wxButton(this, wxID_OK, "OK"), wxSizerFlags(1).Center());
@@ -547,8 +560,10 @@ ExportMiniMapWindow::ExportMiniMapWindow(wxWindow* parent, Editor& editor) :
 
 ExportMiniMapWindow::~ExportMiniMapWindow() = default;
 
-void ExportMiniMapWindow::OnExportTypeChange(wxCommandEvent& event) {
-	floor_number->Enable(event.GetSelection() == 2);
+void ExportMiniMapWindow::OnExportTypeChange(wxCommandEvent& WXUNUSED(event)) {
+	// Both choices send this event
+	floor_number->Enable(floor_options->GetSelection() == 2);
+	format_options->Enable(floor_options->GetSelection() != 3);
 }
 
 void ExportMiniMapWindow::OnClickBrowse(wxCommandEvent& WXUNUSED(event)) {
@@ -577,35 +592,38 @@ void ExportMiniMapWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
 		FileName directory(directory_text_field->GetValue());
 		g_settings.setString(Config::MINIMAP_EXPORT_DIR, directory_text_field->GetValue().ToStdString());
 
+		const wxString name = file_name_text_field->GetValue();
+		const int format = format_options->GetSelection();
+		g_settings.setInteger(Config::MINIMAP_EXPORT_FORMAT, format);
+
+		int first_floor = 0;
+		int last_floor = MAP_MAX_LAYER;
 		switch (floor_options->GetSelection()) {
-			case 0: { // All floors
-				for (int floor = 0; floor < MAP_LAYERS; ++floor) {
-					g_gui.SetLoadScale(int(floor * (100.f / 16.f)), int((floor + 1) * (100.f / 16.f)));
-					FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".bmp");
-					file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-					editor.exportMiniMap(file, floor, true);
-				}
+			case 1: // Ground floor
+				first_floor = last_floor = GROUND_LAYER;
 				break;
-			}
-
-			case 1: { // Ground floor
-				FileName file(file_name_text_field->GetValue() + "_" + i2ws(GROUND_LAYER) + ".bmp");
-				file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-				editor.exportMiniMap(file, GROUND_LAYER, true);
+			case 2: // Specific floor
+				first_floor = last_floor = floor_number->GetValue();
 				break;
-			}
+			default:
+				break;
+		}
 
-			case 2: { // Specific floors
-				int floor = floor_number->GetValue();
-				FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".bmp");
+		if (floor_options->GetSelection() == 3) { // Selected area
+			editor.exportSelectionAsMiniMap(directory, name);
+		} else if (format == 0) {
+			for (int floor = first_floor; floor <= last_floor; ++floor) {
+				const int floors = last_floor - first_floor + 1;
+				g_gui.SetLoadScale(int((floor - first_floor) * (100.f / floors)), int((floor - first_floor + 1) * (100.f / floors)));
+				FileName file(name + "_" + i2ws(floor) + ".bmp");
 				file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
 				editor.exportMiniMap(file, floor, true);
-				break;
 			}
-
-			case 3: { // Selected area
-				editor.exportSelectionAsMiniMap(directory, file_name_text_field->GetValue());
-				break;
+		} else {
+			// All floors are scanned in one pass and rendered in parallel
+			MinimapExporter exporter(editor.map, format == 1 ? MinimapExporter::FORMAT_PNG : MinimapExporter::FORMAT_TILES);
+			if (!exporter.exportFloors(directory, name, first_floor, last_floor)) {
+				g_gui.PopupDialog("Error", exporter.getError(), wxOK);
 			}
 		}
 	} catch (std::bad_alloc&) {
@@ -213,79 +213,133 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 	g_gui.SetStatusText(wxstr(ss.str()));
 }
 
+namespace {
+	// One byte of flags per position of the paste box, which is one tile larger than
+	// the pasted tiles on every side so their neighbours fit in as well.
+	class PasteArea {
+	public:
+		enum {
+			PASTED = 1,
+			MERGED = 2,
+			BORDER = 4,
+		};
+
+		PasteArea(const Position& min_pos, const Position& max_pos) :
+			x(min_pos.x - 1), y(min_pos.y - 1), z(min_pos.z),
+			width(max_pos.x - min_pos.x + 3), height(max_pos.y - min_pos.y + 3),
+			flags(size_t(width) * height * (max_pos.z - min_pos.z + 1), 0) {
+			////
+		}
+
+		uint8_t& at(const Position& pos) {
+			return flags[(size_t(pos.z - z) * height + (pos.y - y)) * width + (pos.x - x)];
+		}
+
+	private:
+		int x, y, z;
+		int width, height;
+		std::vector<uint8_t> flags;
+	};
+}
+
 void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 	if (!tiles) {
 		return;
 	}
 
+	Position min_pos(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+	Position max_pos(std::numeric_limits<int>::min(), std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
+	for (MapIterator it = tiles->begin(); it != tiles->end(); ++it) {
+		Position pos = (*it)->get()->getPosition() - copyPos + toPosition;
+		if (pos.isValid()) {
+			min_pos.x = std::min(min_pos.x, pos.x);
+			min_pos.y = std::min(min_pos.y, pos.y);
+			min_pos.z = std::min(min_pos.z, pos.z);
+			max_pos.x = std::max(max_pos.x, pos.x);
+			max_pos.y = std::max(max_pos.y, pos.y);
+			max_pos.z = std::max(max_pos.z, pos.z);
+		}
+	}
+	if (min_pos.x > max_pos.x) {
+		return;
+	}
+
+	PasteArea area(min_pos, max_pos);
+	PositionVector pasted;
+	pasted.reserve(tiles->size());
+
 	BatchAction* batchAction = editor.actionQueue->createBatch(ACTION_PASTE_TILES);
 	Action* action = editor.actionQueue->createAction(batchAction);
-	
-	// Track modified positions for minimap update
-	PositionVector modifiedPositions;
-	
-	// Original paste logic
+	const bool merge = g_settings.getInteger(Config::MERGE_PASTE);
+
+	// The buffer is copied straight into the new destination tiles, no intermediate copies
 	for (MapIterator it = tiles->begin(); it != tiles->end(); ++it) {
 		Tile* buffer_tile = (*it)->get();
 		Position pos = buffer_tile->getPosition() - copyPos + toPosition;
-		
 		if (!pos.isValid()) {
 			continue;
 		}
-		
-		// Add position for minimap update
-		modifiedPositions.push_back(pos);
-		
-		// Add surrounding positions for border updates
-		for(int dx = -1; dx <= 1; dx++) {
-			for(int dy = -1; dy <= 1; dy++) {
-				Position borderPos(pos.x + dx, pos.y + dy, pos.z);
-				if(borderPos.isValid()) {
-					modifiedPositions.push_back(borderPos);
-				}
-			}
-		}
 
 		TileLocation* location = editor.map.createTileL(pos);
-		Tile* copy_tile = buffer_tile->deepCopy(editor.map);
 		Tile* old_dest_tile = location->get();
 		Tile* new_dest_tile = nullptr;
-		copy_tile->setLocation(location);
+		uint8_t& flags = area.at(pos);
 
-		if (g_settings.getInteger(Config::MERGE_PASTE) || !copy_tile->ground) {
+		if (merge || !buffer_tile->ground) {
 			if (old_dest_tile) {
 				new_dest_tile = old_dest_tile->deepCopy(editor.map);
+				// Old and new content meet on this tile, its borders have to be redone
+				flags |= PasteArea::MERGED;
 			} else {
 				new_dest_tile = editor.map.allocator(location);
 			}
-			new_dest_tile->merge(copy_tile);
-			delete copy_tile;
+			new_dest_tile->mergeCopy(buffer_tile);
 		} else {
-			new_dest_tile = copy_tile;
+			new_dest_tile = buffer_tile->deepCopy(editor.map);
+			new_dest_tile->setLocation(location);
 		}
 
+		flags |= PasteArea::PASTED;
+		pasted.push_back(pos);
 		action->addChange(newd Change(new_dest_tile));
 	}
-	
+
 	batchAction->addAndCommitAction(action);
 
+	// Pasted tiles brought their borders from the buffer, only where they meet tiles that
+	// were not pasted (or were merged into) can borders change. Each such position is
+	// queued once, the flags double as the visited set.
+	PositionVector frontier;
+	for (const Position& pos : pasted) {
+		bool on_frontier = (area.at(pos) & PasteArea::MERGED) != 0;
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				Position neighbour(pos.x + dx, pos.y + dy, pos.z);
+				uint8_t& flags = area.at(neighbour);
+				if (flags & PasteArea::PASTED) {
+					continue;
+				}
+				on_frontier = true;
+				if (!(flags & PasteArea::BORDER) && neighbour.isValid()) {
+					flags |= PasteArea::BORDER;
+					frontier.push_back(neighbour);
+				}
+			}
+		}
+
+		uint8_t& flags = area.at(pos);
+		if (on_frontier && !(flags & PasteArea::BORDER)) {
+			flags |= PasteArea::BORDER;
+			frontier.push_back(pos);
+		}
+	}
+
 	if (g_settings.getInteger(Config::USE_AUTOMAGIC) && g_settings.getInteger(Config::BORDERIZE_PASTE)) {
 		action = editor.actionQueue->createAction(batchAction);
-		TileList borderize_tiles;
 		Map& map = editor.map;
 
-		for (const Position& pos : modifiedPositions) {
+		for (const Position& pos : frontier) {
 			Tile* tile = map.getTile(pos);
-			if (tile) {
-				borderize_tiles.push_back(tile);
-			}
-		}
-
-		// Remove duplicates
-		borderize_tiles.sort();
-		borderize_tiles.unique();
-
-		for (Tile* tile : borderize_tiles) {
 			if (tile) {
 				Tile* newTile = tile->deepCopy(editor.map);
 				newTile->borderize(&map);
@@ -299,9 +353,14 @@ void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 
 	editor.addBatch(batchAction);
 
-	// Update minimap with modified positions
+	// Update minimap with the pasted tiles and the neighbours that may have changed
 	if (g_gui.minimap) {
-		g_gui.minimap->UpdateDrawnTiles(modifiedPositions);
+		for (const Position& pos : frontier) {
+			if (!(area.at(pos) & PasteArea::PASTED)) {
+				pasted.push_back(pos);
+			}
+		}
+		g_gui.minimap->UpdateDrawnTiles(pasted);
 	}
 }
 
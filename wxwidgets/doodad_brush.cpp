@@ -164,6 +164,20 @@ bool DoodadBrush::loadAlternative(pugi::xml_node node, wxArrayString& warnings,
 					cb.items.push_back(std::make_pair(Position(x, y, z), items));
 				}
 			}
+
+			if (!cb.items.empty()) {
+				cb.footprint_min = cb.footprint_max = cb.items.front().first;
+			}
+			for (const auto& composite : cb.items) {
+				const Position& offset = composite.first;
+				cb.footprint_min = Position(std::min(cb.footprint_min.x, offset.x), std::min(cb.footprint_min.y, offset.y), std::min(cb.footprint_min.z, offset.z));
+				cb.footprint_max = Position(std::max(cb.footprint_max.x, offset.x), std::max(cb.footprint_max.y, offset.y), std::max(cb.footprint_max.z, offset.z));
+			}
+			Position& alt_min = alternativeBlock->footprint_min;
+			Position& alt_max = alternativeBlock->footprint_max;
+			alt_min = Position(std::min(alt_min.x, cb.footprint_min.x), std::min(alt_min.y, cb.footprint_min.y), std::min(alt_min.z, cb.footprint_min.z));
+			alt_max = Position(std::max(alt_max.x, cb.footprint_max.x), std::max(alt_max.y, cb.footprint_max.y), std::max(alt_max.z, cb.footprint_max.z));
+
 			alternativeBlock->composite_items.push_back(cb);
 		}
 	}
@@ -343,6 +357,17 @@ void DoodadBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	}
 }
 
+const DoodadBrush::CompositeBlock* DoodadBrush::pickComposite(const AlternativeBlock* ab_ptr) const {
+	int roll = random(1, ab_ptr->composite_chance);
+	for (std::vector<CompositeBlock>::const_iterator block_iter = ab_ptr->composite_items.begin(); block_iter != ab_ptr->composite_items.end(); ++block_iter) {
+		const CompositeBlock& cb = *block_iter;
+		if (roll <= cb.chance) {
+			return &cb;
+		}
+	}
+	return nullptr;
+}
+
 const CompositeTileList& DoodadBrush::getComposite(int variation) const {
 	static CompositeTileList empty;
 
@@ -354,14 +379,104 @@ const CompositeTileList& DoodadBrush::getComposite(int variation) const {
 	const AlternativeBlock* ab_ptr = alternatives[variation];
 	ASSERT(ab_ptr);
 
-	int roll = random(1, ab_ptr->composite_chance);
-	for (std::vector<CompositeBlock>::const_iterator block_iter = ab_ptr->composite_items.begin(); block_iter != ab_ptr->composite_items.end(); ++block_iter) {
-		const CompositeBlock& cb = *block_iter;
-		if (roll <= cb.chance) {
-			return cb.items;
+	const CompositeBlock* cb = pickComposite(ab_ptr);
+	return cb ? cb->items : empty;
+}
+
+namespace {
+	// One flag per tile a scatter can reach, set once a stamp covers that tile
+	class StampMask {
+	public:
+		StampMask(const Position& min, const Position& max) :
+			min(min),
+			width(max.x - min.x + 1),
+			height(max.y - min.y + 1),
+			flags(static_cast<size_t>(width) * height * (max.z - min.z + 1), 0) { }
+
+		bool test(const Position& offset) const {
+			return flags[index(offset)] != 0;
+		}
+		void set(const Position& offset) {
+			flags[index(offset)] = 1;
+		}
+
+	private:
+		size_t index(const Position& offset) const {
+			return (static_cast<size_t>(offset.z - min.z) * height + (offset.y - min.y)) * width + (offset.x - min.x);
+		}
+
+		Position min;
+		int width;
+		int height;
+		std::vector<uint8_t> flags;
+	};
+}
+
+void DoodadBrush::scatter(BaseMap* buffer, const Position& center, int variation, int radius, bool circle, int count) {
+	if (alternatives.empty()) {
+		return;
+	}
+
+	variation %= alternatives.size();
+	const AlternativeBlock* ab_ptr = alternatives[variation];
+	ASSERT(ab_ptr);
+
+	// Every spot a stamp may be centered on, so picking one is a single roll
+	std::vector<Position> spots;
+	for (int y = -radius; y <= radius; ++y) {
+		for (int x = -radius; x <= radius; ++x) {
+			if (!circle || sqrt(float(x * x) + float(y * y)) < radius + 0.005) {
+				spots.push_back(Position(x, y, 0));
+			}
+		}
+	}
+
+	const Position reach(radius, radius, 0);
+	StampMask mask(ab_ptr->footprint_min - reach, ab_ptr->footprint_max + reach);
+
+	const int total_chance = ab_ptr->composite_chance + ab_ptr->single_chance;
+	for (int object = 0; object < count; ++object) {
+		const Position& spot = spots[random(0, static_cast<int>(spots.size()) - 1)];
+
+		// Decide whether the spot gets a composite or a single object
+		if (random(total_chance) <= ab_ptr->composite_chance) {
+			const CompositeBlock* cb = pickComposite(ab_ptr);
+			if (!cb) {
+				continue;
+			}
+
+			bool fits = true;
+			for (const auto& composite : cb->items) {
+				if (mask.test(spot + composite.first)) {
+					fits = false;
+					break;
+				}
+			}
+			if (!fits) {
+				continue;
+			}
+
+			for (const auto& composite : cb->items) {
+				const Position offset = spot + composite.first;
+				mask.set(offset);
+
+				Tile* tile = buffer->allocator(buffer->createTileL(center + offset));
+				for (Item* item : composite.second) {
+					tile->addItem(item->deepCopy());
+				}
+				buffer->setTile(tile->getPosition(), tile);
+			}
+		} else if (ab_ptr->single_chance > 0) {
+			if (mask.test(spot)) {
+				continue;
+			}
+			mask.set(spot);
+
+			Tile* tile = buffer->allocator(buffer->createTileL(center + spot));
+			draw(buffer, tile, &variation);
+			buffer->setTile(tile->getPosition(), tile);
 		}
 	}
-	return empty;
 }
 
 bool DoodadBrush::isEmpty(int variation) const {
@@ -51,6 +51,11 @@ public:
 	const CompositeTileList& getComposite(int variation) const;
 	virtual void undraw(BaseMap* map, Tile* tile);
 
+	// Places 'count' stamps (a composite or a single item, rolled like a single click) on
+	// random spots within 'radius' of 'center' in 'buffer'. Stamps that would overlap an
+	// earlier one are dropped, overlap is tested against the precomputed composite footprints.
+	void scatter(BaseMap* buffer, const Position& center, int variation, int radius, bool circle, int count);
+
 	bool isEmpty(int variation) const;
 
 	int getThickness() const {
@@ -123,6 +128,9 @@ protected:
 	struct CompositeBlock {
 		int chance;
 		CompositeTileList items;
+		// Bounding box of the tile offsets in 'items'
+		Position footprint_min;
+		Position footprint_max;
 	};
 
 	struct AlternativeBlock {
@@ -134,8 +142,14 @@ protected:
 
 		int composite_chance; // Total chance of a composite
 		int single_chance; // Total chance of a single object
+
+		// Union of all composite footprints, always includes the origin
+		Position footprint_min;
+		Position footprint_max;
 	};
 
+	const CompositeBlock* pickComposite(const AlternativeBlock* ab_ptr) const;
+
 	std::vector<AlternativeBlock*> alternatives;
 };
 
@@ -41,6 +41,7 @@
 #include "live_action.h"
 #include "minimap_window.h"
 #include "borderize_window.h"
+#include "ground_randomizer.h"
 
 Editor::Editor(CopyBuffer& copybuffer) :
 	live_server(nullptr),
@@ -180,6 +181,12 @@ void Editor::addAction(Action* action, int stacking_delay) {
 }
 
 void Editor::saveMap(FileName filename, bool showdialog) {
+	if (map.hasUnreadablePages()) {
+		// Those tiles are only in the page cache file, they would be saved as empty ground
+		g_gui.PopupDialog("Error", "Could not save, part of the map couldn't be read back from the page cache file.", wxOK);
+		return;
+	}
+
 	std::string savefile = filename.GetFullPath().mb_str(wxConvUTF8).data();
 	bool save_as = false;
 	bool save_otgz = false;
@@ -377,6 +384,7 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 }
 
 bool Editor::importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset) {
+	map.statistics.invalidate();
 	return false;
 }
 
@@ -487,6 +495,7 @@ bool Editor::exportSelectionAsMiniMap(FileName directory, wxString fileName) {
 }
 
 bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offset, ImportType house_import_type, ImportType spawn_import_type) {
+	map.statistics.invalidate();
 	selection.clear();
 	actionQueue->clear();
 
@@ -834,6 +843,7 @@ void Editor::borderizeSelection() {
 }
 
 void Editor::borderizeMap(bool showdialog) {
+	map.statistics.invalidate();
 	if (!showdialog) {
 		// Old immediate processing for automated calls
 		uint64_t tiles_done = 0;
@@ -851,69 +861,53 @@ void Editor::borderizeMap(bool showdialog) {
 	window->Destroy();
 }
 
-void Editor::randomizeSelection() {
+void Editor::randomizeSelection(uint64_t seed) {
 	if (selection.size() == 0) {
 		g_gui.SetStatusText("No items selected. Can't randomize.");
+		return;
 	}
 
-	Action* action = actionQueue->createAction(ACTION_RANDOMIZE);
-	for (Tile* tile : selection) {
-		Tile* newTile = tile->deepCopy(map);
-		GroundBrush* groundBrush = newTile->getGroundBrush();
-		if (groundBrush && groundBrush->isReRandomizable()) {
-			groundBrush->draw(&map, newTile, nullptr);
+	std::vector<Tile*> tiles(selection.begin(), selection.end());
+	std::vector<Tile*> randomized = GroundRandomizer(seed, true).randomize(map, tiles);
 
-			Item* oldGround = tile->ground;
-			Item* newGround = newTile->ground;
-			if (oldGround && newGround) {
-				newGround->setActionID(oldGround->getActionID());
-				newGround->setUniqueID(oldGround->getUniqueID());
-			}
-
-			newTile->select();
-			action->addChange(newd Change(newTile));
+	BatchAction* batch = actionQueue->createBatch(ACTION_RANDOMIZE);
+	Action* action = actionQueue->createAction(batch);
+	for (Tile* new_tile : randomized) {
+		if (new_tile) {
+			new_tile->select();
+			action->addChange(newd Change(new_tile));
 		}
 	}
-	addAction(action);
+	batch->addAndCommitAction(action);
+	addBatch(batch);
 }
 
-void Editor::randomizeMap(bool showdialog) {
+void Editor::randomizeMap(bool showdialog, uint64_t seed) {
 	if (showdialog) {
 		g_gui.CreateLoadBar("Randomizing map...");
 	}
 
-	uint64_t tiles_done = 0;
+	std::vector<Tile*> tiles;
+	tiles.reserve(map.getTileCount());
 	for (TileLocation* tileLocation : map) {
-		if (showdialog && tiles_done % 4096 == 0) {
-			g_gui.SetLoadDone(static_cast<int32_t>(tiles_done / double(map.tilecount) * 100.0));
-		}
-
-		Tile* tile = tileLocation->get();
-		ASSERT(tile);
-
-		GroundBrush* groundBrush = tile->getGroundBrush();
-		if (groundBrush) {
-			Item* oldGround = tile->ground;
+		tiles.push_back(tileLocation->get());
+	}
 
-			uint16_t actionId, uniqueId;
-			if (oldGround) {
-				actionId = oldGround->getActionID();
-				uniqueId = oldGround->getUniqueID();
-			} else {
-				actionId = 0;
-				uniqueId = 0;
-			}
-			groundBrush->draw(&map, tile, nullptr);
+	std::vector<Tile*> randomized = GroundRandomizer(seed, false).randomize(map, tiles, [showdialog](int percent) {
+		if (showdialog) {
+			g_gui.SetLoadDone(percent);
+		}
+	});
 
-			Item* newGround = tile->ground;
-			if (newGround) {
-				newGround->setActionID(actionId);
-				newGround->setUniqueID(uniqueId);
-			}
-			tile->update();
+	BatchAction* batch = actionQueue->createBatch(ACTION_RANDOMIZE);
+	Action* action = actionQueue->createAction(batch);
+	for (Tile* new_tile : randomized) {
+		if (new_tile) {
+			action->addChange(newd Change(new_tile));
 		}
-		++tiles_done;
 	}
+	batch->addAndCommitAction(action);
+	addBatch(batch);
 
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
@@ -1343,7 +1337,7 @@ void Editor::destroySelection() {
 }
 
 // Macro to avoid useless code repetition
-void doSurroundingBorders(DoodadBrush* doodad_brush, PositionList& tilestoborder, Tile* buffer_tile, Tile* new_tile) {
+void doSurroundingBorders(DoodadBrush* doodad_brush, PositionVector& tilestoborder, Tile* buffer_tile, Tile* new_tile) {
 	if (doodad_brush->doNewBorders() && g_settings.getInteger(Config::USE_AUTOMAGIC)) {
 		tilestoborder.push_back(Position(new_tile->getPosition().x, new_tile->getPosition().y, new_tile->getPosition().z));
 		if (buffer_tile->hasGround()) {
@@ -1379,10 +1373,15 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 		BatchAction* batch = actionQueue->createBatch(ACTION_DRAW);
 		Action* action = actionQueue->createAction(batch);
 		BaseMap* buffer_map = g_gui.doodad_buffer_map.get();
+		DoodadBrush* doodad_brush = brush->asDoodad();
+
+		const bool on_blocking = doodad_brush->placeOnBlocking() || alt;
+		const bool check_duplicate = !doodad_brush->placeOnDuplicate() && !alt;
 
 		Position delta_pos = offset - Position(0x8000, 0x8000, 0x8);
-		PositionList tilestoborder;
+		PositionVector tilestoborder;
 
+		// Every stamp of the buffer goes into this one action, one change per destination tile
 		for (MapIterator it = buffer_map->begin(); it != buffer_map->end(); ++it) {
 			Tile* buffer_tile = (*it)->get();
 			Position pos = buffer_tile->getPosition() + delta_pos;
@@ -1390,55 +1389,33 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 				continue;
 			}
 
-			TileLocation* location = map.createTileL(pos);
-			Tile* tile = location->get();
-			DoodadBrush* doodad_brush = brush->asDoodad();
-
-			if (doodad_brush->placeOnBlocking() || alt) {
-				if (tile) {
-					bool place = true;
-					if (!doodad_brush->placeOnDuplicate() && !alt) {
-						for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
-							if (doodad_brush->ownsItem(*iter)) {
-								place = false;
-								break;
-							}
-						}
-					}
-					if (place) {
-						Tile* new_tile = tile->deepCopy(map);
-						removeDuplicateWalls(buffer_tile, new_tile);
-						doSurroundingBorders(doodad_brush, tilestoborder, buffer_tile, new_tile);
-						new_tile->merge(buffer_tile);
-						action->addChange(newd Change(new_tile));
+			// Only stamps that may land on empty ground need a location created
+			TileLocation* location = on_blocking ? map.createTileL(pos) : map.getTileL(pos);
+			Tile* tile = location ? location->get() : nullptr;
+			if (!tile && !on_blocking) {
+				continue;
+			}
+			if (tile && !on_blocking && tile->isBlocking()) {
+				continue;
+			}
+			if (tile && check_duplicate) {
+				bool duplicate = false;
+				for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
+					if (doodad_brush->ownsItem(*iter)) {
+						duplicate = true;
+						break;
 					}
-				} else {
-					Tile* new_tile = map.allocator(location);
-					removeDuplicateWalls(buffer_tile, new_tile);
-					doSurroundingBorders(doodad_brush, tilestoborder, buffer_tile, new_tile);
-					new_tile->merge(buffer_tile);
-					action->addChange(newd Change(new_tile));
 				}
-			} else {
-				if (tile && !tile->isBlocking()) {
-					bool place = true;
-					if (!doodad_brush->placeOnDuplicate() && !alt) {
-						for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
-							if (doodad_brush->ownsItem(*iter)) {
-								place = false;
-								break;
-							}
-						}
-					}
-					if (place) {
-						Tile* new_tile = tile->deepCopy(map);
-						removeDuplicateWalls(buffer_tile, new_tile);
-						doSurroundingBorders(doodad_brush, tilestoborder, buffer_tile, new_tile);
-						new_tile->merge(buffer_tile);
-						action->addChange(newd Change(new_tile));
-					}
+				if (duplicate) {
+					continue;
 				}
 			}
+
+			Tile* new_tile = tile ? tile->deepCopy(map) : map.allocator(location);
+			removeDuplicateWalls(buffer_tile, new_tile);
+			doSurroundingBorders(doodad_brush, tilestoborder, buffer_tile, new_tile);
+			new_tile->merge(buffer_tile);
+			action->addChange(newd Change(new_tile));
 		}
 		batch->addAndCommitAction(action);
 
@@ -1446,10 +1423,10 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 			Action* action = actionQueue->createAction(batch);
 
 			// Remove duplicates
-			tilestoborder.sort();
-			tilestoborder.unique();
+			std::sort(tilestoborder.begin(), tilestoborder.end());
+			tilestoborder.erase(std::unique(tilestoborder.begin(), tilestoborder.end()), tilestoborder.end());
 
-			for (PositionList::const_iterator it = tilestoborder.begin(); it != tilestoborder.end(); ++it) {
+			for (PositionVector::const_iterator it = tilestoborder.begin(); it != tilestoborder.end(); ++it) {
 				Tile* tile = map.getTile(*it);
 				if (tile) {
 					Tile* new_tile = tile->deepCopy(map);
@@ -2083,6 +2060,8 @@ uint32_t Editor::validateGrounds(bool validateStack, bool generateEmpty, bool re
     g_gui.DestroyLoadBar();
 
     if (changes > 0) {
+        // The stacks were changed in place, not through actions
+        map.statistics.invalidate();
         map.doChange();
     }
 
@@ -117,14 +117,17 @@ public: // Functions
 	void destroySelection();
 	// Borderizes the selected region
 	void borderizeSelection();
-	// Randomizes the ground in the selected region
-	void randomizeSelection();
+	// Randomizes the ground in the selected region, the same seed gives the same grounds
+	void randomizeSelection(uint64_t seed);
 
 	// Same as above although it applies to the entire map
-	// action queue is flushed when these functions are called
 	// showdialog is whether a progress bar should be shown
+	// With the dialog the map is borderized in undoable chunks (see BorderizeWindow), without it
+	// the tiles are changed in place and can't be undone
 	void borderizeMap(bool showdialog);
-	void randomizeMap(bool showdialog);
+	// Goes through the undo queue as a single batch, see GroundRandomizer for the seed
+	void randomizeMap(bool showdialog, uint64_t seed);
+	// These change the tiles in place, they can't be undone and leave the action queue as it is
 	void clearInvalidHouseTiles(bool showdialog);
 	void clearModifiedTileState(bool showdialog);
 
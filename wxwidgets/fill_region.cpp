@@ -0,0 +1,177 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "fill_region.h"
+#include "basemap.h"
+#include "map_region.h"
+
+namespace {
+	inline uint32_t leafKey(int x, int y) {
+		return uint32_t(x >> 2) | (uint32_t(y >> 2) << 16);
+	}
+
+	// Same layout as the leaf locations and occupancy
+	inline uint16_t leafBit(int x, int y) {
+		return uint16_t(1 << ((x & 3) * 4 + (y & 3)));
+	}
+
+	void markBit(std::unordered_map<uint32_t, uint16_t>& bits, int x, int y) {
+		bits[leafKey(x, y)] |= leafBit(x, y);
+	}
+
+	bool testBit(const std::unordered_map<uint32_t, uint16_t>& bits, int x, int y) {
+		auto it = bits.find(leafKey(x, y));
+		return it != bits.end() && (it->second & leafBit(x, y)) != 0;
+	}
+}
+
+FillRegion::FillRegion(BaseMap& map, int z) :
+	map(map),
+	z(z),
+	width(map.getWidth()),
+	height(map.getHeight()) {
+	////
+}
+
+const Tile* FillRegion::lookup(int x, int y) {
+	const uint32_t key = leafKey(x, y);
+	if (key != leaf_key) {
+		leaf_key = key;
+		leaf = map.getLeaf(x, y);
+	}
+	if (!leaf || (leaf->getOccupancy(z) & leafBit(x, y)) == 0) {
+		return nullptr;
+	}
+	Floor* floor = leaf->getFloor(z);
+	return floor ? floor->locs[(x & 3) * 4 + (y & 3)].get() : nullptr;
+}
+
+bool FillRegion::accepts(int x, int y) {
+	if (x < 0 || y < 0 || x >= width || y >= height || testBit(visited, x, y)) {
+		return false;
+	}
+	if (!(*matches)(lookup(x, y))) {
+		return false;
+	}
+	if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
+		reached_edge = true;
+		return false;
+	}
+	return true;
+}
+
+void FillRegion::take(int x, int y) {
+	markBit(visited, x, y);
+	positions.push_back(Position(x, y, z));
+}
+
+bool FillRegion::contains(int x, int y) const {
+	return testBit(visited, x, y);
+}
+
+FillRegion::Result FillRegion::fill(int x, int y, const Matcher& matcher, size_t limit, bool stop_at_edge) {
+	visited.clear();
+	positions.clear();
+	reached_edge = false;
+	matches = &matcher;
+
+	struct Seed {
+		int x, y;
+	};
+	std::vector<Seed> seeds;
+	seeds.push_back({ x, y });
+
+	while (!seeds.empty()) {
+		const Seed seed = seeds.back();
+		seeds.pop_back();
+		if (!accepts(seed.x, seed.y)) {
+			if (stop_at_edge && reached_edge) {
+				return FILL_ESCAPED;
+			}
+			continue;
+		}
+
+		// Widen the seed to the whole run of matching tiles on its row
+		int left = seed.x;
+		while (accepts(left - 1, seed.y)) {
+			--left;
+		}
+		int right = seed.x;
+		while (accepts(right + 1, seed.y)) {
+			++right;
+		}
+		if (stop_at_edge && reached_edge) {
+			return FILL_ESCAPED;
+		}
+
+		for (int run_x = left; run_x <= right; ++run_x) {
+			if (limit != 0 && positions.size() >= limit) {
+				return FILL_CAPPED;
+			}
+			take(run_x, seed.y);
+		}
+
+		// One seed per run of matching tiles directly above and below
+		for (int row = seed.y - 1; row <= seed.y + 1; row += 2) {
+			bool in_run = false;
+			for (int run_x = left; run_x <= right; ++run_x) {
+				if (accepts(run_x, row)) {
+					if (!in_run) {
+						seeds.push_back({ run_x, row });
+						in_run = true;
+					}
+				} else {
+					in_run = false;
+				}
+			}
+			if (stop_at_edge && reached_edge) {
+				return FILL_ESCAPED;
+			}
+		}
+	}
+	return FILL_DONE;
+}
+
+PositionVector FillRegion::getFrontier() const {
+	PositionVector inner;
+	PositionVector outer;
+	std::unordered_map<uint32_t, uint16_t> added;
+	for (const Position& position : positions) {
+		bool edge = false;
+		for (int dy = -1; dy <= 1; ++dy) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				const int nx = position.x + dx;
+				const int ny = position.y + dy;
+				if ((dx == 0 && dy == 0) || testBit(visited, nx, ny)) {
+					continue;
+				}
+				edge = true;
+				if (!testBit(added, nx, ny)) {
+					markBit(added, nx, ny);
+					outer.push_back(Position(nx, ny, z));
+				}
+			}
+		}
+		if (edge) {
+			inner.push_back(position);
+		}
+	}
+	inner.insert(inner.end(), outer.begin(), outer.end());
+	return inner;
+}
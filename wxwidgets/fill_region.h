@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_FILL_REGION_H_
+#define RME_FILL_REGION_H_
+
+#include <functional>
+#include <unordered_map>
+
+#include "position.h"
+
+class BaseMap;
+class Tile;
+class QTreeNode;
+
+// The 4-connected area of one floor around a position whose tiles all satisfy a predicate.
+// The area is found a run of tiles along x at a time, without recursion and without a size
+// window. Tiles are read straight from the quad tree leaves, so a run costs one tree lookup
+// per 4 tiles, and positions without a tile are answered from the leaf occupancy mask.
+// Visited positions are kept as one 16 bit mask per leaf.
+class FillRegion {
+public:
+	// Called with nullptr for positions without a tile
+	typedef std::function<bool(const Tile*)> Matcher;
+
+	enum Result {
+		FILL_DONE,
+		// Stopped at the tile limit, the area is only partially collected
+		FILL_CAPPED,
+		// Reached the map border with 'stop_at_edge'
+		FILL_ESCAPED,
+	};
+
+	FillRegion(BaseMap& map, int z);
+
+	// Collects the area around x, y. At most 'limit' tiles are taken, 0 is no limit.
+	// Tiles on the outermost row or column of the map are never taken; with 'stop_at_edge'
+	// reaching one aborts the fill, otherwise the area just ends there.
+	Result fill(int x, int y, const Matcher& matches, size_t limit = 0, bool stop_at_edge = false);
+
+	size_t size() const {
+		return positions.size();
+	}
+	const PositionVector& getPositions() const {
+		return positions;
+	}
+	bool contains(int x, int y) const;
+
+	// The taken positions with a neighbour outside the area, followed by those neighbours
+	// (8 directions). These are the only tiles whose borders a fill can change.
+	PositionVector getFrontier() const;
+
+private:
+	const Tile* lookup(int x, int y);
+	// Whether x, y is free to be taken, flags the map border
+	bool accepts(int x, int y);
+	void take(int x, int y);
+
+	BaseMap& map;
+	int z;
+	int width;
+	int height;
+
+	const Matcher* matches = nullptr;
+	bool reached_edge = false;
+
+	// Leaf of the last lookup
+	QTreeNode* leaf = nullptr;
+	uint32_t leaf_key = 0xFFFFFFFF;
+
+	std::unordered_map<uint32_t, uint16_t> visited;
+	PositionVector positions;
+};
+
+#endif
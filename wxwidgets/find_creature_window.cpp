@@ -180,75 +180,45 @@ void FindCreatureDialog::OnClickOK(wxCommandEvent& event) {
                 SearchResultWindow* result_window = g_gui.ShowSearchWindow();
                 result_window->Clear();
                 
-                // Iterate through all tiles to find spawns with matching creatures
+                // Walk the existing tiles once, the spawn index tells whether a creature is in a spawn
                 size_t creature_found_count = 0;
                 
                 g_gui.CreateLoadBar("Searching for creatures...");
                 
                 const std::string creature_name = creature_type->name;
+                std::set<Position> matched_spawns;
+                PositionVector covering;
                 uint64_t tile_count = 0;
-                for (int z = 0; z < 16; ++z) {
-                    for (int x = 0; x < map.getWidth(); ++x) {
-                        for (int y = 0; y < map.getHeight(); ++y) {
-                            ++tile_count;
-                            if (tile_count % 5000 == 0) {
-                                g_gui.SetLoadDone(int(tile_count * 100.0 / map.getTileCount()));
-                            }
-                            
-                            Tile* tile = map.getTile(x, y, z);
-                            if (!tile) continue;
-                            
-                            // Check for spawns
-                            if (tile->spawn) {
-                                // Found a spawn, now check for creatures nearby with matching name
-                                bool found_matching_creature = false;
-                                Position spawn_pos = tile->getPosition();
-                                int spawn_radius = tile->spawn->getSize();
-                                
-                                // Check if any creatures of this type exist within spawn radius
-                                for (int sx = -spawn_radius; sx <= spawn_radius && !found_matching_creature; ++sx) {
-                                    for (int sy = -spawn_radius; sy <= spawn_radius && !found_matching_creature; ++sy) {
-                                        Tile* creature_tile = map.getTile(spawn_pos.x + sx, spawn_pos.y + sy, spawn_pos.z);
-                                        if (!creature_tile || !creature_tile->creature) continue;
-                                        
-                                        // Check if this creature matches our search
-                                        if (creature_tile->creature && creature_tile->creature->getName() == creature_name) {
-                                            found_matching_creature = true;
-                                            wxString description = wxString::Format("%s at (%d,%d,%d)", 
-                                                wxString(creature_name.c_str(), wxConvUTF8), 
-                                                creature_tile->getPosition().x, 
-                                                creature_tile->getPosition().y, 
-                                                creature_tile->getPosition().z);
-                                            result_window->AddPosition(description, creature_tile->getPosition());
-                                            ++creature_found_count;
-                                        }
-                                    }
-                                }
-                                
-                                // If no creature of this type found, still show the spawn position
-                                if (!found_matching_creature) {
-                                    wxString description = wxString::Format("Spawn for %s at (%d,%d,%d)", 
-                                        wxString(creature_name.c_str(), wxConvUTF8), 
-                                        spawn_pos.x, spawn_pos.y, spawn_pos.z);
-                                    result_window->AddPosition(description, spawn_pos);
-                                    ++creature_found_count;
-                                }
-                            }
-                            
-                            // Check for loose creatures (not in spawns)
-                            if (tile->creature) {
-                                // Check if this loose creature matches our search
-                                if (tile->creature->getName() == creature_name) {
-                                    wxString description = wxString::Format("%s (loose) at (%d,%d,%d)", 
-                                        wxString(creature_name.c_str(), wxConvUTF8), 
-                                        tile->getPosition().x, 
-                                        tile->getPosition().y, 
-                                        tile->getPosition().z);
-                                    result_window->AddPosition(description, tile->getPosition());
-                                    ++creature_found_count;
-                                }
-                            }
-                        }
+                for (MapIterator mit = map.begin(); mit != map.end(); ++mit) {
+                    ++tile_count;
+                    if (tile_count % 5000 == 0) {
+                        g_gui.SetLoadDone(int(tile_count * 100.0 / map.getTileCount()));
+                    }
+                    
+                    Tile* tile = (*mit)->get();
+                    if (!tile || !tile->creature || tile->creature->getName() != creature_name) {
+                        continue;
+                    }
+                    
+                    const Position& pos = tile->getPosition();
+                    covering.clear();
+                    map.spawns.getSpawnsCovering(pos, covering);
+                    matched_spawns.insert(covering.begin(), covering.end());
+                    
+                    wxString description = wxString::Format(covering.empty() ? "%s (loose) at (%d,%d,%d)" : "%s at (%d,%d,%d)", 
+                        wxString(creature_name.c_str(), wxConvUTF8), pos.x, pos.y, pos.z);
+                    result_window->AddPosition(description, pos);
+                    ++creature_found_count;
+                }
+                
+                // Spawns without this creature are still listed, as before
+                for (const Position& spawn_pos : map.spawns) {
+                    if (matched_spawns.count(spawn_pos) == 0) {
+                        wxString description = wxString::Format("Spawn for %s at (%d,%d,%d)", 
+                            wxString(creature_name.c_str(), wxConvUTF8), 
+                            spawn_pos.x, spawn_pos.y, spawn_pos.z);
+                        result_window->AddPosition(description, spawn_pos);
+                        ++creature_found_count;
                     }
                 }
                 
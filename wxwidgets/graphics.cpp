@@ -23,6 +23,7 @@
 #include "settings.h"
 #include "gui.h"
 #include "otml.h"
+#include "thumbnail_atlas.h"
 
 #include <wx/mstream.h>
 #include <wx/stopwatch.h>
@@ -189,7 +190,8 @@ GraphicManager::GraphicManager() :
 	has_frame_durations(false),
 	has_frame_groups(false),
 	loaded_textures(0),
-	lastclean(0) {
+	lastclean(0),
+	texture_generation(0) {
 	animation_timer = newd wxStopWatch();
 	animation_timer->Start();
 }
@@ -236,11 +238,13 @@ void GraphicManager::clear() {
 	sprite_space.swap(new_sprite_space);
 	image_space.clear();
 	cleanup_list.clear();
+	g_thumbnails.clear();
 
 	item_count = 0;
 	creature_count = 0;
 	loaded_textures = 0;
 	lastclean = time(nullptr);
+	++texture_generation;
 	spritefile = "";
 
 	unloaded = true;
@@ -252,6 +256,7 @@ void GraphicManager::cleanSoftwareSprites() {
 			iter->second->unloadDC();
 		}
 	}
+	g_thumbnails.clear();
 }
 
 Sprite* GraphicManager::getSprite(int id) {
@@ -955,6 +960,7 @@ void GraphicManager::garbageCollection() {
 				++sit;
 			}
 			lastclean = t;
+			++texture_generation;
 		}
 	}
 }
@@ -1051,6 +1057,10 @@ int GameSprite::getIndex(int width, int height, int layer, int pattern_x, int pa
 }
 
 GLuint GameSprite::getHardwareID(int _x, int _y, int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) {
+	return spriteList[getImageIndex(_x, _y, _layer, _count, _pattern_x, _pattern_y, _pattern_z, _frame)]->getHardwareID();
+}
+
+uint32_t GameSprite::getImageIndex(int _x, int _y, int _layer, int _count, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) const {
 	uint32_t v;
 	if (_count >= 0 && height <= 1 && width <= 1) {
 		v = _count;
@@ -1064,7 +1074,24 @@ GLuint GameSprite::getHardwareID(int _x, int _y, int _layer, int _count, int _pa
 			v %= numsprites;
 		}
 	}
-	return spriteList[v]->getHardwareID();
+	return v;
+}
+
+uint8_t* GameSprite::getImageRGBA(uint32_t index) {
+	if (index >= spriteList.size() || !spriteList[index]) {
+		return nullptr;
+	}
+	return spriteList[index]->getRGBAData();
+}
+
+uint8_t* GameSprite::getOutfitImageRGBA(uint32_t index, const Outfit& outfit) {
+	if (layers < 2 || outfit.getColorHash() == 0) {
+		return getImageRGBA(index);
+	}
+	if (index + width * height >= spriteList.size() || !spriteList[index] || !spriteList[index + width * height]) {
+		return nullptr;
+	}
+	return getTemplateImage(index, outfit)->getRGBAData();
 }
 
 GameSprite::TemplateImage* GameSprite::getTemplateImage(int sprite_index, const Outfit& outfit) {
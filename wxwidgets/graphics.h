@@ -83,6 +83,13 @@ public:
 
 	int getIndex(int width, int height, int layer, int pattern_x, int pattern_y, int pattern_z, int frame) const;
 	GLuint getHardwareID(int _x, int _y, int _layer, int _subtype, int _pattern_x, int _pattern_y, int _pattern_z, int _frame);
+	// Image getHardwareID would pick, for drawing without OpenGL
+	uint32_t getImageIndex(int _x, int _y, int _layer, int _subtype, int _pattern_x, int _pattern_y, int _pattern_z, int _frame) const;
+	// SPRITE_PIXELS x SPRITE_PIXELS RGBA copy of an image (delete[] it), nullptr if it can't be read.
+	// May read the sprite file, don't call it from two threads at once.
+	uint8_t* getImageRGBA(uint32_t index);
+	// Same as getImageRGBA, with the template layer colored by 'outfit' if the sprite has one
+	uint8_t* getOutfitImageRGBA(uint32_t index, const Outfit& outfit);
 	GLuint getHardwareID(int _x, int _y, int _dir, int _addon, int _pattern_z, const Outfit& _outfit, int _frame); // CreatureDatabase
 	virtual void DrawTo(wxDC* dc, SpriteSize sz, int start_x, int start_y, int width = -1, int height = -1);
 
@@ -300,6 +307,11 @@ public:
 	// Cleans old & unused textures according to config settings
 	void garbageCollection();
 	void addSpriteToCleanup(GameSprite* spr);
+	// Changes every time textures may have been unloaded (garbage collection or clear),
+	// anything holding on to texture ids recorded earlier has to record them again
+	uint32_t getTextureGeneration() const {
+		return texture_generation;
+	}
 
 	wxFileName getMetadataFileName() const {
 		return metadata_file;
@@ -338,6 +350,7 @@ private:
 
 	int loaded_textures;
 	int lastclean;
+	uint32_t texture_generation;
 
 	wxStopWatch* animation_timer;
 
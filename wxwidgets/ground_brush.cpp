@@ -557,19 +557,24 @@ void GroundBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 		}
 	}
 	
-	// Get a random ground ID
-	int chance = random(1, total_chance);
+	setGround(tile, getGroundID(random(1, total_chance)));
+}
+
+uint16_t GroundBrush::getGroundID(int roll) const {
+	if (border_items.empty()) {
+		return 0;
+	}
 	uint16_t id = 0;
 	for (std::vector<ItemChanceBlock>::const_iterator it = border_items.begin(); it != border_items.end(); ++it) {
-		if (chance < it->chance) {
+		if (roll < it->chance) {
 			id = it->id;
 			break;
 		}
 	}
-	if (id == 0) {
-		id = border_items.front().id;
-	}
+	return id != 0 ? id : border_items.front().id;
+}
 
+void GroundBrush::setGround(Tile* tile, uint16_t id) {
 	// Create the ground item
 	Item* groundItem = Item::Create(id);
 	
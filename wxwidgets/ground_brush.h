@@ -43,6 +43,13 @@ public:
 
 	virtual void draw(BaseMap* map, Tile* tile, void* parameter);
 	virtual void undraw(BaseMap* map, Tile* tile);
+	// Ground id picked by a roll in [1, getTotalChance()], 0 if the brush has no grounds
+	uint16_t getGroundID(int roll) const;
+	int getTotalChance() const {
+		return total_chance;
+	}
+	// Replaces the ground of the tile (and any ground items lying among its items) with a new 'id'
+	static void setGround(Tile* tile, uint16_t id);
 	static void doBorders(BaseMap* map, Tile* tile);
 	static const BorderBlock* getBrushTo(GroundBrush* from, GroundBrush* to);
 	static void reborderizeTile(BaseMap* map, Tile* tile);
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "ground_randomizer.h"
+#include "worker_pool.h"
+#include "ground_brush.h"
+#include "basemap.h"
+
+namespace {
+	// splitmix64 finalizer, spreads neighbouring keys over the whole 64 bit range
+	uint64_t mix(uint64_t value) {
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+}
+
+GroundRandomizer::GroundRandomizer(uint64_t seed, bool rerandomizable_only) :
+	seed(seed),
+	rerandomizable_only(rerandomizable_only) {
+	////
+}
+
+uint64_t GroundRandomizer::roll(int x, int y, int z) const {
+	// Stream of the 4x4 leaf holding the tile, then the tile's own slot in it
+	const uint64_t leaf = (uint64_t(uint32_t(x >> 2)) << 32) | uint32_t(y >> 2);
+	const uint64_t stream = mix(seed ^ mix(leaf));
+	const uint64_t slot = uint64_t(z) * 16 + (x & 3) * 4 + (y & 3);
+	return mix(stream + (slot + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+std::vector<Tile*> GroundRandomizer::randomize(BaseMap& map, const std::vector<Tile*>& tiles, const std::function<void(int)>& progress) const {
+	std::vector<Tile*> result(tiles.size(), nullptr);
+
+	WorkerPool pool;
+	const size_t parts = std::max<size_t>(1, std::min(pool.size() * 4, tiles.size() / 4096 + 1));
+	std::atomic<size_t> parts_done(0);
+
+	// Every part writes its own range of 'result', the source tiles are only read
+	for (size_t part = 0; part < parts; ++part) {
+		pool.submit([&, part]() {
+			const size_t begin = tiles.size() * part / parts;
+			const size_t end = tiles.size() * (part + 1) / parts;
+			for (size_t index = begin; index < end; ++index) {
+				Tile* tile = tiles[index];
+				GroundBrush* brush = tile->getGroundBrush();
+				if (!brush || brush->getTotalChance() <= 0 || (rerandomizable_only && !brush->isReRandomizable())) {
+					continue;
+				}
+
+				const Position& position = tile->getPosition();
+				const int chance = 1 + int(roll(position.x, position.y, position.z) % uint64_t(brush->getTotalChance()));
+
+				Tile* new_tile = tile->deepCopy(map);
+				GroundBrush::setGround(new_tile, brush->getGroundID(chance));
+
+				// Scripts rely on these, keep them on the new ground
+				Item* old_ground = tile->ground;
+				Item* new_ground = new_tile->ground;
+				if (old_ground && new_ground) {
+					new_ground->setActionID(old_ground->getActionID());
+					new_ground->setUniqueID(old_ground->getUniqueID());
+				}
+				result[index] = new_tile;
+			}
+			++parts_done;
+		});
+	}
+
+	while (!pool.waitFor(std::chrono::milliseconds(100))) {
+		if (progress) {
+			progress(int(std::min<size_t>(99, parts_done * 100 / parts)));
+		}
+	}
+	return result;
+}
@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_GROUND_RANDOMIZER_H_
+#define RME_GROUND_RANDOMIZER_H_
+
+#include <functional>
+#include <vector>
+
+class BaseMap;
+class Tile;
+
+// Re-rolls the ground of tiles painted with a ground brush.
+// Every quad tree leaf draws from its own random stream, derived from the seed and the leaf
+// coordinates, and every tile takes a fixed slot of its leaf's stream. A tile therefore gets
+// the same ground for the same seed however the work is spread over threads, and whether it
+// is randomized with the whole map or as part of a selection.
+class GroundRandomizer {
+public:
+	// 'rerandomizable_only' skips brushes that don't allow re-randomizing
+	GroundRandomizer(uint64_t seed, bool rerandomizable_only);
+
+	// Returns a re-rolled copy of each tile (nullptr where the ground brush doesn't apply),
+	// index for index with 'tiles'. The copies are built on worker threads; 'progress' is
+	// called with a percentage on the calling thread while they run.
+	std::vector<Tile*> randomize(BaseMap& map, const std::vector<Tile*>& tiles, const std::function<void(int)>& progress = nullptr) const;
+
+	// The roll (0 to 2^64 - 1) of the tile at x, y, z
+	uint64_t roll(int x, int y, int z) const;
+
+private:
+	uint64_t seed;
+	bool rerandomizable_only;
+};
+
+#endif
@@ -174,6 +174,7 @@
 #include "live_tab.h"
 #include "live_server.h"
 #include "dark_mode_manager.h"
+#include "load_graph.h"
 #include <wx/regex.h>
 
 #ifdef __WXOSX__
@@ -238,7 +239,8 @@ GUI::GUI() :
 	winDisabler(nullptr),
 	disabled_counter(0),
 	last_autosave(time(nullptr)),
-	last_autosave_check(time(nullptr))
+	last_autosave_check(time(nullptr)),
+	last_page_trim(0)
 {
 }
 
@@ -536,67 +538,87 @@ bool GUI::LoadDataFiles(wxString& error, wxArrayString& warnings) {
 	g_gui.CreateLoadBar("Loading asset files");
 	g_gui.SetLoadDone(0, "Loading metadata file...");
 
+	// Only the real dependencies are joined: sprite data, items.otb and creatures.xml
+	// only need the metadata (sprite objects), items.xml needs items.otb and brushes
+	// need everything before them.
+	wxString data_dir = data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR);
 	wxFileName metadata_path = g_gui.gfx.getMetadataFileName();
-	if (!g_gui.gfx.loadSpriteMetadata(metadata_path, error, warnings)) {
-		error = "Couldn't load metadata: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
-		return false;
-	}
+	wxFileName sprites_path = g_gui.gfx.getSpritesFileName();
+	FileName user_creatures_path = getLoadedVersion()->getLocalDataPath();
+	user_creatures_path.SetFullName("creatures.xml");
 
-	g_gui.SetLoadDone(10, "Loading sprites file...");
+	LoadGraph graph;
+	LoadGraph::StageID metadata = graph.addStage("Loading metadata file...", 10, [&metadata_path](wxString& error, wxArrayString& warnings) {
+		if (!g_gui.gfx.loadSpriteMetadata(metadata_path, error, warnings)) {
+			error = "Couldn't load metadata: " + error;
+			return false;
+		}
+		return true;
+	});
 
-	wxFileName sprites_path = g_gui.gfx.getSpritesFileName();
-	if (!g_gui.gfx.loadSpriteData(sprites_path.GetFullPath(), error, warnings)) {
-		error = "Couldn't load sprites: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
-		return false;
-	}
+	LoadGraph::StageID sprites = graph.addStage("Loading sprites file...", 10, [&sprites_path](wxString& error, wxArrayString& warnings) {
+		if (!g_gui.gfx.loadSpriteData(sprites_path.GetFullPath(), error, warnings)) {
+			error = "Couldn't load sprites: " + error;
+			return false;
+		}
+		return true;
+	}, { metadata });
 
-	g_gui.SetLoadDone(20, "Loading items.otb file...");
-	if (!g_items.loadFromOtb(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "items.otb"), error, warnings)) {
-		error = "Couldn't load items.otb: " + error;
-		g_gui.DestroyLoadBar();
-		UnloadVersion();
-		return false;
-	}
+	LoadGraph::StageID otb = graph.addStage("Loading items.otb file...", 10, [&data_dir](wxString& error, wxArrayString& warnings) {
+		if (!g_items.loadFromOtb(wxString(data_dir + "items.otb"), error, warnings)) {
+			error = "Couldn't load items.otb: " + error;
+			return false;
+		}
+		return true;
+	}, { metadata });
 
-	g_gui.SetLoadDone(30, "Loading items.xml ...");
-	if (!g_items.loadFromGameXml(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "items.xml"), error, warnings)) {
-		warnings.push_back("Couldn't load items.xml: " + error);
-	}
+	LoadGraph::StageID items_xml = graph.addStage("Loading items.xml ...", 15, [&data_dir](wxString& error, wxArrayString& warnings) {
+		if (!g_items.loadFromGameXml(wxString(data_dir + "items.xml"), error, warnings)) {
+			warnings.push_back("Couldn't load items.xml: " + error);
+		}
+		return true;
+	}, { otb });
 
-	g_gui.SetLoadDone(45, "Loading creatures.xml ...");
-	if (!g_creatures.loadFromXML(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "creatures.xml"), true, error, warnings)) {
-		warnings.push_back("Couldn't load creatures.xml: " + error);
-	}
+	LoadGraph::StageID creatures = graph.addStage("Loading creatures.xml ...", 5, [&data_dir, &user_creatures_path](wxString& error, wxArrayString& warnings) {
+		if (!g_creatures.loadFromXML(wxString(data_dir + "creatures.xml"), true, error, warnings)) {
+			warnings.push_back("Couldn't load creatures.xml: " + error);
+		}
 
-	g_gui.SetLoadDone(45, "Loading user creatures.xml ...");
-	{
-		FileName cdb = getLoadedVersion()->getLocalDataPath();
-		cdb.SetFullName("creatures.xml");
 		wxString nerr;
 		wxArrayString nwarn;
-		g_creatures.loadFromXML(cdb, false, nerr, nwarn);
-	}
+		g_creatures.loadFromXML(user_creatures_path, false, nerr, nwarn);
+		return true;
+	}, { metadata });
 
-	g_gui.SetLoadDone(50, "Loading materials.xml ...");
-	if (!g_materials.loadMaterials(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "materials.xml"), error, warnings)) {
-		warnings.push_back("Couldn't load materials.xml: " + error);
-	}
-	
-	g_gui.SetLoadDone(60, "Loading collections.xml ...");
-	if (!g_materials.loadMaterials(wxString(data_path.GetPath(wxPATH_GET_VOLUME | wxPATH_GET_SEPARATOR) + "collections.xml"), error, warnings)) {
-		warnings.push_back("Couldn't load collections.xml: " + error);
-	}
-	
-	g_gui.SetLoadDone(70, "Loading extensions...");
-	if (!g_materials.loadExtensions(extension_path, error, warnings)) {
-		// warnings.push_back("Couldn't load extensions: " + error);
+	// Materials create brushes and tilesets, keep them on this thread
+	LoadGraph::StageID materials = graph.addStage("Loading materials.xml ...", 15, [&data_dir](wxString& error, wxArrayString& warnings) {
+		if (!g_materials.loadMaterials(wxString(data_dir + "materials.xml"), error, warnings)) {
+			warnings.push_back("Couldn't load materials.xml: " + error);
+		}
+		return true;
+	}, { sprites, items_xml, creatures }, true);
+
+	LoadGraph::StageID collections = graph.addStage("Loading collections.xml ...", 10, [&data_dir](wxString& error, wxArrayString& warnings) {
+		if (!g_materials.loadMaterials(wxString(data_dir + "collections.xml"), error, warnings)) {
+			warnings.push_back("Couldn't load collections.xml: " + error);
+		}
+		return true;
+	}, { materials }, true);
+
+	graph.addStage("Loading extensions...", 5, [&extension_path](wxString& error, wxArrayString& warnings) {
+		if (!g_materials.loadExtensions(extension_path, error, warnings)) {
+			// warnings.push_back("Couldn't load extensions: " + error);
+		}
+		return true;
+	}, { collections }, true);
+
+	if (!graph.run(error, warnings)) {
+		g_gui.DestroyLoadBar();
+		UnloadVersion();
+		return false;
 	}
 
-	g_gui.SetLoadDone(70, "Finishing...");
+	g_gui.SetLoadDone(95, "Finishing...");
 	g_brushes.init();
 	g_materials.createOtherTileset();
 
@@ -2241,7 +2263,6 @@ void GUI::FillDoodadPreviewBuffer() {
 		return;
 	}
 
-	int object_count = 0;
 	int area;
 	if (GetBrushShape() == BRUSHSHAPE_SQUARE) {
 		area = 2 * GetBrushSize();
@@ -2261,101 +2282,7 @@ void GUI::FillDoodadPreviewBuffer() {
 	Position center_pos(0x8000, 0x8000, 0x8);
 
 	if (brush_size > 0 && !brush->oneSizeFitsAll()) {
-		while (object_count < final_object_count) {
-			int retries = 0;
-			bool exit = false;
-
-			// Try to place objects 5 times
-			while (retries < 5 && !exit) {
-
-				int pos_retries = 0;
-				int xpos = 0, ypos = 0;
-				bool found_pos = false;
-				if (GetBrushShape() == BRUSHSHAPE_CIRCLE) {
-					while (pos_retries < 5 && !found_pos) {
-						xpos = random(-brush_size, brush_size);
-						ypos = random(-brush_size, brush_size);
-						float distance = sqrt(float(xpos * xpos) + float(ypos * ypos));
-						if (distance < g_gui.GetBrushSize() + 0.005) {
-							found_pos = true;
-						} else {
-							++pos_retries;
-						}
-					}
-				} else {
-					found_pos = true;
-					xpos = random(-brush_size, brush_size);
-					ypos = random(-brush_size, brush_size);
-				}
-
-				if (!found_pos) {
-					++retries;
-					continue;
-				}
-
-				// Decide whether the zone should have a composite or several single objects.
-				bool fail = false;
-				if (random(brush->getTotalChance(GetBrushVariation())) <= brush->getCompositeChance(GetBrushVariation())) {
-					// Composite
-					const CompositeTileList& composites = brush->getComposite(GetBrushVariation());
-
-					// Figure out if the placement is valid
-					for (const auto& composite : composites) {
-						// Include the z offset in the position calculation
-						Position pos = center_pos + Position(composite.first.x + xpos, composite.first.y + ypos, composite.first.z);
-						if (Tile* tile = doodad_buffer_map.get()->getTile(pos)) {
-							if (!tile->empty()) {
-								fail = true;
-								break;
-							}
-						}
-					}
-					if (fail) {
-						++retries;
-						break;
-					}
-
-					// Transfer items to the stack
-					for (const auto& composite : composites) {
-						// Include the z offset in the position calculation
-						Position pos = center_pos + Position(composite.first.x + xpos, composite.first.y + ypos, composite.first.z);
-						const ItemVector& items = composite.second;
-						Tile* tile = doodad_buffer_map.get()->getTile(pos);
-
-						if (!tile) {
-							tile = doodad_buffer_map.get()->allocator(doodad_buffer_map.get()->createTileL(pos));
-						}
-
-						for (auto item : items) {
-							tile->addItem(item->deepCopy());
-						}
-						doodad_buffer_map.get()->setTile(tile->getPosition(), tile);
-					}
-					exit = true;
-				} else if (brush->hasSingleObjects(GetBrushVariation())) {
-					Position pos = center_pos + Position(xpos, ypos, 0);
-					Tile* tile = doodad_buffer_map.get()->getTile(pos);
-					if (tile) {
-						if (!tile->empty()) {
-							fail = true;
-							break;
-						}
-					} else {
-						tile = doodad_buffer_map.get()->allocator(doodad_buffer_map.get()->createTileL(pos));
-					}
-					int variation = GetBrushVariation();
-					brush->draw(doodad_buffer_map.get(), tile, &variation);
-					// std::cout << "\tpos: " << tile->getPosition() << std::endl;
-					doodad_buffer_map.get()->setTile(tile->getPosition(), tile);
-					exit = true;
-				}
-				if (fail) {
-					++retries;
-					break;
-				}
-			}
-			++object_count;
-		}
+		brush->scatter(doodad_buffer_map.get(), center_pos, GetBrushVariation(), brush_size, GetBrushShape() == BRUSHSHAPE_CIRCLE, final_object_count);
 	} else {
 		if (brush->hasCompositeObjects(GetBrushVariation()) && random(brush->getTotalChance(GetBrushVariation())) <= brush->getCompositeChance(GetBrushVariation())) {
 			// Composite
@@ -2567,6 +2494,49 @@ int GUI::GetHotkeyEventId(const std::string& action) {
 	return -1; // Temporary return until implementation
 }
 
+void GUI::TrimMapPages() {
+	uint32_t now = time(nullptr);
+
+	// Once per second is plenty, leaves are only evicted after a few seconds without use
+	if (now == last_page_trim) {
+		return;
+	}
+	last_page_trim = now;
+
+	// Loading, saving and other long operations run with a progress bar and walk the maps themselves
+	if (progressBar || !tabbook) {
+		return;
+	}
+
+	std::vector<Map*> maps;
+	for (int index = 0; index < tabbook->GetTabCount(); ++index) {
+		auto* tab = dynamic_cast<MapTab*>(tabbook->GetTab(index));
+		// Live maps are synchronized leaf by leaf with the server, they stay in memory
+		if (tab && !tab->GetEditor()->IsLive() && std::find(maps.begin(), maps.end(), tab->GetMap()) == maps.end()) {
+			maps.push_back(tab->GetMap());
+		}
+	}
+
+	const uint64_t budget = static_cast<uint64_t>(g_settings.getInteger(Config::PAGED_MAP_MEMORY)) * 1024 * 1024;
+	if (budget > 0 && maps.empty()) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> minimap_lock;
+	if (minimap) {
+		minimap_lock = std::unique_lock<std::mutex>(minimap->GetRenderMutex(), std::try_to_lock);
+		if (!minimap_lock.owns_lock()) {
+			// The minimap is reading tiles right now, try again next time
+			return;
+		}
+	}
+
+	for (Map* map : maps) {
+		map->setPageBudget(budget / maps.size());
+		map->trimPages();
+	}
+}
+
 void GUI::CheckAutoSave() {
 	uint32_t now = time(nullptr);
 	
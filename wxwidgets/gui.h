@@ -520,6 +520,11 @@ public:
 	uint32_t last_autosave;
 	uint32_t last_autosave_check;
 
+	// Splits Config::PAGED_MAP_MEMORY between the open maps and pages out what doesn't fit,
+	// called from the idle handler so no tiles are held by anything when leaves are evicted
+	void TrimMapPages();
+	uint32_t last_page_trim;
+
 	// Dark mode
 	void ApplyDarkMode();
 
@@ -21,6 +21,7 @@
 #include "house.h"
 #include "tile.h"
 #include "map.h"
+#include "action.h"
 
 Houses::Houses(Map& map) :
 	map(map),
@@ -106,8 +107,10 @@ House::House(Map& map) :
 	townid(0),
 	guildhall(false),
 	map(&map),
-	exit(0, 0, 0) {
-	////
+	exit(0, 0, 0),
+	walkable_count(0),
+	bounds_dirty(false) {
+	door_counts.fill(0);
 }
 
 House::~House() {
@@ -115,7 +118,10 @@ House::~House() {
 }
 
 void House::clean() {
-	for (PositionList::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
+	if (!tiles.empty()) {
+		map->statistics.invalidate();
+	}
+	for (PositionVector::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
 		Tile* tile = map->getTile(*pos_iter);
 		if (tile) {
 			tile->setHouse(nullptr);
@@ -128,49 +134,165 @@ void House::clean() {
 	}
 }
 
-size_t House::size() const {
-	size_t count = 0;
-	for (PositionList::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
-		Tile* tile = map->getTile(*pos_iter);
-		if (tile && !tile->isBlocking()) {
-			++count;
+void House::describeTile(const Tile* tile, TileEntry& entry) {
+	entry.walkable = !tile->isBlocking();
+	entry.doors.clear();
+	for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
+		if ((*item_iter)->isDoor()) {
+			if (const Door* door = dynamic_cast<const Door*>(*item_iter)) {
+				entry.doors.push_back(door->getDoorID());
+			}
 		}
 	}
-	return count;
+}
+
+void House::countTile(const TileEntry& entry, int sign) {
+	if (entry.walkable) {
+		walkable_count += sign;
+	}
+	for (uint8_t door_id : entry.doors) {
+		door_counts[door_id] += sign;
+	}
+}
+
+void House::updateBounds() const {
+	min_position = max_position = tiles.front();
+	for (PositionVector::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
+		const Position& pos = *pos_iter;
+		min_position.x = std::min(min_position.x, pos.x);
+		min_position.y = std::min(min_position.y, pos.y);
+		min_position.z = std::min(min_position.z, pos.z);
+		max_position.x = std::max(max_position.x, pos.x);
+		max_position.y = std::max(max_position.y, pos.y);
+		max_position.z = std::max(max_position.z, pos.z);
+	}
+	bounds_dirty = false;
+}
+
+bool House::getBounds(Position& min_pos, Position& max_pos) const {
+	if (tiles.empty()) {
+		return false;
+	}
+	if (bounds_dirty) {
+		updateBounds();
+	}
+	min_pos = min_position;
+	max_pos = max_position;
+	return true;
 }
 
 void House::addTile(Tile* tile) {
 	ASSERT(tile);
+	if (tile->getHouseID() != id && map->getTile(tile->getPosition()) == tile) {
+		// Changed in place, actions hand over tiles that already belong to the house
+		map->statistics.invalidate();
+	}
 	tile->setHouse(this);
-	tiles.push_back(tile->getPosition());
+
+	const Position& pos = tile->getPosition();
+	std::pair<std::unordered_map<uint64_t, TileEntry>::iterator, bool> result = tile_index.emplace(tileKey(pos), TileEntry());
+	TileEntry& entry = result.first->second;
+	if (result.second) {
+		entry.slot = tiles.size();
+		tiles.push_back(pos);
+		if (tiles.size() == 1) {
+			min_position = max_position = pos;
+			bounds_dirty = false;
+		} else if (!bounds_dirty) {
+			min_position.x = std::min(min_position.x, pos.x);
+			min_position.y = std::min(min_position.y, pos.y);
+			min_position.z = std::min(min_position.z, pos.z);
+			max_position.x = std::max(max_position.x, pos.x);
+			max_position.y = std::max(max_position.y, pos.y);
+			max_position.z = std::max(max_position.z, pos.z);
+		}
+	} else {
+		// Added again, the tile may have changed since
+		countTile(entry, -1);
+	}
+	describeTile(tile, entry);
+	countTile(entry, 1);
 }
 
 void House::removeTile(Tile* tile) {
 	ASSERT(tile);
-	for (PositionList::iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (*tile_iter == tile->getPosition()) {
-			tiles.erase(tile_iter);
-			tile->setHouse(nullptr);
-			return;
-		}
+	const Position pos = tile->getPosition();
+	std::unordered_map<uint64_t, TileEntry>::iterator it = tile_index.find(tileKey(pos));
+	if (it == tile_index.end()) {
+		return;
+	}
+	countTile(it->second, -1);
+
+	// Move the last tile into the freed slot
+	const size_t slot = it->second.slot;
+	tile_index.erase(it);
+	if (slot != tiles.size() - 1) {
+		tiles[slot] = tiles.back();
+		tile_index[tileKey(tiles[slot])].slot = slot;
+	}
+	tiles.pop_back();
+
+	if (tile->getHouseID() != 0 && map->getTile(pos) == tile) {
+		map->statistics.invalidate();
+	}
+
+	// Only a tile on the edge of the box can make it smaller
+	if (pos.x == min_position.x || pos.y == min_position.y || pos.z == min_position.z || pos.x == max_position.x || pos.y == max_position.y || pos.z == max_position.z) {
+		bounds_dirty = true;
 	}
+
+	tile->setHouse(nullptr);
 }
 
-uint8_t House::getEmptyDoorID() const {
-	std::set<uint8_t> taken;
-	for (PositionList::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (const Tile* tile = map->getTile(*tile_iter)) {
-			for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-				if (Door* door = dynamic_cast<Door*>(*item_iter)) {
-					taken.insert(door->getDoorID());
-				}
+void House::updateTile(Tile* tile) {
+	ASSERT(tile);
+	std::unordered_map<uint64_t, TileEntry>::iterator it = tile_index.find(tileKey(tile->getPosition()));
+	if (it != tile_index.end()) {
+		countTile(it->second, -1);
+		describeTile(tile, it->second);
+		countTile(it->second, 1);
+	}
+}
+
+uint64_t House::removeLooseItems(Action* action) {
+	uint64_t removed = 0;
+	for (PositionVector::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
+		Tile* tile = map->getTile(*pos_iter);
+		if (!tile) {
+			continue;
+		}
+
+		// Same rule the house brush uses when it clears a tile
+		uint64_t loose = 0;
+		for (ItemVector::const_iterator it = tile->items.begin(); it != tile->items.end(); ++it) {
+			if ((*it)->isNotMoveable() == 0) {
+				++loose;
+			}
+		}
+		if (loose == 0) {
+			continue;
+		}
+
+		Tile* new_tile = tile->deepCopy(*map);
+		for (ItemVector::iterator it = new_tile->items.begin(); it != new_tile->items.end();) {
+			Item* item = *it;
+			if (item->isNotMoveable() == 0) {
+				delete item;
+				it = new_tile->items.erase(it);
+			} else {
+				++it;
 			}
 		}
+		new_tile->update();
+		action->addChange(newd Change(new_tile));
+		removed += loose;
 	}
+	return removed;
+}
 
+uint8_t House::getEmptyDoorID() const {
 	for (int i = 1; i < 256; ++i) {
-		std::set<uint8_t>::iterator it = taken.find(uint8_t(i));
-		if (it == taken.end()) {
+		if (door_counts[i] == 0) {
 			// Free ID!
 			return i;
 		}
@@ -179,7 +301,11 @@ uint8_t House::getEmptyDoorID() const {
 }
 
 Position House::getDoorPositionByID(uint8_t id) const {
-	for (PositionList::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
+	if (door_counts[id] == 0) {
+		return Position();
+	}
+
+	for (PositionVector::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
 		if (const Tile* tile = map->getTile(*tile_iter)) {
 			for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
 				if (Door* door = dynamic_cast<Door*>(*item_iter)) {
@@ -20,9 +20,14 @@
 
 #include "position.h"
 
+#include <array>
+#include <unordered_map>
+#include <vector>
+
 class Map;
 class Tile;
 class Door;
+class Action;
 
 class Houses;
 
@@ -41,7 +46,23 @@ public:
 	void clean();
 	void addTile(Tile* tile);
 	void removeTile(Tile* tile);
-	size_t size() const;
+	// The tile at this position was replaced by one of the same house, its items may differ
+	void updateTile(Tile* tile);
+	bool hasTile(const Position& pos) const {
+		return tile_index.find(tileKey(pos)) != tile_index.end();
+	}
+	// Number of walkable house tiles
+	size_t size() const {
+		return walkable_count;
+	}
+	size_t getTileCount() const {
+		return tiles.size();
+	}
+	// Smallest box holding every house tile, false if the house has none
+	bool getBounds(Position& min_pos, Position& max_pos) const;
+	// Adds a copy without the moveable items of every house tile that has some to 'action',
+	// returns how many items the copies leave out
+	uint64_t removeLooseItems(Action* action);
 	std::string getDescription();
 
 	int rent;
@@ -59,16 +80,40 @@ public:
 	Position getDoorPositionByID(uint8_t id) const;
 
 	// Added accessor to retrieve the list of tile positions for export functionality.
-	const PositionList& getTilePositions() const { return tiles; }
+	const PositionVector& getTilePositions() const { return tiles; }
 
 private:
 	uint32_t id;
 
 protected:
+	static uint64_t tileKey(const Position& pos) {
+		return (uint64_t(uint32_t(pos.x)) << 32) | (uint64_t(uint32_t(pos.y) & 0xFFFFFF) << 8) | uint64_t(pos.z & 0xFF);
+	}
+	// What a tile adds to the counts below, kept so it can be taken out again
+	struct TileEntry {
+		size_t slot = 0; // Index in 'tiles'
+		bool walkable = false;
+		std::vector<uint8_t> doors; // Ids of the doors on the tile
+	};
+	static void describeTile(const Tile* tile, TileEntry& entry);
+	void countTile(const TileEntry& entry, int sign);
+	void updateBounds() const;
+
 	Map* map;
-	PositionList tiles;
+	// Tiles in the order they were added, 'tile_index' holds the slot of each one so
+	// lookups are O(1) and removal is a swap with the last slot.
+	PositionVector tiles;
+	std::unordered_map<uint64_t, TileEntry> tile_index;
 	Position exit;
 
+	// Updated in place whenever a tile is added, removed or changed. Only the bounds are
+	// rebuilt, the next time they are needed after a tile on their edge was removed.
+	size_t walkable_count;
+	std::array<uint32_t, 256> door_counts; // Doors per id
+	mutable bool bounds_dirty;
+	mutable Position min_position;
+	mutable Position max_position;
+
 	friend class Houses;
 };
 
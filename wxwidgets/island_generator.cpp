@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "island_generator.h"
+#include "worker_pool.h"
+#include "basemap.h"
+#include "tile.h"
+#include "item.h"
+
+namespace {
+	const int Lanes = IslandGenerator::ChunkSize;
+
+	// Integer hash of a lattice point, in [0, 1)
+	inline float lattice(uint32_t seed, int32_t x, int32_t y) {
+		uint32_t n = seed + uint32_t(x) * 1997u + uint32_t(y) * 17931u;
+		n = (n << 13) ^ n;
+		return float((n * (n * n * 15731u + 789221u) + 1376312589u) & 0x7FFFFFFFu) * (1.0f / 2147483648.0f);
+	}
+
+	inline float fade(float t) {
+		return t * t * (3.0f - 2.0f * t);
+	}
+
+	inline float lerp(float a, float b, float t) {
+		return a + (b - a) * t;
+	}
+
+	// Fractal value noise in [0, 1] for the tiles x0 to x0 + Lanes - 1 of row y.
+	// Every octave doubles the frequency and halves the weight of the previous one.
+	void fractalRow(uint32_t seed, float frequency, int octaves, int x0, int y, float* out) {
+		float sum[Lanes] = {};
+		float amplitude = 1.0f;
+		float total = 0.0f;
+		for (int octave = 0; octave < octaves; ++octave) {
+			const uint32_t octave_seed = seed + uint32_t(octave) * 0x9E3779B9u;
+			const float fy = y * frequency;
+			const int32_t iy = int32_t(std::floor(fy));
+			const float ty = fade(fy - iy);
+
+			for (int lane = 0; lane < Lanes; ++lane) {
+				const float fx = (x0 + lane) * frequency;
+				const int32_t ix = int32_t(std::floor(fx));
+				const float tx = fade(fx - ix);
+				const float top = lerp(lattice(octave_seed, ix, iy), lattice(octave_seed, ix + 1, iy), tx);
+				const float bottom = lerp(lattice(octave_seed, ix, iy + 1), lattice(octave_seed, ix + 1, iy + 1), tx);
+				sum[lane] += amplitude * lerp(top, bottom, ty);
+			}
+
+			total += amplitude;
+			amplitude *= 0.5f;
+			frequency *= 2.0f;
+		}
+
+		const float scale = 1.0f / total;
+		for (int lane = 0; lane < Lanes; ++lane) {
+			out[lane] = sum[lane] * scale;
+		}
+	}
+}
+
+IslandGenerator::IslandGenerator(uint32_t seed, int size, int roughness, Shape shape) :
+	seed(seed),
+	side(std::max(1, size + 1)),
+	roughness(roughness),
+	shape(shape) {
+	////
+}
+
+void IslandGenerator::generate(WorkerPool& pool) {
+	mask.assign(size_t(side) * side, 0);
+
+	// Chunks write disjoint parts of the mask
+	const int chunks = (side + ChunkSize - 1) / ChunkSize;
+	pool.parallelFor(size_t(chunks) * chunks, [this, chunks](size_t index) {
+		shapeChunk(int(index % chunks), int(index / chunks));
+	});
+
+	keepConnected();
+}
+
+void IslandGenerator::shapeChunk(int chunk_x, int chunk_y) {
+	const float radius = (side - 1) / 2.0f;
+	const float influence = roughness / (shape == SHAPE_IRREGULAR ? 100.0f : 200.0f);
+	const int x0 = chunk_x * ChunkSize;
+	const int width = std::min(ChunkSize, side - x0);
+
+	float base[Lanes];
+	float detail[Lanes];
+	uint8_t land[Lanes];
+
+	for (int y = chunk_y * ChunkSize; y < std::min(side, (chunk_y + 1) * ChunkSize); ++y) {
+		// Broad coast line plus some finer wobble on top of it
+		fractalRow(seed, 0.05f, 3, x0, y, base);
+		fractalRow(seed ^ 0x5BD1E995u, 0.15f, 2, x0, y, detail);
+
+		const float dy = (y - radius) / radius;
+		for (int lane = 0; lane < Lanes; ++lane) {
+			const float dx = (x0 + lane - radius) / radius;
+			const float distance = shape == SHAPE_SQUARE ? std::max(std::abs(dx), std::abs(dy)) : std::sqrt(dx * dx + dy * dy);
+			const float threshold = 1.0f - influence * (base[lane] * 0.7f + detail[lane] * 0.3f);
+			land[lane] = distance <= threshold ? 1 : 0;
+		}
+		std::copy(land, land + width, mask.begin() + size_t(y) * side + x0);
+	}
+}
+
+void IslandGenerator::keepConnected() {
+	const int centre = (side / 2) * side + side / 2;
+	if (!mask[centre]) {
+		return;
+	}
+
+	// Breadth first over the 8 neighbours, reached land is marked 2
+	std::vector<int> queue;
+	queue.reserve(mask.size());
+	queue.push_back(centre);
+	mask[centre] = 2;
+	for (size_t head = 0; head < queue.size(); ++head) {
+		const int x = queue[head] % side;
+		const int y = queue[head] / side;
+		for (int ny = std::max(0, y - 1); ny <= std::min(side - 1, y + 1); ++ny) {
+			for (int nx = std::max(0, x - 1); nx <= std::min(side - 1, x + 1); ++nx) {
+				uint8_t& cell = mask[ny * side + nx];
+				if (cell == 1) {
+					cell = 2;
+					queue.push_back(ny * side + nx);
+				}
+			}
+		}
+	}
+
+	for (uint8_t& cell : mask) {
+		cell = cell == 2 ? 1 : 0;
+	}
+}
+
+std::vector<Tile*> IslandGenerator::buildRows(BaseMap& map, WorkerPool& pool, const std::vector<TileLocation*>& locations, int row_begin, int row_end, uint16_t ground_id, uint16_t water_id) const {
+	std::vector<Tile*> result(size_t(row_end - row_begin) * side, nullptr);
+
+	const int chunks = (side + ChunkSize - 1) / ChunkSize;
+	pool.parallelFor(chunks, [&](size_t chunk) {
+		const int x0 = int(chunk) * ChunkSize;
+		const int x1 = std::min(side, x0 + ChunkSize);
+		for (int y = row_begin; y < row_end; ++y) {
+			for (int x = x0; x < x1; ++x) {
+				TileLocation* location = locations[size_t(y) * side + x];
+				Tile* tile = location->get();
+				Tile* new_tile = tile ? tile->deepCopy(map) : map.allocator(location);
+
+				const uint16_t id = mask[size_t(y) * side + x] ? ground_id : water_id;
+				if (id != 0) {
+					new_tile->addItem(Item::Create(id));
+				}
+				result[size_t(y - row_begin) * side + x] = new_tile;
+			}
+		}
+	});
+	return result;
+}
@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_ISLAND_GENERATOR_H_
+#define RME_ISLAND_GENERATOR_H_
+
+#include <vector>
+
+class BaseMap;
+class Tile;
+class TileLocation;
+class WorkerPool;
+
+// Shapes an island of (size + 1) x (size + 1) tiles from fractal value noise and builds its tiles.
+// The land mask is evaluated in 32x32 chunks on worker threads, a whole chunk row of noise at a
+// time, so the inner loops are plain per-lane arithmetic the compiler can vectorize. The result
+// only depends on the seed, never on how the chunks were spread over the threads.
+class IslandGenerator {
+public:
+	enum Shape {
+		SHAPE_CIRCULAR,
+		SHAPE_SQUARE,
+		SHAPE_IRREGULAR,
+	};
+
+	static const int ChunkSize = 32;
+
+	// 'roughness' is 0 to 100, how far the noise may pull the coast in
+	IslandGenerator(uint32_t seed, int size, int roughness, Shape shape);
+
+	// Evaluates the land mask and drops land that isn't connected to the centre
+	void generate(WorkerPool& pool);
+
+	// Width and height of the island in tiles
+	int getSide() const {
+		return side;
+	}
+	// Island relative, false outside the island
+	bool isLand(int x, int y) const {
+		return x >= 0 && y >= 0 && x < side && y < side && mask[y * side + x] != 0;
+	}
+
+	// Copies of the tiles of island rows [row_begin, row_end) with the ground or water added,
+	// row by row. 'locations' holds the side * side locations of the island, row by row.
+	// The copies are built on 'pool', one chunk column per task; the map is only read.
+	std::vector<Tile*> buildRows(BaseMap& map, WorkerPool& pool, const std::vector<TileLocation*>& locations, int row_begin, int row_end, uint16_t ground_id, uint16_t water_id) const;
+
+private:
+	void shapeChunk(int chunk_x, int chunk_y);
+	void keepConnected();
+
+	uint32_t seed;
+	int side;
+	int roughness;
+	Shape shape;
+	std::vector<uint8_t> mask;
+};
+
+#endif
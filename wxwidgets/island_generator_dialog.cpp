@@ -22,6 +22,8 @@
 #include "items.h"
 #include "brush.h"
 #include "ground_brush.h"
+#include "island_generator.h"
+#include "worker_pool.h"
 #include <random>
 #include <ctime>
 
@@ -62,21 +64,6 @@ void IslandPreviewButton::SetItemId(uint16_t id) {
     SetSprite(0);
 }
 
-// Since we don't have FastNoise, let's create a simple noise function
-class SimpleNoise {
-public:
-    SimpleNoise() : seed(0) {}
-    void SetSeed(int s) { seed = s; }
-    
-    float GetNoise(float x, float y) {
-        int n = seed + static_cast<int>(x * 1997) + static_cast<int>(y * 17931);
-        n = (n << 13) ^ n;
-        return 1.0f - ((n * (n * n * 15731 + 789221) + 1376312589) & 0x7fffffff) / 1073741824.0f;
-    }
-private:
-    int seed;
-};
-
 IslandGeneratorDialog::IslandGeneratorDialog(wxWindow* parent) :
     wxDialog(parent, wxID_ANY, "Island Generator", wxDefaultPosition, wxSize(1000, 700), 
              wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER) {
@@ -331,7 +318,7 @@ void IslandGeneratorDialog::OnGenerateClick(wxCommandEvent& event) {
     start_position.y = pos_y_spin->GetValue();
     start_position.z = pos_z_spin->GetValue();
 
-    GenerateIsland();
+    GenerateMultipleIslands(1, 0);
 }
 
 void IslandGeneratorDialog::OnGenerateMultiple(wxCommandEvent& event) {
@@ -467,217 +454,135 @@ void IslandGeneratorDialog::OnBorderPreview(wxCommandEvent& WXUNUSED(event)) {
     UpdateBorderPreview();
 }
 
-void IslandGeneratorDialog::GenerateIsland() {
+bool IslandGeneratorDialog::GenerateIsland(WorkerPool& pool, wxProgressDialog& dialog, int island, int islands) {
     Editor* editor = g_gui.GetCurrentEditor();
-    if (!editor) return;
-
-    // Create action to hold all changes
-    Action* action = editor->actionQueue->createAction(ACTION_DRAW);
-    
-    // Calculate island dimensions based on size (no more division by 2)
-    int start_x = start_position.x;
-    int start_y = start_position.y;
-    int end_x = start_position.x + island_size;
-    int end_y = start_position.y + island_size;
+    if (!editor) return false;
+    Map& map = editor->map;
+
+    const int start_x = start_position.x;
+    const int start_y = start_position.y;
+    const int z = start_position.z;
+
+    IslandGenerator::Shape shape = IslandGenerator::SHAPE_CIRCULAR;
+    if (selected_shape == "Square") {
+        shape = IslandGenerator::SHAPE_SQUARE;
+    } else if (selected_shape == "Irregular") {
+        shape = IslandGenerator::SHAPE_IRREGULAR;
+    }
 
-    // Initialize random number generator with seed
+    // Same text, same island
     std::mt19937 rng(std::hash<std::string>{}(nstr(seed)));
-
-    // Create noise generator
-    SimpleNoise noise;
-    noise.SetSeed(rng());
-
-    // First pass: Generate base shape
-    std::vector<std::vector<bool>> isGround(island_size + 2, std::vector<bool>(island_size + 2, false));
-    
-    // Calculate center and radius for shape generation
-    float center_x = start_x + island_size / 2.0f;
-    float center_y = start_y + island_size / 2.0f;
-    float max_radius = island_size / 2.0f;
-
-    // First pass: Generate initial shape
-    for (int y = 0; y <= island_size; ++y) {
-        for (int x = 0; x <= island_size; ++x) {
-            float dx = (x - island_size/2.0f) / max_radius;
-            float dy = (y - island_size/2.0f) / max_radius;
-
-            bool should_place = false;
-            float base_noise = (noise.GetNoise(x * 0.05f, y * 0.05f) + 1.0f) * 0.5f;
-            float detail_noise = (noise.GetNoise(x * 0.15f, y * 0.15f) + 1.0f) * 0.5f;
-            float combined_noise = base_noise * 0.7f + detail_noise * 0.3f;
-            
-            if (selected_shape == "Circular") {
-                float distance = std::sqrt(dx * dx + dy * dy);
-                float threshold = 1.0f - (roughness / 200.0f) * combined_noise;
-                should_place = distance <= threshold;
-            }
-            else if (selected_shape == "Square") {
-                float distance = std::max(std::abs(dx), std::abs(dy));
-                float threshold = 1.0f - (roughness / 200.0f) * combined_noise;
-                should_place = distance <= threshold;
-            }
-            else if (selected_shape == "Irregular") {
-                float distance = std::sqrt(dx * dx + dy * dy);
-                float noise_influence = roughness / 100.0f;
-                float threshold = 1.0f - noise_influence * combined_noise;
-                should_place = distance <= threshold;
-            }
-
-            if (should_place) {
-                isGround[y][x] = true;
-            }
+    IslandGenerator generator(rng(), island_size, roughness, shape);
+    generator.generate(pool);
+
+    auto report = [&](int percent) {
+        const int done = (island * 100 + percent) / islands;
+        progress->SetValue(done);
+        return dialog.Update(done, wxString::Format("Generating island %d of %d...", island + 1, islands));
+    };
+
+    // Allocate every location up front, the workers must not grow the quad tree
+    const int side = generator.getSide();
+    std::vector<TileLocation*> locations(size_t(side) * side);
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            locations[size_t(y) * side + x] = map.createTileL(start_x + x, start_y + y, z);
         }
     }
 
-    // Second pass: Remove isolated ground tiles and ensure connectivity
-    std::vector<std::vector<bool>> connected = isGround;
-    std::queue<std::pair<int, int>> floodQueue;
-    
-    // Start flood fill from center
-    int center_tile_x = island_size / 2;
-    int center_tile_y = island_size / 2;
-    if (isGround[center_tile_y][center_tile_x]) {
-        floodQueue.push({center_tile_x, center_tile_y});
-        std::vector<std::vector<bool>> visited(island_size + 2, std::vector<bool>(island_size + 2, false));
-        visited[center_tile_y][center_tile_x] = true;
-
-        while (!floodQueue.empty()) {
-            auto [x, y] = floodQueue.front();
-            floodQueue.pop();
-
-            // Check all 8 neighbors
-            for (int dy = -1; dy <= 1; ++dy) {
-                for (int dx = -1; dx <= 1; ++dx) {
-                    if (dx == 0 && dy == 0) continue;
-                    
-                    int nx = x + dx;
-                    int ny = y + dy;
-                    
-                    if (nx >= 0 && nx < island_size && ny >= 0 && ny < island_size &&
-                        isGround[ny][nx] && !visited[ny][nx]) {
-                        visited[ny][nx] = true;
-                        floodQueue.push({nx, ny});
-                    }
-                }
-            }
+    // Commit one band of chunks at a time, so the island shows up while it is generated and
+    // cancelling keeps what is already there (undoable as one step)
+    BatchAction* batch = editor->actionQueue->createBatch(ACTION_DRAW);
+    bool cancelled = false;
+    const int bands = (side + IslandGenerator::ChunkSize - 1) / IslandGenerator::ChunkSize;
+    for (int band = 0; band < bands && !cancelled; ++band) {
+        const int row_begin = band * IslandGenerator::ChunkSize;
+        const int row_end = std::min(side, row_begin + IslandGenerator::ChunkSize);
+
+        Action* action = editor->actionQueue->createAction(batch);
+        for (Tile* new_tile : generator.buildRows(map, pool, locations, row_begin, row_end, ground_id, water_id)) {
+            action->addChange(newd Change(new_tile));
         }
+        batch->addAndCommitAction(action);
 
-        // Only keep connected ground tiles
-        for (int y = 0; y <= island_size; ++y) {
-            for (int x = 0; x <= island_size; ++x) {
-                connected[y][x] = visited[y][x];
-            }
-        }
+        cancelled = !report((band + 1) * 90 / bands);
+        g_gui.RefreshView();
     }
 
-    // Generate the island using the processed shape
-    progress->SetValue(0);
-    int total_tiles = (end_x - start_x + 1) * (end_y - start_y + 1);
-    int current_tile = 0;
-
-    // Store ground tile positions for border placement
-    std::vector<Position> groundTiles;
-
-    for (int y = 0; y <= island_size; ++y) {
-        for (int x = 0; x <= island_size; ++x) {
-            // Update progress
-            current_tile++;
-            progress->SetValue((current_tile * 100) / total_tiles);
-
-            int map_x = start_x + x;
-            int map_y = start_y + y;
+    // Borders go in last, over the whole coast, so chunk seams get the same treatment as the rest
+    if (!cancelled && use_automagic->GetValue()) {
+        Action* action = editor->actionQueue->createAction(batch);
 
-            // Create or get the tile
-            Tile* tile = editor->map.getTile(map_x, map_y, start_position.z);
-            if (!tile) {
-                tile = editor->map.createTile(map_x, map_y, start_position.z);
-            }
-
-            // Create a copy for the action
-            Tile* new_tile = tile->deepCopy(editor->map);
-
-            if (connected[y][x]) {
-                // Place ground
-                if (ground_id > 0) {
-                    Item* ground_item = Item::Create(ground_id);
-                    new_tile->addItem(ground_item);
-                }
-                groundTiles.push_back(Position(map_x, map_y, start_position.z));
-            } else {
-                // Place water
-                if (water_id > 0) {
-                    Item* water_item = Item::Create(water_id);
-                    new_tile->addItem(water_item);
+        if (selected_border_id != -1) {
+            const BorderData* border = nullptr;
+            for (const BorderData& data : border_data) {
+                if (data.id == selected_border_id) {
+                    border = &data;
+                    break;
                 }
             }
 
-            action->addChange(newd Change(new_tile));
-        }
-    }
-
-    // Add the action to the editor
-    editor->addAction(action);
-
-    // Apply borders if automagic is enabled
-    if (use_automagic->GetValue()) {
-        if(selected_border_id != -1) {
-            // Find selected border data
-            for(const BorderData& data : border_data) {
-                if(data.id == selected_border_id) {
-                    Action* borderAction = editor->actionQueue->createAction(ACTION_DRAW);
-                    
-                    // For each ground tile, check if it needs borders
-                    for(const Position& pos : groundTiles) {
-                        // Check all 8 surrounding tiles
-                        for(int dy = -1; dy <= 1; dy++) {
-                            for(int dx = -1; dx <= 1; dx++) {
-                                if(dx == 0 && dy == 0) continue;
-                                
-                                Position checkPos(pos.x + dx, pos.y + dy, pos.z);
-                                bool isNeighborGround = false;
-                                
-                                // Check if neighbor position is in our ground tiles list
-                                for(const Position& groundPos : groundTiles) {
-                                    if(groundPos == checkPos) {
-                                        isNeighborGround = true;
-                                        break;
-                                    }
-                                }
-                                
-                                if(!isNeighborGround) {
-                                    // This is an edge that needs a border
-                                    Tile* tile = editor->map.getTile(checkPos.x, checkPos.y, checkPos.z);
-                                    if(!tile) {
-                                        tile = editor->map.createTile(checkPos.x, checkPos.y, checkPos.z);
-                                    }
-                                    
-                                    Tile* new_tile = tile->deepCopy(editor->map);
-                                    
-                                    // Add a border item
-                                    if(!data.items.empty()) {
-                                        // Select appropriate border piece based on position
-                                        size_t index = ((dx + 1) * 3 + (dy + 1)) % data.items.size();
-                                        Item* border_item = Item::Create(data.items[index]);
-                                        new_tile->addItem(border_item);
-                                    }
-                                    
-                                    borderAction->addChange(newd Change(new_tile));
+            if (border && !border->items.empty()) {
+                // Piece for every non-land tile touching land, picked by the direction of the land.
+                // The last land tile in row order decides, the island plus a one tile rim is checked.
+                const int padded = side + 2;
+                std::vector<int> pieces(size_t(padded) * padded, -1);
+                for (int y = 0; y < side; ++y) {
+                    for (int x = 0; x < side; ++x) {
+                        if (!generator.isLand(x, y)) continue;
+
+                        for (int dy = -1; dy <= 1; ++dy) {
+                            for (int dx = -1; dx <= 1; ++dx) {
+                                if (!generator.isLand(x + dx, y + dy)) {
+                                    pieces[size_t(y + dy + 1) * padded + (x + dx + 1)] = ((dx + 1) * 3 + (dy + 1)) % border->items.size();
                                 }
                             }
                         }
                     }
-                    
-                    editor->addAction(borderAction);
-                    break;
+                }
+
+                for (int y = 0; y < padded; ++y) {
+                    for (int x = 0; x < padded; ++x) {
+                        const int piece = pieces[size_t(y) * padded + x];
+                        if (piece < 0) continue;
+
+                        TileLocation* location = map.createTileL(start_x + x - 1, start_y + y - 1, z);
+                        Tile* tile = location->get();
+                        Tile* new_tile = tile ? tile->deepCopy(map) : map.allocator(location);
+                        new_tile->addItem(Item::Create(border->items[piece]));
+                        action->addChange(newd Change(new_tile));
+                    }
                 }
             }
         } else {
-            editor->borderizeSelection();
+            // Only where land meets water can a border change
+            for (int y = -1; y <= side; ++y) {
+                for (int x = -1; x <= side; ++x) {
+                    const bool land = generator.isLand(x, y);
+                    bool coast = false;
+                    for (int dy = -1; dy <= 1 && !coast; ++dy) {
+                        for (int dx = -1; dx <= 1 && !coast; ++dx) {
+                            coast = generator.isLand(x + dx, y + dy) != land;
+                        }
+                    }
+                    if (!coast) continue;
+
+                    Tile* tile = map.getTile(start_x + x, start_y + y, z);
+                    if (!tile) continue;
+
+                    Tile* new_tile = tile->deepCopy(map);
+                    new_tile->borderize(&map);
+                    action->addChange(newd Change(new_tile));
+                }
+            }
         }
+
+        batch->addAndCommitAction(action);
+        cancelled = !report(100);
     }
 
-    // Refresh the view
-    g_gui.RefreshView();
+    editor->addBatch(batch);
+    return !cancelled;
 }
 
 void IslandGeneratorDialog::GenerateMultipleIslands(int count, int spacing) {
@@ -692,22 +597,21 @@ void IslandGeneratorDialog::GenerateMultipleIslands(int count, int spacing) {
     // Store original position
     Position original_pos = start_position;
 
+    WorkerPool pool;
+    wxProgressDialog dialog("Island Generator", "Generating island...", 100, this, wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_CAN_ABORT);
+
     // Generate islands in a grid pattern
-    size_t islands_created = 0;
+    int islands_created = 0;
     progress->SetValue(0);
 
-    for (size_t row = 0; row < grid_size && islands_created < static_cast<size_t>(count); ++row) {
-        for (size_t col = 0; col < grid_size && islands_created < static_cast<size_t>(count); ++col) {
+    bool cancelled = false;
+    for (size_t row = 0; row < grid_size && islands_created < count && !cancelled; ++row) {
+        for (size_t col = 0; col < grid_size && islands_created < count && !cancelled; ++col) {
             // Calculate new start position for this island
             start_position.x = original_pos.x + static_cast<int>(col * (island_size_t + spacing_tiles));
             start_position.y = original_pos.y + static_cast<int>(row * (island_size_t + spacing_tiles));
 
-            // Update progress
-            progress->SetValue(static_cast<int>((islands_created * 100) / static_cast<size_t>(count)));
-
-            // Generate the island
-            GenerateIsland();
-
+            cancelled = !GenerateIsland(pool, dialog, islands_created, count);
             islands_created++;
         }
     }
@@ -25,6 +25,8 @@
 #include "brush.h"
 #include "ground_brush.h"
 
+class WorkerPool;
+
 // Event IDs
 enum {
     ID_ISLAND_GENERATE_SINGLE = 34000,
@@ -81,7 +83,8 @@ public:
 private:
     void UpdateWidgets();
     void UpdatePreview();
-    void GenerateIsland();
+    // Generates island number 'island' of 'islands' at start_position, false if it was cancelled
+    bool GenerateIsland(WorkerPool& pool, wxProgressDialog& dialog, int island, int islands);
     void GenerateMultipleIslands(int count, int spacing);
     wxString GetDataDirectoryForVersion(const wxString& versionStr);
     std::vector<std::pair<uint16_t, uint16_t>> ParseRangeString(const wxString& input);
@@ -30,6 +30,109 @@
 #include "table_brush.h"
 #include "wall_brush.h"
 
+#include <memory>
+#include <mutex>
+
+namespace {
+	// Fixed size slots carved out of large blocks, freed slots are reused.
+	// The blocks are kept while any plain item is alive, so the pool holds on to the most items
+	// there ever were at once; they are given back when the last one is deleted (every map closed).
+	class PlainItemPool {
+	public:
+		void* allocate() {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!free_list) {
+				grow();
+			}
+			Slot* slot = free_list;
+			free_list = slot->next;
+			++live;
+			return slot;
+		}
+
+		void release(void* ptr) {
+			std::lock_guard<std::mutex> lock(mutex);
+			Slot* slot = static_cast<Slot*>(ptr);
+			slot->next = free_list;
+			free_list = slot;
+			if (--live == 0) {
+				free_list = nullptr;
+				blocks.clear();
+			}
+		}
+
+#ifdef DEBUG_MEM
+		bool owns(const void* ptr) {
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const std::unique_ptr<Slot[]>& block : blocks) {
+				if (ptr >= block.get() && ptr < block.get() + SLOTS_PER_BLOCK) {
+					return true;
+				}
+			}
+			return false;
+		}
+#endif
+
+	private:
+		union Slot {
+			Slot* next;
+			alignas(Item) unsigned char storage[sizeof(Item)];
+		};
+
+		void grow() {
+			blocks.emplace_back(new Slot[SLOTS_PER_BLOCK]);
+			Slot* block = blocks.back().get();
+			// Backwards, so slots are handed out in address order
+			for (size_t i = SLOTS_PER_BLOCK; i-- > 0;) {
+				block[i].next = free_list;
+				free_list = &block[i];
+			}
+		}
+
+		static const size_t SLOTS_PER_BLOCK = 4096;
+
+		std::mutex mutex;
+		Slot* free_list = nullptr;
+		size_t live = 0;
+		std::vector<std::unique_ptr<Slot[]>> blocks;
+	};
+
+	PlainItemPool& plainItemPool() {
+		// Never destroyed, items may still be deleted by other static destructors at exit
+		static PlainItemPool* pool = new PlainItemPool;
+		return *pool;
+	}
+}
+
+void* Item::operator new(size_t size) {
+	if (size == sizeof(Item)) {
+		return plainItemPool().allocate();
+	}
+	return ::operator new(size);
+}
+
+void Item::operator delete(void* ptr, size_t size) {
+	if (!ptr) {
+		return;
+	}
+	if (size == sizeof(Item)) {
+		plainItemPool().release(ptr);
+	} else {
+		::operator delete(ptr);
+	}
+}
+
+#ifdef DEBUG_MEM
+void Item::operator delete(void* ptr, const char* file, int line) {
+	// Only called when a constructor throws, the size isn't passed here so ask the pool
+	if (ptr && plainItemPool().owns(ptr)) {
+		plainItemPool().release(ptr);
+	} else {
+		::operator delete(ptr);
+	}
+}
+#endif
+
 Item* Item::Create(uint16_t _type, uint16_t _subtype /*= 0xFFFF*/) {
 	if (_type == 0) {
 		return nullptr;
@@ -72,8 +175,9 @@ Item* Item::Create(uint16_t _type, uint16_t _subtype /*= 0xFFFF*/) {
 Item::Item(unsigned short _type, unsigned short _count) :
 	id(_type),
 	subtype(1),
+	frame(0),
 	selected(false),
-	frame(0) {
+	locked(false) {
 	if (hasSubtype()) {
 		subtype = _count;
 	}
@@ -88,7 +192,7 @@ Item* Item::deepCopy() const {
 	if (copy) {
 		copy->selected = selected;
 		if (attributes) {
-			copy->attributes = newd ItemAttributeMap(*attributes);
+			copy->attributes = newd ItemAttributeList(*attributes);
 		}
 	}
 	return copy;
@@ -271,23 +375,23 @@ double Item::getWeight() const {
 }
 
 void Item::setUniqueID(unsigned short n) {
-	setAttribute("uid", n);
+	setAttribute(ATTRIBUTE_KEY_UNIQUE_ID, n);
 }
 
 void Item::setActionID(unsigned short n) {
-	setAttribute("aid", n);
+	setAttribute(ATTRIBUTE_KEY_ACTION_ID, n);
 }
 
 void Item::setText(const std::string& str) {
-	setAttribute("text", str);
+	setAttribute(ATTRIBUTE_KEY_TEXT, str);
 }
 
 void Item::setDescription(const std::string& str) {
-	setAttribute("desc", str);
+	setAttribute(ATTRIBUTE_KEY_DESCRIPTION, str);
 }
 
 void Item::setTier(unsigned short n) {
-	setAttribute("tier", n);
+	setAttribute(ATTRIBUTE_KEY_TIER, n);
 }
 
 double Item::getWeight() {
@@ -415,7 +519,7 @@ void Item::animate() {
 		return;
 	}
 
-	frame = sprite->animator->getFrame();
+	frame = static_cast<uint8_t>(sprite->animator->getFrame());
 }
 
 // ============================================================================
@@ -90,6 +90,18 @@ protected:
 public:
 	virtual ~Item();
 
+	// Objects the size of a plain item (most of any map) come from a pool of large blocks, see
+	// item.cpp, so they carry no per-allocation overhead and the items of a tile end up next to
+	// each other. Bigger subclasses go to the heap as usual.
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+#ifdef DEBUG_MEM
+	static void* operator new(size_t size, const char* file, int line) {
+		return operator new(size);
+	}
+	static void operator delete(void* ptr, const char* file, int line);
+#endif
+
 	// Deep copy thingy
 	virtual Item* deepCopy() const;
 
@@ -472,8 +484,8 @@ protected:
 	uint16_t id; // the same id as in ItemType
 	// Subtype is either fluid type, count, subtype or charges
 	uint16_t subtype;
+	uint8_t frame; // Sprites have at most 255 frames
 	bool selected;
-	int frame;
 	bool locked;
 
 private:
@@ -495,7 +507,7 @@ inline int Item::getCount() const {
 }
 
 inline uint16_t Item::getUniqueID() const {
-	const int32_t* a = getIntegerAttribute("uid");
+	const int32_t* a = getIntegerAttribute(ATTRIBUTE_KEY_UNIQUE_ID);
 	if (a) {
 		return *a;
 	}
@@ -503,7 +515,7 @@ inline uint16_t Item::getUniqueID() const {
 }
 
 inline uint16_t Item::getActionID() const {
-	const int32_t* a = getIntegerAttribute("aid");
+	const int32_t* a = getIntegerAttribute(ATTRIBUTE_KEY_ACTION_ID);
 	if (a) {
 		return *a;
 	}
@@ -511,7 +523,7 @@ inline uint16_t Item::getActionID() const {
 }
 
 inline uint16_t Item::getTier() const {
-	const int32_t* a = getIntegerAttribute("tier");
+	const int32_t* a = getIntegerAttribute(ATTRIBUTE_KEY_TIER);
 	if (a) {
 		return *a;
 	}
@@ -519,7 +531,7 @@ inline uint16_t Item::getTier() const {
 }
 
 inline std::string Item::getText() const {
-	const std::string* a = getStringAttribute("text");
+	const std::string* a = getStringAttribute(ATTRIBUTE_KEY_TEXT);
 	if (a) {
 		return *a;
 	}
@@ -527,7 +539,7 @@ inline std::string Item::getText() const {
 }
 
 inline std::string Item::getDescription() const {
-	const std::string* a = getStringAttribute("desc");
+	const std::string* a = getStringAttribute(ATTRIBUTE_KEY_DESCRIPTION);
 	if (a) {
 		return *a;
 	}
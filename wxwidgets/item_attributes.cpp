@@ -20,14 +20,141 @@
 #include "item_attributes.h"
 #include "filehandle.h"
 
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+// Attribute keys
+
+namespace {
+	const char* const WELL_KNOWN_KEYS[ATTRIBUTE_KEY_FIRST_DYNAMIC] = {
+		"aid",
+		"uid",
+		"text",
+		"desc",
+		"tier",
+	};
+
+	bool findWellKnownKey(const std::string& name, ItemAttributeKey& key) {
+		for (ItemAttributeKey index = 0; index < ATTRIBUTE_KEY_FIRST_DYNAMIC; ++index) {
+			if (name == WELL_KNOWN_KEYS[index]) {
+				key = index;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	struct KeyTable {
+		std::mutex mutex;
+		std::unordered_map<std::string, ItemAttributeKey> keys;
+		std::deque<std::string> names; // A deque, so names already handed out never move
+
+		KeyTable() {
+			for (const char* name : WELL_KNOWN_KEYS) {
+				keys.emplace(name, static_cast<ItemAttributeKey>(names.size()));
+				names.emplace_back(name);
+			}
+		}
+	};
+
+	KeyTable& keyTable() {
+		// Never destroyed, items may be deleted by other static destructors at exit
+		static KeyTable* table = new KeyTable;
+		return *table;
+	}
+}
+
+ItemAttributeKey ItemAttributeKeys::intern(const std::string& name) {
+	ItemAttributeKey key;
+	if (findWellKnownKey(name, key)) {
+		return key;
+	}
+
+	KeyTable& table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto it = table.keys.find(name);
+	if (it != table.keys.end()) {
+		return it->second;
+	}
+	key = static_cast<ItemAttributeKey>(table.names.size());
+	table.names.push_back(name);
+	table.keys.emplace(name, key);
+	return key;
+}
+
+bool ItemAttributeKeys::find(const std::string& name, ItemAttributeKey& key) {
+	if (findWellKnownKey(name, key)) {
+		return true;
+	}
+
+	KeyTable& table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	auto it = table.keys.find(name);
+	if (it == table.keys.end()) {
+		return false;
+	}
+	key = it->second;
+	return true;
+}
+
+const std::string& ItemAttributeKeys::getName(ItemAttributeKey key) {
+	KeyTable& table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+	ASSERT(key < table.names.size());
+	return table.names[key];
+}
+
+// Attribute list
+
+namespace {
+	struct EntryKeyLess {
+		bool operator()(const ItemAttributeList::Entry& entry, ItemAttributeKey key) const {
+			return entry.first < key;
+		}
+	};
+}
+
+ItemAttribute* ItemAttributeList::find(ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, EntryKeyLess());
+	if (it != entries.end() && it->first == key) {
+		return &it->second;
+	}
+	return nullptr;
+}
+
+const ItemAttribute* ItemAttributeList::find(ItemAttributeKey key) const {
+	return const_cast<ItemAttributeList*>(this)->find(key);
+}
+
+ItemAttribute& ItemAttributeList::operator[](ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, EntryKeyLess());
+	if (it == entries.end() || it->first != key) {
+		it = entries.emplace(it, key, ItemAttribute());
+	}
+	return it->second;
+}
+
+bool ItemAttributeList::erase(ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, EntryKeyLess());
+	if (it != entries.end() && it->first == key) {
+		entries.erase(it);
+		return true;
+	}
+	return false;
+}
+
+// Item attributes
+
 ItemAttributes::ItemAttributes() :
 	attributes(nullptr) {
 	////
 }
 
-ItemAttributes::ItemAttributes(const ItemAttributes& o) {
+ItemAttributes::ItemAttributes(const ItemAttributes& o) :
+	attributes(nullptr) {
 	if (o.attributes) {
-		attributes = newd ItemAttributeMap(*o.attributes);
+		attributes = newd ItemAttributeList(*o.attributes);
 	}
 }
 
@@ -37,7 +164,7 @@ ItemAttributes::~ItemAttributes() {
 
 void ItemAttributes::createAttributes() {
 	if (!attributes) {
-		attributes = newd ItemAttributeMap;
+		attributes = newd ItemAttributeList;
 	}
 }
 
@@ -49,95 +176,83 @@ void ItemAttributes::clearAllAttributes() {
 }
 
 ItemAttributeMap ItemAttributes::getAttributes() const {
+	ItemAttributeMap map;
 	if (attributes) {
-		return *attributes;
+		for (const ItemAttributeList::Entry& entry : *attributes) {
+			map[ItemAttributeKeys::getName(entry.first)] = entry.second;
+		}
 	}
-	return ItemAttributeMap();
+	return map;
+}
+
+const ItemAttribute* ItemAttributes::findAttribute(const std::string& key) const {
+	ItemAttributeKey id;
+	if (!attributes || !ItemAttributeKeys::find(key, id)) {
+		return nullptr;
+	}
+	return attributes->find(id);
 }
 
 void ItemAttributes::setAttribute(const std::string& key, const ItemAttribute& value) {
 	createAttributes();
-	(*attributes)[key] = value;
+	(*attributes)[ItemAttributeKeys::intern(key)] = value;
 }
 
 void ItemAttributes::setAttribute(const std::string& key, const std::string& value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	(*attributes)[ItemAttributeKeys::intern(key)].set(value);
 }
 
 void ItemAttributes::setAttribute(const std::string& key, int32_t value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	(*attributes)[ItemAttributeKeys::intern(key)].set(value);
 }
 
 void ItemAttributes::setAttribute(const std::string& key, double value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	(*attributes)[ItemAttributeKeys::intern(key)].set(value);
 }
 
 void ItemAttributes::setAttribute(const std::string& key, bool value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	(*attributes)[ItemAttributeKeys::intern(key)].set(value);
 }
 
-void ItemAttributes::eraseAttribute(const std::string& key) {
-	if (!attributes) {
-		return;
-	}
+void ItemAttributes::setAttribute(ItemAttributeKey key, const std::string& value) {
+	createAttributes();
+	(*attributes)[key].set(value);
+}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
+void ItemAttributes::setAttribute(ItemAttributeKey key, int32_t value) {
+	createAttributes();
+	(*attributes)[key].set(value);
+}
 
-	if (iter != attributes->end()) {
-		attributes->erase(iter);
+void ItemAttributes::eraseAttribute(const std::string& key) {
+	ItemAttributeKey id;
+	if (attributes && ItemAttributeKeys::find(key, id)) {
+		attributes->erase(id);
 	}
 }
 
 const std::string* ItemAttributes::getStringAttribute(const std::string& key) const {
-	if (!attributes) {
-		return nullptr;
-	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getString();
-	}
-	return nullptr;
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getString() : nullptr;
 }
 
 const int32_t* ItemAttributes::getIntegerAttribute(const std::string& key) const {
-	if (!attributes) {
-		return nullptr;
-	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getInteger();
-	}
-	return nullptr;
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getInteger() : nullptr;
 }
 
 const double* ItemAttributes::getFloatAttribute(const std::string& key) const {
-	if (!attributes) {
-		return nullptr;
-	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getFloat();
-	}
-	return nullptr;
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getFloat() : nullptr;
 }
 
 const bool* ItemAttributes::getBooleanAttribute(const std::string& key) const {
-	if (!attributes) {
-		return nullptr;
-	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getBoolean();
-	}
-	return nullptr;
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getBoolean() : nullptr;
 }
 
 bool ItemAttributes::hasStringAttribute(const std::string& key) const {
@@ -157,31 +272,32 @@ bool ItemAttributes::hasBooleanAttribute(const std::string& key) const {
 }
 
 // Attribute type
-// Can hold either int, bool or std::string
-// Without using newd to allocate them
+// Can hold either int, bool, double or std::string
+// Only strings are allocated
 
 ItemAttribute::ItemAttribute() :
 	type(ItemAttribute::NONE) {
-	////
+	data.string = nullptr;
 }
 
 ItemAttribute::ItemAttribute(const std::string& str) :
 	type(ItemAttribute::STRING) {
-	new (data) std::string(str);
+	data.string = newd std::string(str);
 }
 
 ItemAttribute::ItemAttribute(int32_t i) :
 	type(ItemAttribute::INTEGER) {
-	*reinterpret_cast<int*>(data) = i;
+	data.integer = i;
 }
 
 ItemAttribute::ItemAttribute(double f) :
 	type(ItemAttribute::DOUBLE) {
-	*reinterpret_cast<double*>(data) = f;
+	data.number = f;
 }
 
-ItemAttribute::ItemAttribute(bool b) {
-	*reinterpret_cast<bool*>(data) = b;
+ItemAttribute::ItemAttribute(bool b) :
+	type(ItemAttribute::BOOLEAN) {
+	data.boolean = b;
 }
 
 ItemAttribute::ItemAttribute(const ItemAttribute& o) :
@@ -189,6 +305,12 @@ ItemAttribute::ItemAttribute(const ItemAttribute& o) :
 	*this = o;
 }
 
+ItemAttribute::ItemAttribute(ItemAttribute&& o) noexcept :
+	type(o.type),
+	data(o.data) {
+	o.type = NONE;
+}
+
 ItemAttribute& ItemAttribute::operator=(const ItemAttribute& o) {
 	if (&o == this) {
 		return *this;
@@ -197,15 +319,9 @@ ItemAttribute& ItemAttribute::operator=(const ItemAttribute& o) {
 	clear();
 	type = o.type;
 	if (type == STRING) {
-		new (data) std::string(*reinterpret_cast<const std::string*>(&o.data));
-	} else if (type == INTEGER) {
-		*reinterpret_cast<int32_t*>(data) = *reinterpret_cast<const int32_t*>(&o.data);
-	} else if (type == FLOAT) {
-		*reinterpret_cast<float*>(data) = *reinterpret_cast<const float*>(&o.data);
-	} else if (type == DOUBLE) {
-		*reinterpret_cast<double*>(data) = *reinterpret_cast<const double*>(&o.data);
-	} else if (type == BOOLEAN) {
-		*reinterpret_cast<bool*>(data) = *reinterpret_cast<const bool*>(&o.data);
+		data.string = newd std::string(*o.data.string);
+	} else if (type == INTEGER || type == FLOAT || type == DOUBLE || type == BOOLEAN) {
+		data = o.data;
 	} else {
 		type = NONE;
 	}
@@ -213,65 +329,78 @@ ItemAttribute& ItemAttribute::operator=(const ItemAttribute& o) {
 	return *this;
 }
 
+ItemAttribute& ItemAttribute::operator=(ItemAttribute&& o) noexcept {
+	if (&o != this) {
+		clear();
+		type = o.type;
+		data = o.data;
+		o.type = NONE;
+	}
+	return *this;
+}
+
 ItemAttribute::~ItemAttribute() {
 	clear();
 }
 
 void ItemAttribute::clear() {
 	if (type == STRING) {
-		(reinterpret_cast<std::string*>(&data))->~basic_string();
+		delete data.string;
 		type = NONE;
 	}
 }
 
 void ItemAttribute::set(const std::string& str) {
-	clear();
+	if (type == STRING) {
+		*data.string = str;
+		return;
+	}
 	type = STRING;
-	new (data) std::string(str);
+	data.string = newd std::string(str);
 }
 
 void ItemAttribute::set(int32_t i) {
 	clear();
 	type = INTEGER;
-	*reinterpret_cast<int32_t*>(&data) = i;
+	data.integer = i;
 }
 
 void ItemAttribute::set(double y) {
 	clear();
 	type = DOUBLE;
-	*reinterpret_cast<double*>(&data) = y;
+	data.number = y;
 }
 
 void ItemAttribute::set(bool b) {
 	clear();
 	type = BOOLEAN;
-	*reinterpret_cast<bool*>(&data) = b;
+	data.boolean = b;
 }
 
 const std::string* ItemAttribute::getString() const {
 	if (type == STRING) {
-		return reinterpret_cast<const std::string*>(&data);
+		return data.string;
 	}
 	return nullptr;
 }
 
 const int32_t* ItemAttribute::getInteger() const {
 	if (type == INTEGER) {
-		return reinterpret_cast<const int32_t*>(&data);
+		return &data.integer;
 	}
 	return nullptr;
 }
 
 const double* ItemAttribute::getFloat() const {
 	if (type == DOUBLE) {
-		return reinterpret_cast<const double*>(&data);
+		return &data.number;
 	}
 	return nullptr;
 }
 
 const bool* ItemAttribute::getBoolean() const {
 	if (type == BOOLEAN) {
-		return reinterpret_cast<const bool*>(&data);
+		return &data.boolean;
 	}
 	return nullptr;
 }
@@ -291,7 +420,7 @@ bool ItemAttributes::unserializeAttributeMap(const IOMap& maphandle, BinaryNode*
 			if (!attrib.unserialize(maphandle, stream)) {
 				return false;
 			}
-			(*attributes)[key] = attrib;
+			(*attributes)[ItemAttributeKeys::intern(key)] = std::move(attrib);
 		}
 	}
 	return true;
@@ -301,10 +430,10 @@ void ItemAttributes::serializeAttributeMap(const IOMap& maphandle, NodeFileWrite
 	// Maximum of 65535 attributes per item
 	f.addU16(std::min((size_t)0xFFFF, attributes->size()));
 
-	ItemAttributeMap::const_iterator attribute = attributes->begin();
+	ItemAttributeList::const_iterator attribute = attributes->begin();
 	int i = 0;
 	while (attribute != attributes->end() && i <= 0xFFFF) {
-		const std::string& key = attribute->first;
+		const std::string& key = ItemAttributeKeys::getName(attribute->first);
 		if (key.size() > 0xFFFF) {
 			f.addString(key.substr(0, 65535));
 		} else {
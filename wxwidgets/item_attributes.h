@@ -20,6 +20,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "filehandle.h"
 
@@ -31,6 +32,29 @@ class ItemAttribute;
 class PropWriteStream;
 class PropStream;
 
+// Attribute names are interned once and items store the number instead of the string
+typedef uint32_t ItemAttributeKey;
+
+// Keys the editor itself uses, they have fixed numbers and are resolved without a lookup
+enum : ItemAttributeKey {
+	ATTRIBUTE_KEY_ACTION_ID, // "aid"
+	ATTRIBUTE_KEY_UNIQUE_ID, // "uid"
+	ATTRIBUTE_KEY_TEXT, // "text"
+	ATTRIBUTE_KEY_DESCRIPTION, // "desc"
+	ATTRIBUTE_KEY_TIER, // "tier"
+
+	ATTRIBUTE_KEY_FIRST_DYNAMIC
+};
+
+class ItemAttributeKeys {
+public:
+	// Returns the key of 'name', adding it if it's new
+	static ItemAttributeKey intern(const std::string& name);
+	// False if 'name' was never interned, then no item can have it set
+	static bool find(const std::string& name, ItemAttributeKey& key);
+	static const std::string& getName(ItemAttributeKey key);
+};
+
 class ItemAttribute {
 public:
 	ItemAttribute();
@@ -39,7 +63,9 @@ public:
 	ItemAttribute(double f);
 	ItemAttribute(bool b);
 	ItemAttribute(const ItemAttribute& o);
+	ItemAttribute(ItemAttribute&& o) noexcept;
 	ItemAttribute& operator=(const ItemAttribute& o);
+	ItemAttribute& operator=(ItemAttribute&& o) noexcept;
 	~ItemAttribute();
 
 	enum Type {
@@ -67,11 +93,48 @@ public:
 	const bool* getBoolean() const;
 
 private:
-	char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
+	// Strings live on the heap so numbers, the common case, don't pay for a std::string
+	union {
+		int32_t integer;
+		double number;
+		bool boolean;
+		std::string* string;
+	} data;
 };
 
+// Copy of the attributes of an item by name, for display
 typedef std::map<std::string, ItemAttribute> ItemAttributeMap;
 
+// Attributes of one item, sorted by key. Items rarely have more than a couple of attributes,
+// a binary search over a flat array beats a tree of heap nodes with string keys there.
+class ItemAttributeList {
+public:
+	typedef std::pair<ItemAttributeKey, ItemAttribute> Entry;
+	typedef std::vector<Entry>::const_iterator const_iterator;
+
+	ItemAttribute* find(ItemAttributeKey key);
+	const ItemAttribute* find(ItemAttributeKey key) const;
+	// Inserts an empty attribute if the key isn't set
+	ItemAttribute& operator[](ItemAttributeKey key);
+	bool erase(ItemAttributeKey key);
+
+	size_t size() const {
+		return entries.size();
+	}
+	bool empty() const {
+		return entries.empty();
+	}
+	const_iterator begin() const {
+		return entries.begin();
+	}
+	const_iterator end() const {
+		return entries.end();
+	}
+
+private:
+	std::vector<Entry> entries;
+};
+
 class ItemAttributes {
 public:
 	ItemAttributes();
@@ -89,12 +152,18 @@ public:
 	void setAttribute(const std::string& key, double value);
 	void setAttribute(const std::string& key, bool set);
 
+	void setAttribute(ItemAttributeKey key, const std::string& value);
+	void setAttribute(ItemAttributeKey key, int32_t value);
+
 	// returns nullptr if the attribute is not set
 	const std::string* getStringAttribute(const std::string& key) const;
 	const int32_t* getIntegerAttribute(const std::string& key) const;
 	const double* getFloatAttribute(const std::string& key) const;
 	const bool* getBooleanAttribute(const std::string& key) const;
 
+	const std::string* getStringAttribute(ItemAttributeKey key) const;
+	const int32_t* getIntegerAttribute(ItemAttributeKey key) const;
+
 	// Returns true if the attribute (of that type) exists
 	bool hasStringAttribute(const std::string& key) const;
 	bool hasIntegerAttribute(const std::string& key) const;
@@ -107,9 +176,26 @@ public:
 	ItemAttributeMap getAttributes() const;
 
 protected:
-	ItemAttributeMap* attributes;
+	ItemAttributeList* attributes;
 
 	void createAttributes();
+	const ItemAttribute* findAttribute(const std::string& key) const;
 };
 
+inline const std::string* ItemAttributes::getStringAttribute(ItemAttributeKey key) const {
+	if (!attributes) {
+		return nullptr;
+	}
+	const ItemAttribute* attribute = attributes->find(key);
+	return attribute ? attribute->getString() : nullptr;
+}
+
+inline const int32_t* ItemAttributes::getIntegerAttribute(ItemAttributeKey key) const {
+	if (!attributes) {
+		return nullptr;
+	}
+	const ItemAttribute* attribute = attributes->find(key);
+	return attribute ? attribute->getInteger() : nullptr;
+}
+
 #endif
@@ -17,8 +17,10 @@
 
 #include "main.h"
 #include "light_drawer.h"
+#include "worker_pool.h"
 
-LightDrawer::LightDrawer() {
+LightDrawer::LightDrawer() :
+	cached_x(0), cached_y(0), cached_w(0), cached_h(0), cached(false) {
 	texture = 0;
 	global_color = wxColor(50, 50, 50, 255);
 }
@@ -29,42 +31,121 @@ LightDrawer::~LightDrawer() {
 	lights.clear();
 }
 
+const std::array<LightDrawer::Kernel, MaxLightIntensity + 1>& LightDrawer::getKernels() {
+	static const std::array<Kernel, MaxLightIntensity + 1> kernels = [] {
+		std::array<Kernel, MaxLightIntensity + 1> result;
+		for (int intensity = 0; intensity <= MaxLightIntensity; ++intensity) {
+			const Light light { MaxLightIntensity, MaxLightIntensity, 0, static_cast<uint8_t>(intensity) };
+			for (int y = 0; y < KernelSize; ++y) {
+				for (int x = 0; x < KernelSize; ++x) {
+					result[intensity][y * KernelSize + x] = calculateIntensity(x, y, light);
+				}
+			}
+		}
+		return result;
+	}();
+	return kernels;
+}
+
+void LightDrawer::fillBand(const std::vector<Splat>& splats, const std::vector<size_t>& bin, const uint8_t* base, int w, int h, int band) {
+	const int first_row = band * BandHeight;
+	const int last_row = std::min(h, first_row + BandHeight);
+
+	for (int y = first_row; y < last_row; ++y) {
+		uint8_t* row = &buffer[static_cast<size_t>(y) * w * PixelFormatRGBA];
+		for (int x = 0; x < w; ++x) {
+			std::copy(base, base + PixelFormatRGBA, row + x * PixelFormatRGBA);
+		}
+	}
+
+	const auto& kernels = getKernels();
+	uint8_t span[KernelSize * PixelFormatRGBA] = {};
+	for (size_t index : bin) {
+		const Splat& splat = splats[index];
+		const Kernel& kernel = kernels[splat.intensity];
+
+		const int kx0 = std::max(0, -splat.x);
+		const int kx1 = std::min(KernelSize, w - splat.x);
+		const int ky0 = std::max(0, first_row - splat.y);
+		const int ky1 = std::min(KernelSize, last_row - splat.y);
+		if (kx0 >= kx1) {
+			continue;
+		}
+
+		for (int ky = ky0; ky < ky1; ++ky) {
+			// Colour the kernel row first (alpha stays 0), then merge it into the
+			// light map as one contiguous byte-wise max the compiler can vectorize
+			const float* falloff = &kernel[ky * KernelSize];
+			for (int kx = kx0; kx < kx1; ++kx) {
+				uint8_t* texel = &span[kx * PixelFormatRGBA];
+				texel[0] = static_cast<uint8_t>(splat.red * falloff[kx]);
+				texel[1] = static_cast<uint8_t>(splat.green * falloff[kx]);
+				texel[2] = static_cast<uint8_t>(splat.blue * falloff[kx]);
+			}
+
+			const uint8_t* src = &span[kx0 * PixelFormatRGBA];
+			uint8_t* dst = &buffer[(static_cast<size_t>(splat.y + ky) * w + splat.x + kx0) * PixelFormatRGBA];
+			const int length = (kx1 - kx0) * PixelFormatRGBA;
+			for (int i = 0; i < length; ++i) {
+				dst[i] = std::max(dst[i], src[i]);
+			}
+		}
+	}
+}
+
+void LightDrawer::updateBuffer(int map_x, int map_y, int w, int h) {
+	buffer.resize(static_cast<size_t>(w * h * PixelFormatRGBA));
+
+	// Bin every light into the bands its kernel reaches, so bands can be filled independently
+	const int bands = (h + BandHeight - 1) / BandHeight;
+	std::vector<Splat> splats;
+	splats.reserve(lights.size());
+	std::vector<std::vector<size_t>> bins(bands);
+	for (const Light& light : lights) {
+		const int x = light.map_x - map_x - MaxLightIntensity;
+		const int y = light.map_y - map_y - MaxLightIntensity;
+		if (light.intensity == 0 || x + KernelSize <= 0 || x >= w || y + KernelSize <= 0 || y >= h) {
+			continue;
+		}
+
+		const wxColor color = colorFromEightBit(light.color);
+		const int first_band = std::max(0, y) / BandHeight;
+		const int last_band = std::min(h - 1, y + KernelSize - 1) / BandHeight;
+		for (int band = first_band; band <= last_band; ++band) {
+			bins[band].push_back(splats.size());
+		}
+		splats.push_back(Splat { x, y, light.intensity, color.Red(), color.Green(), color.Blue() });
+	}
+
+	const uint8_t base[PixelFormatRGBA] = { global_color.Red(), global_color.Green(), global_color.Blue(), 140 }; // global_color.Alpha()
+
+	// A handful of lights is cheaper to splat than to hand out to other threads
+	if (bands > 1 && splats.size() > 64) {
+		if (!pool) {
+			pool.reset(newd WorkerPool());
+		}
+		pool->parallelFor(bands, [&](size_t band) {
+			fillBand(splats, bins[band], base, w, h, static_cast<int>(band));
+		});
+	} else {
+		for (int band = 0; band < bands; ++band) {
+			fillBand(splats, bins[band], base, w, h, band);
+		}
+	}
+}
+
 void LightDrawer::draw(int map_x, int map_y, int end_x, int end_y, int scroll_x, int scroll_y, bool fog) {
 	if (texture == 0) {
 		createGLTexture();
+		cached = false;
 	}
 
 	int w = end_x - map_x;
 	int h = end_y - map_y;
 
-	buffer.resize(static_cast<size_t>(w * h * PixelFormatRGBA));
-
-	for (int x = 0; x < w; ++x) {
-		for (int y = 0; y < h; ++y) {
-			int mx = (map_x + x);
-			int my = (map_y + y);
-			int index = (y * w + x);
-			int color_index = index * PixelFormatRGBA;
-
-			buffer[color_index] = global_color.Red();
-			buffer[color_index + 1] = global_color.Green();
-			buffer[color_index + 2] = global_color.Blue();
-			buffer[color_index + 3] = 140; // global_color.Alpha();
-
-			for (auto& light : lights) {
-				float intensity = calculateIntensity(mx, my, light);
-				if (intensity == 0.f) {
-					continue;
-				}
-				wxColor light_color = colorFromEightBit(light.color);
-				uint8_t red = static_cast<uint8_t>(light_color.Red() * intensity);
-				uint8_t green = static_cast<uint8_t>(light_color.Green() * intensity);
-				uint8_t blue = static_cast<uint8_t>(light_color.Blue() * intensity);
-				buffer[color_index] = std::max(buffer[color_index], red);
-				buffer[color_index + 1] = std::max(buffer[color_index + 1], green);
-				buffer[color_index + 2] = std::max(buffer[color_index + 2], blue);
-			}
-		}
+	const bool changed = !cached || map_x != cached_x || map_y != cached_y || w != cached_w || h != cached_h || global_color != cached_color || lights != cached_lights;
+	if (changed) {
+		updateBuffer(map_x, map_y, w, h);
 	}
 
 	const int draw_x = map_x * TileSize - scroll_x;
@@ -78,7 +159,17 @@ void LightDrawer::draw(int map_x, int map_y, int end_x, int end_y, int scroll_x,
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+	if (changed) {
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+
+		cached_lights = lights;
+		cached_color = global_color;
+		cached_x = map_x;
+		cached_y = map_y;
+		cached_w = w;
+		cached_h = h;
+		cached = true;
+	}
 
 	if (!fog) {
 		glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
@@ -151,4 +242,5 @@ void LightDrawer::unloadGLTexture() {
 	if (texture != 0) {
 		glDeleteTextures(1, &texture);
 	}
+	cached = false;
 }
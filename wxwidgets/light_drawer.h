@@ -21,14 +21,36 @@
 #include "graphics.h"
 #include "position.h"
 
+#include <array>
+#include <memory>
+
+class WorkerPool;
+
 class LightDrawer {
 	struct Light {
 		uint16_t map_x = 0;
 		uint16_t map_y = 0;
 		uint8_t color = 0;
 		uint8_t intensity = 0;
+
+		bool operator==(const Light& other) const {
+			return map_x == other.map_x && map_y == other.map_y && color == other.color && intensity == other.intensity;
+		}
+	};
+
+	// A light resolved for splatting: kernel origin relative to the light map, and its colour
+	struct Splat {
+		int x, y;
+		uint8_t intensity;
+		uint8_t red, green, blue;
 	};
 
+	// Falloff of a light at every offset within MaxLightIntensity tiles, one per intensity
+	static constexpr int KernelSize = MaxLightIntensity * 2 + 1;
+	using Kernel = std::array<float, KernelSize * KernelSize>;
+	// Rows of the light map handled by one task
+	static constexpr int BandHeight = 16;
+
 public:
 	LightDrawer();
 	virtual ~LightDrawer();
@@ -43,7 +65,11 @@ private:
 	void createGLTexture();
 	void unloadGLTexture();
 
-	inline float calculateIntensity(int map_x, int map_y, const Light& light) {
+	void updateBuffer(int map_x, int map_y, int w, int h);
+	void fillBand(const std::vector<Splat>& splats, const std::vector<size_t>& bin, const uint8_t* base, int w, int h, int band);
+	static const std::array<Kernel, MaxLightIntensity + 1>& getKernels();
+
+	static float calculateIntensity(int map_x, int map_y, const Light& light) {
 		int dx = map_x - light.map_x;
 		int dy = map_y - light.map_y;
 		float distance = std::sqrt(dx * dx + dy * dy);
@@ -61,6 +87,14 @@ private:
 	std::vector<Light> lights;
 	std::vector<uint8_t> buffer;
 	wxColor global_color;
+
+	// What the texture holds right now, it is only rebuilt once one of these changes
+	std::vector<Light> cached_lights;
+	wxColor cached_color;
+	int cached_x, cached_y, cached_w, cached_h;
+	bool cached;
+
+	std::unique_ptr<WorkerPool> pool;
 };
 
 #endif
@@ -0,0 +1,194 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "load_graph.h"
+#include "worker_pool.h"
+#include "gui.h"
+
+LoadGraph::StageID LoadGraph::addStage(const wxString& message, int weight, StageFunction function, std::initializer_list<StageID> dependencies, bool main_thread) {
+	Stage stage;
+	stage.message = message;
+	stage.weight = std::max(0, weight);
+	stage.function = std::move(function);
+	stage.dependencies = dependencies;
+	stage.main_thread = main_thread;
+	stage.state = STAGE_WAITING;
+
+	// Dependencies must already be known, this keeps the graph acyclic
+	for (StageID dependency : stage.dependencies) {
+		ASSERT(dependency < stages.size());
+		(void)dependency;
+	}
+
+	stages.push_back(std::move(stage));
+	return stages.size() - 1;
+}
+
+bool LoadGraph::isReady(const Stage& stage) const {
+	for (StageID dependency : stage.dependencies) {
+		if (stages[dependency].state != STAGE_DONE) {
+			return false;
+		}
+	}
+	return true;
+}
+
+wxString LoadGraph::runningMessage() const {
+	wxString message;
+	for (const Stage& stage : stages) {
+		if (stage.state != STAGE_RUNNING) {
+			continue;
+		}
+		if (!message.empty()) {
+			message << " | ";
+		}
+		message << stage.message;
+	}
+	return message;
+}
+
+bool LoadGraph::run(wxString& error, wxArrayString& warnings) {
+	int total_weight = 0;
+	size_t worker_stages = 0;
+	for (const Stage& stage : stages) {
+		total_weight += stage.weight;
+		if (!stage.main_thread) {
+			++worker_stages;
+		}
+	}
+	total_weight = std::max(1, total_weight);
+
+	WorkerPool pool(std::max<size_t>(1, std::min(worker_stages, WorkerPool::defaultThreadCount())));
+	std::mutex mutex;
+	std::condition_variable changed;
+
+	int done_weight = 0;
+	size_t running = 0;
+	bool failed = false;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		// Start every stage whose dependencies have finished
+		std::vector<StageID> main_stages;
+		if (!failed) {
+			for (StageID id = 0; id < stages.size(); ++id) {
+				Stage& stage = stages[id];
+				if (stage.state != STAGE_WAITING || !isReady(stage)) {
+					continue;
+				}
+
+				stage.state = STAGE_RUNNING;
+				++running;
+				if (stage.main_thread) {
+					main_stages.push_back(id);
+					continue;
+				}
+
+				pool.submit([this, id, &mutex, &changed, &running, &done_weight, &failed]() {
+					Stage& stage = stages[id];
+					wxString stage_error;
+					wxArrayString stage_warnings;
+					bool ok = stage.function(stage_error, stage_warnings);
+
+					std::lock_guard<std::mutex> guard(mutex);
+					stage.error = stage_error;
+					stage.warnings = stage_warnings;
+					stage.state = ok ? STAGE_DONE : STAGE_FAILED;
+					if (ok) {
+						done_weight += stage.weight;
+					} else {
+						failed = true;
+					}
+					--running;
+					changed.notify_all();
+				});
+			}
+		}
+
+		// The caller owns the load bar, never report completion (100 closes it)
+		wxString message = runningMessage();
+		int progress = std::min(99, (done_weight * 100) / total_weight);
+
+		lock.unlock();
+		if (!message.empty()) {
+			g_gui.SetLoadDone(progress, message);
+		}
+
+		// Stages touching GUI owned data run here, while the workers keep going
+		for (StageID id : main_stages) {
+			Stage& stage = stages[id];
+			bool ok = stage.function(stage.error, stage.warnings);
+
+			std::lock_guard<std::mutex> guard(mutex);
+			stage.state = ok ? STAGE_DONE : STAGE_FAILED;
+			if (ok) {
+				done_weight += stage.weight;
+			} else {
+				failed = true;
+			}
+			--running;
+		}
+		lock.lock();
+
+		// Workers may have finished while the lock was released
+		bool startable = false;
+		if (!failed) {
+			for (const Stage& stage : stages) {
+				if (stage.state == STAGE_WAITING && isReady(stage)) {
+					startable = true;
+					break;
+				}
+			}
+		}
+		if (startable) {
+			continue;
+		} else if (running == 0) {
+			break;
+		}
+
+		int seen_weight = done_weight;
+		size_t seen_running = running;
+		changed.wait_for(lock, std::chrono::milliseconds(100), [&]() {
+			return done_weight != seen_weight || running != seen_running;
+		});
+	}
+	lock.unlock();
+	pool.wait();
+
+	bool ok = true;
+	for (const Stage& stage : stages) {
+		for (const wxString& warning : stage.warnings) {
+			warnings.push_back(warning);
+		}
+		if (ok && stage.state == STAGE_FAILED) {
+			error = stage.error;
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		for (const Stage& stage : stages) {
+			if (stage.state != STAGE_DONE) {
+				error = "Data file loading stopped before \"" + stage.message + "\" could run.";
+				return false;
+			}
+		}
+	}
+	return ok;
+}
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_LOAD_GRAPH_H_
+#define RME_LOAD_GRAPH_H_
+
+#include <functional>
+#include <initializer_list>
+
+// Runs the data file loading stages as a dependency graph.
+// Stages whose dependencies are done are started right away on a worker pool,
+// stages flagged as main thread only run on the calling (GUI) thread.
+// Progress is reported through g_gui.SetLoadDone as the combined weight of finished stages.
+class LoadGraph {
+public:
+	// Returning false aborts the load, 'error' is then reported to the caller
+	typedef std::function<bool(wxString& error, wxArrayString& warnings)> StageFunction;
+	typedef size_t StageID;
+
+	LoadGraph() = default;
+
+	StageID addStage(const wxString& message, int weight, StageFunction function, std::initializer_list<StageID> dependencies = {}, bool main_thread = false);
+
+	// Warnings of all stages are appended in the order the stages were added
+	bool run(wxString& error, wxArrayString& warnings);
+
+protected:
+	enum StageState {
+		STAGE_WAITING,
+		STAGE_RUNNING,
+		STAGE_DONE,
+		STAGE_FAILED,
+	};
+
+	struct Stage {
+		wxString message;
+		int weight;
+		StageFunction function;
+		std::vector<StageID> dependencies;
+		bool main_thread;
+
+		StageState state;
+		wxString error;
+		wxArrayString warnings;
+	};
+
+	bool isReady(const Stage& stage) const;
+	wxString runningMessage() const;
+
+	std::vector<Stage> stages;
+};
+
+#endif
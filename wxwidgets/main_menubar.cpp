@@ -1554,7 +1554,11 @@ void MainMenuBar::OnRandomizeSelection(wxCommandEvent& WXUNUSED(event)) {
 		return;
 	}
 
-	g_gui.GetCurrentEditor()->randomizeSelection();
+	const uint64_t seed = (uint64_t(mt_randi()) << 32) | mt_randi();
+	g_gui.GetCurrentEditor()->randomizeSelection(seed);
+	wxString ss;
+	ss << "Randomized selection with seed " << seed << ".";
+	g_gui.SetStatusText(ss);
 	g_gui.RefreshView();
 }
 
@@ -1563,9 +1567,13 @@ void MainMenuBar::OnRandomizeMap(wxCommandEvent& WXUNUSED(event)) {
 		return;
 	}
 
-	int ret = g_gui.PopupDialog("Randomize Map", "Are you sure you want to randomize the entire map (this action cannot be undone)?", wxYES | wxNO);
+	int ret = g_gui.PopupDialog("Randomize Map", "Are you sure you want to randomize the entire map?", wxYES | wxNO);
 	if (ret == wxID_YES) {
-		g_gui.GetCurrentEditor()->randomizeMap(true);
+		const uint64_t seed = (uint64_t(mt_randi()) << 32) | mt_randi();
+		g_gui.GetCurrentEditor()->randomizeMap(true, seed);
+		wxString ss;
+		ss << "Randomized map with seed " << seed << ".";
+		g_gui.SetStatusText(ss);
 	}
 
 	g_gui.RefreshView();
@@ -1694,55 +1702,6 @@ void MainMenuBar::OnMapRemoveCorpses(wxCommandEvent& WXUNUSED(event)) {
 	}
 }
 
-namespace OnMapRemoveUnreachable {
-	struct condition {
-		condition() { }
-
-		bool isReachable(Tile* tile) {
-			if (tile == nullptr) {
-				return false;
-			}
-			if (!tile->isBlocking()) {
-				return true;
-			}
-			return false;
-		}
-
-		bool operator()(Map& map, Tile* tile, long long removed, long long done, long long total) {
-			if (done % 0x1000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / total));
-			}
-
-			Position pos = tile->getPosition();
-			int sx = std::max(pos.x - 10, 0);
-			int ex = std::min(pos.x + 10, 65535);
-			int sy = std::max(pos.y - 8, 0);
-			int ey = std::min(pos.y + 8, 65535);
-			int sz, ez;
-
-			if (pos.z <= GROUND_LAYER) {
-				sz = 0;
-				ez = 9;
-	} else {
-				// underground
-				sz = std::max(pos.z - 2, GROUND_LAYER);
-				ez = std::min(pos.z + 2, MAP_MAX_LAYER);
-			}
-
-			for (int z = sz; z <= ez; ++z) {
-				for (int y = sy; y <= ey; ++y) {
-					for (int x = sx; x <= ex; ++x) {
-						if (isReachable(map.getTile(x, y, z))) {
-							return false;
-						}
-					}
-				}
-			}
-			return true;
-		}
-	};
-}
-
 void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent& WXUNUSED(event)) {
     if (!g_gui.IsEditorOpen()) {
         return;
@@ -1792,61 +1751,34 @@ void MainMenuBar::OnMapRemoveUnreachable(wxCommandEvent& WXUNUSED(event)) {
 
     // Show dialog and process result
     if (dialog->ShowModal() == wxID_OK) {
-        // Create modified condition with custom ranges
-        struct CustomRangeCondition : public OnMapRemoveUnreachable::condition {
-            int xRange;
-            int yRange;
-            
-            CustomRangeCondition(int x, int y) : xRange(x), yRange(y) {}
-            
-            bool operator()(Map& map, Tile* tile, long long removed, long long done, long long total) {
-                if (done % 0x1000 == 0) {
-                    g_gui.SetLoadDone((unsigned int)(100 * done / total));
-                }
-
-                Position pos = tile->getPosition();
-                int sx = std::max(pos.x - xRange, 0);
-                int ex = std::min(pos.x + xRange, 65535);
-                int sy = std::max(pos.y - yRange, 0);
-                int ey = std::min(pos.y + yRange, 65535);
-                int sz, ez;
-
-                if (pos.z <= GROUND_LAYER) {
-                    sz = 0;
-                    ez = 9;
-                } else {
-                    sz = std::max(pos.z - 2, GROUND_LAYER);
-                    ez = std::min(pos.z + 2, MAP_MAX_LAYER);
-                }
-
-                for (int z = sz; z <= ez; ++z) {
-                    for (int y = sy; y <= ey; ++y) {
-                        for (int x = sx; x <= ex; ++x) {
-                            if (isReachable(map.getTile(x, y, z))) {
-                                return false;
-                            }
-                        }
-                    }
-                }
-                return true;
-            }
-        };
-
-        g_gui.GetCurrentEditor()->selection.clear();
-        g_gui.GetCurrentEditor()->actionQueue->clear();
+        Editor* editor = g_gui.GetCurrentEditor();
+        Map& map = g_gui.GetCurrentMap();
 
-        CustomRangeCondition func(xRange->GetValue(), yRange->GetValue());
         g_gui.CreateLoadBar("Searching map for tiles to remove...");
-
-        long long removed = remove_if_TileOnMap(g_gui.GetCurrentMap(), func);
-
+        PositionVector positions = map.findUnreachableTiles(xRange->GetValue(), yRange->GetValue(), true);
         g_gui.DestroyLoadBar();
 
-        wxString msg;
-        msg << removed << " tiles deleted.";
-        g_gui.PopupDialog("Search completed", msg, wxOK);
+        // Nothing is touched until the user has seen how much would go
+        if (positions.empty()) {
+            g_gui.PopupDialog("Search completed", "No unreachable tiles found.", wxOK);
+        } else {
+            wxString msg;
+            msg << positions.size() << " unreachable tiles found. Delete them? (this action cannot be undone)";
+            if (g_gui.PopupDialog("Search completed", msg, wxYES | wxNO) == wxID_YES) {
+                editor->selection.clear();
+                editor->actionQueue->clear();
 
-        g_gui.GetCurrentMap().doChange();
+                for (const Position& pos : positions) {
+                    map.setTile(pos, nullptr, true);
+                }
+                map.statistics.invalidate();
+
+                msg.Clear();
+                msg << positions.size() << " tiles deleted.";
+                g_gui.PopupDialog("Search completed", msg, wxOK);
+                map.doChange();
+            }
+        }
     }
     
     dialog->Destroy();
@@ -1900,13 +1832,21 @@ void MainMenuBar::OnMapCleanHouseItems(wxCommandEvent& WXUNUSED(event)) {
 
 	int ret = g_gui.PopupDialog(
 		"Clear Moveable House Items",
-		"Are you sure you want to remove all items inside houses that can be moved (this action cannot be undone)?",
+		"Are you sure you want to remove all items inside houses that can be moved?",
 		wxYES | wxNO
 	);
 
 	if (ret == wxID_YES) {
-		// Editor will do the work
-		// editor->removeHouseItems(true);
+		Action* action = editor->actionQueue->createAction(ACTION_DELETE_TILES);
+		uint64_t removed = 0;
+		for (HouseMap::iterator it = editor->map.houses.begin(); it != editor->map.houses.end(); ++it) {
+			removed += it->second->removeLooseItems(action);
+		}
+		editor->addAction(action);
+
+		wxString msg;
+		msg << removed << " items deleted.";
+		g_gui.PopupDialog("Clear Moveable House Items", msg, wxOK);
 	}
 
 	g_gui.RefreshView();
@@ -1928,243 +1868,189 @@ void MainMenuBar::OnMapEditMonsters(wxCommandEvent& WXUNUSED(event)) {
 	;
 }
 
-void MainMenuBar::OnMapStatistics(wxCommandEvent& WXUNUSED(event)) {
-	if (!g_gui.IsEditorOpen()) {
-		return;
-	}
-
-	g_gui.CreateLoadBar("Collecting data...");
+namespace OnMapStatistics {
+	// Builds the report from the cached counters, only the house and town records are looked up
+	std::string report(Map* map) {
+		const MapStatistics::Counters& counters = map->statistics.get();
+
+		uint64_t tile_count = counters.tiles;
+		uint64_t detailed_tile_count = counters.detailed_tiles;
+		uint64_t blocking_tile_count = counters.blocking_tiles;
+		uint64_t walkable_tile_count = counters.walkable_tiles;
+		uint64_t spawn_count = counters.spawns;
+		uint64_t creature_count = counters.creatures;
+
+		uint64_t item_count = counters.items;
+		uint64_t loose_item_count = counters.loose_items;
+		uint64_t depot_count = counters.depots;
+		uint64_t action_item_count = counters.action_items;
+		uint64_t unique_item_count = counters.unique_items;
+		uint64_t container_count = counters.containers;
+
+		double creatures_per_spawn = (spawn_count != 0 ? double(creature_count) / double(spawn_count) : -1.0);
+		double percent_pathable = 100.0 * (tile_count != 0 ? double(walkable_tile_count) / double(tile_count) : -1.0);
+		double percent_detailed = 100.0 * (tile_count != 0 ? double(detailed_tile_count) / double(tile_count) : -1.0);
+
+		int town_count = map->towns.count();
+		int house_count = map->houses.count();
+		std::map<uint32_t, uint32_t> town_sqm_count;
+		const Town* largest_town = nullptr;
+		uint64_t largest_town_size = 0;
+		uint64_t total_house_sqm = 0;
+		const House* largest_house = nullptr;
+		uint64_t largest_house_size = 0;
+
+		Houses& houses = map->houses;
+		for (std::map<uint32_t, uint64_t>::const_iterator hit = counters.house_tiles.begin(); hit != counters.house_tiles.end(); ++hit) {
+			const House* house = houses.getHouse(hit->first);
+			if (!house) {
+				continue;
+			}
+			if (hit->second > largest_house_size) {
+				largest_house = house;
+				largest_house_size = hit->second;
+			}
+			total_house_sqm += hit->second;
+			town_sqm_count[house->townid] += hit->second;
+		}
 
-	Map* map = &g_gui.GetCurrentMap();
+		double houses_per_town = (town_count != 0 ? double(house_count) / double(town_count) : -1.0);
+		double sqm_per_house = (house_count != 0 ? double(total_house_sqm) / double(house_count) : -1.0);
+		double sqm_per_town = (town_count != 0 ? double(total_house_sqm) / double(town_count) : -1.0);
 
-	int load_counter = 0;
-
-	uint64_t tile_count = 0;
-	uint64_t detailed_tile_count = 0;
-	uint64_t blocking_tile_count = 0;
-	uint64_t walkable_tile_count = 0;
-	double percent_pathable = 0.0;
-	double percent_detailed = 0.0;
-	uint64_t spawn_count = 0;
-	uint64_t creature_count = 0;
-	double creatures_per_spawn = 0.0;
-
-	uint64_t item_count = 0;
-	uint64_t loose_item_count = 0;
-	uint64_t depot_count = 0;
-	uint64_t action_item_count = 0;
-	uint64_t unique_item_count = 0;
-	uint64_t container_count = 0; // Only includes containers containing more than 1 item
-
-	int town_count = map->towns.count();
-	int house_count = map->houses.count();
-	std::map<uint32_t, uint32_t> town_sqm_count;
-	const Town* largest_town = nullptr;
-	uint64_t largest_town_size = 0;
-	uint64_t total_house_sqm = 0;
-	const House* largest_house = nullptr;
-	uint64_t largest_house_size = 0;
-	double houses_per_town = 0.0;
-	double sqm_per_house = 0.0;
-	double sqm_per_town = 0.0;
-
-	for (MapIterator mit = map->begin(); mit != map->end(); ++mit) {
-		Tile* tile = (*mit)->get();
-		if (load_counter % 8192 == 0) {
-			g_gui.SetLoadDone((unsigned int)(int64_t(load_counter) * 95ll / int64_t(map->getTileCount())));
+		Towns& towns = map->towns;
+		for (std::map<uint32_t, uint32_t>::iterator town_iter = town_sqm_count.begin(); town_iter != town_sqm_count.end(); ++town_iter) {
+			Town* town = towns.getTown(town_iter->first);
+			if (town && town_iter->second > largest_town_size) {
+				largest_town = town;
+				largest_town_size = town_iter->second;
+			}
 		}
 
-		if (tile->empty()) {
-			continue;
+		std::ostringstream os;
+		os.setf(std::ios::fixed, std::ios::floatfield);
+		os.precision(2);
+		os << "Map statistics for the map \"" << map->getMapDescription() << "\"\n";
+
+		// Add map dimensions information
+		os << "\tMap dimensions:\n";
+		os << "\t\tWidth: " << map->getWidth() << " tiles\n";
+		os << "\t\tHeight: " << map->getHeight() << " tiles\n";
+		os << "\t\tTotal area: " << (map->getWidth() * map->getHeight()) << " square tiles\n";
+		os << "\t\tNumber of floors: " << (MAP_MAX_LAYER + 1) << "\n";
+
+		os << "\tTile data:\n";
+		os << "\t\tTotal number of tiles: " << tile_count << "\n";
+		os << "\t\tNumber of pathable tiles: " << walkable_tile_count << "\n";
+		os << "\t\tNumber of unpathable tiles: " << blocking_tile_count << "\n";
+		if (percent_pathable >= 0.0) {
+			os << "\t\tPercent walkable tiles: " << percent_pathable << "%\n";
 		}
-
-		tile_count += 1;
-
-		bool is_detailed = false;
-#define ANALYZE_ITEM(_item)                                         \
-	{                                                               \
-		item_count += 1;                                            \
-		if (!(_item)->isGroundTile() && !(_item)->isBorder()) {     \
-			is_detailed = true;                                     \
-			ItemType& it = g_items[(_item)->getID()];               \
-			if (it.moveable) {                                      \
-				loose_item_count += 1;                              \
-			}                                                       \
-			if (it.isDepot()) {                                     \
-				depot_count += 1;                                   \
-			}                                                       \
-			if ((_item)->getActionID() > 0) {                       \
-				action_item_count += 1;                             \
-			}                                                       \
-			if ((_item)->getUniqueID() > 0) {                       \
-				unique_item_count += 1;                             \
-			}                                                       \
-			if (Container* c = dynamic_cast<Container*>((_item))) { \
-				if (c->getVector().size()) {                        \
-					container_count += 1;                           \
-				}                                                   \
-			}                                                       \
-		}                                                           \
-	}
-
-		if (tile->ground) {
-			ANALYZE_ITEM(tile->ground);
+		os << "\t\tDetailed tiles: " << detailed_tile_count << "\n";
+		if (percent_detailed >= 0.0) {
+			os << "\t\tPercent detailed tiles: " << percent_detailed << "%\n";
 		}
 
-		for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-			Item* item = *item_iter;
-			ANALYZE_ITEM(item);
+		os << "\tItem data:\n";
+		os << "\t\tTotal number of items: " << item_count << "\n";
+		os << "\t\tNumber of moveable tiles: " << loose_item_count << "\n";
+		os << "\t\tNumber of depots: " << depot_count << "\n";
+		os << "\t\tNumber of containers: " << container_count << "\n";
+		os << "\t\tNumber of items with Action ID: " << action_item_count << "\n";
+		os << "\t\tNumber of items with Unique ID: " << unique_item_count << "\n";
+		os << "\t\tItems per tile ratio: " << (tile_count > 0 ? (double)item_count / tile_count : 0) << "\n";
+
+		os << "\tCreature data:\n";
+		os << "\t\tTotal creature count: " << creature_count << "\n";
+		os << "\t\tTotal spawn count: " << spawn_count << "\n";
+		if (creatures_per_spawn >= 0) {
+			os << "\t\tMean creatures per spawn: " << creatures_per_spawn << "\n";
 		}
-#undef ANALYZE_ITEM
+		os << "\t\tCreature density: " << (tile_count > 0 ? (double)creature_count / tile_count * 100 : 0) << "% of tiles\n";
 
-		if (tile->spawn) {
-			spawn_count += 1;
+		os << "\tTown/House data:\n";
+		os << "\t\tTotal number of towns: " << town_count << "\n";
+		os << "\t\tTotal number of houses: " << house_count << "\n";
+		if (houses_per_town >= 0) {
+			os << "\t\tMean houses per town: " << houses_per_town << "\n";
 		}
-
-		if (tile->creature) {
-			creature_count += 1;
+		os << "\t\tTotal amount of housetiles: " << total_house_sqm << "\n";
+		if (sqm_per_house >= 0) {
+			os << "\t\tMean tiles per house: " << sqm_per_house << "\n";
 		}
-
-		if (tile->isBlocking()) {
-			blocking_tile_count += 1;
-		} else {
-			walkable_tile_count += 1;
+		if (sqm_per_town >= 0) {
+			os << "\t\tMean tiles per town: " << sqm_per_town << "\n";
 		}
-
-		if (is_detailed) {
-			detailed_tile_count += 1;
+		os << "\t\tPercentage of map covered by houses: " << (tile_count > 0 ? (double)total_house_sqm / tile_count * 100 : 0) << "%\n";
+		/*
+		// Add waypoint statistics
+		int waypoint_count = map->waypoints.getWaypointCount();
+		os << "\tWaypoint data:\n";
+		os << "\t\tTotal number of waypoints: " << waypoint_count << "\n";
+
+		// Add zone statistics if available
+		os << "\tZone data:\n";
+		os << "\t\tTotal number of zones: " << map->zones.size() << "\n";
+		*/
+		if (largest_town) {
+			os << "\t\tLargest Town: \"" << largest_town->getName() << "\" (" << largest_town_size << " sqm)\n";
+		}
+		if (largest_house) {
+			os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
 		}
 
-		load_counter += 1;
-	}
-
-	creatures_per_spawn = (spawn_count != 0 ? double(creature_count) / double(spawn_count) : -1.0);
-	percent_pathable = 100.0 * (tile_count != 0 ? double(walkable_tile_count) / double(tile_count) : -1.0);
-	percent_detailed = 100.0 * (tile_count != 0 ? double(detailed_tile_count) / double(tile_count) : -1.0);
-
-	load_counter = 0;
-	Houses& houses = map->houses;
-	for (HouseMap::const_iterator hit = houses.begin(); hit != houses.end(); ++hit) {
-		const House* house = hit->second;
-
-		if (load_counter % 64) {
-			g_gui.SetLoadDone((unsigned int)(95ll + int64_t(load_counter) * 5ll / int64_t(house_count)));
+		os << "\tFloor data:\n";
+		for (int z = 0; z < MAP_LAYERS; ++z) {
+			if (counters.floor_tiles[z] > 0) {
+				os << "\t\tFloor " << z << ": " << counters.floor_tiles[z] << " tiles\n";
+			}
 		}
 
-		if (house->size() > largest_house_size) {
-			largest_house = house;
-			largest_house_size = house->size();
+		// Ten most used item types
+		std::vector<std::pair<uint32_t, uint16_t>> item_types;
+		for (size_t id = 0; id < counters.item_types.size(); ++id) {
+			if (counters.item_types[id] > 0) {
+				item_types.emplace_back(counters.item_types[id], uint16_t(id));
+			}
 		}
-		total_house_sqm += house->size();
-		town_sqm_count[house->townid] += house->size();
-	}
-
-	houses_per_town = (town_count != 0 ? double(house_count) / double(town_count) : -1.0);
-	sqm_per_house = (house_count != 0 ? double(total_house_sqm) / double(house_count) : -1.0);
-	sqm_per_town = (town_count != 0 ? double(total_house_sqm) / double(town_count) : -1.0);
-
-	Towns& towns = map->towns;
-	for (std::map<uint32_t, uint32_t>::iterator town_iter = town_sqm_count.begin();
-		 town_iter != town_sqm_count.end();
-		 ++town_iter) {
-		// No load bar for this, load is non-existant
-		uint32_t town_id = town_iter->first;
-		uint32_t town_sqm = town_iter->second;
-		Town* town = towns.getTown(town_id);
-		if (town && town_sqm > largest_town_size) {
-			largest_town = town;
-			largest_town_size = town_sqm;
-		} else {
-			// Non-existant town!
+		const size_t top_count = std::min<size_t>(10, item_types.size());
+		std::partial_sort(item_types.begin(), item_types.begin() + top_count, item_types.end(), std::greater<std::pair<uint32_t, uint16_t>>());
+		if (top_count > 0) {
+			os << "\tMost used items:\n";
+			for (size_t i = 0; i < top_count; ++i) {
+				os << "\t\t" << g_items[item_types[i].second].name << " (" << item_types[i].second << "): " << item_types[i].first << "\n";
+			}
 		}
-	}
 
-	g_gui.DestroyLoadBar();
+		// Add map file information
+		os << "\tMap file information:\n";
+		os << "\t\tOTBM version: " << map->getVersion().otbm << "\n";
+		os << "\t\tClient version: " << map->getVersion().client << "\n";
+		os << "\t\tFile size (approximate): " << (map->getTileCount() * 512 / 1024) << " KB\n";
 
-	std::ostringstream os;
-	os.setf(std::ios::fixed, std::ios::floatfield);
-	os.precision(2);
-	os << "Map statistics for the map \"" << map->getMapDescription() << "\"\n";
-
-	// Add map dimensions information
-	os << "\tMap dimensions:\n";
-	os << "\t\tWidth: " << map->getWidth() << " tiles\n";
-	os << "\t\tHeight: " << map->getHeight() << " tiles\n";
-	os << "\t\tTotal area: " << (map->getWidth() * map->getHeight()) << " square tiles\n";
-	os << "\t\tNumber of floors: " << (MAP_MAX_LAYER + 1) << "\n";
-
-	os << "\tTile data:\n";
-	os << "\t\tTotal number of tiles: " << tile_count << "\n";
-	os << "\t\tNumber of pathable tiles: " << walkable_tile_count << "\n";
-	os << "\t\tNumber of unpathable tiles: " << blocking_tile_count << "\n";
-	if (percent_pathable >= 0.0) {
-		os << "\t\tPercent walkable tiles: " << percent_pathable << "%\n";
-	}
-	os << "\t\tDetailed tiles: " << detailed_tile_count << "\n";
-	if (percent_detailed >= 0.0) {
-		os << "\t\tPercent detailed tiles: " << percent_detailed << "%\n";
-	}
-
-	os << "\tItem data:\n";
-	os << "\t\tTotal number of items: " << item_count << "\n";
-	os << "\t\tNumber of moveable tiles: " << loose_item_count << "\n";
-	os << "\t\tNumber of depots: " << depot_count << "\n";
-	os << "\t\tNumber of containers: " << container_count << "\n";
-	os << "\t\tNumber of items with Action ID: " << action_item_count << "\n";
-	os << "\t\tNumber of items with Unique ID: " << unique_item_count << "\n";
-	os << "\t\tItems per tile ratio: " << (tile_count > 0 ? (double)item_count / tile_count : 0) << "\n";
-
-	os << "\tCreature data:\n";
-	os << "\t\tTotal creature count: " << creature_count << "\n";
-	os << "\t\tTotal spawn count: " << spawn_count << "\n";
-	if (creatures_per_spawn >= 0) {
-		os << "\t\tMean creatures per spawn: " << creatures_per_spawn << "\n";
-	}
-	os << "\t\tCreature density: " << (tile_count > 0 ? (double)creature_count / tile_count * 100 : 0) << "% of tiles\n";
-
-	os << "\tTown/House data:\n";
-	os << "\t\tTotal number of towns: " << town_count << "\n";
-	os << "\t\tTotal number of houses: " << house_count << "\n";
-	if (houses_per_town >= 0) {
-		os << "\t\tMean houses per town: " << houses_per_town << "\n";
-	}
-	os << "\t\tTotal amount of housetiles: " << total_house_sqm << "\n";
-	if (sqm_per_house >= 0) {
-		os << "\t\tMean tiles per house: " << sqm_per_house << "\n";
-	}
-	if (sqm_per_town >= 0) {
-		os << "\t\tMean tiles per town: " << sqm_per_town << "\n";
-	}
-	os << "\t\tPercentage of map covered by houses: " << (tile_count > 0 ? (double)total_house_sqm / tile_count * 100 : 0) << "%\n";
-	/*
-	// Add waypoint statistics
-	int waypoint_count = map->waypoints.getWaypointCount();
-	os << "\tWaypoint data:\n";
-	os << "\t\tTotal number of waypoints: " << waypoint_count << "\n";
-
-	// Add zone statistics if available
-	os << "\tZone data:\n";
-	os << "\t\tTotal number of zones: " << map->zones.size() << "\n";
-	*/
-	if (largest_town) {
-		os << "\t\tLargest Town: \"" << largest_town->getName() << "\" (" << largest_town_size << " sqm)\n";
+		os << "\n";
+		os << "Generated by Remere's Map Editor version OTARMEIE " + __RME_VERSION__ + "\n";
+		return os.str();
 	}
-	if (largest_house) {
-		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
+}
+
+void MainMenuBar::OnMapStatistics(wxCommandEvent& WXUNUSED(event)) {
+	if (!g_gui.IsEditorOpen()) {
+		return;
 	}
 
-	// Add map file information
-	os << "\tMap file information:\n";
-	os << "\t\tOTBM version: " << map->getVersion().otbm << "\n";
-	os << "\t\tClient version: " << map->getVersion().client << "\n";
-	os << "\t\tFile size (approximate): " << (map->getTileCount() * 512 / 1024) << " KB\n";
+	Map* map = &g_gui.GetCurrentMap();
 
-	os << "\n";
-	os << "Generated by Remere's Map Editor version OTARMEIE " + __RME_VERSION__ + "\n";
+	// Actions keep the counters up to date, the map is only counted the first time
+	if (!map->statistics.isValid()) {
+		g_gui.CreateLoadBar("Collecting data...");
+		map->statistics.rescan(*map, true);
+		g_gui.DestroyLoadBar();
+	}
 
 	wxDialog* dg = newd wxDialog(frame, wxID_ANY, "Map Statistics", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX);
 	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
-	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(os.str()), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
+	wxTextCtrl* text_field = newd wxTextCtrl(dg, wxID_ANY, wxstr(OnMapStatistics::report(map)), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
 	text_field->SetMinSize(wxSize(400, 300));
 	topsizer->Add(text_field, wxSizerFlags(5).Expand());
 
@@ -2172,6 +2058,18 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent& WXUNUSED(event)) {
 	wxButton* export_button = newd wxButton(dg, wxID_OK, "Export as XML");
 	choicesizer->Add(export_button, wxSizerFlags(1).Center());
 	export_button->Enable(false);
+	wxButton* recount_button = newd wxButton(dg, wxID_REFRESH, "Recount");
+	recount_button->Bind(wxEVT_BUTTON, [map, text_field](wxCommandEvent&) {
+		g_gui.CreateLoadBar("Collecting data...");
+		bool matched = map->statistics.rescan(*map, true);
+		g_gui.DestroyLoadBar();
+
+		text_field->ChangeValue(wxstr(OnMapStatistics::report(map)));
+		if (!matched) {
+			g_gui.PopupDialog("Map Statistics", "The statistics were out of date and have been recounted.", wxOK);
+		}
+	});
+	choicesizer->Add(recount_button, wxSizerFlags(1).Center());
 	choicesizer->Add(newd wxButton(dg, wxID_CANCEL, "OK"), wxSizerFlags(1).Center());
 	topsizer->Add(choicesizer, wxSizerFlags(1).Center());
 	dg->SetSizerAndFit(topsizer);
@@ -2409,17 +2307,18 @@ void MainMenuBar::OnMapCleanup(wxCommandEvent& WXUNUSED(event)) {
                     }
                 } spawnCondition;
                 
-                spawnCondition.totalTiles = currentMap.getTileCount();
+                // Only spawn centers need to be visited, copied since removing edits the list
+                PositionVector spawn_positions(currentMap.spawns.begin(), currentMap.spawns.end());
+                spawnCondition.totalTiles = std::max<long long>(1, spawn_positions.size());
                 spawnCondition.startProgress = progressStep;
                 spawnCondition.endProgress = progressStep + progressIncrement;
                 
                 g_gui.SetLoadDone(progressStep, "Removing empty spawns...");
                 
-                // Need to iterate through all map tiles
-                long long total = currentMap.getTileCount();
+                long long total = spawn_positions.size();
                 long long done = 0;
-                for (MapIterator mit = currentMap.begin(); mit != currentMap.end(); ++mit) {
-                    if (Tile* tile = (*mit)->get()) {
+                for (const Position& spawn_pos : spawn_positions) {
+                    if (Tile* tile = currentMap.getTile(spawn_pos)) {
                         spawnCondition(currentMap, tile, done, total);
                     }
                     done++;
@@ -3617,6 +3516,7 @@ void MainMenuBar::OnRefreshItems(wxCommandEvent& WXUNUSED(event)) {
         msg << itemsToRecreate.size() << " items have been refreshed.";
         g_gui.PopupDialog("Refresh completed", msg, wxOK);
 
+        editor->map.statistics.invalidate();
         editor->map.doChange();
         g_gui.RefreshView();
     }
@@ -20,6 +20,7 @@
 #include "gui.h" // loadbar
 
 #include "map.h"
+#include "worker_pool.h"
 
 #include <sstream>
 #include "string_utils.h"
@@ -143,6 +144,7 @@ bool Map::convert(MapVersion to, bool showdialog) {
 }
 
 bool Map::convert(const ConversionMap& rm, bool showdialog) {
+	statistics.invalidate();
 	if (showdialog) {
 		g_gui.CreateLoadBar("Converting map ...");
 	}
@@ -276,6 +278,7 @@ bool Map::convert(const ConversionMap& rm, bool showdialog) {
 }
 
 void Map::cleanInvalidTiles(bool showdialog) {
+	statistics.invalidate();
 	uint64_t tiles_done = 0;
 	uint64_t removed_count = 0;
 	bool has_invalid_tiles = false;
@@ -341,26 +344,19 @@ void Map::cleanInvalidTiles(bool showdialog) {
 }
 
 void Map::convertHouseTiles(uint32_t fromId, uint32_t toId) {
-	g_gui.CreateLoadBar("Converting house tiles...");
-	uint64_t tiles_done = 0;
-
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		uint32_t houseId = tile->getHouseID();
-		if (houseId == 0 || houseId != fromId) {
-			continue;
-		}
+	House* house = houses.getHouse(fromId);
+	if (!house) {
+		return;
+	}
 
-		tile->setHouseID(toId);
-		++tiles_done;
-		if (tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
+	// Only the tiles of the house itself can carry its id
+	const PositionVector& positions = house->getTilePositions();
+	for (PositionVector::const_iterator pos_iter = positions.begin(); pos_iter != positions.end(); ++pos_iter) {
+		Tile* tile = getTile(*pos_iter);
+		if (tile && tile->getHouseID() == fromId) {
+			tile->setHouseID(toId);
 		}
 	}
-
-	g_gui.DestroyLoadBar();
 }
 
 MapVersion Map::getVersion() const {
@@ -421,20 +417,7 @@ void Map::setSpawnFilename(const std::string& new_spawnfile) {
 }
 
 bool Map::addSpawn(Tile* tile) {
-	Spawn* spawn = tile->spawn;
-	if (spawn) {
-		int z = tile->getZ();
-		int start_x = tile->getX() - spawn->getSize();
-		int start_y = tile->getY() - spawn->getSize();
-		int end_x = tile->getX() + spawn->getSize();
-		int end_y = tile->getY() + spawn->getSize();
-
-		for (int y = start_y; y <= end_y; ++y) {
-			for (int x = start_x; x <= end_x; ++x) {
-				TileLocation* ctile_loc = createTileL(x, y, z);
-				ctile_loc->increaseSpawnCount();
-			}
-		}
+	if (tile->spawn) {
 		spawns.addSpawn(tile);
 		return true;
 	}
@@ -442,113 +425,194 @@ bool Map::addSpawn(Tile* tile) {
 }
 
 void Map::removeSpawnInternal(Tile* tile) {
-	Spawn* spawn = tile->spawn;
-	ASSERT(spawn);
-
-	int z = tile->getZ();
-	int start_x = tile->getX() - spawn->getSize();
-	int start_y = tile->getY() - spawn->getSize();
-	int end_x = tile->getX() + spawn->getSize();
-	int end_y = tile->getY() + spawn->getSize();
-
-	for (int y = start_y; y <= end_y; ++y) {
-		for (int x = start_x; x <= end_x; ++x) {
-			TileLocation* ctile_loc = getTileL(x, y, z);
-			if (ctile_loc != nullptr && ctile_loc->getSpawnCount() > 0) {
-				ctile_loc->decreaseSpawnCount();
-			}
-		}
-	}
+	ASSERT(tile->spawn);
+	spawns.removeSpawn(tile);
 }
 
 void Map::removeSpawn(Tile* tile) {
 	if (tile->spawn) {
 		removeSpawnInternal(tile);
-		spawns.removeSpawn(tile);
 	}
 }
 
 SpawnList Map::getSpawnList(Tile* where) {
 	SpawnList list;
-	TileLocation* tile_loc = where->getLocation();
-	if (tile_loc) {
-		if (tile_loc->getSpawnCount() > 0) {
-			uint32_t found = 0;
-			if (where->spawn) {
-				++found;
-				list.push_back(where->spawn);
-			}
+	if (!where) {
+		return list;
+	}
+
+	PositionVector centers;
+	spawns.getSpawnsCovering(where->getPosition(), centers);
+
+	// Nearest spawns first, like the old expanding search
+	const Position& pos = where->getPosition();
+	std::sort(centers.begin(), centers.end(), [&pos](const Position& a, const Position& b) {
+		return std::max(std::abs(a.x - pos.x), std::abs(a.y - pos.y)) < std::max(std::abs(b.x - pos.x), std::abs(b.y - pos.y));
+	});
+	for (const Position& center : centers) {
+		Tile* tile = getTile(center);
+		if (tile && tile->spawn) {
+			list.push_back(tile->spawn);
+		}
+	}
+	return list;
+}
+
+PositionVector Map::findUnreachableTiles(int x_range, int y_range, bool showdialog) {
+	// Keeps every query box below 65536 tiles, see the table below
+	ASSERT((2 * x_range + 1) * (2 * y_range + 1) < 0x10000);
+	PositionVector result;
+
+	// Union of the used area of all floors, from the occupancy index
+	std::vector<int> floors;
+	int min_x = std::numeric_limits<int>::max(), min_y = std::numeric_limits<int>::max();
+	int max_x = -1, max_y = -1;
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		Position min_pos, max_pos;
+		if (getFloorBounds(z, min_pos, max_pos)) {
+			floors.push_back(z);
+			min_x = std::min(min_x, min_pos.x);
+			min_y = std::min(min_y, min_pos.y);
+			max_x = std::max(max_x, max_pos.x);
+			max_y = std::max(max_y, max_pos.y);
+		}
+	}
+	if (floors.empty()) {
+		return result;
+	}
 
-			// Scans the border tiles in an expanding square around the original spawn
-			int z = where->getZ();
-			int start_x = where->getX() - 1, end_x = where->getX() + 1;
-			int start_y = where->getY() - 1, end_y = where->getY() + 1;
-			while (found != tile_loc->getSpawnCount()) {
-				for (int x = start_x; x <= end_x; ++x) {
-					Tile* tile = getTile(x, start_y, z);
-					if (tile && tile->spawn) {
-						list.push_back(tile->spawn);
-						++found;
+	// The map is handled in bands of rows, each band only needs its rows plus the y range around them.
+	// Bands start on a multiple of the band height so a leaf never lies in two of them.
+	const int band_height = 256;
+	const int first_band = min_y / band_height;
+	const int last_band = max_y / band_height;
+	const int origin_x = min_x - x_range;
+	const int width = max_x - min_x + 1 + 2 * x_range;
+	const int stride = width + 1;
+
+	std::vector<std::vector<std::vector<QTreeNode*>>> band_leaves(MAP_LAYERS, std::vector<std::vector<QTreeNode*>>(last_band - first_band + 1));
+	for (int z : floors) {
+		std::vector<QTreeNode*> leaves;
+		getLeaves(leaves, 1 << z);
+		for (QTreeNode* leaf : leaves) {
+			band_leaves[z][leaf->getFloor(z)->locs[0].getY() / band_height - first_band].push_back(leaf);
+		}
+	}
+
+	WorkerPool pool;
+	std::vector<std::vector<uint16_t>> sums(MAP_LAYERS);
+	std::vector<PositionVector> unreachable(MAP_LAYERS);
+
+	for (int band = first_band; band <= last_band; ++band) {
+		const int top = band * band_height - y_range;
+		const int height = band_height + 2 * y_range;
+
+		// Summed-area table of walkable tiles per floor. Sums wrap around at 16 bits, which is fine since
+		// no query box holds more than 201 * 201 tiles, the difference of four corners is still exact.
+		pool.parallelFor(floors.size(), [&](size_t index) {
+			const int z = floors[index];
+			std::vector<uint16_t>& table = sums[z];
+			table.assign(size_t(stride) * (height + 1), 0);
+
+			for (int ly = top & ~3; ly < top + height; ly += 4) {
+				for (int lx = origin_x & ~3; lx < origin_x + width; lx += 4) {
+					if (lx < 0 || ly < 0 || lx > 0xFFFF || ly > 0xFFFF) {
+						continue;
+					}
+					QTreeNode* leaf = getLeaf(lx, ly);
+					if (!leaf || leaf->getOccupancy(z) == 0) {
+						continue;
 					}
-					tile = getTile(x, end_y, z);
-					if (tile && tile->spawn) {
-						list.push_back(tile->spawn);
-						++found;
+
+					Floor* floor = leaf->getFloor(z);
+					for (int i = 0; i < MAP_LAYERS; ++i) {
+						const Tile* tile = floor->locs[i].get();
+						const int row = ly + (i & 3) - top;
+						const int column = lx + (i >> 2) - origin_x;
+						if (tile && !tile->isBlocking() && row >= 0 && row < height && column >= 0 && column < width) {
+							table[size_t(row + 1) * stride + column + 1] = 1;
+						}
 					}
 				}
+			}
+
+			for (int row = 1; row <= height; ++row) {
+				uint16_t* current = &table[size_t(row) * stride];
+				const uint16_t* above = current - stride;
+				for (int column = 1; column <= width; ++column) {
+					current[column] = uint16_t(current[column] + current[column - 1] + above[column] - above[column - 1]);
+				}
+			}
+		});
+
+		auto boxSum = [&](int z, int x0, int y0, int x1, int y1) -> uint16_t {
+			const std::vector<uint16_t>& table = sums[z];
+			if (table.empty()) {
+				return 0;
+			}
+			const int c0 = x0 - origin_x, c1 = x1 - origin_x + 1;
+			const int r0 = y0 - top, r1 = y1 - top + 1;
+			return uint16_t(table[size_t(r1) * stride + c1] - table[size_t(r0) * stride + c1] - table[size_t(r1) * stride + c0] + table[size_t(r0) * stride + c0]);
+		};
+
+		pool.parallelFor(floors.size(), [&](size_t index) {
+			const int z = floors[index];
+			int start_z, end_z;
+			if (z <= GROUND_LAYER) {
+				start_z = 0;
+				end_z = 9;
+			} else {
+				// underground
+				start_z = std::max(z - 2, GROUND_LAYER);
+				end_z = std::min(z + 2, MAP_MAX_LAYER);
+			}
+
+			for (QTreeNode* leaf : band_leaves[z][band - first_band]) {
+				const uint16_t occupancy = leaf->getOccupancy(z);
+				Floor* floor = leaf->getFloor(z);
+				for (int i = 0; i < MAP_LAYERS; ++i) {
+					if ((occupancy & (1 << i)) == 0) {
+						continue;
+					}
 
-				for (int y = start_y + 1; y < end_y; ++y) {
-					Tile* tile = getTile(start_x, y, z);
-					if (tile && tile->spawn) {
-						list.push_back(tile->spawn);
-						++found;
+					const Position pos = floor->locs[i].getPosition();
+					bool reachable = false;
+					for (int sz = start_z; sz <= end_z && !reachable; ++sz) {
+						reachable = boxSum(sz, pos.x - x_range, pos.y - y_range, pos.x + x_range, pos.y + y_range) != 0;
 					}
-					tile = getTile(end_x, y, z);
-					if (tile && tile->spawn) {
-						list.push_back(tile->spawn);
-						++found;
+					if (!reachable) {
+						unreachable[z].push_back(pos);
 					}
 				}
-				--start_x, --start_y;
-				++end_x, ++end_y;
 			}
+		});
+
+		if (showdialog) {
+			g_gui.SetLoadDone(int(100.0 * (band - first_band + 1) / (last_band - first_band + 1)));
 		}
 	}
-	return list;
+
+	for (PositionVector& positions : unreachable) {
+		result.insert(result.end(), positions.begin(), positions.end());
+	}
+	return result;
 }
 
 bool Map::exportMinimap(FileName filename, int floor, bool displaydialog) {
 	uint8_t* pic = nullptr;
 
 	try {
-		// Find the actual bounds of used tiles
-		int min_x = 0x10000, min_y = 0x10000;
-		int max_x = 0x00000, max_y = 0x00000;
-		bool found_tiles = false;
-
-		for (MapIterator mit = begin(); mit != end(); ++mit) {
-			if ((*mit)->get() == nullptr || (*mit)->empty() || (*mit)->getZ() != floor) {
-				continue;
-			}
-
-			found_tiles = true;
-			Position pos = (*mit)->getPosition();
-
-			min_x = std::min(min_x, pos.x);
-			min_y = std::min(min_y, pos.y);
-			max_x = std::max(max_x, pos.x);
-			max_y = std::max(max_y, pos.y);
-		}
-
-		if (!found_tiles) {
+		// Bounds of the floor come from the occupancy index, no need to walk the map for them
+		Position min_pos, max_pos;
+		if (!getFloorBounds(floor, min_pos, max_pos)) {
 			return true;
 		}
 
 		// Add padding of 10 tiles
-		min_x = std::max(0, min_x - 10);
-		min_y = std::max(0, min_y - 10);
-		max_x = std::min(65535, max_x + 10);
-		max_y = std::min(65535, max_y + 10);
+		int min_x = std::max(0, min_pos.x - 10);
+		int min_y = std::max(0, min_pos.y - 10);
+		int max_x = std::min(65535, max_pos.x + 10);
+		int max_y = std::min(65535, max_pos.y + 10);
 
 		// Calculate dimensions
 		int minimap_width = max_x - min_x + 1;
@@ -558,28 +622,18 @@ bool Map::exportMinimap(FileName filename, int floor, bool displaydialog) {
 		pic = newd uint8_t[minimap_width * minimap_height];
 		memset(pic, 0, minimap_width * minimap_height);
 
-		// Fill the bitmap
-		for (MapIterator mit = begin(); mit != end(); ++mit) {
-			Tile* tile = (*mit)->get();
-			if (!tile || tile->empty() || tile->getZ() != floor) {
-				continue;
-			}
-
-			uint32_t pixelpos = (tile->getY() - min_y) * minimap_width + (tile->getX() - min_x);
-			uint8_t& pixel = pic[pixelpos];
-
-			// Get color from items
-			for (ItemVector::const_reverse_iterator item_iter = tile->items.rbegin(); 
-				 item_iter != tile->items.rend(); ++item_iter) {
-				if ((*item_iter)->getMiniMapColor()) {
-					pixel = (*item_iter)->getMiniMapColor();
-					break;
+		// Fill the bitmap, only the leaves holding this floor are visited
+		std::vector<QTreeNode*> leaves;
+		getLeaves(leaves, 1 << floor);
+		for (QTreeNode* leaf : leaves) {
+			for (TileLocation& location : leaf->getFloor(floor)->locs) {
+				Tile* tile = location.get();
+				if (!tile || tile->empty()) {
+					continue;
 				}
-			}
 
-			// If no item color, check ground
-			if (pixel == 0 && tile->hasGround()) {
-				pixel = tile->ground->getMiniMapColor();
+				uint32_t pixelpos = (tile->getY() - min_y) * minimap_width + (tile->getX() - min_x);
+				pic[pixelpos] = tile->getMiniMapColor();
 			}
 		}
 
@@ -663,6 +717,7 @@ bool Map::exportMinimap(FileName filename, int floor, bool displaydialog) {
 }
 
 uint32_t Map::cleanDuplicateItems(const std::vector<std::pair<uint16_t, uint16_t>>& ranges, const PropertyFlags& flags) {
+	statistics.invalidate();
 	uint32_t duplicates_removed = 0;
 	uint32_t tiles_affected = 0;
 
@@ -25,6 +25,7 @@
 #include "spawn.h"
 #include "complexitem.h"
 #include "waypoints.h"
+#include "map_statistics.h"
 #include "templates.h"
 
 // Add this struct before the Map class definition
@@ -85,6 +86,11 @@ public:
 	void cleanInvalidTiles(bool showdialog = false);
 	void convertHouseTiles(uint32_t fromId, uint32_t toId);
 
+	// Every tile without a walkable tile within x_range/y_range on the floors it can see
+	// (0-9 above ground, two up and down below it). Uses per-floor prefix sums, built and
+	// queried in parallel, so each tile costs a handful of lookups whatever the ranges.
+	PositionVector findUnreachableTiles(int x_range, int y_range, bool showdialog = false);
+
 	// Save a bmp image of the minimap
 	bool exportMinimap(FileName filename, int floor = GROUND_LAYER, bool showdialog = false);
 	//
@@ -217,6 +223,7 @@ protected:
 
 public:
 	Waypoints waypoints;
+	MapStatistics statistics;
 };
 
 template <typename ForeachType>
@@ -281,6 +288,8 @@ inline void foreach_TileOnMap(Map& map, ForeachType& foreach) {
 
 template <typename RemoveIfType>
 inline long long remove_if_TileOnMap(Map& map, RemoveIfType& remove_if) {
+	// Bypasses actions, the statistics have to be recounted
+	map.statistics.invalidate();
 	MapIterator tileiter = map.begin();
 	MapIterator end = map.end();
 	long long done = 0;
@@ -302,6 +311,8 @@ inline long long remove_if_TileOnMap(Map& map, RemoveIfType& remove_if) {
 
 template <typename RemoveIfType>
 inline int64_t RemoveItemOnMap(Map& map, RemoveIfType& condition, bool selectedOnly) {
+	// Bypasses actions, the statistics have to be recounted
+	map.statistics.invalidate();
 	int64_t done = 0;
 	int64_t removed = 0;
 
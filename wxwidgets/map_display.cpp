@@ -61,6 +61,7 @@
 #include "materials.h"
 #include "selection.h"
 #include "find_item_window.h"
+#include "fill_region.h"
 
 BEGIN_EVENT_TABLE(MapCanvas, wxGLCanvas)
 EVT_KEY_DOWN(MapCanvas::OnKeyDown)
@@ -123,8 +124,6 @@ EVT_MENU(MAP_POPUP_MENU_SELECTION_TO_DOODAD, MapCanvas::OnSelectionToDoodad)
 
 END_EVENT_TABLE()
 
-bool MapCanvas::processed[] = { 0 };
-
 MapCanvas::MapCanvas(MapWindow* parent, Editor& editor, int* attriblist) :
 	wxGLCanvas(parent, wxID_ANY, nullptr, wxDefaultPosition, wxDefaultSize, wxWANTS_CHARS),
 	editor(editor),
@@ -2723,8 +2722,38 @@ void MapCanvas::getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, Posi
 			}
 		}
 
-		std::fill(std::begin(processed), std::end(processed), false);
-		floodFill(&editor.map, position, BLOCK_SIZE / 2, BLOCK_SIZE / 2, oldBrush, tilestodraw);
+		// Filling empty space needs ground drawn around it, an empty area reaching the map border
+		// isn't enclosed and would cover the rest of the floor
+		const int limit = g_settings.getInteger(Config::FILL_MAX_TILES);
+		FillRegion region(editor.map, floor);
+		FillRegion::Result result = region.fill(mouse_map_x, mouse_map_y, [oldBrush](const Tile* tile) {
+			if (!oldBrush) {
+				return !tile || !tile->ground;
+			}
+			GroundBrush* groundBrush = tile ? tile->getGroundBrush() : nullptr;
+			return groundBrush && groundBrush->getID() == oldBrush->getID();
+		}, limit, !oldBrush);
+
+		if (result == FillRegion::FILL_ESCAPED) {
+			g_gui.PopupDialog("Error", "Cannot fill - area is not enclosed.", wxOK);
+			return;
+		}
+		if (result == FillRegion::FILL_CAPPED) {
+			wxString message = wxString::Format(
+				"The area is larger than the fill limit of %d tiles.\nFill only the first %d tiles?",
+				limit, (int)region.size());
+			if (g_gui.PopupDialog("Fill Area", message, wxYES_NO) != wxID_YES) {
+				return;
+			}
+		}
+
+		if (tilestodraw) {
+			tilestodraw->insert(tilestodraw->end(), region.getPositions().begin(), region.getPositions().end());
+		}
+		if (tilestoborder) {
+			PositionVector frontier = region.getFrontier();
+			tilestoborder->insert(tilestoborder->end(), frontier.begin(), frontier.end());
+		}
 
 	} else {
 		for (int y = -g_gui.GetBrushSize() - 1; y <= g_gui.GetBrushSize() + 1; y++) {
@@ -2758,59 +2787,6 @@ void MapCanvas::getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, Posi
 	}
 }
 
-bool MapCanvas::floodFill(Map* map, const Position& center, int x, int y, GroundBrush* brush, PositionVector* positions) {
-	countMaxFills++;
-	if (countMaxFills > (BLOCK_SIZE * 4 * 4)) {
-		countMaxFills = 0;
-		return true;
-	}
-
-	if (x <= 0 || y <= 0 || x >= BLOCK_SIZE || y >= BLOCK_SIZE) {
-		return false;
-	}
-
-	processed[getFillIndex(x, y)] = true;
-
-	int px = (center.x + x) - (BLOCK_SIZE / 2);
-	int py = (center.y + y) - (BLOCK_SIZE / 2);
-	if (px <= 0 || py <= 0 || px >= map->getWidth() || py >= map->getHeight()) {
-		return false;
-	}
-
-	Tile* tile = map->getTile(px, py, center.z);
-	if ((tile && tile->ground && !brush) || (!tile && brush)) {
-		return false;
-	}
-
-	if (tile && brush) {
-		GroundBrush* groundBrush = tile->getGroundBrush();
-		if (!groundBrush || groundBrush->getID() != brush->getID()) {
-			return false;
-		}
-	}
-
-	positions->push_back(Position(px, py, center.z));
-
-	bool deny = false;
-	if (!processed[getFillIndex(x - 1, y)]) {
-		deny = floodFill(map, center, x - 1, y, brush, positions);
-	}
-
-	if (!deny && !processed[getFillIndex(x, y - 1)]) {
-		deny = floodFill(map, center, x, y - 1, brush, positions);
-	}
-
-	if (!deny && !processed[getFillIndex(x + 1, y)]) {
-		deny = floodFill(map, center, x + 1, y, brush, positions);
-	}
-
-	if (!deny && !processed[getFillIndex(x, y + 1)]) {
-		deny = floodFill(map, center, x, y + 1, brush, positions);
-	}
-
-	return deny;
-}
-
 // ============================================================================
 // AnimationTimer
 
@@ -3023,78 +2999,72 @@ void MapCanvas::OnFill(wxCommandEvent& WXUNUSED(event)) {
     } else {
         // Normal fill with area validation
         OutputDebugStringA("NORMAL FILL INITIATED! VALIDATING AREA...\n");
-        
-        std::queue<Position> to_check;
-        std::set<Position> checked;
-        to_check.push(start);
-        bool escape_found = false;
-
-        while (!to_check.empty() && !escape_found) {
-            Position pos = to_check.front();
-            to_check.pop();
-
-            if (checked.count(pos) > 0) continue;
-            checked.insert(pos);
-
-            // Check map boundaries
-            if (pos.x <= 0 || pos.y <= 0 || 
-                pos.x >= editor.map.getWidth() - 1 || 
-                pos.y >= editor.map.getHeight() - 1) {
-                escape_found = true;
-                break;
-            }
 
-            Tile* tile = editor.map.getTile(pos);
-            bool is_empty = (!tile || 
-                           (!tile->spawn || !g_settings.getInteger(Config::SHOW_SPAWNS)) && 
-                           (!tile->creature || !g_settings.getInteger(Config::SHOW_CREATURES)) && 
-                           !tile->getTopItem());
-
-            if (!is_empty) continue;
-
-            // Check adjacent tiles (4-directional)
-            Position adjacent[4] = {
-                Position(pos.x + 1, pos.y, floor),
-                Position(pos.x - 1, pos.y, floor),
-                Position(pos.x, pos.y + 1, floor),
-                Position(pos.x, pos.y - 1, floor)
-            };
+        const bool show_spawns = g_settings.getInteger(Config::SHOW_SPAWNS);
+        const bool show_creatures = g_settings.getInteger(Config::SHOW_CREATURES);
+        const int limit = g_settings.getInteger(Config::FILL_MAX_TILES);
 
-            for (const Position& next : adjacent) {
-                if (checked.count(next) > 0) continue;
-                
-                Tile* next_tile = editor.map.getTile(next);
-                bool next_is_empty = (!next_tile || 
-                                    (!next_tile->spawn || !g_settings.getInteger(Config::SHOW_SPAWNS)) && 
-                                    (!next_tile->creature || !g_settings.getInteger(Config::SHOW_CREATURES)) && 
-                                    !next_tile->getTopItem());
-                
-                if (next_is_empty) {
-                    to_check.push(next);
-                }
-            }
-        }
+        FillRegion region(editor.map, floor);
+        FillRegion::Result result = region.fill(start.x, start.y, [show_spawns, show_creatures](const Tile* tile) {
+            return !tile ||
+                   (!tile->spawn || !show_spawns) &&
+                   (!tile->creature || !show_creatures) &&
+                   !tile->getTopItem();
+        }, limit, true);
 
-        if (escape_found) {
+        if (result == FillRegion::FILL_ESCAPED) {
             OutputDebugStringA("AREA NOT ENCLOSED! THE VOID LEAKS!\n");
             g_gui.PopupDialog("Error", "Cannot fill - area is not enclosed.", wxOK);
             return;
         }
+        if (region.size() == 0) {
+            return;
+        }
 
-        OutputDebugStringA(wxString::Format("FOUND %d TILES TO FILL NORMALLY!\n", checked.size()).c_str());
-        
-        Action* action = editor.actionQueue->createAction(ACTION_DRAW);
-        for (const Position& pos : checked) {
-            Tile* tile = editor.map.getTile(pos);
-            if (!tile) {
-                tile = editor.map.createTile(pos.x, pos.y, pos.z);
+        // Let the user see what they are about to change before anything is touched
+        if (result == FillRegion::FILL_CAPPED) {
+            wxString message = wxString::Format(
+                "The area is larger than the fill limit of %d tiles.\nFill only the first %d tiles?",
+                limit, (int)region.size());
+            if (g_gui.PopupDialog("Fill Area", message, wxYES_NO) != wxID_YES) {
+                return;
             }
-            Tile* new_tile = tile->deepCopy(editor.map);
-            g_gui.GetCurrentBrush()->draw(&editor.map, new_tile, nullptr);
+        } else {
+            g_gui.SetStatusText(wxString::Format("Filling %d tiles.", (int)region.size()));
+        }
+
+        OutputDebugStringA(wxString::Format("FOUND %d TILES TO FILL NORMALLY!\n", (int)region.size()).c_str());
+
+        Brush* brush = g_gui.GetCurrentBrush();
+        BatchAction* batch = editor.actionQueue->createBatch(ACTION_DRAW);
+        Action* action = editor.actionQueue->createAction(batch);
+        for (const Position& pos : region.getPositions()) {
+            TileLocation* location = editor.map.createTileL(pos);
+            Tile* tile = location->get();
+            Tile* new_tile = tile ? tile->deepCopy(editor.map) : editor.map.allocator(location);
+            brush->draw(&editor.map, new_tile, nullptr);
             action->addChange(newd Change(new_tile));
         }
-        
-        editor.addAction(action);
+        batch->addAndCommitAction(action);
+
+        // Only tiles on the rim of the area can get new borders, the inside is all the same ground
+        if (brush->needBorders() && g_settings.getInteger(Config::USE_AUTOMAGIC)) {
+            action = editor.actionQueue->createAction(batch);
+            for (const Position& pos : region.getFrontier()) {
+                TileLocation* location = editor.map.createTileL(pos);
+                Tile* tile = location->get();
+                Tile* new_tile = tile ? tile->deepCopy(editor.map) : editor.map.allocator(location);
+                new_tile->borderize(&editor.map);
+                if (tile || new_tile->size() > 0) {
+                    action->addChange(newd Change(new_tile));
+                } else {
+                    delete new_tile;
+                }
+            }
+            batch->addAndCommitAction(action);
+        }
+
+        editor.addBatch(batch);
         g_gui.RefreshView();
         OutputDebugStringA("NORMAL FILL COMPLETE! THE VOID HAS BEEN FILLED!\n");
     }
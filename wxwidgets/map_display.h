@@ -133,7 +133,6 @@ public:
 
 protected:
 	void getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, PositionVector* tilestodraw, PositionVector* tilestoborder, bool fill = false);
-	bool floodFill(Map* map, const Position& center, int x, int y, GroundBrush* brush, PositionVector* positions);
 	bool hasHouseWall(Tile* tile);
 	bool hasDoor(Tile* tile);
 	bool hasStairsOrLadder(Tile* tile);
@@ -143,16 +142,9 @@ private:
 		BLOCK_SIZE = 100
 	};
 
-	inline int getFillIndex(int x, int y) const {
-		return x + BLOCK_SIZE * y;
-	}
-
-	static bool processed[BLOCK_SIZE * BLOCK_SIZE];
-
 	Editor& editor;
 	MapDrawer* drawer;
 	int keyCode;
-	int countMaxFills = 0;
 
 	// View related
 	int floor;
@@ -154,6 +154,48 @@ bool DrawingOptions::isDrawLight() const noexcept {
 	return show_lights;
 }
 
+GhostLayer::~GhostLayer() {
+	clear();
+}
+
+void GhostLayer::reset(const Key& new_key) {
+	clear();
+	key = new_key;
+	valid = true;
+}
+
+void GhostLayer::clear() {
+	for (const Chunk& chunk : chunks) {
+		glDeleteLists(chunk.list, 1);
+	}
+	chunks.clear();
+	valid = false;
+}
+
+void GhostLayer::beginChunk(int x, int y, int z) {
+	const GLuint list = glGenLists(1);
+	chunks.push_back({ x, y, z, list });
+	glNewList(list, GL_COMPILE);
+}
+
+void GhostLayer::endChunk() {
+	glEndList();
+}
+
+void GhostLayer::draw(const Chunk& chunk, int draw_x, int draw_y, int view_width, int view_height) const {
+	// Sprites are drawn up to a few tiles up and left of their own tile
+	const int extent = CHUNK_SIZE * TileSize;
+	const int margin = 3 * TileSize;
+	if (draw_x + extent <= 0 || draw_y + extent <= 0 || draw_x - margin >= view_width || draw_y - margin >= view_height) {
+		return;
+	}
+
+	glPushMatrix();
+	glTranslatef(draw_x, draw_y, 0.0f);
+	glCallList(chunk.list);
+	glPopMatrix();
+}
+
 MapDrawer::MapDrawer(MapCanvas* canvas) :
 	canvas(canvas), editor(canvas->editor) {
 	light_drawer = std::make_shared<LightDrawer>();
@@ -424,7 +466,6 @@ void MapDrawer::DrawMap() {
 		// Draws the doodad preview or the paste preview (or import preview)
 		if (g_gui.secondary_map != nullptr && !options.ingame) {
 			Position normalPos;
-			Position to(mouse_map_x, mouse_map_y, floor);
 
 			if (canvas->isPasting()) {
 				normalPos = editor.copybuffer.getPosition();
@@ -432,92 +473,7 @@ void MapDrawer::DrawMap() {
 				normalPos = Position(0x8000, 0x8000, 0x8);
 			}
 
-			for (int map_x = start_x; map_x <= end_x; map_x++) {
-				for (int map_y = start_y; map_y <= end_y; map_y++) {
-					Position final(map_x, map_y, map_z);
-					Position pos = normalPos + final - to;
-					// Position pos = topos + copypos - Position(map_x, map_y, map_z);
-					if (pos.z >= MAP_LAYERS || pos.z < 0) {
-						continue;
-					}
-
-					Tile* tile = g_gui.secondary_map->getTile(pos);
-					if (tile) {
-						// Compensate for underground/overground
-						int offset;
-						if (map_z <= GROUND_LAYER) {
-							offset = (GROUND_LAYER - map_z) * TileSize;
-						} else {
-							offset = TileSize * (floor - map_z);
-						}
-
-						int draw_x = ((map_x * TileSize) - view_scroll_x) - offset;
-						int draw_y = ((map_y * TileSize) - view_scroll_y) - offset;
-
-						// Draw ground
-						uint8_t r = 160, g = 160, b = 160;
-						if (tile->ground) {
-							if (tile->isBlocking() && options.show_blocking) {
-								g = g / 3 * 2;
-								b = b / 3 * 2;
-							}
-							if (tile->isHouseTile() && options.show_houses) {
-								if ((int)tile->getHouseID() == current_house_id) {
-									r /= 2;
-								} else {
-									r /= 2;
-									g /= 2;
-								}
-							} else if (options.show_special_tiles && tile->isPZ()) {
-								r /= 2;
-								b /= 2;
-							}
-							if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_PVPZONE) {
-								r = r / 3 * 2;
-								b = r / 3 * 2;
-							}
-							if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOLOGOUT) {
-								b /= 2;
-							}
-							if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOPVP) {
-								g /= 2;
-							}
-							if (options.show_zone_areas && tile->getMapFlags() & TILESTATE_ZONE_BRUSH) {
-								size_t zones = tile->getZoneIds().size();
-								uint16_t r16 = 0, g16 = 0, b16 = 0;
-								for (const auto& zoneId : tile->getZoneIds()) {
-									const uint16_t colorIndex = zoneId % colors.size();
-									const Color colour = colors.at(colorIndex);
-
-									r16 += std::get<0>(colour);
-									g16 += std::get<1>(colour);
-									b16 += std::get<2>(colour);
-								}
-
-								r = r16 / zones;
-								g = g16 / zones;
-								b = b16 / zones;
-							}
-							BlitItem(draw_x, draw_y, tile, tile->ground, true, r, g, b, 160);
-						}
-
-						// Draw items on the tile
-						if (zoom <= 10.0 || !options.hide_items_when_zoomed) {
-							ItemVector::iterator it;
-							for (it = tile->items.begin(); it != tile->items.end(); it++) {
-								if ((*it)->isBorder()) {
-									BlitItem(draw_x, draw_y, tile, *it, true, 160, r, g, b);
-								} else {
-									BlitItem(draw_x, draw_y, tile, *it, true, 160, 160, 160, 160);
-								}
-							}
-							if (tile->creature && options.show_creatures) {
-								BlitCreature(draw_x, draw_y, tile->creature);
-							}
-						}
-					}
-				}
-			}
+			DrawSecondaryMap(map_z, normalPos);
 		}
 
 		--start_x;
@@ -612,62 +568,239 @@ void MapDrawer::DrawGrid() {
 	}
 }
 
-void MapDrawer::DrawDraggingShadow() {
-	glEnable(GL_TEXTURE_2D);
+uint64_t MapDrawer::GetGhostOptions() const {
+	uint64_t flags = 0;
+	int bit = 0;
+	for (bool option : { options.show_blocking, options.show_houses, options.show_special_tiles, options.show_zone_areas, options.show_creatures, options.hide_items_when_zoomed, options.show_tech_items, options.highlight_locked_doors, options.show_light_str, options.show_hooks, zoom > 3.0, zoom > 10.0 }) {
+		flags |= uint64_t(option) << bit++;
+	}
+	return flags | (uint64_t(current_house_id) << 32);
+}
 
-	// Draw dragging shadow
-	if (!editor.selection.isBusy() && dragging && !options.ingame) {
-		for (TileSet::iterator tit = editor.selection.begin(); tit != editor.selection.end(); tit++) {
-			Tile* tile = *tit;
-			Position pos = tile->getPosition();
+template <typename DrawTile>
+void MapDrawer::RecordGhostLayer(GhostLayer& layer, std::vector<Tile*>& tiles, DrawTile draw_tile) {
+	// Lower floors first, then chunk by chunk, and column by column inside a chunk like the screen loops
+	std::sort(tiles.begin(), tiles.end(), [](const Tile* a, const Tile* b) {
+		const Position& pa = a->getPosition();
+		const Position& pb = b->getPosition();
+		if (pa.z != pb.z) {
+			return pa.z > pb.z;
+		}
+		if ((pa.x >> GhostLayer::CHUNK_SHIFT) != (pb.x >> GhostLayer::CHUNK_SHIFT)) {
+			return pa.x < pb.x;
+		}
+		if ((pa.y >> GhostLayer::CHUNK_SHIFT) != (pb.y >> GhostLayer::CHUNK_SHIFT)) {
+			return pa.y < pb.y;
+		}
+		return pa.x != pb.x ? pa.x < pb.x : pa.y < pb.y;
+	});
+
+	size_t first = 0;
+	while (first < tiles.size()) {
+		const Position& origin = tiles[first]->getPosition();
+		const int chunk_x = origin.x & ~(GhostLayer::CHUNK_SIZE - 1);
+		const int chunk_y = origin.y & ~(GhostLayer::CHUNK_SIZE - 1);
+		const int chunk_z = origin.z;
+
+		size_t last = first + 1;
+		while (last < tiles.size()) {
+			const Position& pos = tiles[last]->getPosition();
+			if (pos.z != chunk_z || (pos.x & ~(GhostLayer::CHUNK_SIZE - 1)) != chunk_x || (pos.y & ~(GhostLayer::CHUNK_SIZE - 1)) != chunk_y) {
+				break;
+			}
+			++last;
+		}
 
-			int move_x, move_y, move_z;
-			move_x = canvas->drag_start_x - mouse_map_x;
-			move_y = canvas->drag_start_y - mouse_map_y;
-			move_z = canvas->drag_start_z - floor;
+		auto draw_chunk = [&]() {
+			for (size_t i = first; i < last; ++i) {
+				const Position& pos = tiles[i]->getPosition();
+				draw_tile((pos.x - chunk_x) * TileSize, (pos.y - chunk_y) * TileSize, tiles[i]);
+			}
+		};
 
-			pos.x -= move_x;
-			pos.y -= move_y;
-			pos.z -= move_z;
+		// Sprites upload their texture the first time they are drawn, and an upload
+		// compiled into a list never reaches the texture. So draw once without writing
+		// any color to get everything loaded, then record.
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		draw_chunk();
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-			if (pos.z < 0 || pos.z >= MAP_LAYERS) {
-				continue;
+		layer.beginChunk(chunk_x, chunk_y, chunk_z);
+		draw_chunk();
+		layer.endChunk();
+
+		first = last;
+	}
+}
+
+void MapDrawer::DrawSecondaryMap(int map_z, const Position& normalPos) {
+	BaseMap* source = g_gui.secondary_map;
+
+	const GhostLayer::Key key { source, source->getRevision(), GetGhostOptions(), g_gui.gfx.getTextureGeneration() };
+	if (!paste_layer.isCurrent(key)) {
+		paste_layer.reset(key);
+
+		std::vector<Tile*> tiles;
+		tiles.reserve(source->size());
+		for (MapIterator it = source->begin(); it != source->end(); ++it) {
+			if (Tile* tile = (*it)->get()) {
+				tiles.push_back(tile);
 			}
+		}
+		RecordGhostLayer(paste_layer, tiles, [this](int draw_x, int draw_y, Tile* tile) {
+			DrawGhostTile(draw_x, draw_y, tile);
+		});
+	}
 
-			// On screen and dragging?
-			if (pos.x + 2 > start_x && pos.x < end_x && pos.y + 2 > start_y && pos.y < end_y && (move_x != 0 || move_y != 0 || move_z != 0)) {
-				int offset;
-				if (pos.z <= GROUND_LAYER) {
-					offset = (GROUND_LAYER - pos.z) * TileSize;
-				} else {
-					offset = TileSize * (floor - pos.z);
-				}
+	const int source_z = normalPos.z + map_z - floor;
+	if (source_z < 0 || source_z >= MAP_LAYERS) {
+		return;
+	}
 
-				int draw_x = ((pos.x * TileSize) - view_scroll_x) - offset;
-				int draw_y = ((pos.y * TileSize) - view_scroll_y) - offset;
+	// Compensate for underground/overground
+	int offset;
+	if (map_z <= GROUND_LAYER) {
+		offset = (GROUND_LAYER - map_z) * TileSize;
+	} else {
+		offset = TileSize * (floor - map_z);
+	}
 
-				// save performance when moving large chunks unzoomed
-				ItemVector toRender = tile->getSelectedItems(zoom > 3.0);
-				Tile* desttile = editor.map.getTile(pos);
-				for (ItemVector::const_iterator iit = toRender.begin(); iit != toRender.end(); iit++) {
-					if (desttile) {
-						BlitItem(draw_x, draw_y, desttile, *iit, true, 160, 160, 160, 160);
-					} else {
-						BlitItem(draw_x, draw_y, pos, *iit, true, 160, 160, 160, 160);
-					}
-				}
+	const int view_width = screensize_x * zoom;
+	const int view_height = screensize_y * zoom;
+	for (const GhostLayer::Chunk& chunk : paste_layer.getChunks()) {
+		if (chunk.z != source_z) {
+			continue;
+		}
+		const int draw_x = ((chunk.x - normalPos.x + mouse_map_x) * TileSize - view_scroll_x) - offset;
+		const int draw_y = ((chunk.y - normalPos.y + mouse_map_y) * TileSize - view_scroll_y) - offset;
+		paste_layer.draw(chunk, draw_x, draw_y, view_width, view_height);
+	}
+}
 
-				// save performance when moving large chunks unzoomed
-				if (zoom <= 3.0) {
-					if (tile->creature && tile->creature->isSelected() && options.show_creatures) {
-						BlitCreature(draw_x, draw_y, tile->creature);
-					}
-					if (tile->spawn && tile->spawn->isSelected()) {
-						BlitSpriteType(draw_x, draw_y, SPRITE_SPAWN, 160, 160, 160, 160);
-					}
-				}
+void MapDrawer::DrawGhostTile(int draw_x, int draw_y, Tile* tile) {
+	// Draw ground
+	uint8_t r = 160, g = 160, b = 160;
+	if (tile->ground) {
+		if (tile->isBlocking() && options.show_blocking) {
+			g = g / 3 * 2;
+			b = b / 3 * 2;
+		}
+		if (tile->isHouseTile() && options.show_houses) {
+			if ((int)tile->getHouseID() == current_house_id) {
+				r /= 2;
+			} else {
+				r /= 2;
+				g /= 2;
+			}
+		} else if (options.show_special_tiles && tile->isPZ()) {
+			r /= 2;
+			b /= 2;
+		}
+		if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_PVPZONE) {
+			r = r / 3 * 2;
+			b = r / 3 * 2;
+		}
+		if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOLOGOUT) {
+			b /= 2;
+		}
+		if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOPVP) {
+			g /= 2;
+		}
+		if (options.show_zone_areas && tile->getMapFlags() & TILESTATE_ZONE_BRUSH) {
+			size_t zones = tile->getZoneIds().size();
+			uint16_t r16 = 0, g16 = 0, b16 = 0;
+			for (const auto& zoneId : tile->getZoneIds()) {
+				const uint16_t colorIndex = zoneId % colors.size();
+				const Color colour = colors.at(colorIndex);
+
+				r16 += std::get<0>(colour);
+				g16 += std::get<1>(colour);
+				b16 += std::get<2>(colour);
+			}
+
+			r = r16 / zones;
+			g = g16 / zones;
+			b = b16 / zones;
+		}
+		BlitItem(draw_x, draw_y, tile, tile->ground, true, r, g, b, 160);
+	}
+
+	// Draw items on the tile
+	if (zoom <= 10.0 || !options.hide_items_when_zoomed) {
+		ItemVector::iterator it;
+		for (it = tile->items.begin(); it != tile->items.end(); it++) {
+			if ((*it)->isBorder()) {
+				BlitItem(draw_x, draw_y, tile, *it, true, 160, r, g, b);
+			} else {
+				BlitItem(draw_x, draw_y, tile, *it, true, 160, 160, 160, 160);
+			}
+		}
+		if (tile->creature && options.show_creatures) {
+			BlitCreature(draw_x, draw_y, tile->creature);
+		}
+	}
+}
+
+void MapDrawer::DrawGhostSelection(int draw_x, int draw_y, Tile* tile) {
+	// save performance when moving large chunks unzoomed
+	ItemVector toRender = tile->getSelectedItems(zoom > 3.0);
+	for (ItemVector::const_iterator iit = toRender.begin(); iit != toRender.end(); iit++) {
+		BlitItem(draw_x, draw_y, tile, *iit, true, 160, 160, 160, 160);
+	}
+
+	// save performance when moving large chunks unzoomed
+	if (zoom <= 3.0) {
+		if (tile->creature && tile->creature->isSelected() && options.show_creatures) {
+			BlitCreature(draw_x, draw_y, tile->creature);
+		}
+		if (tile->spawn && tile->spawn->isSelected()) {
+			BlitSpriteType(draw_x, draw_y, SPRITE_SPAWN, 160, 160, 160, 160);
+		}
+	}
+}
+
+void MapDrawer::DrawDraggingShadow() {
+	glEnable(GL_TEXTURE_2D);
+
+	// Draw dragging shadow
+	if (!editor.selection.isBusy() && dragging && !options.ingame) {
+		const int move_x = canvas->drag_start_x - mouse_map_x;
+		const int move_y = canvas->drag_start_y - mouse_map_y;
+		const int move_z = canvas->drag_start_z - floor;
+
+		// The selection can't change during a drag, so the drag start identifies it
+		const uint64_t drag_id = (uint64_t(canvas->drag_start_x) << 32) | (uint64_t(canvas->drag_start_y & 0xFFFFFF) << 8) | (canvas->drag_start_z & 0xFF);
+		const GhostLayer::Key key { &editor.selection, drag_id, GetGhostOptions(), g_gui.gfx.getTextureGeneration() };
+		if (!drag_layer.isCurrent(key)) {
+			drag_layer.reset(key);
+
+			std::vector<Tile*> tiles(editor.selection.begin(), editor.selection.end());
+			RecordGhostLayer(drag_layer, tiles, [this](int draw_x, int draw_y, Tile* tile) {
+				DrawGhostSelection(draw_x, draw_y, tile);
+			});
+		}
+
+		const int view_width = screensize_x * zoom;
+		const int view_height = screensize_y * zoom;
+		for (const GhostLayer::Chunk& chunk : drag_layer.getChunks()) {
+			const int z = chunk.z - move_z;
+			if (z < 0 || z >= MAP_LAYERS || (move_x == 0 && move_y == 0 && move_z == 0)) {
+				continue;
 			}
+
+			int offset;
+			if (z <= GROUND_LAYER) {
+				offset = (GROUND_LAYER - z) * TileSize;
+			} else {
+				offset = TileSize * (floor - z);
+			}
+
+			const int draw_x = (((chunk.x - move_x) * TileSize) - view_scroll_x) - offset;
+			const int draw_y = (((chunk.y - move_y) * TileSize) - view_scroll_y) - offset;
+			drag_layer.draw(chunk, draw_x, draw_y, view_width, view_height);
 		}
+	} else {
+		drag_layer.clear();
 	}
 
 	glDisable(GL_TEXTURE_2D);
@@ -1188,6 +1321,44 @@ void MapDrawer::DrawBrush() {
 	}
 }
 
+void MapDrawer::GetItemPattern(const ItemType& type, const GameSprite* sprite, const Item* item, const Position& pos, const Tile* tile, int& subtype, int& pattern_x, int& pattern_y, int& pattern_z) {
+	subtype = -1;
+
+	pattern_x = pos.x % sprite->pattern_x;
+	pattern_y = pos.y % sprite->pattern_y;
+	pattern_z = pos.z % sprite->pattern_z;
+
+	if (type.isSplash() || type.isFluidContainer()) {
+		subtype = item->getSubtype();
+	} else if (type.isHangable) {
+		if (tile && tile->hasProperty(HOOK_SOUTH)) {
+			pattern_x = 1;
+		} else if (tile && tile->hasProperty(HOOK_EAST)) {
+			pattern_x = 2;
+		} else {
+			pattern_x = 0;
+		}
+	} else if (type.stackable) {
+		if (item->getSubtype() <= 1) {
+			subtype = 0;
+		} else if (item->getSubtype() <= 2) {
+			subtype = 1;
+		} else if (item->getSubtype() <= 3) {
+			subtype = 2;
+		} else if (item->getSubtype() <= 4) {
+			subtype = 3;
+		} else if (item->getSubtype() < 10) {
+			subtype = 4;
+		} else if (item->getSubtype() < 25) {
+			subtype = 5;
+		} else if (item->getSubtype() < 50) {
+			subtype = 6;
+		} else {
+			subtype = 7;
+		}
+	}
+}
+
 void MapDrawer::BlitItem(int& draw_x, int& draw_y, const Tile* tile, Item* item, bool ephemeral, int red, int green, int blue, int alpha) {
 	const Position& pos = tile->getPosition();
 	BlitItem(draw_x, draw_y, pos, item, ephemeral, red, green, blue, alpha, tile);
@@ -1263,41 +1434,8 @@ void MapDrawer::BlitItem(int& draw_x, int& draw_y, const Position& pos, Item* it
 	draw_x -= spr->getDrawHeight();
 	draw_y -= spr->getDrawHeight();
 
-	int subtype = -1;
-
-	int pattern_x = pos.x % spr->pattern_x;
-	int pattern_y = pos.y % spr->pattern_y;
-	int pattern_z = pos.z % spr->pattern_z;
-
-	if (it.isSplash() || it.isFluidContainer()) {
-		subtype = item->getSubtype();
-	} else if (it.isHangable) {
-		if (tile && tile->hasProperty(HOOK_SOUTH)) {
-			pattern_x = 1;
-		} else if (tile && tile->hasProperty(HOOK_EAST)) {
-			pattern_x = 2;
-		} else {
-			pattern_x = 0;
-		}
-	} else if (it.stackable) {
-		if (item->getSubtype() <= 1) {
-			subtype = 0;
-		} else if (item->getSubtype() <= 2) {
-			subtype = 1;
-		} else if (item->getSubtype() <= 3) {
-			subtype = 2;
-		} else if (item->getSubtype() <= 4) {
-			subtype = 3;
-		} else if (item->getSubtype() < 10) {
-			subtype = 4;
-		} else if (item->getSubtype() < 25) {
-			subtype = 5;
-		} else if (item->getSubtype() < 50) {
-			subtype = 6;
-		} else {
-			subtype = 7;
-		}
-	}
+	int subtype, pattern_x, pattern_y, pattern_z;
+	GetItemPattern(it, spr, item, pos, tile, subtype, pattern_x, pattern_y, pattern_z);
 
 	if (!ephemeral && options.transparent_items && (!it.isGroundTile() || spr->width > 1 || spr->height > 1) && !it.isSplash() && (!it.isBorder || spr->width > 1 || spr->height > 1)) {
 		alpha /= 2;
@@ -1701,9 +1839,10 @@ void MapDrawer::DrawTile(TileLocation* location) {
 			r = int(r * factor[idx]);
 		}
 
-		if (options.show_spawns && location->getSpawnCount() > 0) {
+		const size_t spawn_coverage = options.show_spawns ? editor.map.spawns.getCoverage(location->getPosition()) : 0;
+		if (spawn_coverage > 0) {
 			float f = 1.0f;
-			for (uint32_t i = 0; i < location->getSpawnCount(); ++i) {
+			for (size_t i = 0; i < spawn_coverage; ++i) {
 				f *= 0.7f;
 			}
 			g = uint8_t(g * f);
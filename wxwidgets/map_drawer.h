@@ -192,6 +192,60 @@ public:
 	}
 };
 
+// Display lists of a translucent preview (paste buffer, doodad buffer or dragged selection),
+// one per CHUNK_SIZE x CHUNK_SIZE tiles of each floor. The chunks are recorded once for a
+// given source and then only replayed, translated to wherever the mouse is.
+class GhostLayer {
+public:
+	static constexpr int CHUNK_SHIFT = 5;
+	static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+
+	// Everything the recorded lists depend on, any change means recording again
+	struct Key {
+		const void* source = nullptr;
+		uint64_t revision = 0;
+		uint64_t options = 0;
+		uint32_t textures = 0;
+
+		bool operator==(const Key& other) const {
+			return source == other.source && revision == other.revision && options == other.options && textures == other.textures;
+		}
+	};
+
+	struct Chunk {
+		int x, y, z; // Top left tile of the chunk, in source coordinates
+		GLuint list;
+	};
+
+	GhostLayer() = default;
+	~GhostLayer();
+	GhostLayer(const GhostLayer&) = delete;
+	GhostLayer& operator=(const GhostLayer&) = delete;
+
+	bool isCurrent(const Key& other) const {
+		return valid && key == other;
+	}
+	// Drops all chunks and starts over for 'new_key'
+	void reset(const Key& new_key);
+	void clear();
+
+	// Everything drawn in between is recorded into a new chunk, tiles are
+	// drawn relative to the chunk origin
+	void beginChunk(int x, int y, int z);
+	void endChunk();
+
+	const std::vector<Chunk>& getChunks() const {
+		return chunks;
+	}
+	// Replays a chunk with its origin at draw_x, draw_y, skipped if it can't reach the view
+	void draw(const Chunk& chunk, int draw_x, int draw_y, int view_width, int view_height) const;
+
+private:
+	Key key;
+	bool valid = false;
+	std::vector<Chunk> chunks;
+};
+
 class MapDrawer {
 	MapCanvas* canvas;
 	Editor& editor;
@@ -216,6 +270,9 @@ protected:
 	std::vector<MapTooltip*> tooltips;
 	std::ostringstream tooltip;
 
+	GhostLayer paste_layer;
+	GhostLayer drag_layer;
+
 public:
 	MapDrawer(MapCanvas* canvas);
 	~MapDrawer();
@@ -248,6 +305,10 @@ public:
 		return options;
 	}
 
+	// Sprite subtype and patterns 'item' is drawn with at 'pos', 'tile' may be null.
+	// Shared with the software renderer of the map image export.
+	static void GetItemPattern(const ItemType& type, const GameSprite* sprite, const Item* item, const Position& pos, const Tile* tile, int& subtype, int& pattern_x, int& pattern_y, int& pattern_z);
+
 protected:
 	void BlitItem(int& screenx, int& screeny, const Tile* tile, Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255);
 	void BlitItem(int& screenx, int& screeny, const Position& pos, Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255, const Tile* tile = nullptr);
@@ -265,6 +326,14 @@ protected:
 	void MakeTooltip(int screenx, int screeny, const std::string& text, uint8_t r = 255, uint8_t g = 255, uint8_t b = 255);
 	void AddLight(TileLocation* location);
 
+	// Paste / doodad preview and dragged selection, see GhostLayer
+	void DrawSecondaryMap(int map_z, const Position& normalPos);
+	void DrawGhostTile(int draw_x, int draw_y, Tile* tile);
+	void DrawGhostSelection(int draw_x, int draw_y, Tile* tile);
+	uint64_t GetGhostOptions() const;
+	template <typename DrawTile>
+	void RecordGhostLayer(GhostLayer& layer, std::vector<Tile*>& tiles, DrawTile draw_tile);
+
 	enum BrushColor {
 		COLOR_BRUSH,
 		COLOR_HOUSE_BRUSH,
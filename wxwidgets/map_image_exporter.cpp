@@ -0,0 +1,478 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_image_exporter.h"
+#include "map_drawer.h"
+#include "worker_pool.h"
+#include "png_writer.h"
+#include "map.h"
+#include "gui.h"
+
+namespace {
+	const int TILE_BYTES = MapImageExporter::TILE_SIZE * MapImageExporter::TILE_SIZE * 4;
+	const int HALF_TILE = MapImageExporter::TILE_SIZE / 2;
+	// Tiles right of and below a piece that can still reach into it: a sprite is up to
+	// three tiles wide and a stack of items lifts it up a bit more
+	const int SPRITE_MARGIN = 4;
+	// Decoded images kept between pieces, 4 kB each
+	const size_t MAX_CACHED_IMAGES = 16384;
+	// Drawn over the lower floors before the viewed floor, as in the editor
+	const uint8_t SHADE[4] = { 0, 0, 0, 128 };
+
+	// 'src' over 'dst', both with straight alpha
+	inline void blend(uint8_t* dst, const uint8_t* src) {
+		const int alpha = src[3];
+		if (alpha == 0) {
+			return;
+		}
+		if (alpha == 255) {
+			memcpy(dst, src, 4);
+			return;
+		}
+
+		const int dst_alpha = dst[3] * (255 - alpha) / 255;
+		const int out_alpha = alpha + dst_alpha;
+		for (int c = 0; c < 3; ++c) {
+			dst[c] = uint8_t((src[c] * alpha + dst[c] * dst_alpha) / out_alpha);
+		}
+		dst[3] = uint8_t(out_alpha);
+	}
+
+	// Alpha weighted average of a size x size square of pixels, 'stride' pixels per row
+	void average(const uint8_t* src, int stride, int size, uint8_t* out) {
+		uint32_t red = 0, green = 0, blue = 0, alpha = 0;
+		for (int y = 0; y < size; ++y) {
+			const uint8_t* pixel = src + size_t(y) * stride * 4;
+			for (int x = 0; x < size; ++x, pixel += 4) {
+				red += pixel[0] * pixel[3];
+				green += pixel[1] * pixel[3];
+				blue += pixel[2] * pixel[3];
+				alpha += pixel[3];
+			}
+		}
+
+		if (alpha == 0) {
+			memset(out, 0, 4);
+			return;
+		}
+		out[0] = uint8_t(red / alpha);
+		out[1] = uint8_t(green / alpha);
+		out[2] = uint8_t(blue / alpha);
+		out[3] = uint8_t(alpha / (size * size));
+	}
+
+	// Shrinks a tile into one quarter of its parent
+	void downsample(const uint8_t* child, uint8_t* parent, int quadrant) {
+		const int size = MapImageExporter::TILE_SIZE;
+		uint8_t* out = parent + (size_t((quadrant >> 1) * HALF_TILE) * size + (quadrant & 1) * HALF_TILE) * 4;
+		for (int y = 0; y < HALF_TILE; ++y) {
+			for (int x = 0; x < HALF_TILE; ++x) {
+				average(child + (size_t(y * 2) * size + x * 2) * 4, size, 2, out + (size_t(y) * size + x) * 4);
+			}
+		}
+	}
+
+	bool hasPixels(const uint8_t* pixels) {
+		for (int i = 3; i < TILE_BYTES; i += 4) {
+			if (pixels[i] != 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+MapImageExporter::MapImageExporter(Map& map, Format format, int zoom, bool lower_floors) :
+	map(map),
+	format(format),
+	zoom(1),
+	lower_floors(lower_floors),
+	tiles_done(0) {
+	// Powers of two only, so pieces always start on a whole image pixel
+	while (this->zoom * 2 <= std::min(zoom, int(MAX_ZOOM))) {
+		this->zoom *= 2;
+	}
+}
+
+void MapImageExporter::setError(const wxString& message) {
+	std::lock_guard<std::mutex> lock(error_mutex);
+	if (error.empty()) {
+		error = message;
+	}
+}
+
+bool MapImageExporter::getUsedArea(int first_floor, int last_floor, int& min_x, int& min_y, int& max_x, int& max_y) const {
+	bool found = false;
+	for (int z = std::max(0, first_floor); z <= std::min(MAP_MAX_LAYER, last_floor); ++z) {
+		Position min_pos, max_pos;
+		if (!map.getFloorBounds(z, min_pos, max_pos)) {
+			continue;
+		}
+
+		if (found) {
+			min_x = std::min(min_x, min_pos.x);
+			min_y = std::min(min_y, min_pos.y);
+			max_x = std::max(max_x, max_pos.x);
+			max_y = std::max(max_y, max_pos.y);
+		} else {
+			min_x = min_pos.x;
+			min_y = min_pos.y;
+			max_x = max_pos.x;
+			max_y = max_pos.y;
+			found = true;
+		}
+	}
+	return found;
+}
+
+MapImageExporter::Image MapImageExporter::getImage(GameSprite* sprite, uint32_t index, ImageCache& local) {
+	const auto key = std::make_pair(static_cast<const GameSprite*>(sprite), index);
+	auto found = local.find(key);
+	if (found != local.end()) {
+		return found->second;
+	}
+
+	Image image;
+	{
+		std::lock_guard<std::mutex> lock(image_mutex);
+		auto shared = images.find(key);
+		if (shared != images.end()) {
+			image = shared->second;
+		} else {
+			// Decoding may read the sprite file, it stays under the lock
+			uint8_t* rgba = sprite->getImageRGBA(index);
+			if (rgba) {
+				image = std::make_shared<Raster>(rgba, rgba + SPRITE_PIXELS_SIZE * 4);
+				delete[] rgba;
+			}
+			// Pieces still drawing hold on to the images they use
+			if (images.size() >= MAX_CACHED_IMAGES) {
+				images.clear();
+			}
+			images[key] = image;
+		}
+	}
+	local[key] = image;
+	return image;
+}
+
+void MapImageExporter::drawItem(Canvas& canvas, int& draw_x, int& draw_y, const Tile* tile, const Item* item) {
+	const ItemType& type = g_items[item->getID()];
+	GameSprite* sprite = type.sprite;
+	if (type.isMetaItem() || !sprite) {
+		return;
+	}
+
+	const int screen_x = draw_x - sprite->getDrawOffset().first;
+	const int screen_y = draw_y - sprite->getDrawOffset().second;
+	draw_x -= sprite->getDrawHeight();
+	draw_y -= sprite->getDrawHeight();
+
+	int subtype, pattern_x, pattern_y, pattern_z;
+	MapDrawer::GetItemPattern(type, sprite, item, tile->getPosition(), tile, subtype, pattern_x, pattern_y, pattern_z);
+
+	for (int cx = 0; cx != sprite->width; ++cx) {
+		for (int cy = 0; cy != sprite->height; ++cy) {
+			for (int cf = 0; cf != sprite->layers; ++cf) {
+				// Always the first animation frame, so exports of the same map compare equal
+				Image image = getImage(sprite, sprite->getImageIndex(cx, cy, cf, subtype, pattern_x, pattern_y, pattern_z, 0), canvas.images);
+				if (!image) {
+					continue;
+				}
+
+				const int left = screen_x - cx * TileSize;
+				const int top = screen_y - cy * TileSize;
+				const int x0 = std::max(0, -left);
+				const int x1 = std::min(SPRITE_PIXELS, canvas.size - left);
+				const int y0 = std::max(0, -top);
+				const int y1 = std::min(SPRITE_PIXELS, canvas.size - top);
+				for (int y = y0; y < y1; ++y) {
+					uint8_t* dst = &canvas.pixels[(size_t(top + y) * canvas.size + left + x0) * 4];
+					const uint8_t* src = &(*image)[(y * SPRITE_PIXELS + x0) * 4];
+					for (int x = x0; x < x1; ++x, dst += 4, src += 4) {
+						blend(dst, src);
+					}
+				}
+			}
+		}
+	}
+}
+
+void MapImageExporter::renderTile(const View& view, int tx, int ty, uint8_t* pixels) {
+	// Drawn at full size, then shrunk by the zoom
+	Canvas canvas;
+	canvas.size = TILE_SIZE * zoom;
+	canvas.pixels.assign(size_t(canvas.size) * canvas.size * 4, 0);
+
+	const int origin_x = tx * canvas.size;
+	const int origin_y = ty * canvas.size;
+	// Sprites only reach up and left of their tile
+	const int first_x = origin_x / TileSize;
+	const int first_y = origin_y / TileSize;
+	const int last_x = (origin_x + canvas.size) / TileSize + SPRITE_MARGIN;
+	const int last_y = (origin_y + canvas.size) / TileSize + SPRITE_MARGIN;
+
+	for (int z = view.start_z; z >= view.floor; --z) {
+		if (z == view.floor && z != view.start_z) {
+			for (size_t i = 0; i < canvas.pixels.size(); i += 4) {
+				if (canvas.pixels[i + 3] != 0) {
+					blend(&canvas.pixels[i], SHADE);
+				}
+			}
+		}
+
+		// Every floor down is drawn one tile further to the bottom right
+		const int shift = z - view.floor;
+		for (int column_y = first_y; column_y <= last_y; ++column_y) {
+			const int map_y = view.min_y + column_y - shift;
+			if (map_y < 0 || map_y > 0xFFFF) {
+				continue;
+			}
+
+			for (int column_x = first_x; column_x <= last_x; ++column_x) {
+				const int map_x = view.min_x + column_x - shift;
+				if (map_x < 0 || map_x > 0xFFFF) {
+					continue;
+				}
+
+				const Tile* tile = map.getTile(map_x, map_y, z);
+				if (!tile) {
+					continue;
+				}
+
+				int draw_x = column_x * TileSize - origin_x;
+				int draw_y = column_y * TileSize - origin_y;
+				if (tile->ground) {
+					drawItem(canvas, draw_x, draw_y, tile, tile->ground);
+				}
+				for (const Item* item : tile->items) {
+					drawItem(canvas, draw_x, draw_y, tile, item);
+				}
+			}
+		}
+	}
+
+	if (zoom == 1) {
+		memcpy(pixels, canvas.pixels.data(), TILE_BYTES);
+	} else {
+		for (int y = 0; y < TILE_SIZE; ++y) {
+			for (int x = 0; x < TILE_SIZE; ++x) {
+				average(&canvas.pixels[(size_t(y) * zoom * canvas.size + x * zoom) * 4], canvas.size, zoom, pixels + (size_t(y) * TILE_SIZE + x) * 4);
+			}
+		}
+	}
+	++tiles_done;
+}
+
+bool MapImageExporter::exportImage(WorkerPool& pool, const View& view, const std::string& filename, int total_tiles) {
+	PngWriter png(filename, view.width, view.height, PngWriter::PNG_RGBA);
+	if (!png.isOk()) {
+		setError("Could not open \"" + wxstr(filename) + "\" for writing.");
+		return false;
+	}
+
+	// One band of pieces at a time, each piece in its own slice of the band
+	Raster band(size_t(TILE_BYTES) * view.tiles_x);
+	Raster row(size_t(view.width) * 4);
+	for (int ty = 0; ty < view.tiles_y; ++ty) {
+		for (int tx = 0; tx < view.tiles_x; ++tx) {
+			pool.submit([this, &view, &band, tx, ty]() {
+				renderTile(view, tx, ty, &band[size_t(TILE_BYTES) * tx]);
+			});
+		}
+		while (!pool.waitFor(std::chrono::milliseconds(100))) {
+			g_gui.SetLoadDone(std::min(99, int(int64_t(tiles_done) * 100 / total_tiles)), "Rendering map...");
+		}
+
+		const int rows = std::min(int(TILE_SIZE), view.height - ty * TILE_SIZE);
+		for (int y = 0; y < rows; ++y) {
+			for (int tx = 0; tx < view.tiles_x; ++tx) {
+				const int columns = std::min(int(TILE_SIZE), view.width - tx * TILE_SIZE);
+				memcpy(&row[size_t(tx) * TILE_SIZE * 4], &band[size_t(TILE_BYTES) * tx + size_t(y) * TILE_SIZE * 4], size_t(columns) * 4);
+			}
+			if (!png.addRow(row.data())) {
+				setError("Could not write \"" + wxstr(filename) + "\".");
+				return false;
+			}
+		}
+	}
+
+	if (!png.finish()) {
+		setError("Could not write \"" + wxstr(filename) + "\".");
+		return false;
+	}
+	return true;
+}
+
+bool MapImageExporter::writeTile(const std::string& directory, int tx, int ty, const uint8_t* pixels) {
+	// Not i2s, it shares one stream between all callers
+	const std::string filename = directory + std::to_string(tx) + "_" + std::to_string(ty) + ".png";
+
+	PngWriter png(filename, TILE_SIZE, TILE_SIZE, PngWriter::PNG_RGBA);
+	for (int y = 0; y < TILE_SIZE; ++y) {
+		if (!png.addRow(pixels + size_t(y) * TILE_SIZE * 4)) {
+			break;
+		}
+	}
+	if (!png.finish()) {
+		setError("Could not write \"" + wxstr(filename) + "\".");
+		return false;
+	}
+	return true;
+}
+
+bool MapImageExporter::exportTile(const View& view, int level, int tx, int ty, const std::vector<std::string>& directories, uint8_t* pixels, bool& used) {
+	used = false;
+	if ((tx << level) >= view.tiles_x || (ty << level) >= view.tiles_y) {
+		return true;
+	}
+
+	if (level == 0) {
+		renderTile(view, tx, ty, pixels);
+		used = hasPixels(pixels);
+	} else {
+		// Depth first, so only one raster per level is alive at a time
+		memset(pixels, 0, TILE_BYTES);
+		Raster child(TILE_BYTES);
+		for (int quadrant = 0; quadrant < 4; ++quadrant) {
+			bool child_used = false;
+			if (!exportTile(view, level - 1, tx * 2 + (quadrant & 1), ty * 2 + (quadrant >> 1), directories, child.data(), child_used)) {
+				return false;
+			}
+			if (child_used) {
+				downsample(child.data(), pixels, quadrant);
+				used = true;
+			}
+		}
+	}
+
+	return !used || writeTile(directories[level], tx, ty, pixels);
+}
+
+bool MapImageExporter::exportArea(const FileName& directory, const wxString& name, int min_x, int min_y, int max_x, int max_y, int first_floor, int last_floor) {
+	first_floor = std::max(0, first_floor);
+	last_floor = std::min(MAP_MAX_LAYER, last_floor);
+	error.clear();
+	tiles_done = 0;
+
+	if (min_x > max_x || min_y > max_y || first_floor > last_floor) {
+		setError("The area to export is empty.");
+		return false;
+	}
+
+	std::vector<View> views;
+	int total_tiles = 0;
+	for (int z = first_floor; z <= last_floor; ++z) {
+		View view;
+		view.floor = z;
+		if (!lower_floors) {
+			view.start_z = z;
+		} else if (z <= GROUND_LAYER) {
+			view.start_z = GROUND_LAYER;
+		} else {
+			view.start_z = std::min(MAP_MAX_LAYER, z + 2);
+		}
+		view.min_x = min_x;
+		view.min_y = min_y;
+		view.width = ((max_x - min_x + 1) * TileSize + zoom - 1) / zoom;
+		view.height = ((max_y - min_y + 1) * TileSize + zoom - 1) / zoom;
+		view.tiles_x = (view.width + TILE_SIZE - 1) / TILE_SIZE;
+		view.tiles_y = (view.height + TILE_SIZE - 1) / TILE_SIZE;
+		total_tiles += view.tiles_x * view.tiles_y;
+		views.push_back(view);
+	}
+
+	WorkerPool pool;
+	const wxString separator = wxFileName::GetPathSeparator();
+	const wxString root = directory.GetFullPath() + separator;
+
+	for (const View& view : views) {
+		if (format == FORMAT_PNG) {
+			FileName file(name + "_" + i2ws(view.floor) + ".png");
+			file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
+			if (!exportImage(pool, view, nstr(file.GetFullPath()), total_tiles)) {
+				return false;
+			}
+			continue;
+		}
+
+		// Smallest level where a single tile covers the whole area
+		int top_level = 0;
+		while (((view.tiles_x - 1) >> top_level) != 0 || ((view.tiles_y - 1) >> top_level) != 0) {
+			++top_level;
+		}
+
+		std::vector<std::string> directories;
+		for (int level = 0; level <= top_level; ++level) {
+			const wxString path = root + name + separator + i2ws(view.floor) + separator + i2ws(level) + separator;
+			if (!wxFileName::Mkdir(path, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+				setError("Could not create the folder \"" + path + "\".");
+				return false;
+			}
+			directories.push_back(nstr(path));
+		}
+
+		// Up to 64 independent branches, the levels above them are merged afterwards
+		const int split_level = std::max(0, top_level - 3);
+		std::map<uint32_t, Raster> merge_tiles;
+		std::mutex merge_mutex;
+		for (int ty = 0; ty <= (view.tiles_y - 1) >> split_level; ++ty) {
+			for (int tx = 0; tx <= (view.tiles_x - 1) >> split_level; ++tx) {
+				pool.submit([this, &view, &directories, &merge_tiles, &merge_mutex, split_level, tx, ty]() {
+					Raster pixels(TILE_BYTES);
+					bool used = false;
+					if (exportTile(view, split_level, tx, ty, directories, pixels.data(), used) && used) {
+						std::lock_guard<std::mutex> lock(merge_mutex);
+						merge_tiles[uint32_t(ty) << 16 | uint32_t(tx)] = std::move(pixels);
+					}
+				});
+			}
+		}
+		while (!pool.waitFor(std::chrono::milliseconds(100))) {
+			g_gui.SetLoadDone(std::min(99, int(int64_t(tiles_done) * 100 / total_tiles)), "Rendering map...");
+		}
+
+		std::map<uint32_t, Raster> tiles = std::move(merge_tiles);
+		for (int level = split_level + 1; level <= top_level && error.empty(); ++level) {
+			std::map<uint32_t, Raster> parents;
+			for (auto& tile : tiles) {
+				const int tx = tile.first & 0xFFFF;
+				const int ty = tile.first >> 16;
+				Raster& parent = parents[uint32_t(ty >> 1) << 16 | uint32_t(tx >> 1)];
+				if (parent.empty()) {
+					parent.assign(TILE_BYTES, 0);
+				}
+				downsample(tile.second.data(), parent.data(), (ty & 1) * 2 + (tx & 1));
+			}
+
+			for (auto& parent : parents) {
+				if (!writeTile(directories[level], parent.first & 0xFFFF, parent.first >> 16, parent.second.data())) {
+					break;
+				}
+			}
+			tiles = std::move(parents);
+		}
+
+		if (!error.empty()) {
+			return false;
+		}
+	}
+
+	return error.empty();
+}
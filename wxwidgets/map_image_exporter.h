@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_IMAGE_EXPORTER_H_
+#define RME_MAP_IMAGE_EXPORTER_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Map;
+class Tile;
+class Item;
+class GameSprite;
+class WorkerPool;
+
+// Renders an area of the map to PNG files, without OpenGL and without a window.
+// Tiles are drawn in software with the sprites and patterns MapDrawer uses. Images are cut into
+// TILE_SIZE x TILE_SIZE pieces rendered on worker threads; only one band of pieces (or one branch
+// of the pyramid per worker) is held at a time, so memory doesn't grow with the area.
+class MapImageExporter {
+public:
+	enum Format {
+		// <name>_<floor>.png, the whole area in one image
+		FORMAT_PNG,
+		// <name>/<floor>/<level>/<x>_<y>.png, level 0 is the full resolution,
+		// every level above halves it, until one tile holds the area
+		FORMAT_TILES,
+	};
+
+	static const int TILE_SIZE = 256;
+	static const int MAX_ZOOM = 8;
+
+	// 'zoom' is the number of map pixels per image pixel, 1, 2, 4 or 8.
+	// With 'lower_floors' the floors below are drawn shaded, like the editor shows all floors.
+	MapImageExporter(Map& map, Format format, int zoom, bool lower_floors);
+
+	// Smallest area holding every tile of floors [first_floor, last_floor], false if they are empty
+	bool getUsedArea(int first_floor, int last_floor, int& min_x, int& min_y, int& max_x, int& max_y) const;
+
+	// Renders floors [first_floor, last_floor] of the area into 'directory', one image or pyramid
+	// per floor, reporting progress on the load bar
+	bool exportArea(const FileName& directory, const wxString& name, int min_x, int min_y, int max_x, int max_y, int first_floor, int last_floor);
+
+	const wxString& getError() const {
+		return error;
+	}
+
+protected:
+	typedef std::vector<uint8_t> Raster; // RGBA
+	typedef std::shared_ptr<const Raster> Image;
+	typedef std::map<std::pair<const GameSprite*, uint32_t>, Image> ImageCache;
+
+	// One floor as seen from above
+	struct View {
+		int floor = 0;
+		int start_z = 0; // lowest floor drawn
+		int min_x = 0, min_y = 0;
+		int width = 0, height = 0; // pixels
+		int tiles_x = 0, tiles_y = 0;
+	};
+
+	// Canvas of one image tile at full resolution
+	struct Canvas {
+		Raster pixels;
+		int size = 0;
+		ImageCache images; // images this worker already looked up
+	};
+
+	Image getImage(GameSprite* sprite, uint32_t index, ImageCache& local);
+	void drawItem(Canvas& canvas, int& draw_x, int& draw_y, const Tile* tile, const Item* item);
+	void renderTile(const View& view, int tx, int ty, uint8_t* pixels);
+
+	bool exportImage(WorkerPool& pool, const View& view, const std::string& filename, int total_tiles);
+	// Renders tile (tx, ty) of 'level' into 'pixels', writing it and every used tile below it
+	bool exportTile(const View& view, int level, int tx, int ty, const std::vector<std::string>& directories, uint8_t* pixels, bool& used);
+	bool writeTile(const std::string& directory, int tx, int ty, const uint8_t* pixels);
+
+	void setError(const wxString& message);
+
+	Map& map;
+	Format format;
+	int zoom;
+	bool lower_floors;
+
+	// Decoded sprite images, shared by all workers
+	std::mutex image_mutex;
+	ImageCache images;
+
+	std::atomic<int> tiles_done;
+	std::mutex error_mutex;
+	wxString error;
+};
+
+#endif
@@ -0,0 +1,408 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_pager.h"
+#include "basemap.h"
+#include "tile.h"
+#include "item.h"
+#include "iomap_otbm.h"
+
+#include <wx/filename.h>
+
+MapPager::MapPager(BaseMap& map) :
+	map(map),
+	map_version(MapVersion(MAP_OTBM_4, CLIENT_VERSION_NONE)),
+	cache(nullptr),
+	cache_end(0),
+	reader(nullptr, 0),
+	clock(1),
+	skip_trims(0),
+	budget(0),
+	paged_tiles(0),
+	failed_leaves(0),
+	failed_edit_reported(false),
+	bytes_per_tile(0) {
+	wxString path = wxFileName::CreateTempFileName(wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "rme_pages");
+	if (!path.empty()) {
+		cache_path = nstr(path);
+		cache = fopen(cache_path.c_str(), "w+b");
+		if (!cache) {
+			wxRemoveFile(path);
+			cache_path.clear();
+		}
+	}
+}
+
+MapPager::~MapPager() {
+	// The map is going away with its tree, nothing needs to be read back
+	if (cache) {
+		fclose(cache);
+	}
+	if (!cache_path.empty()) {
+		wxRemoveFile(wxstr(cache_path));
+	}
+}
+
+bool MapPager::seek(uint64_t offset) {
+#ifdef _WIN32
+	return _fseeki64(cache, static_cast<int64_t>(offset), SEEK_SET) == 0;
+#else
+	return fseeko(cache, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+uint64_t MapPager::getResidentBytes() const {
+	const uint64_t paged = paged_tiles.load(std::memory_order_relaxed);
+	const uint64_t tiles = map.getTileCount();
+	return tiles > paged ? static_cast<uint64_t>((tiles - paged) * bytes_per_tile) : 0;
+}
+
+void MapPager::collectLeaves(QTreeNode* node, bool paged_out, std::vector<QTreeNode*>& leaves) {
+	for (int index = 0; index < MAP_LAYERS; ++index) {
+		QTreeNode* child = node->child[index];
+		if (!child) {
+			continue;
+		}
+		if (child->isLeaf) {
+			if (child->paged_out.load(std::memory_order_relaxed) == paged_out) {
+				leaves.push_back(child);
+			}
+		} else {
+			collectLeaves(child, paged_out, leaves);
+		}
+	}
+}
+
+void MapPager::sampleTileSize(const std::vector<QTreeNode*>& leaves) {
+	// Tiles vary a lot between maps, measure a spread out sample instead of guessing
+	uint64_t bytes = 0;
+	uint64_t tiles = 0;
+	const size_t step = std::max<size_t>(1, leaves.size() / 1024);
+	for (size_t i = 0; i < leaves.size(); i += step) {
+		for (Floor* floor : leaves[i]->array) {
+			if (!floor) {
+				continue;
+			}
+			bytes += sizeof(Floor);
+			for (const TileLocation& location : floor->locs) {
+				if (location.tile) {
+					bytes += location.tile->memsize();
+					++tiles;
+				}
+			}
+		}
+	}
+	if (tiles > 0) {
+		bytes_per_tile = static_cast<double>(bytes) / tiles;
+	}
+}
+
+bool MapPager::canPageOut(const QTreeNode* leaf) const {
+	for (const Floor* floor : leaf->array) {
+		if (!floor) {
+			continue;
+		}
+		for (const TileLocation& location : floor->locs) {
+			// Waypoints, towns and houses point at the locations, they have to stay
+			if (location.waypoint_count > 0 || location.town_count > 0 || location.house_exits) {
+				return false;
+			}
+			const Tile* tile = location.tile;
+			if (tile && (tile->isModified() || tile->isSelected() || tile->creature || tile->spawn)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void MapPager::trim() {
+	const uint32_t now = clock.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (budget == 0 || !cache) {
+		return;
+	}
+	if (skip_trims > 0) {
+		--skip_trims;
+		return;
+	}
+
+	std::vector<QTreeNode*> leaves;
+	if (bytes_per_tile == 0) {
+		collectLeaves(&map.root, false, leaves);
+		sampleTileSize(leaves);
+		if (bytes_per_tile == 0) {
+			return;
+		}
+	}
+	if (getResidentBytes() <= budget) {
+		return;
+	}
+
+	if (leaves.empty()) {
+		collectLeaves(&map.root, false, leaves);
+	}
+	// Leaves used during the last two ticks are on screen or being worked on
+	auto in_use = [this, now](const QTreeNode* leaf) {
+		return leaf->last_used.load(std::memory_order_relaxed) + 2 > now || !canPageOut(leaf);
+	};
+	leaves.erase(std::remove_if(leaves.begin(), leaves.end(), in_use), leaves.end());
+	std::sort(leaves.begin(), leaves.end(), [](const QTreeNode* a, const QTreeNode* b) {
+		return a->last_used.load(std::memory_order_relaxed) < b->last_used.load(std::memory_order_relaxed);
+	});
+
+	// Go a bit below the budget so this doesn't run again for every few tiles loaded
+	const uint64_t target = budget - budget / 10;
+	bool freed = false;
+	std::lock_guard<std::mutex> lock(mutex);
+	for (QTreeNode* leaf : leaves) {
+		if (getResidentBytes() <= target) {
+			break;
+		}
+		freed = pageOut(leaf) || freed;
+	}
+	if (!freed) {
+		// Everything left is in use or modified, no point in walking the tree every tick
+		skip_trims = 10;
+	}
+}
+
+bool MapPager::pageInAll() {
+	std::vector<QTreeNode*> leaves;
+	collectLeaves(&map.root, true, leaves);
+	bool ok = true;
+	for (QTreeNode* leaf : leaves) {
+		pageIn(leaf);
+		ok = !leaf->paged_out.load(std::memory_order_relaxed) && ok;
+	}
+	return ok;
+}
+
+bool MapPager::retryFailed() {
+	std::vector<QTreeNode*> leaves;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& entry : records) {
+			if (entry.second.failed) {
+				leaves.push_back(entry.first);
+			}
+		}
+	}
+	for (QTreeNode* leaf : leaves) {
+		pageIn(leaf);
+	}
+	return !hasFailedLeaves();
+}
+
+bool MapPager::pageOut(QTreeNode* leaf) {
+	int base_x = -1, base_y = -1;
+	for (const Floor* floor : leaf->array) {
+		if (floor) {
+			base_x = floor->locs[0].getX();
+			base_y = floor->locs[0].getY();
+			break;
+		}
+	}
+	if (base_x < 0) {
+		return false;
+	}
+
+	writer.reset();
+	writer.addNode(0);
+	writer.addU16(base_x);
+	writer.addU16(base_y);
+	uint32_t tiles = 0;
+	for (uint8_t z = 0; z < MAP_LAYERS; ++z) {
+		if (const Floor* floor = leaf->array[z]) {
+			for (uint8_t index = 0; index < MAP_LAYERS; ++index) {
+				if (const Tile* tile = floor->locs[index].tile) {
+					writeTile(tile, z, index);
+					++tiles;
+				}
+			}
+		}
+	}
+	writer.endNode();
+
+	Record& record = records[leaf];
+	const size_t size = writer.getSize();
+	if (size > record.capacity) {
+		record.offset = cache_end;
+		record.capacity = size;
+		cache_end += size;
+	}
+	if (!seek(record.offset) || fwrite(writer.getMemory(), 1, size, cache) != size) {
+		// Disk full or similar, keep the leaf as it is
+		return false;
+	}
+	record.size = size;
+	record.tiles = tiles;
+
+	for (Floor*& floor : leaf->array) {
+		delete floor;
+		floor = nullptr;
+	}
+	paged_tiles += tiles;
+	leaf->paged_out.store(true, std::memory_order_release);
+	return true;
+}
+
+void MapPager::pageIn(QTreeNode* leaf) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!leaf->paged_out.load(std::memory_order_relaxed)) {
+		// Another thread was first
+		return;
+	}
+
+	auto it = records.find(leaf);
+	ASSERT(it != records.end());
+	Record& record = it->second;
+
+	buffer.resize(record.size);
+	bool ok = seek(record.offset) && fread(buffer.data(), 1, record.size, cache) == record.size;
+	if (ok) {
+		reader.assign(buffer.data(), buffer.size());
+		BinaryNode* root = reader.getRootNode();
+		uint8_t type;
+		uint16_t base_x, base_y;
+		ok = root && root->getU8(type) && root->getU16(base_x) && root->getU16(base_y);
+		if (ok) {
+			for (BinaryNode* node = root->getChild(); node; node = node->advance()) {
+				readTile(node, leaf, base_x, base_y);
+			}
+		}
+		reader.close();
+	}
+
+	if (!ok) {
+		// The leaf stays paged out with its record, it reads as empty and the next access tries
+		// again; the tiles are still in the cache file, nothing may write over them
+		if (!record.failed) {
+			record.failed = true;
+			++failed_leaves;
+			wxLogError("Could not read map tiles back from the page cache file \"%s\", part of the map can't be shown or edited and the map can't be saved.", wxstr(cache_path));
+		}
+		return;
+	}
+
+	if (record.failed) {
+		record.failed = false;
+		--failed_leaves;
+	}
+	paged_tiles -= record.tiles;
+	leaf->paged_out.store(false, std::memory_order_release);
+}
+
+void MapPager::reportFailedEdit() {
+	if (!failed_edit_reported.exchange(true, std::memory_order_relaxed)) {
+		wxLogError("Tiles were changed in a part of the map that couldn't be read back from the page cache file, the map can't be saved until it is.");
+	}
+}
+
+void MapPager::writeTile(const Tile* tile, uint8_t z, uint8_t index) {
+	writer.addNode(tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+	writer.addU8(z);
+	writer.addU8(index);
+	writer.addU8(tile->ground ? 1 : 0);
+
+	if (tile->isHouseTile()) {
+		writer.addU32(tile->getHouseID());
+	}
+
+	if (tile->getMapFlags()) {
+		writer.addByte(OTBM_ATTR_TILE_FLAGS);
+		writer.addU32(tile->getMapFlags());
+		if (tile->getMapFlags() & TILESTATE_ZONE_BRUSH) {
+			for (const auto& zoneId : tile->getZoneIds()) {
+				writer.addU16(zoneId);
+			}
+			writer.addU16(0);
+		}
+	}
+
+	// Every item as a full node, the cache is never read by anything else. The ground goes first.
+	if (tile->ground) {
+		tile->ground->serializeItemNode_OTBM(map_version, writer);
+	}
+	for (const Item* item : tile->items) {
+		item->serializeItemNode_OTBM(map_version, writer);
+	}
+
+	writer.endNode();
+}
+
+void MapPager::readTile(BinaryNode* node, QTreeNode* leaf, int base_x, int base_y) {
+	uint8_t type, z, index, has_ground;
+	if (!node->getU8(type) || !node->getU8(z) || !node->getU8(index) || !node->getU8(has_ground) || z >= MAP_LAYERS || index >= MAP_LAYERS) {
+		return;
+	}
+
+	// Straight into the floor, the tile was never taken out of the counts
+	Floor* floor = leaf->createFloor(base_x, base_y, z);
+	TileLocation* location = &floor->locs[index];
+	if (location->tile || !(leaf->occupancy[z] & (1 << index))) {
+		// Set or cleared while the leaf couldn't be read back, the newer state wins
+		return;
+	}
+	Tile* tile = map.allocator(location);
+
+	if (type == OTBM_HOUSETILE) {
+		uint32_t house_id = 0;
+		node->getU32(house_id);
+		tile->setHouseID(house_id);
+	}
+
+	uint8_t attribute;
+	while (node->getU8(attribute)) {
+		if (attribute != OTBM_ATTR_TILE_FLAGS) {
+			break;
+		}
+		uint32_t flags = 0;
+		node->getU32(flags);
+		tile->setMapFlags(flags);
+		if (flags & TILESTATE_ZONE_BRUSH) {
+			uint16_t zoneId = 0;
+			while (node->getU16(zoneId) && zoneId != 0) {
+				tile->addZoneId(zoneId);
+			}
+		}
+	}
+
+	// The stack is restored as it was, addItem would sort it and replace grounds again
+	for (BinaryNode* itemNode = node->getChild(); itemNode; itemNode = itemNode->advance()) {
+		uint8_t itemType;
+		if (!itemNode->getByte(itemType) || itemType != OTBM_ITEM) {
+			continue;
+		}
+		const bool is_ground = has_ground != 0;
+		has_ground = 0;
+		Item* item = Item::Create_OTBM(map_version, itemNode);
+		if (!item) {
+			continue;
+		}
+		item->unserializeItemNode_OTBM(map_version, itemNode);
+		if (is_ground) {
+			tile->ground = item;
+		} else {
+			tile->items.push_back(item);
+		}
+	}
+	tile->update();
+
+	location->tile = tile;
+}
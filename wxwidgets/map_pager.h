@@ -0,0 +1,129 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_PAGER_H_
+#define RME_MAP_PAGER_H_
+
+#include "map_region.h"
+#include "filehandle.h"
+#include "iomap.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class BaseMap;
+class Tile;
+
+// Keeps the tiles of a map within a memory budget.
+// Leaves (4x4 tiles on all floors) that weren't used for a while and hold nothing but saved,
+// unselected tiles are written to a temporary cache file and their floors are deleted. The tree,
+// the occupancy bits and the tile count are left alone, so the map looks the same from outside;
+// the next access to the leaf through the tree (QTreeNode::use) reads the tiles back.
+class MapPager {
+public:
+	MapPager(BaseMap& map);
+	~MapPager();
+
+	MapPager(const MapPager&) = delete;
+	MapPager& operator=(const MapPager&) = delete;
+
+	// False if the cache file couldn't be created
+	bool isOk() const {
+		return cache != nullptr;
+	}
+
+	void setBudget(uint64_t bytes) {
+		budget = bytes;
+	}
+	uint64_t getBudget() const {
+		return budget;
+	}
+	// Estimated memory held by the tiles that are in memory
+	uint64_t getResidentBytes() const;
+	uint64_t getPagedTileCount() const {
+		return paged_tiles;
+	}
+	// True while a paged out leaf can't be read back, saving would write that part of the map as empty
+	bool hasFailedLeaves() const {
+		return failed_leaves.load(std::memory_order_relaxed) > 0;
+	}
+	// Logs once that tiles were stored on a leaf that couldn't be read back
+	void reportFailedEdit();
+
+	// Any thread
+	void use(QTreeNode* leaf) {
+		leaf->last_used.store(clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		if (leaf->paged_out.load(std::memory_order_acquire)) {
+			pageIn(leaf);
+		}
+	}
+
+	// Main thread only, while no tile pointers of the map are held: advances the clock and pages
+	// out the least recently used leaves until the map fits its budget again
+	void trim();
+	// Reads every paged out leaf back, false if any of them couldn't be read
+	bool pageInAll();
+	// Tries the leaves that couldn't be read back again, false if any of them still fails
+	bool retryFailed();
+
+private:
+	struct Record {
+		uint64_t offset = 0;
+		uint32_t size = 0;
+		uint32_t capacity = 0; // Space reserved in the file, a record is rewritten in place if it fits
+		uint32_t tiles = 0;
+		bool failed = false; // Reading it back failed once, already reported
+	};
+
+	void pageIn(QTreeNode* leaf);
+	bool pageOut(QTreeNode* leaf);
+	bool canPageOut(const QTreeNode* leaf) const;
+	void sampleTileSize(const std::vector<QTreeNode*>& leaves);
+	// Walks the tree without faulting anything in
+	static void collectLeaves(QTreeNode* node, bool paged_out, std::vector<QTreeNode*>& leaves);
+
+	void writeTile(const Tile* tile, uint8_t z, uint8_t index);
+	void readTile(BinaryNode* node, QTreeNode* leaf, int base_x, int base_y);
+
+	bool seek(uint64_t offset);
+
+	BaseMap& map;
+	VirtualIOMap map_version;
+	std::string cache_path;
+	FILE* cache;
+	uint64_t cache_end;
+
+	std::mutex mutex; // Guards the file, the records and the buffers, taken by pageIn from any thread
+	std::unordered_map<QTreeNode*, Record> records;
+	MemoryNodeFileWriteHandle writer;
+	MemoryNodeFileReadHandle reader;
+	std::vector<uint8_t> buffer;
+
+	std::atomic<uint32_t> clock;
+	uint32_t skip_trims; // Trims left to skip after one that couldn't free anything
+	uint64_t budget;
+	std::atomic<uint64_t> paged_tiles;
+	std::atomic<uint32_t> failed_leaves;
+	std::atomic<bool> failed_edit_reported;
+	double bytes_per_tile;
+};
+
+#endif
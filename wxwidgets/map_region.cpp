@@ -27,7 +27,6 @@
 TileLocation::TileLocation() :
 	tile(nullptr),
 	position(0, 0, 0),
-	spawn_count(0),
 	waypoint_count(0),
 	town_count(0),
 	house_exits(nullptr) {
@@ -43,7 +42,7 @@ int TileLocation::size() const {
 	if (tile) {
 		return tile->size();
 	}
-	return spawn_count + waypoint_count + (house_exits ? 1 : 0);
+	return waypoint_count + (house_exits ? 1 : 0);
 }
 
 bool TileLocation::empty() const {
@@ -68,10 +67,14 @@ Floor::Floor(int sx, int sy, int z) {
 QTreeNode::QTreeNode(BaseMap& map) :
 	map(map),
 	visible(0),
-	isLeaf(false) {
+	floor_mask(0),
+	isLeaf(false),
+	paged_out(false),
+	last_used(0) {
 	// Doesn't matter if we're leaf or node
 	for (int i = 0; i < MAP_LAYERS; ++i) {
 		child[i] = nullptr;
+		occupancy[i] = 0;
 	}
 }
 
@@ -92,6 +95,7 @@ QTreeNode* QTreeNode::getLeaf(int x, int y) {
 	uint32_t cx = x, cy = y;
 	while (node) {
 		if (node->isLeaf) {
+			node->use();
 			return node;
 		} else {
 			uint32_t index = ((cx & 0xC000) >> 14) | ((cy & 0xC000) >> 12);
@@ -117,6 +121,7 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 		QTreeNode*& qt = node->child[index];
 		if (qt) {
 			if (qt->isLeaf) {
+				qt->use();
 				return qt;
 			}
 
@@ -227,6 +232,10 @@ TileLocation* QTreeNode::createTile(int x, int y, int z) {
 
 Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	ASSERT(isLeaf);
+	if (paged_out.load(std::memory_order_acquire)) {
+		// The leaf couldn't be read back (see MapPager), what is stored now wins over the cached tiles
+		map.pager->reportFailedEdit();
+	}
 	Floor* f = createFloor(x, y, z);
 
 	int offset_x = x & 3;
@@ -235,11 +244,20 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
 	Tile* oldtile = tmp->tile;
 	tmp->tile = newtile;
+	map.touch();
 
-	if (newtile && !oldtile) {
+	const uint16_t bit = 1 << (offset_x * 4 + offset_y);
+	// A paged out leaf keeps the bits of the tiles that are in the cache file
+	const bool had_tile = oldtile || (occupancy[z] & bit);
+	if (newtile && !had_tile) {
 		++map.tilecount;
-	} else if (oldtile && !newtile) {
+		const bool first = occupancy[z] == 0;
+		occupancy[z] |= bit;
+		map.onTileAdded(x, y, z, first);
+	} else if (had_tile && !newtile) {
 		--map.tilecount;
+		occupancy[z] &= ~bit;
+		map.onTileRemoved(x, y, z, occupancy[z] == 0);
 	}
 
 	return oldtile;
@@ -247,6 +265,9 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 
 void QTreeNode::clearTile(int x, int y, int z) {
 	ASSERT(isLeaf);
+	if (paged_out.load(std::memory_order_acquire)) {
+		map.pager->reportFailedEdit();
+	}
 	Floor* f = createFloor(x, y, z);
 
 	int offset_x = x & 3;
@@ -255,4 +276,5 @@ void QTreeNode::clearTile(int x, int y, int z) {
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
 	delete tmp->tile;
 	tmp->tile = map.allocator(tmp);
+	map.touch();
 }
@@ -20,6 +20,8 @@
 
 #include "position.h"
 
+#include <atomic>
+
 class Tile;
 class Floor;
 class BaseMap;
@@ -36,7 +38,6 @@ public:
 protected:
 	Tile* tile;
 	Position position;
-	size_t spawn_count;
 	size_t waypoint_count;
 	size_t town_count;
 	HouseExitList* house_exits; // Any house exits pointing here
@@ -68,15 +69,6 @@ public:
 		return position.z;
 	}
 
-	size_t getSpawnCount() const {
-		return spawn_count;
-	}
-	void increaseSpawnCount() {
-		spawn_count++;
-	}
-	void decreaseSpawnCount() {
-		spawn_count--;
-	}
 	size_t getWaypointCount() const {
 		return waypoint_count;
 	}
@@ -108,6 +100,7 @@ public:
 	friend class Floor;
 	friend class QTreeNode;
 	friend class Waypoints;
+	friend class MapPager;
 };
 
 class Floor {
@@ -152,11 +145,31 @@ public:
 	bool isVisible(bool underground);
 	bool isRequested(bool underground);
 
+	// Bit z is set if floor z has a tile anywhere below this node
+	uint16_t getFloorMask() const {
+		return floor_mask;
+	}
+	// Leaves only, bit (x & 3) * 4 + (y & 3) is set if that position of floor z has a tile
+	uint16_t getOccupancy(int z) const {
+		return occupancy[z];
+	}
+
+	// Leaves only, called on every access through the tree: reads the floors back if the
+	// map's pager wrote them out and marks the leaf as recently used
+	void use();
+	bool isPagedOut() const {
+		return paged_out.load(std::memory_order_acquire);
+	}
+
 protected:
 	BaseMap& map;
 	uint32_t visible;
+	uint16_t floor_mask;
+	uint16_t occupancy[MAP_LAYERS];
 
 	bool isLeaf;
+	std::atomic<bool> paged_out;
+	std::atomic<uint32_t> last_used; // MapPager clock tick of the last access
 	union {
 		QTreeNode* child[MAP_LAYERS];
 		Floor* array[MAP_LAYERS];
@@ -169,6 +182,7 @@ protected:
 
 	friend class BaseMap;
 	friend class MapIterator;
+	friend class MapPager;
 };
 
 #endif
@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_statistics.h"
+#include "worker_pool.h"
+#include "complexitem.h"
+#include "items.h"
+#include "map.h"
+#include "gui.h"
+
+namespace {
+	template <typename T>
+	void addSigned(T& counter, int sign) {
+		counter += T(sign);
+	}
+}
+
+void MapStatistics::Counters::addTile(const Tile* tile, int sign) {
+	if (!tile || tile->empty()) {
+		return;
+	}
+
+	addSigned(tiles, sign);
+	addSigned(floor_tiles[tile->getZ()], sign);
+
+	bool is_detailed = false;
+	auto addItem = [&](const Item* item) {
+		addSigned(items, sign);
+
+		const uint16_t id = item->getID();
+		if (id >= item_types.size()) {
+			item_types.resize(size_t(id) + 1, 0);
+		}
+		addSigned(item_types[id], sign);
+
+		if (item->isGroundTile() || item->isBorder()) {
+			return;
+		}
+
+		is_detailed = true;
+		const ItemType& type = g_items[id];
+		if (type.moveable) {
+			addSigned(loose_items, sign);
+		}
+		if (type.isDepot()) {
+			addSigned(depots, sign);
+		}
+		if (item->getActionID() > 0) {
+			addSigned(action_items, sign);
+		}
+		if (item->getUniqueID() > 0) {
+			addSigned(unique_items, sign);
+		}
+		// Only pay for the cast when the type can be a container
+		if (type.isContainer()) {
+			const Container* container = dynamic_cast<const Container*>(item);
+			if (container && container->getItemCount() > 0) {
+				addSigned(containers, sign);
+			}
+		}
+	};
+
+	if (tile->ground) {
+		addItem(tile->ground);
+	}
+	for (const Item* item : tile->items) {
+		addItem(item);
+	}
+
+	if (tile->spawn) {
+		addSigned(spawns, sign);
+	}
+	if (tile->creature) {
+		addSigned(creatures, sign);
+	}
+	if (tile->isBlocking()) {
+		addSigned(blocking_tiles, sign);
+	} else {
+		addSigned(walkable_tiles, sign);
+		if (tile->isHouseTile()) {
+			// A tile only leaves after it entered, the count never goes below zero
+			uint64_t& house_count = house_tiles[tile->getHouseID()];
+			addSigned(house_count, sign);
+			if (house_count == 0) {
+				house_tiles.erase(tile->getHouseID());
+			}
+		}
+	}
+	if (is_detailed) {
+		addSigned(detailed_tiles, sign);
+	}
+}
+
+void MapStatistics::Counters::merge(const Counters& other) {
+	tiles += other.tiles;
+	detailed_tiles += other.detailed_tiles;
+	blocking_tiles += other.blocking_tiles;
+	walkable_tiles += other.walkable_tiles;
+	spawns += other.spawns;
+	creatures += other.creatures;
+	items += other.items;
+	loose_items += other.loose_items;
+	depots += other.depots;
+	action_items += other.action_items;
+	unique_items += other.unique_items;
+	containers += other.containers;
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		floor_tiles[z] += other.floor_tiles[z];
+	}
+	for (const auto& house : other.house_tiles) {
+		house_tiles[house.first] += house.second;
+	}
+
+	if (other.item_types.size() > item_types.size()) {
+		item_types.resize(other.item_types.size(), 0);
+	}
+	for (size_t id = 0; id < other.item_types.size(); ++id) {
+		item_types[id] += other.item_types[id];
+	}
+}
+
+bool MapStatistics::Counters::operator==(const Counters& other) const {
+	if (tiles != other.tiles || detailed_tiles != other.detailed_tiles || blocking_tiles != other.blocking_tiles || walkable_tiles != other.walkable_tiles || spawns != other.spawns || creatures != other.creatures || items != other.items || loose_items != other.loose_items || depots != other.depots || action_items != other.action_items || unique_items != other.unique_items || containers != other.containers) {
+		return false;
+	}
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		if (floor_tiles[z] != other.floor_tiles[z]) {
+			return false;
+		}
+	}
+	if (house_tiles != other.house_tiles) {
+		return false;
+	}
+
+	// Trailing zeroes don't matter, the vectors only grow
+	for (size_t id = 0; id < std::max(item_types.size(), other.item_types.size()); ++id) {
+		const uint32_t mine = id < item_types.size() ? item_types[id] : 0;
+		const uint32_t theirs = id < other.item_types.size() ? other.item_types[id] : 0;
+		if (mine != theirs) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void MapStatistics::onTileSwapped(const Tile* removed, const Tile* added) {
+	if (!valid) {
+		return;
+	}
+	counters.addTile(removed, -1);
+	counters.addTile(added, 1);
+}
+
+bool MapStatistics::rescan(Map& map, bool showdialog) {
+	std::vector<QTreeNode*> leaves;
+	map.getLeaves(leaves);
+
+	WorkerPool pool;
+	const size_t parts = std::max<size_t>(1, std::min(pool.size() * 4, leaves.size() / 1024 + 1));
+	std::vector<Counters> partial(parts);
+	std::atomic<size_t> parts_done(0);
+
+	// Leaves are split in contiguous ranges, every part counts into its own counters
+	for (size_t part = 0; part < parts; ++part) {
+		pool.submit([&, part]() {
+			const size_t begin = leaves.size() * part / parts;
+			const size_t end = leaves.size() * (part + 1) / parts;
+			for (size_t index = begin; index < end; ++index) {
+				for (int z = 0; z < MAP_LAYERS; ++z) {
+					Floor* floor = leaves[index]->getFloor(z);
+					if (!floor) {
+						continue;
+					}
+					for (TileLocation& location : floor->locs) {
+						partial[part].addTile(location.get());
+					}
+				}
+			}
+			++parts_done;
+		});
+	}
+
+	while (!pool.waitFor(std::chrono::milliseconds(100))) {
+		if (showdialog) {
+			g_gui.SetLoadDone(int(std::min<size_t>(99, parts_done * 100 / parts)));
+		}
+	}
+
+	Counters result;
+	for (const Counters& counted : partial) {
+		result.merge(counted);
+	}
+
+	const bool matched = !valid || result == counters;
+	counters = std::move(result);
+	valid = true;
+	return matched;
+}
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_STATISTICS_H_
+#define RME_MAP_STATISTICS_H_
+
+#include <map>
+#include <vector>
+
+class Map;
+class Tile;
+
+// Tile, item and creature totals of a map.
+// A parallel rescan establishes the counters, after that every tile swapped in or out by an
+// Action keeps them current, so showing the statistics doesn't have to walk the map again.
+// Edits that bypass actions (imports, cleanups, tiles given to a house in place) invalidate them instead.
+class MapStatistics {
+public:
+	struct Counters {
+		// Only tiles with something on them are counted
+		uint64_t tiles = 0;
+		uint64_t detailed_tiles = 0;
+		uint64_t blocking_tiles = 0;
+		uint64_t walkable_tiles = 0;
+		uint64_t spawns = 0;
+		uint64_t creatures = 0;
+
+		uint64_t items = 0;
+		uint64_t loose_items = 0;
+		uint64_t depots = 0;
+		uint64_t action_items = 0;
+		uint64_t unique_items = 0;
+		uint64_t containers = 0; // Only containers holding something
+
+		uint64_t floor_tiles[MAP_LAYERS] = {};
+		// Walkable tiles per house id, ids without tiles are left out
+		std::map<uint32_t, uint64_t> house_tiles;
+		// Number of items per item id, grows as needed
+		std::vector<uint32_t> item_types;
+
+		// 'sign' is 1 when the tile enters the map and -1 when it leaves it.
+		// Counters are unsigned and wrap, which keeps removals exact.
+		void addTile(const Tile* tile, int sign = 1);
+		void merge(const Counters& other);
+
+		bool operator==(const Counters& other) const;
+		bool operator!=(const Counters& other) const {
+			return !(*this == other);
+		}
+	};
+
+	MapStatistics() = default;
+
+	bool isValid() const {
+		return valid;
+	}
+	void invalidate() {
+		valid = false;
+	}
+	const Counters& get() const {
+		return counters;
+	}
+
+	// Called for every tile an action swaps, either side may be null
+	void onTileSwapped(const Tile* removed, const Tile* added);
+
+	// Counts the whole map again on a worker pool and replaces the counters.
+	// Returns false if the counters were valid but did not match the rescan.
+	bool rescan(Map& map, bool showdialog = false);
+
+protected:
+	Counters counters;
+	bool valid = false;
+};
+
+#endif
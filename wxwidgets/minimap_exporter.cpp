@@ -0,0 +1,414 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "minimap_exporter.h"
+#include "worker_pool.h"
+#include "png_writer.h"
+#include "map.h"
+#include "gui.h"
+
+namespace {
+	const int HALF_TILE = MinimapExporter::TILE_SIZE / 2;
+
+	// Shrinks a tile into one quarter of its parent, keeping the first coloured pixel of every 2x2 square
+	void downsample(const uint8_t* child, uint8_t* parent, int quadrant) {
+		const int size = MinimapExporter::TILE_SIZE;
+		uint8_t* out = parent + (quadrant >> 1) * HALF_TILE * size + (quadrant & 1) * HALF_TILE;
+		for (int y = 0; y < HALF_TILE; ++y) {
+			const uint8_t* top = child + (y * 2) * size;
+			const uint8_t* bottom = top + size;
+			for (int x = 0; x < HALF_TILE; ++x) {
+				const int sx = x * 2;
+				uint8_t color = top[sx];
+				if (color == 0) {
+					color = top[sx + 1];
+				}
+				if (color == 0) {
+					color = bottom[sx];
+				}
+				if (color == 0) {
+					color = bottom[sx + 1];
+				}
+				out[y * size + x] = color;
+			}
+		}
+	}
+
+	bool hasColor(const uint8_t* pixels) {
+		const int count = MinimapExporter::TILE_SIZE * MinimapExporter::TILE_SIZE;
+		for (int i = 0; i < count; ++i) {
+			if (pixels[i] != 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+MinimapExporter::MinimapExporter(Map& map, Format format) :
+	map(map),
+	format(format),
+	blocks_done(0) {
+	palette.reserve(256 * 3);
+	for (int i = 0; i < 256; ++i) {
+		palette.push_back(minimap_color[i].red);
+		palette.push_back(minimap_color[i].green);
+		palette.push_back(minimap_color[i].blue);
+	}
+}
+
+void MinimapExporter::setError(const wxString& message) {
+	std::lock_guard<std::mutex> lock(error_mutex);
+	if (error.empty()) {
+		error = message;
+	}
+}
+
+void MinimapExporter::scanFloors(WorkerPool& pool, int first_floor, int last_floor) {
+	// Bounds come from the map's occupancy index, empty floors are never visited
+	uint16_t floor_mask = 0;
+	for (int z = first_floor; z <= last_floor; ++z) {
+		FloorInfo& floor_info = floors[z];
+		floor_info = FloorInfo();
+
+		Position min_pos, max_pos;
+		if (map.getFloorBounds(z, min_pos, max_pos)) {
+			floor_info.used = true;
+			floor_info.min_x = min_pos.x;
+			floor_info.min_y = min_pos.y;
+			floor_info.max_x = max_pos.x;
+			floor_info.max_y = max_pos.y;
+			floor_info.blocks.assign(BLOCK_COUNT * BLOCK_COUNT, 0);
+			floor_mask |= 1 << z;
+		}
+	}
+	if (floor_mask == 0) {
+		return;
+	}
+
+	std::vector<QTreeNode*> leaves;
+	map.getLeaves(leaves, floor_mask);
+
+	// Every part gets its own block tables, they are merged once all leaves were seen
+	const size_t parts = std::max<size_t>(1, std::min(pool.size(), leaves.size() / 4096 + 1));
+	std::vector<std::vector<std::vector<uint8_t>>> partial(parts, std::vector<std::vector<uint8_t>>(MAP_LAYERS));
+
+	pool.parallelFor(parts, [&](size_t part) {
+		std::vector<std::vector<uint8_t>>& blocks = partial[part];
+		for (int z = first_floor; z <= last_floor; ++z) {
+			if (floor_mask & (1 << z)) {
+				blocks[z].assign(BLOCK_COUNT * BLOCK_COUNT, 0);
+			}
+		}
+
+		const size_t begin = leaves.size() * part / parts;
+		const size_t end = leaves.size() * (part + 1) / parts;
+		for (size_t index = begin; index < end; ++index) {
+			QTreeNode* leaf = leaves[index];
+			for (int z = first_floor; z <= last_floor; ++z) {
+				if ((floor_mask & (1 << z)) == 0 || leaf->getOccupancy(z) == 0) {
+					continue;
+				}
+
+				// A leaf never crosses a block border
+				const TileLocation& location = leaf->getFloor(z)->locs[0];
+				blocks[z][(location.getY() / TILE_SIZE) * BLOCK_COUNT + location.getX() / TILE_SIZE] = 1;
+			}
+		}
+	});
+
+	for (int z = first_floor; z <= last_floor; ++z) {
+		FloorInfo& floor_info = floors[z];
+		if (!floor_info.used) {
+			continue;
+		}
+
+		for (std::vector<std::vector<uint8_t>>& blocks : partial) {
+			for (size_t block = 0; block < floor_info.blocks.size(); ++block) {
+				floor_info.blocks[block] |= blocks[z][block];
+			}
+		}
+		for (uint8_t block : floor_info.blocks) {
+			floor_info.block_count += block;
+		}
+	}
+}
+
+bool MinimapExporter::isBlockUsed(int z, int bx, int by) const {
+	if (floors[z].blocks.empty() || bx < 0 || by < 0 || bx >= BLOCK_COUNT || by >= BLOCK_COUNT) {
+		return false;
+	}
+	return floors[z].blocks[by * BLOCK_COUNT + bx] != 0;
+}
+
+bool MinimapExporter::isAreaUsed(int z, int level, int tx, int ty) const {
+	const int x_end = std::min(BLOCK_COUNT, (tx + 1) << level);
+	const int y_end = std::min(BLOCK_COUNT, (ty + 1) << level);
+	for (int by = ty << level; by < y_end; ++by) {
+		for (int bx = tx << level; bx < x_end; ++bx) {
+			if (isBlockUsed(z, bx, by)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void MinimapExporter::renderBlock(int z, int bx, int by, uint8_t* pixels) {
+	memset(pixels, 0, TILE_SIZE * TILE_SIZE);
+
+	// Walk the block one leaf (4x4 tiles) at a time, same colour rule as the bmp export
+	const int base_x = bx * TILE_SIZE;
+	const int base_y = by * TILE_SIZE;
+	for (int ly = 0; ly < TILE_SIZE; ly += 4) {
+		for (int lx = 0; lx < TILE_SIZE; lx += 4) {
+			QTreeNode* leaf = map.getLeaf(base_x + lx, base_y + ly);
+			if (!leaf) {
+				continue;
+			}
+			Floor* floor = leaf->getFloor(z);
+			if (!floor) {
+				continue;
+			}
+
+			for (int i = 0; i < MAP_LAYERS; ++i) {
+				const Tile* tile = floor->locs[i].get();
+				if (tile) {
+					pixels[(ly + (i & 3)) * TILE_SIZE + lx + (i >> 2)] = tile->getMiniMapColor();
+				}
+			}
+		}
+	}
+	++blocks_done;
+}
+
+bool MinimapExporter::exportImage(int z, const std::string& filename) {
+	const FloorInfo& floor_info = floors[z];
+	const int min_x = std::max(0, floor_info.min_x - PADDING);
+	const int min_y = std::max(0, floor_info.min_y - PADDING);
+	const int max_x = std::min(0xFFFF, floor_info.max_x + PADDING);
+	const int max_y = std::min(0xFFFF, floor_info.max_y + PADDING);
+	const int width = max_x - min_x + 1;
+
+	PngWriter png(filename, width, max_y - min_y + 1, PngWriter::PNG_PALETTE);
+	if (!png.isOk()) {
+		setError("Could not open \"" + wxstr(filename) + "\" for writing.");
+		return false;
+	}
+	png.setPalette(palette);
+
+	// Only one band of blocks is held at a time
+	Raster band(size_t(width) * TILE_SIZE);
+	Raster block(TILE_SIZE * TILE_SIZE);
+	for (int by = min_y / TILE_SIZE; by <= max_y / TILE_SIZE; ++by) {
+		const int band_top = std::max(min_y, by * TILE_SIZE);
+		const int band_bottom = std::min(max_y, by * TILE_SIZE + TILE_SIZE - 1);
+		std::fill(band.begin(), band.end(), 0);
+
+		for (int bx = min_x / TILE_SIZE; bx <= max_x / TILE_SIZE; ++bx) {
+			if (!isBlockUsed(z, bx, by)) {
+				continue;
+			}
+			renderBlock(z, bx, by, block.data());
+
+			const int x0 = std::max(min_x, bx * TILE_SIZE);
+			const int x1 = std::min(max_x, bx * TILE_SIZE + TILE_SIZE - 1);
+			for (int y = band_top; y <= band_bottom; ++y) {
+				memcpy(&band[size_t(y - band_top) * width + (x0 - min_x)], &block[(y - by * TILE_SIZE) * TILE_SIZE + (x0 - bx * TILE_SIZE)], x1 - x0 + 1);
+			}
+		}
+
+		for (int y = band_top; y <= band_bottom; ++y) {
+			if (!png.addRow(&band[size_t(y - band_top) * width])) {
+				setError("Could not write \"" + wxstr(filename) + "\".");
+				return false;
+			}
+		}
+	}
+
+	if (!png.finish()) {
+		setError("Could not write \"" + wxstr(filename) + "\".");
+		return false;
+	}
+	return true;
+}
+
+bool MinimapExporter::writeTile(const std::string& directory, int tx, int ty, const uint8_t* pixels) {
+	// Not i2s, it shares one stream between all callers
+	const std::string filename = directory + std::to_string(tx) + "_" + std::to_string(ty) + ".png";
+
+	PngWriter png(filename, TILE_SIZE, TILE_SIZE, PngWriter::PNG_PALETTE);
+	png.setPalette(palette, 0);
+	for (int y = 0; y < TILE_SIZE; ++y) {
+		if (!png.addRow(pixels + y * TILE_SIZE)) {
+			break;
+		}
+	}
+	if (!png.finish()) {
+		setError("Could not write \"" + wxstr(filename) + "\".");
+		return false;
+	}
+	return true;
+}
+
+bool MinimapExporter::exportTile(int z, int level, int tx, int ty, const std::vector<std::string>& directories, uint8_t* pixels, bool& used) {
+	used = false;
+	if (!isAreaUsed(z, level, tx, ty)) {
+		return true;
+	}
+
+	if (level == 0) {
+		renderBlock(z, tx, ty, pixels);
+		used = hasColor(pixels);
+	} else {
+		// Depth first, so only one raster per level is alive at a time
+		memset(pixels, 0, TILE_SIZE * TILE_SIZE);
+		Raster child(TILE_SIZE * TILE_SIZE);
+		for (int quadrant = 0; quadrant < 4; ++quadrant) {
+			bool child_used = false;
+			if (!exportTile(z, level - 1, tx * 2 + (quadrant & 1), ty * 2 + (quadrant >> 1), directories, child.data(), child_used)) {
+				return false;
+			}
+			if (child_used) {
+				downsample(child.data(), pixels, quadrant);
+				used = true;
+			}
+		}
+	}
+
+	return !used || writeTile(directories[level], tx, ty, pixels);
+}
+
+bool MinimapExporter::exportFloors(const FileName& directory, const wxString& name, int first_floor, int last_floor) {
+	first_floor = std::max(0, first_floor);
+	last_floor = std::min(MAP_MAX_LAYER, last_floor);
+	error.clear();
+	blocks_done = 0;
+
+	WorkerPool pool;
+	scanFloors(pool, first_floor, last_floor);
+
+	int total_blocks = 0;
+	for (int z = first_floor; z <= last_floor; ++z) {
+		total_blocks += floors[z].block_count;
+	}
+	if (total_blocks == 0) {
+		return true;
+	}
+
+	const wxString separator = wxFileName::GetPathSeparator();
+	const wxString root = directory.GetFullPath() + separator;
+
+	// Upper pyramid levels are merged from these, keyed by tile y << 16 | x
+	std::vector<std::map<uint32_t, Raster>> merge_tiles(MAP_LAYERS);
+	std::vector<std::vector<std::string>> directories(MAP_LAYERS);
+	std::vector<int> split_levels(MAP_LAYERS, 0);
+	std::vector<int> top_levels(MAP_LAYERS, 0);
+	std::mutex merge_mutex;
+
+	for (int z = first_floor; z <= last_floor; ++z) {
+		const FloorInfo& floor_info = floors[z];
+		if (!floor_info.used) {
+			continue;
+		}
+
+		if (format == FORMAT_PNG) {
+			FileName file(name + "_" + i2ws(z) + ".png");
+			file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
+			const std::string filename = nstr(file.GetFullPath());
+			pool.submit([this, z, filename]() {
+				exportImage(z, filename);
+			});
+			continue;
+		}
+
+		// Smallest level where a single tile covers the whole floor
+		const int min_bx = floor_info.min_x / TILE_SIZE, max_bx = floor_info.max_x / TILE_SIZE;
+		const int min_by = floor_info.min_y / TILE_SIZE, max_by = floor_info.max_y / TILE_SIZE;
+		int top_level = 0;
+		while ((min_bx >> top_level) != (max_bx >> top_level) || (min_by >> top_level) != (max_by >> top_level)) {
+			++top_level;
+		}
+		top_levels[z] = top_level;
+
+		for (int level = 0; level <= top_level; ++level) {
+			const wxString path = root + name + separator + i2ws(z) + separator + i2ws(level) + separator;
+			if (!wxFileName::Mkdir(path, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+				// Tasks for the previous floors still use the locals above
+				setError("Could not create the folder \"" + path + "\".");
+				pool.wait();
+				return false;
+			}
+			directories[z].push_back(nstr(path));
+		}
+
+		// Up to 64 independent subtrees per floor, the levels above them are merged afterwards
+		const int split_level = std::max(0, top_level - 3);
+		split_levels[z] = split_level;
+		for (int ty = min_by >> split_level; ty <= max_by >> split_level; ++ty) {
+			for (int tx = min_bx >> split_level; tx <= max_bx >> split_level; ++tx) {
+				pool.submit([this, z, split_level, tx, ty, &directories, &merge_tiles, &merge_mutex]() {
+					Raster pixels(TILE_SIZE * TILE_SIZE);
+					bool used = false;
+					if (exportTile(z, split_level, tx, ty, directories[z], pixels.data(), used) && used) {
+						std::lock_guard<std::mutex> lock(merge_mutex);
+						merge_tiles[z][uint32_t(ty) << 16 | uint32_t(tx)] = std::move(pixels);
+					}
+				});
+			}
+		}
+	}
+
+	while (!pool.waitFor(std::chrono::milliseconds(100))) {
+		g_gui.SetLoadDone(std::min(99, int(int64_t(blocks_done) * 100 / total_blocks)), "Exporting minimap...");
+	}
+
+	if (format == FORMAT_TILES && error.empty()) {
+		for (int z = first_floor; z <= last_floor; ++z) {
+			if (merge_tiles[z].empty()) {
+				continue;
+			}
+			pool.submit([this, z, &directories, &merge_tiles, &split_levels, &top_levels]() {
+				std::map<uint32_t, Raster> tiles = std::move(merge_tiles[z]);
+				for (int level = split_levels[z] + 1; level <= top_levels[z]; ++level) {
+					std::map<uint32_t, Raster> parents;
+					for (auto& tile : tiles) {
+						const int tx = tile.first & 0xFFFF;
+						const int ty = tile.first >> 16;
+						Raster& parent = parents[uint32_t(ty >> 1) << 16 | uint32_t(tx >> 1)];
+						if (parent.empty()) {
+							parent.assign(TILE_SIZE * TILE_SIZE, 0);
+						}
+						downsample(tile.second.data(), parent.data(), (ty & 1) * 2 + (tx & 1));
+					}
+
+					for (auto& parent : parents) {
+						if (!writeTile(directories[z][level], parent.first & 0xFFFF, parent.first >> 16, parent.second.data())) {
+							return;
+						}
+					}
+					tiles = std::move(parents);
+				}
+			});
+		}
+		pool.wait();
+	}
+
+	return error.empty();
+}
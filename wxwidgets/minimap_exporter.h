@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_EXPORTER_H_
+#define RME_MINIMAP_EXPORTER_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class Map;
+class WorkerPool;
+
+// Exports the minimap of a range of floors as PNG.
+// The map is scanned once, in parallel, to find which TILE_SIZE x TILE_SIZE blocks
+// of every floor are used. Blocks are then rendered on worker threads one at a time,
+// so memory is bounded by a band of blocks instead of the whole floor.
+class MinimapExporter {
+public:
+	enum Format {
+		// <name>_<floor>.png, cropped to the used area of the floor
+		FORMAT_PNG,
+		// <name>/<floor>/<level>/<x>_<y>.png, level 0 is one pixel per map tile,
+		// every level above halves the resolution, until one tile holds the floor
+		FORMAT_TILES,
+	};
+
+	static const int TILE_SIZE = 256;
+	static const int BLOCK_COUNT = 0x10000 / TILE_SIZE;
+	// Empty border around single image exports, same as the bmp export
+	static const int PADDING = 10;
+
+	MinimapExporter(Map& map, Format format);
+
+	// Exports floors [first_floor, last_floor] into 'directory', reporting progress on the load bar
+	bool exportFloors(const FileName& directory, const wxString& name, int first_floor, int last_floor);
+
+	const wxString& getError() const {
+		return error;
+	}
+
+protected:
+	struct FloorInfo {
+		bool used = false;
+		int min_x = 0xFFFF, min_y = 0xFFFF;
+		int max_x = 0, max_y = 0;
+		// One byte per block, non-zero if the block holds a tile
+		std::vector<uint8_t> blocks;
+		int block_count = 0;
+	};
+	typedef std::vector<uint8_t> Raster;
+
+	void scanFloors(WorkerPool& pool, int first_floor, int last_floor);
+
+	bool isBlockUsed(int z, int bx, int by) const;
+	bool isAreaUsed(int z, int level, int tx, int ty) const;
+	void renderBlock(int z, int bx, int by, uint8_t* pixels);
+
+	bool exportImage(int z, const std::string& filename);
+	// Renders tile (tx, ty) of 'level' into 'pixels', writing it and every used tile below it
+	bool exportTile(int z, int level, int tx, int ty, const std::vector<std::string>& directories, uint8_t* pixels, bool& used);
+	bool writeTile(const std::string& directory, int tx, int ty, const uint8_t* pixels);
+
+	void setError(const wxString& message);
+
+	Map& map;
+	Format format;
+	FloorInfo floors[MAP_LAYERS];
+	std::vector<uint8_t> palette;
+
+	std::atomic<int> blocks_done;
+	std::mutex error_mutex;
+	wxString error;
+};
+
+#endif
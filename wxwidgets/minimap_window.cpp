@@ -196,26 +196,30 @@ void MinimapWindow::RenderThreadFunction() {
 				// Batch drawing by color
 				std::vector<std::vector<wxPoint>> colorPoints(256);
 				
-				for(int y = 0; y < window_height; ++y) {
-					for(int x = 0; x < window_width; ++x) {
-						int map_x = start_x + x;
-						int map_y = start_y + y;
+				{
+					// Leaves must not be paged out while we read them, see GUI::TrimMapPages
+					std::lock_guard<std::mutex> render_lock(render_mutex);
+					for(int y = 0; y < window_height; ++y) {
+						for(int x = 0; x < window_width; ++x) {
+							int map_x = start_x + x;
+							int map_y = start_y + y;
 						
-						if(map_x >= 0 && map_y >= 0 && 
-						   map_x < editor.map.getWidth() && 
-						   map_y < editor.map.getHeight()) {
+							if(map_x >= 0 && map_y >= 0 && 
+							   map_x < editor.map.getWidth() && 
+							   map_y < editor.map.getHeight()) {
 							
-							Tile* tile = editor.map.getTile(map_x, map_y, floor);
-							if(tile) {
-								uint8_t color = tile->getMiniMapColor();
-								if(color) {
-									colorPoints[color].push_back(wxPoint(x, y));
+								Tile* tile = editor.map.getTile(map_x, map_y, floor);
+								if(tile) {
+									uint8_t color = tile->getMiniMapColor();
+									if(color) {
+										colorPoints[color].push_back(wxPoint(x, y));
+									}
 								}
 							}
 						}
 					}
 				}
-				
+
 				// Draw points by color
 				for(int color = 0; color < 256; ++color) {
 					if(!colorPoints[color].empty()) {
@@ -112,6 +112,11 @@ public:
 	void OnLoadMinimapWaypoints(wxCommandEvent& event);
 	void SetMinimapFloor(int floor);
 
+	// Held by the render thread while it reads tiles of the current map
+	std::mutex& GetRenderMutex() {
+		return render_mutex;
+	}
+
 private:
 	BlockMap m_blocks;
 	std::mutex m_mutex;
@@ -142,6 +147,7 @@ private:
 
 	wxBitmap buffer;
 	std::mutex buffer_mutex;
+	std::mutex render_mutex;
 	std::thread render_thread;
 	std::atomic<bool> thread_running;
 	
@@ -23,6 +23,9 @@
 #include "gui.h"
 #include "brush.h"
 #include "raw_brush.h"
+#include "creature_brush.h"
+#include "creatures.h"
+#include "thumbnail_atlas.h"
 #include "add_tileset_window.h"
 #include "add_item_window.h"
 #include "materials.h"
@@ -46,6 +49,19 @@ public:
 // Keep a static map of constructed brush panels by tileset
 std::map<const TilesetCategory*, BrushPanelState> g_brush_panel_cache;
 
+// Draws the thumbnail of a brush, 'size' pixels wide, from the shared atlas.
+// Thumbnails that aren't rendered yet are left out, 'window' is refreshed once they are.
+static void DrawBrushThumbnail(wxDC& dc, wxWindow* window, Brush* brush, int x, int y, int size) {
+	if (brush->isCreature()) {
+		CreatureType* type = brush->asCreature()->getType();
+		if (type) {
+			g_thumbnails.drawCreature(dc, window, type->outfit, x, y, size);
+		}
+	} else {
+		g_thumbnails.drawItem(dc, window, brush->getLookID(), x, y, size);
+	}
+}
+
 // ============================================================================
 // Brush Palette Panel
 // A common class for terrain/doodad/item/raw palette
@@ -583,8 +599,6 @@ void BrushPanel::CleanupBrushbox(BrushBoxInterface* box) {
 		// Special cleanup for SeamlessGridPanel
 	SeamlessGridPanel* gridPanel = dynamic_cast<SeamlessGridPanel*>(box);
 		if (gridPanel) {
-			// Clear sprite cache
-			gridPanel->ClearSpriteCache();
 			// Make sure any loading timer is stopped
 			if (gridPanel->loading_timer) {
 				gridPanel->loading_timer->Stop();
@@ -1035,144 +1049,197 @@ void BrushPanel::SetShowItemIDs(bool show) {
 // BrushIconBox
 
 BEGIN_EVENT_TABLE(BrushIconBox, wxScrolledWindow)
-// Listbox style
-EVT_TOGGLEBUTTON(wxID_ANY, BrushIconBox::OnClickBrushButton)
+EVT_PAINT(BrushIconBox::OnPaint)
+EVT_LEFT_DOWN(BrushIconBox::OnMouseClick)
+EVT_MOTION(BrushIconBox::OnMouseMove)
+EVT_KEY_DOWN(BrushIconBox::OnKey)
 END_EVENT_TABLE()
 
 BrushIconBox::BrushIconBox(wxWindow* parent, const TilesetCategory* _tileset, RenderSize rsz) :
 	wxScrolledWindow(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxVSCROLL),
 	BrushBoxInterface(_tileset),
-	icon_size(rsz) {
+	icon_size(rsz),
+	columns(1),
+	cell_size(rsz == RENDER_SIZE_32x32 ? 36 : 20),
+	selected_index(-1),
+	hover_index(-1) {
 	ASSERT(tileset->getType() >= TILESET_UNKNOWN && tileset->getType() <= TILESET_HOUSE);
-	int width;
 	if (icon_size == RENDER_SIZE_32x32) {
-		width = max(g_settings.getInteger(Config::PALETTE_COL_COUNT) / 2 + 1, 1);
+		columns = max(g_settings.getInteger(Config::PALETTE_COL_COUNT) / 2 + 1, 1);
 	} else {
-		width = max(g_settings.getInteger(Config::PALETTE_COL_COUNT) + 1, 1);
-	}
-
-	// Create buttons
-	wxSizer* stacksizer = newd wxBoxSizer(wxVERTICAL);
-	wxSizer* rowsizer = nullptr;
-	int item_counter = 0;
-	for (BrushVector::const_iterator iter = tileset->brushlist.begin(); iter != tileset->brushlist.end(); ++iter) {
-		ASSERT(*iter);
-		++item_counter;
-
-		if (!rowsizer) {
-			rowsizer = newd wxBoxSizer(wxHORIZONTAL);
-		}
-
-		BrushButton* bb = newd BrushButton(this, *iter, rsz);
-		rowsizer->Add(bb);
-		brush_buttons.push_back(bb);
-
-		if (item_counter % width == 0) { // newd row
-			stacksizer->Add(rowsizer);
-			rowsizer = nullptr;
-		}
-	}
-	if (rowsizer) {
-		stacksizer->Add(rowsizer);
+		columns = max(g_settings.getInteger(Config::PALETTE_COL_COUNT) + 1, 1);
 	}
 
-	SetScrollbars(20, 20, 8, item_counter / width, 0, 0);
-	SetSizer(stacksizer);
+	SetBackgroundStyle(wxBG_STYLE_PAINT);
+	const int rows = (int(tileset->size()) + columns - 1) / columns;
+	SetVirtualSize(columns * cell_size, rows * cell_size);
+	SetMinSize(wxSize(columns * cell_size + wxSystemSettings::GetMetric(wxSYS_VSCROLL_X), -1));
+	SetScrollRate(0, cell_size);
 }
 
 BrushIconBox::~BrushIconBox() {
-	////
+	g_thumbnails.removeWindow(this);
 }
 
 void BrushIconBox::SelectFirstBrush() {
 	if (tileset && tileset->size() > 0) {
-		DeselectAll();
-		brush_buttons[0]->SetValue(true);
+		selected_index = 0;
 		EnsureVisible((size_t)0);
+		Refresh();
 	}
 }
 
 Brush* BrushIconBox::GetSelectedBrush() const {
-	if (!tileset) {
+	if (!tileset || selected_index < 0 || selected_index >= int(tileset->size())) {
 		return nullptr;
 	}
-
-	for (std::vector<BrushButton*>::const_iterator it = brush_buttons.begin(); it != brush_buttons.end(); ++it) {
-		if ((*it)->GetValue()) {
-			return (*it)->brush;
-		}
-	}
-	return nullptr;
+	return tileset->brushlist[selected_index];
 }
 
 bool BrushIconBox::SelectBrush(const Brush* whatbrush) {
-	DeselectAll();
-	for (std::vector<BrushButton*>::iterator it = brush_buttons.begin(); it != brush_buttons.end(); ++it) {
-		if ((*it)->brush == whatbrush) {
-			(*it)->SetValue(true);
-			EnsureVisible(*it);
-			return true;
+	selected_index = -1;
+	for (size_t n = 0; n < tileset->size(); ++n) {
+		if (tileset->brushlist[n] == whatbrush) {
+			selected_index = int(n);
+			EnsureVisible(n);
+			break;
 		}
 	}
-	return false;
+	Refresh();
+	return selected_index != -1;
 }
 
-void BrushIconBox::DeselectAll() {
-	for (std::vector<BrushButton*>::iterator it = brush_buttons.begin(); it != brush_buttons.end(); ++it) {
-		(*it)->SetValue(false);
-	}
-}
+void BrushIconBox::EnsureVisible(size_t n) {
+	const int row = int(n) / columns;
+
+	int start_row;
+	GetViewStart(nullptr, &start_row);
+	int client_width, client_height;
+	GetClientSize(&client_width, &client_height);
+	const int visible_rows = std::max(1, client_height / cell_size);
+
+	if (row < start_row) {
+		Scroll(-1, row);
+	} else if (row >= start_row + visible_rows) {
+		// only scroll if the icon isnt visible
+		Scroll(-1, row - visible_rows + 1);
+	}
+}
+
+int BrushIconBox::GetIndexAt(int x, int y) const {
+	const int column = x / cell_size;
+	if (x < 0 || y < 0 || column >= columns) {
+		return -1;
+	}
+	const int index = (y / cell_size) * columns + column;
+	return index < int(tileset->size()) ? index : -1;
+}
+
+void BrushIconBox::DrawCell(wxDC& dc, int index) {
+	static const wxPen highlight_pen(wxColor(0xFF, 0xFF, 0xFF));
+	static const wxPen dark_highlight_pen(wxColor(0xD4, 0xD0, 0xC8));
+	static const wxPen light_shadow_pen(wxColor(0x80, 0x80, 0x80));
+	static const wxPen shadow_pen(wxColor(0x40, 0x40, 0x40));
+
+	const int x = (index % columns) * cell_size;
+	const int y = (index / columns) * cell_size;
+	const int last = cell_size - 1;
+	const bool pressed = index == selected_index;
+
+	// Same bevel as the brush buttons
+	dc.SetPen(*wxTRANSPARENT_PEN);
+	dc.SetBrush(*wxBLACK);
+	dc.DrawRectangle(x, y, cell_size, cell_size);
+	dc.SetPen(pressed ? shadow_pen : highlight_pen);
+	dc.DrawLine(x, y, x + last, y);
+	dc.DrawLine(x, y + 1, x, y + last);
+	dc.SetPen(pressed ? light_shadow_pen : dark_highlight_pen);
+	dc.DrawLine(x + 1, y + 1, x + last - 1, y + 1);
+	dc.DrawLine(x + 1, y + 2, x + 1, y + last - 1);
+	dc.SetPen(pressed ? dark_highlight_pen : light_shadow_pen);
+	dc.DrawLine(x + last - 1, y + 1, x + last - 1, y + last - 1);
+	dc.DrawLine(x + 1, y + last - 1, x + last, y + last - 1);
+	dc.SetPen(pressed ? highlight_pen : shadow_pen);
+	dc.DrawLine(x + last, y, x + last, y + last);
+	dc.DrawLine(x, y + last, x + last, y + last);
+
+	const int icon = ThumbnailAtlas::getPixelSize(icon_size);
+	DrawBrushThumbnail(dc, this, tileset->brushlist[index], x + 2, y + 2, icon);
+	if (pressed && g_settings.getInteger(Config::USE_GUI_SELECTION_SHADOW)) {
+		Sprite* marker = g_gui.gfx.getSprite(EDITOR_SPRITE_SELECTION_MARKER);
+		if (marker) {
+			marker->DrawTo(&dc, icon_size == RENDER_SIZE_16x16 ? SPRITE_SIZE_16x16 : SPRITE_SIZE_32x32, x + 2, y + 2);
+		}
+	}
+}
+
+void BrushIconBox::OnPaint(wxPaintEvent& WXUNUSED(event)) {
+	wxAutoBufferedPaintDC dc(this);
+	DoPrepareDC(dc);
 
-void BrushIconBox::EnsureVisible(BrushButton* btn) {
-	int windowSizeX, windowSizeY;
-	GetVirtualSize(&windowSizeX, &windowSizeY);
+	dc.SetBackground(wxBrush(GetBackgroundColour()));
+	dc.Clear();
+	if (!tileset || g_gui.gfx.isUnloaded()) {
+		return;
+	}
 
-	int scrollUnitX;
-	int scrollUnitY;
-	GetScrollPixelsPerUnit(&scrollUnitX, &scrollUnitY);
+	int start_row;
+	GetViewStart(nullptr, &start_row);
+	int client_width, client_height;
+	GetClientSize(&client_width, &client_height);
 
-	wxRect rect = btn->GetRect();
-	int y;
-	CalcUnscrolledPosition(0, rect.y, nullptr, &y);
+	const int first = start_row * columns;
+	const int last = std::min(int(tileset->size()), (start_row + client_height / cell_size + 2) * columns);
+	for (int index = first; index < last; ++index) {
+		DrawCell(dc, index);
+	}
+}
 
-	int maxScrollPos = windowSizeY / scrollUnitY;
-	int scrollPosY = std::min(maxScrollPos, (y / scrollUnitY));
+void BrushIconBox::OnMouseClick(wxMouseEvent& event) {
+	int x, y;
+	CalcUnscrolledPosition(event.GetX(), event.GetY(), &x, &y);
+	const int index = GetIndexAt(x, y);
+	SetFocus();
+	if (index < 0) {
+		return;
+	}
 
-	int startScrollPosY;
-	GetViewStart(nullptr, &startScrollPosY);
+	selected_index = index;
+	Refresh();
 
-	int clientSizeX, clientSizeY;
-	GetClientSize(&clientSizeX, &clientSizeY);
-	int endScrollPosY = startScrollPosY + clientSizeY / scrollUnitY;
+	wxWindow* w = this;
+	while ((w = w->GetParent()) && dynamic_cast<PaletteWindow*>(w) == nullptr);
+	if (w) {
+		g_gui.ActivatePalette(static_cast<PaletteWindow*>(w));
+	}
 
-	if (scrollPosY < startScrollPosY || scrollPosY > endScrollPosY) {
-		// only scroll if the button isnt visible
-		Scroll(-1, scrollPosY);
+	Brush* brush = tileset->brushlist[index];
+	// If this brush is already selected, deselect it first
+	if(brush == g_gui.GetCurrentBrush()) {
+		g_gui.SelectBrush(nullptr, tileset->getType());
 	}
-}
 
-void BrushIconBox::EnsureVisible(size_t n) {
-	EnsureVisible(brush_buttons[n]);
+	// Now select the brush (either for the first time or re-selecting)
+	g_gui.SelectBrush(brush, tileset->getType());
 }
 
-void BrushIconBox::OnClickBrushButton(wxCommandEvent& event) {
-	wxObject* obj = event.GetEventObject();
-	BrushButton* btn = dynamic_cast<BrushButton*>(obj);
-	if (btn) {
-		wxWindow* w = this;
-		while ((w = w->GetParent()) && dynamic_cast<PaletteWindow*>(w) == nullptr);
-		if (w) {
-			g_gui.ActivatePalette(static_cast<PaletteWindow*>(w));
-		}
-
-		// If this brush is already selected, deselect it first
-		if(btn->brush == g_gui.GetCurrentBrush()) {
-			g_gui.SelectBrush(nullptr, tileset->getType());
+void BrushIconBox::OnMouseMove(wxMouseEvent& event) {
+	int x, y;
+	CalcUnscrolledPosition(event.GetX(), event.GetY(), &x, &y);
+	const int index = GetIndexAt(x, y);
+	if (index != hover_index) {
+		hover_index = index;
+		if (index >= 0) {
+			SetToolTip(wxstr(tileset->brushlist[index]->getName()));
+		} else {
+			UnsetToolTip();
 		}
-
-		// Now select the brush (either for the first time or re-selecting)
-		g_gui.SelectBrush(btn->brush, tileset->getType());
 	}
+	event.Skip();
+}
+
+void BrushIconBox::OnKey(wxKeyEvent& event) {
+	g_gui.AddPendingCanvasEvent(event);
 }
 
 // ============================================================================
@@ -1189,7 +1256,7 @@ BrushListBox::BrushListBox(wxWindow* parent, const TilesetCategory* tileset) :
 }
 
 BrushListBox::~BrushListBox() {
-	////
+	g_thumbnails.removeWindow(this);
 }
 
 void BrushListBox::SelectFirstBrush() {
@@ -1223,10 +1290,7 @@ bool BrushListBox::SelectBrush(const Brush* whatbrush) {
 
 void BrushListBox::OnDrawItem(wxDC& dc, const wxRect& rect, size_t n) const {
 	ASSERT(n < tileset->size());
-	Sprite* spr = g_gui.gfx.getSprite(tileset->brushlist[n]->getLookID());
-	if (spr) {
-		spr->DrawTo(&dc, SPRITE_SIZE_32x32, rect.GetX(), rect.GetY(), rect.GetWidth(), rect.GetHeight());
-	}
+	DrawBrushThumbnail(dc, const_cast<BrushListBox*>(this), tileset->brushlist[n], rect.GetX(), rect.GetY(), 32);
 	if (IsSelected(n)) {
 		if (HasFocus()) {
 			dc.SetTextForeground(wxColor(0xFF, 0xFF, 0xFF));
@@ -1442,6 +1506,8 @@ DirectDrawBrushPanel::DirectDrawBrushPanel(wxWindow* parent, const TilesetCatego
 }
 
 DirectDrawBrushPanel::~DirectDrawBrushPanel() {
+	g_thumbnails.removeWindow(this);
+
 	if (buffer) {
 		delete buffer;
 		buffer = nullptr;
@@ -1647,10 +1713,7 @@ void DirectDrawBrushPanel::DrawItemsToPanel(wxDC& dc) {
 				// Draw item sprite
 				Brush* brush = tileset->brushlist[index];
 				if(brush) {
-					Sprite* sprite = g_gui.gfx.getSprite(brush->getLookID());
-					if(sprite) {
-						sprite->DrawTo(&dc, SPRITE_SIZE_32x32, x + 2, y + 2);
-					}
+					DrawBrushThumbnail(dc, this, brush, x + 2, y + 2, 32);
 					
 					// For RAW brushes, also draw the ID
 					if(brush->isRaw()) {
@@ -1683,10 +1746,7 @@ void DirectDrawBrushPanel::DrawItemsToPanel(wxDC& dc) {
 				// Draw item sprite
 				Brush* brush = tileset->brushlist[index];
 				if(brush) {
-					Sprite* sprite = g_gui.gfx.getSprite(brush->getLookID());
-					if(sprite) {
-						sprite->DrawTo(&dc, SPRITE_SIZE_32x32, x + 2, y + 2);
-					}
+					DrawBrushThumbnail(dc, this, brush, x + 2, y + 2, 32);
 					
 					// For RAW brushes, also draw the ID
 					if(brush->isRaw()) {
@@ -1901,9 +1961,6 @@ SeamlessGridPanel::SeamlessGridPanel(wxWindow* parent, const TilesetCategory* _t
 		max_loading_steps = 10; // Increase steps for smoother progress indication
 	}
 	
-	// Initialize the sprite cache
-	sprite_cache.clear();
-	
 	// Enable scrolling
 	SetScrollRate(sprite_size, sprite_size);
 	
@@ -1930,9 +1987,8 @@ SeamlessGridPanel::~SeamlessGridPanel() {
 		delete loading_timer;
 		loading_timer = nullptr;
 	}
-	
-	// Clear all cached sprites to prevent memory leaks
-	ClearSpriteCache();
+
+	g_thumbnails.removeWindow(this);
 }
 
 void SeamlessGridPanel::StartProgressiveLoading() {
@@ -2036,11 +2092,6 @@ void SeamlessGridPanel::UpdateViewableItems() {
 void SeamlessGridPanel::DrawItemsToPanel(wxDC& dc) {
 	if(!tileset || tileset->size() == 0) return;
 	
-	// Check if we need to manage cache size
-	if (need_full_redraw) {
-		ManageSpriteCache();
-	}
-	
 	// Calculate client area size
 	int width, height;
 	GetClientSize(&width, &height);
@@ -2173,96 +2224,7 @@ void SeamlessGridPanel::DrawSpriteAt(wxDC& dc, int x, int y, int index) {
 		dc.DrawRectangle(x, y, sprite_size, sprite_size);
 	}
 	
-	// Check if we have the sprite already cached at current zoom level
-	bool need_to_create_sprite = true;
-	
-	if (sprite_cache.count(index) > 0 && sprite_cache[index].is_valid) {
-		// Check if the cached sprite is at the current zoom level
-		if (sprite_cache[index].zoom_level == zoom_level) {
-			// Use the cached sprite bitmap
-			dc.DrawBitmap(sprite_cache[index].bitmap, x, y, true);
-			need_to_create_sprite = false;
-		}
-	}
-	
-	// If not in cache or wrong zoom level, create and cache it
-	if (need_to_create_sprite) {
-		Sprite* sprite = g_gui.gfx.getSprite(brush->getLookID());
-		if (sprite) {
-			// Create appropriate sized bitmap based on zoom level
-			if (zoom_level == 1) {
-				// For 1x zoom, create a standard 32x32 bitmap
-				wxBitmap bmp(32, 32);
-				wxMemoryDC memDC(bmp);
-				memDC.SetBackground(*wxTRANSPARENT_BRUSH);
-				memDC.Clear();
-				
-				// Draw to the memory DC
-				sprite->DrawTo(&memDC, SPRITE_SIZE_32x32, 0, 0);
-				memDC.SelectObject(wxNullBitmap);
-				
-				// Store in cache
-				CachedSprite cached;
-				cached.bitmap = bmp;
-				cached.zoom_level = zoom_level;
-				cached.is_valid = true;
-				sprite_cache[index] = cached;
-				
-				// Draw to screen
-				dc.DrawBitmap(bmp, x, y, true);
-			} 
-			else if (zoom_level == 2) {
-				// For 2x zoom (64x64), create a 64x64 bitmap
-				wxBitmap bmp(64, 64);
-				wxMemoryDC memDC(bmp);
-				memDC.SetBackground(*wxTRANSPARENT_BRUSH);
-				memDC.Clear();
-				
-				// Draw to the memory DC with 64x64 size
-				sprite->DrawTo(&memDC, SPRITE_SIZE_64x64, 0, 0);
-				memDC.SelectObject(wxNullBitmap);
-				
-				// Store in cache
-				CachedSprite cached;
-				cached.bitmap = bmp;
-				cached.zoom_level = zoom_level;
-				cached.is_valid = true;
-				sprite_cache[index] = cached;
-				
-				// Draw to screen
-				dc.DrawBitmap(bmp, x, y, true);
-			} 
-			else {
-				// For other zoom levels (3x, 4x), create a scaled bitmap
-				// First draw at 32x32
-				wxBitmap temp_bmp(32, 32);
-				wxMemoryDC temp_dc(temp_bmp);
-				temp_dc.SetBackground(*wxTRANSPARENT_BRUSH);
-				temp_dc.Clear();
-				
-				// Draw the sprite to the temp DC
-				sprite->DrawTo(&temp_dc, SPRITE_SIZE_32x32, 0, 0);
-				temp_dc.SelectObject(wxNullBitmap); // Deselect to finalize drawing
-				
-				// Convert to image, scale, and draw
-				wxImage img = temp_bmp.ConvertToImage();
-				img.SetMaskColour(255, 0, 255); // Keep transparency
-				img = img.Rescale(sprite_size, sprite_size, wxIMAGE_QUALITY_HIGH);
-				
-				wxBitmap scaled(img);
-				
-				// Store in cache
-				CachedSprite cached;
-				cached.bitmap = scaled;
-				cached.zoom_level = zoom_level;
-				cached.is_valid = true;
-				sprite_cache[index] = cached;
-				
-				// Draw to screen
-				dc.DrawBitmap(scaled, x, y, true);
-			}
-		}
-	}
+	DrawBrushThumbnail(dc, this, brush, x, y, sprite_size);
 	
 	// For RAW brushes, draw the ID if enabled
 	if (show_item_ids && brush->isRaw()) {
@@ -2348,9 +2310,6 @@ void SeamlessGridPanel::RecalculateGrid() {
 		buffer = nullptr;
 	}
 	
-	// Limit sprite cache size when grid layout changes
-	ManageSpriteCache();
-	
 	need_full_redraw = true;
 }
 
@@ -2518,9 +2477,6 @@ void SeamlessGridPanel::SelectIndex(int index) {
             // We need to switch chunks first
             current_chunk = target_chunk;
             
-            // Clear cache for new chunk
-            sprite_cache.clear();
-            
             // Recalculate grid with new chunk
             RecalculateGrid();
             
@@ -2710,9 +2666,6 @@ void SeamlessGridPanel::UpdateGridSize() {
 	// Calculate the actual sprite size based on zoom level
 	sprite_size = 32 * zoom_level;
 	
-	// Clear the sprite cache when zoom level changes
-	ClearSpriteCache();
-	
 	// Recalculate grid layout with the new size
 	RecalculateGrid();
 	
@@ -2720,98 +2673,6 @@ void SeamlessGridPanel::UpdateGridSize() {
 	SetScrollRate(sprite_size / 4, sprite_size / 4);
 }
 
-// Add ClearSpriteCache method implementation before UpdateGridSize
-void SeamlessGridPanel::ClearSpriteCache() {
-	// Properly free all bitmap resources before clearing the cache
-	for (auto& pair : sprite_cache) {
-		if (pair.second.is_valid && pair.second.bitmap.IsOk()) {
-			// Ensure bitmap data is released
-			pair.second.bitmap = wxBitmap(); // Assign empty bitmap to release resources
-			pair.second.is_valid = false;
-		}
-	}
-	
-	// Clear the sprite cache
-	sprite_cache.clear();
-}
-
-// Add this method to limit the sprite cache size
-void SeamlessGridPanel::ManageSpriteCache() {
-	// For extremely large tilesets, be much more aggressive with cache management
-	if (tileset->size() > 10000) {
-		// Keep only the sprites in the current chunk and visible area
-		size_t chunk_start = current_chunk * chunk_size;
-		size_t chunk_end = std::min(chunk_start + static_cast<size_t>(chunk_size), tileset->size()) - 1;
-		
-		// Get the current visible range
-		int firstVisRow = first_visible_row;
-		int lastVisRow = last_visible_row;
-		
-		// Calculate visible indices
-		int firstIndex = firstVisRow * columns;
-		int lastIndex = (lastVisRow + 1) * columns - 1;
-		
-		// Adjust to global indices
-		firstIndex = chunk_start + firstIndex;
-		lastIndex = chunk_start + lastIndex;
-		
-		// Bound to valid range
-		firstIndex = std::max(static_cast<int>(chunk_start), std::min(firstIndex, static_cast<int>(chunk_end)));
-		lastIndex = std::max(static_cast<int>(chunk_start), std::min(lastIndex, static_cast<int>(chunk_end)));
-		
-		// Create a set of visible indices with a small margin
-		std::set<int> visibleIndices;
-		int margin = columns * 5; // 5 rows margin
-		
-		for (int i = std::max(static_cast<int>(chunk_start), firstIndex - margin); 
-			 i <= std::min(static_cast<int>(chunk_end), lastIndex + margin); ++i) {
-			visibleIndices.insert(i);
-		}
-		
-		// Remove sprites that aren't in the current visible area
-		std::vector<int> keysToRemove;
-		for (auto& pair : sprite_cache) {
-			if (visibleIndices.find(pair.first) == visibleIndices.end()) {
-				keysToRemove.push_back(pair.first);
-			}
-		}
-		
-		// Remove from cache
-		for (int key : keysToRemove) {
-			sprite_cache.erase(key);
-		}
-	}
-	// For large but not extreme tilesets, use moderate cache management
-	else if (sprite_cache.size() > 500) {
-		// Get the current visible range
-		int firstIndex = first_visible_row * columns;
-		int lastIndex = (last_visible_row + 1) * columns - 1;
-		lastIndex = std::min(lastIndex, static_cast<int>(tileset->size()) - 1);
-		
-		// Create a set of visible indices with a margin
-		std::set<int> visibleIndices;
-		int margin = columns * 10; // 10 rows margin
-		
-		for (int i = std::max(0, firstIndex - margin); 
-			 i <= std::min(static_cast<int>(tileset->size()) - 1, lastIndex + margin); ++i) {
-			visibleIndices.insert(i);
-		}
-		
-		// Remove sprites that aren't currently visible
-		std::vector<int> keysToRemove;
-		for (auto& pair : sprite_cache) {
-			if (visibleIndices.find(pair.first) == visibleIndices.end()) {
-				keysToRemove.push_back(pair.first);
-			}
-		}
-		
-		// Remove from cache
-		for (int key : keysToRemove) {
-			sprite_cache.erase(key);
-		}
-	}
-}
-
 void SeamlessGridPanel::CreateNavigationPanel(wxWindow* parent) {
     // Don't create if it already exists
     if (navigation_panel) return;
@@ -2927,9 +2788,6 @@ void SeamlessGridPanel::OnNavigationButtonClicked(wxCommandEvent& event) {
     
     // Only proceed if the chunk actually changed
     if (old_chunk != current_chunk) {
-        // Clear cache when changing chunks
-        sprite_cache.clear();
-        
         // Recalculate grid with new chunk
         RecalculateGrid();
         
@@ -169,6 +169,7 @@ public:
 	DECLARE_EVENT_TABLE();
 };
 
+// Grid of brush icons drawn like buttons, only the visible rows are painted
 class BrushIconBox : public wxScrolledWindow, public BrushBoxInterface {
 public:
 	BrushIconBox(wxWindow* parent, const TilesetCategory* _tileset, RenderSize rsz);
@@ -178,8 +179,7 @@ public:
 		return this;
 	}
 
-	// Scrolls the window to the position of the named brush button
-	void EnsureVisible(BrushButton* btn);
+	// Scrolls the window to the position of the nth brush
 	void EnsureVisible(size_t n);
 
 	// Select the first brush
@@ -190,15 +190,22 @@ public:
 	bool SelectBrush(const Brush* brush);
 
 	// Event handling...
-	void OnClickBrushButton(wxCommandEvent& event);
+	void OnPaint(wxPaintEvent& event);
+	void OnMouseClick(wxMouseEvent& event);
+	void OnMouseMove(wxMouseEvent& event);
+	void OnKey(wxKeyEvent& event);
 
 protected:
-	// Used internally to deselect all buttons before selecting a newd one.
-	void DeselectAll();
+	// Index of the brush under the unscrolled position x, y, -1 if there is none
+	int GetIndexAt(int x, int y) const;
+	void DrawCell(wxDC& dc, int index);
 
 protected:
-	std::vector<BrushButton*> brush_buttons;
 	RenderSize icon_size;
+	int columns;
+	int cell_size;
+	int selected_index;
+	int hover_index;
 
 	DECLARE_EVENT_TABLE();
 };
@@ -258,9 +265,6 @@ public:
 	int DecrementZoom();
 	void SetZoomLevel(int level);
 	
-	// Move to public section
-	void ClearSpriteCache();
-	
 	// Make timer accessible
 	wxTimer* loading_timer;
 
@@ -280,8 +284,6 @@ protected:
 	void UpdateViewableItems();
 	void StartProgressiveLoading();
 	void UpdateGridSize();
-	// Moved ClearSpriteCache to public section
-	void ManageSpriteCache();
 	int GetSpriteIndexAt(int x, int y) const;
 	void SelectIndex(int index);
 	void CreateNavigationPanel(wxWindow* parent);
@@ -322,17 +324,6 @@ private:
 	// Constants
 	static const int LARGE_TILESET_THRESHOLD = 1000; // Number of items considered "large"
 
-	// Cache structure for sprite rendering
-	struct CachedSprite {
-		wxBitmap bitmap;
-		int zoom_level;
-		bool is_valid;
-		
-		CachedSprite() : zoom_level(1), is_valid(false) {}
-	};
-	
-	std::map<int, CachedSprite> sprite_cache;
-
 	DECLARE_EVENT_TABLE();
 };
 
@@ -0,0 +1,202 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include <wx/zstream.h>
+
+#include "png_writer.h"
+
+namespace {
+	const size_t IDAT_CHUNK_SIZE = 64 * 1024;
+
+	uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+		static const std::vector<uint32_t> table = []() {
+			std::vector<uint32_t> t(256);
+			for (uint32_t n = 0; n < 256; ++n) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k) {
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				t[n] = c;
+			}
+			return t;
+		}();
+
+		for (size_t i = 0; i < size; ++i) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+	void putU32(uint8_t* out, uint32_t value) {
+		out[0] = uint8_t(value >> 24);
+		out[1] = uint8_t(value >> 16);
+		out[2] = uint8_t(value >> 8);
+		out[3] = uint8_t(value);
+	}
+
+	bool writeChunk(FileWriteHandle& file, const char* type, const uint8_t* data, size_t size) {
+		uint8_t header[8];
+		putU32(header, uint32_t(size));
+		memcpy(header + 4, type, 4);
+
+		uint32_t crc = crc32Update(0xFFFFFFFFu, header + 4, 4);
+		crc = crc32Update(crc, data, size);
+		uint8_t footer[4];
+		putU32(footer, crc ^ 0xFFFFFFFFu);
+
+		return file.addRAW(header, 8) && (size == 0 || file.addRAW(data, size)) && file.addRAW(footer, 4);
+	}
+}
+
+// Collects the deflated stream and writes it out as IDAT chunks
+class PngChunkStream : public wxOutputStream {
+public:
+	explicit PngChunkStream(FileWriteHandle& file) :
+		file(file) {
+		buffer.reserve(IDAT_CHUNK_SIZE);
+	}
+
+	bool flushChunk() {
+		if (buffer.empty()) {
+			return true;
+		}
+		bool ok = writeChunk(file, "IDAT", buffer.data(), buffer.size());
+		buffer.clear();
+		return ok;
+	}
+
+protected:
+	size_t OnSysWrite(const void* data, size_t size) override {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		size_t left = size;
+		while (left > 0) {
+			size_t count = std::min(left, IDAT_CHUNK_SIZE - buffer.size());
+			buffer.insert(buffer.end(), bytes, bytes + count);
+			bytes += count;
+			left -= count;
+			if (buffer.size() == IDAT_CHUNK_SIZE && !flushChunk()) {
+				m_lasterror = wxSTREAM_WRITE_ERROR;
+				return size - left;
+			}
+		}
+		return size;
+	}
+
+	FileWriteHandle& file;
+	std::vector<uint8_t> buffer;
+};
+
+PngWriter::PngWriter(const std::string& filename, int width, int height, ColorType type) :
+	file(filename),
+	width(width),
+	height(height),
+	type(type),
+	rows(0),
+	header_written(false),
+	finished(false),
+	transparent_index(-1) {
+	////
+}
+
+PngWriter::~PngWriter() {
+	// The deflater flushes into the chunk stream, it has to go first
+	deflater.reset();
+	chunks.reset();
+}
+
+bool PngWriter::isOk() {
+	return file.isOk() && width > 0 && height > 0;
+}
+
+void PngWriter::setPalette(const std::vector<uint8_t>& rgb, int transparent) {
+	ASSERT(!header_written);
+	palette = rgb;
+	transparent_index = transparent;
+}
+
+bool PngWriter::writeHeader() {
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	if (!file.addRAW(signature, sizeof(signature))) {
+		return false;
+	}
+
+	uint8_t ihdr[13];
+	putU32(ihdr, uint32_t(width));
+	putU32(ihdr + 4, uint32_t(height));
+	ihdr[8] = 8; // bit depth
+	ihdr[9] = type == PNG_PALETTE ? 3 : (type == PNG_RGB ? 2 : 6);
+	ihdr[10] = 0; // deflate
+	ihdr[11] = 0; // adaptive filtering, every row uses filter 0
+	ihdr[12] = 0; // no interlace
+	if (!writeChunk(file, "IHDR", ihdr, sizeof(ihdr))) {
+		return false;
+	}
+
+	if (type == PNG_PALETTE) {
+		if (palette.empty() || palette.size() % 3 != 0 || palette.size() > 256 * 3) {
+			return false;
+		}
+		if (!writeChunk(file, "PLTE", palette.data(), palette.size())) {
+			return false;
+		}
+		if (transparent_index >= 0 && transparent_index < int(palette.size() / 3)) {
+			std::vector<uint8_t> alpha(transparent_index + 1, 0xFF);
+			alpha[transparent_index] = 0;
+			if (!writeChunk(file, "tRNS", alpha.data(), alpha.size())) {
+				return false;
+			}
+		}
+	}
+
+	chunks.reset(newd PngChunkStream(file));
+	deflater.reset(newd wxZlibOutputStream(*chunks, -1, wxZLIB_ZLIB));
+	header_written = true;
+	return true;
+}
+
+bool PngWriter::addRow(const uint8_t* pixels) {
+	if (finished || rows >= height || !isOk()) {
+		return false;
+	}
+	if (!header_written && !writeHeader()) {
+		return false;
+	}
+
+	static const int channels[] = { 1, 3, 4 };
+	const uint8_t filter = 0;
+	deflater->Write(&filter, 1);
+	deflater->Write(pixels, size_t(width) * channels[type]);
+	++rows;
+	return deflater->IsOk() && chunks->IsOk();
+}
+
+bool PngWriter::finish() {
+	if (finished) {
+		return true;
+	}
+	if (rows != height || !header_written) {
+		return false;
+	}
+	finished = true;
+
+	if (!deflater->Close() || !chunks->flushChunk()) {
+		return false;
+	}
+	return writeChunk(file, "IEND", nullptr, 0) && file.isOk();
+}
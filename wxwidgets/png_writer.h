@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_PNG_WRITER_H_
+#define RME_PNG_WRITER_H_
+
+#include "filehandle.h"
+
+#include <memory>
+#include <vector>
+
+class PngChunkStream;
+class wxZlibOutputStream;
+
+// Writes a PNG image one row at a time, so the whole image never has to be in memory.
+// Rows are deflated as they come in and flushed to the file in IDAT chunks of a fixed size.
+// Doesn't touch any GUI object, it is safe to use one writer per worker thread.
+class PngWriter {
+public:
+	enum ColorType {
+		PNG_PALETTE, // 1 byte per pixel, index into the palette
+		PNG_RGB, // 3 bytes per pixel
+		PNG_RGBA, // 4 bytes per pixel
+	};
+
+	PngWriter(const std::string& filename, int width, int height, ColorType type);
+	~PngWriter();
+
+	PngWriter(const PngWriter&) = delete;
+	PngWriter& operator=(const PngWriter&) = delete;
+
+	bool isOk();
+
+	// Palette images only, must be called before the first row.
+	// 'rgb' holds 3 bytes per entry, 'transparent_index' is fully transparent if not -1
+	void setPalette(const std::vector<uint8_t>& rgb, int transparent_index = -1);
+
+	// Adds the next row, top to bottom, 'pixels' is width * bytes per pixel long
+	bool addRow(const uint8_t* pixels);
+	// Writes the remaining data, fails if fewer rows than the height were added
+	bool finish();
+
+protected:
+	bool writeHeader();
+
+	FileWriteHandle file;
+	int width;
+	int height;
+	ColorType type;
+	int rows;
+	bool header_written;
+	bool finished;
+	std::vector<uint8_t> palette;
+	int transparent_index;
+
+	std::unique_ptr<PngChunkStream> chunks;
+	std::unique_ptr<wxZlibOutputStream> deflater;
+};
+
+#endif
@@ -155,6 +155,16 @@ wxNotebookPage* PreferencesWindow::CreateGeneralPage() {
 	grid_sizer->Add(replace_size_spin, 0);
 	SetWindowToolTip(tmptext, replace_size_spin, "How many items you can replace on the map using the Replace Item tool.");
 
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Fill tile limit: "), 0);
+	fill_max_tiles_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::FILL_MAX_TILES)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 0x10000000);
+	grid_sizer->Add(fill_max_tiles_spin, 0);
+	SetWindowToolTip(tmptext, fill_max_tiles_spin, "The most tiles a single fill may change, 0 for no limit.");
+
+	grid_sizer->Add(tmptext = newd wxStaticText(general_page, wxID_ANY, "Map memory limit (MB): "), 0);
+	paged_map_memory_spin = newd wxSpinCtrl(general_page, wxID_ANY, i2ws(g_settings.getInteger(Config::PAGED_MAP_MEMORY)), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 1048576);
+	grid_sizer->Add(paged_map_memory_spin, 0);
+	SetWindowToolTip(tmptext, paged_map_memory_spin, "How much memory the tiles of all open maps may use together. Parts of the map that weren't used for a while and have no unsaved changes are moved to a temporary file and read back when needed. 0 keeps every map in memory.");
+
 	sizer->Add(grid_sizer, 0, wxALL, 5);
 	sizer->AddSpacer(10);
 
@@ -933,6 +943,8 @@ void PreferencesWindow::Apply() {
 	g_settings.setInteger(Config::UNDO_MEM_SIZE, undo_mem_size_spin->GetValue());
 	g_settings.setInteger(Config::WORKER_THREADS, worker_threads_spin->GetValue());
 	g_settings.setInteger(Config::REPLACE_SIZE, replace_size_spin->GetValue());
+	g_settings.setInteger(Config::FILL_MAX_TILES, fill_max_tiles_spin->GetValue());
+	g_settings.setInteger(Config::PAGED_MAP_MEMORY, paged_map_memory_spin->GetValue());
 	g_settings.setInteger(Config::COPY_POSITION_FORMAT, position_format->GetSelection());
 	g_settings.setInteger(Config::AUTO_SAVE_ENABLED, autosave_chkbox->GetValue());
 	g_settings.setInteger(Config::AUTO_SAVE_INTERVAL, autosave_interval_spin->GetValue());
@@ -58,6 +58,8 @@ protected:
 	wxSpinCtrl* undo_mem_size_spin;
 	wxSpinCtrl* worker_threads_spin;
 	wxSpinCtrl* replace_size_spin;
+	wxSpinCtrl* fill_max_tiles_spin;
+	wxSpinCtrl* paged_map_memory_spin;
 	wxRadioBox* position_format;
 
 	// Editor
@@ -286,6 +286,8 @@ void Settings::IO(IOMode mode) {
 	Int(USE_OTGZ, 1);
 	Int(SAVE_WITH_OTB_MAGIC_NUMBER, 0);
 	Int(REPLACE_SIZE, 500);
+	Int(FILL_MAX_TILES, 0);
+	Int(PAGED_MAP_MEMORY, 0);
 	Int(COPY_POSITION_FORMAT, 0);
 
 	section("Graphics");
@@ -304,6 +306,7 @@ void Settings::IO(IOMode mode) {
 	Int(MINIMAP_UPDATE_DELAY, 333);
 	Int(MINIMAP_VIEW_BOX, 1);
 	String(MINIMAP_EXPORT_DIR, "");
+	Int(MINIMAP_EXPORT_FORMAT, 0);
 	String(TILESET_EXPORT_DIR, "");
 
 	Int(CURSOR_RED, 0);
@@ -93,6 +93,8 @@ namespace Config {
 		USE_OTGZ,
 		SAVE_WITH_OTB_MAGIC_NUMBER,
 		REPLACE_SIZE,
+		FILL_MAX_TILES,
+		PAGED_MAP_MEMORY,
 
 		USE_LARGE_CONTAINER_ICONS,
 		USE_LARGE_CHOOSE_ITEM_ICONS,
@@ -147,6 +149,7 @@ namespace Config {
 		MINIMAP_UPDATE_DELAY,
 		MINIMAP_VIEW_BOX,
 		MINIMAP_EXPORT_DIR,
+		MINIMAP_EXPORT_FORMAT,
 		TILESET_EXPORT_DIR,
 		WINDOW_HEIGHT,
 		WINDOW_WIDTH,
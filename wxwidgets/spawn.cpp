@@ -33,22 +33,149 @@ void Spawns::addSpawn(Tile* tile) {
 
 	auto it = spawns.insert(tile->getPosition());
 	ASSERT(it.second);
+	if (it.second) {
+		addArea(tile->getPosition(), tile->spawn->getSize());
+	}
 }
 
 void Spawns::removeSpawn(Tile* tile) {
 	ASSERT(tile->spawn);
-	spawns.erase(tile->getPosition());
-#if 0
-	SpawnPositionList::iterator iter = begin();
-	while(iter != end()) {
-		if(*iter == tile->getPosition()) {
-			spawns.erase(iter);
-			return;
+	if (spawns.erase(tile->getPosition()) > 0) {
+		removeArea(tile->getPosition());
+	}
+}
+
+void Spawns::addArea(const Position& center, int radius) {
+	const SpawnArea area = { center, radius };
+	const int start_cx = (center.x - radius) >> CELL_SHIFT;
+	const int start_cy = (center.y - radius) >> CELL_SHIFT;
+	const int end_cx = (center.x + radius) >> CELL_SHIFT;
+	const int end_cy = (center.y + radius) >> CELL_SHIFT;
+	for (int cy = start_cy; cy <= end_cy; ++cy) {
+		for (int cx = start_cx; cx <= end_cx; ++cx) {
+			cells[cellKey(cx, cy, center.z)].push_back(area);
+		}
+	}
+}
+
+void Spawns::removeArea(const Position& center) {
+	// The center always lies in its own area, so its cell knows the radius
+	const SpawnAreaVector* own_cell = getCell(center);
+	if (!own_cell) {
+		return;
+	}
+	int radius = -1;
+	for (const SpawnArea& area : *own_cell) {
+		if (area.center == center) {
+			radius = area.radius;
+			break;
+		}
+	}
+	if (radius < 0) {
+		return;
+	}
+
+	const int start_cx = (center.x - radius) >> CELL_SHIFT;
+	const int start_cy = (center.y - radius) >> CELL_SHIFT;
+	const int end_cx = (center.x + radius) >> CELL_SHIFT;
+	const int end_cy = (center.y + radius) >> CELL_SHIFT;
+	for (int cy = start_cy; cy <= end_cy; ++cy) {
+		for (int cx = start_cx; cx <= end_cx; ++cx) {
+			auto cell = cells.find(cellKey(cx, cy, center.z));
+			if (cell == cells.end()) {
+				continue;
+			}
+
+			SpawnAreaVector& areas = cell->second;
+			for (size_t i = 0; i < areas.size(); ++i) {
+				if (areas[i].center == center) {
+					areas[i] = areas.back();
+					areas.pop_back();
+					break;
+				}
+			}
+			if (areas.empty()) {
+				cells.erase(cell);
+			}
+		}
+	}
+}
+
+const Spawns::SpawnAreaVector* Spawns::getCell(const Position& pos) const {
+	auto cell = cells.find(cellKey(pos.x >> CELL_SHIFT, pos.y >> CELL_SHIFT, pos.z));
+	return cell != cells.end() ? &cell->second : nullptr;
+}
+
+size_t Spawns::getCoverage(const Position& pos) const {
+	const SpawnAreaVector* cell = getCell(pos);
+	if (!cell) {
+		return 0;
+	}
+
+	size_t count = 0;
+	for (const SpawnArea& area : *cell) {
+		if (area.contains(pos)) {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool Spawns::isCovered(const Position& pos) const {
+	const SpawnAreaVector* cell = getCell(pos);
+	if (!cell) {
+		return false;
+	}
+
+	for (const SpawnArea& area : *cell) {
+		if (area.contains(pos)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void Spawns::getSpawnsCovering(const Position& pos, PositionVector& result) const {
+	const SpawnAreaVector* cell = getCell(pos);
+	if (!cell) {
+		return;
+	}
+
+	for (const SpawnArea& area : *cell) {
+		if (area.contains(pos)) {
+			result.push_back(area.center);
+		}
+	}
+}
+
+void Spawns::getSpawnsInArea(int z, int start_x, int start_y, int end_x, int end_y, PositionVector& result) const {
+	// A spawn spanning several cells is listed in all of them, only report it from the
+	// first cell of the query it shares.
+	const int start_cx = start_x >> CELL_SHIFT;
+	const int start_cy = start_y >> CELL_SHIFT;
+	const int end_cx = end_x >> CELL_SHIFT;
+	const int end_cy = end_y >> CELL_SHIFT;
+	for (int cy = start_cy; cy <= end_cy; ++cy) {
+		for (int cx = start_cx; cx <= end_cx; ++cx) {
+			auto cell = cells.find(cellKey(cx, cy, z));
+			if (cell == cells.end()) {
+				continue;
+			}
+
+			for (const SpawnArea& area : cell->second) {
+				const int area_start_x = std::max(area.center.x - area.radius, start_x);
+				const int area_start_y = std::max(area.center.y - area.radius, start_y);
+				const int area_end_x = std::min(area.center.x + area.radius, end_x);
+				const int area_end_y = std::min(area.center.y + area.radius, end_y);
+				if (area_start_x > area_end_x || area_start_y > area_end_y) {
+					continue;
+				}
+				if ((area_start_x >> CELL_SHIFT) == cx && (area_start_y >> CELL_SHIFT) == cy) {
+					result.push_back(area.center);
+				}
+			}
 		}
-		++iter;
 	}
-	ASSERT(false);
-#endif
 }
 
 std::ostream& operator<<(std::ostream& os, const Spawn& spawn) {
@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_H_
 #define RME_SPAWN_H_
 
+#include <unordered_map>
+
 class Tile;
 
 class Spawn {
@@ -28,7 +30,7 @@ public:
 	}
 	~Spawn() { }
 
-	Spawn* deepCopy() {
+	Spawn* deepCopy() const {
 		Spawn* copy = newd Spawn(size);
 		copy->selected = selected;
 		return copy;
@@ -68,6 +70,9 @@ protected:
 typedef std::set<Position> SpawnPositionList;
 typedef std::list<Spawn*> SpawnList;
 
+// All spawns of a map, with a grid index over the areas they cover.
+// A spawn of radius r covers (2r+1)^2 tiles, instead of touching all of them it is filed
+// under the few grid cells its area overlaps, coverage of a tile is then counted on demand.
 class Spawns {
 public:
 	Spawns();
@@ -89,14 +94,46 @@ public:
 		return spawns.end();
 	}
 	void erase(SpawnPositionList::iterator iter) {
+		removeArea(*iter);
 		spawns.erase(iter);
 	}
 	SpawnPositionList::iterator find(Position& pos) {
 		return spawns.find(pos);
 	}
+	size_t size() const {
+		return spawns.size();
+	}
+
+	// Number of spawns whose area contains the position
+	size_t getCoverage(const Position& pos) const;
+	bool isCovered(const Position& pos) const;
+	// Centers of the spawns whose area contains the position
+	void getSpawnsCovering(const Position& pos, PositionVector& result) const;
+	// Centers of the spawns whose area overlaps the rectangle on floor z, corners included
+	void getSpawnsInArea(int z, int start_x, int start_y, int end_x, int end_y, PositionVector& result) const;
 
 private:
+	static const int CELL_SHIFT = 6; // 64x64 tiles per cell
+
+	struct SpawnArea {
+		Position center;
+		int radius;
+
+		bool contains(const Position& pos) const {
+			return pos.z == center.z && std::abs(pos.x - center.x) <= radius && std::abs(pos.y - center.y) <= radius;
+		}
+	};
+	typedef std::vector<SpawnArea> SpawnAreaVector;
+
+	static uint64_t cellKey(int cx, int cy, int z) {
+		return (uint64_t(z & 0xFF) << 48) | (uint64_t(uint32_t(cy) & 0xFFFFFF) << 24) | uint64_t(uint32_t(cx) & 0xFFFFFF);
+	}
+	const SpawnAreaVector* getCell(const Position& pos) const;
+	void addArea(const Position& center, int radius);
+	void removeArea(const Position& center);
+
 	SpawnPositionList spawns;
+	std::unordered_map<uint64_t, SpawnAreaVector> cells;
 };
 
 #endif
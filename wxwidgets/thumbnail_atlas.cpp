@@ -0,0 +1,338 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "thumbnail_atlas.h"
+#include "worker_pool.h"
+#include "graphics.h"
+#include "settings.h"
+#include "gui.h"
+
+ThumbnailAtlas g_thumbnails;
+
+namespace {
+	enum Kind {
+		KIND_ITEM,
+		KIND_CREATURE,
+	};
+
+	inline uint64_t makeKey(Kind kind, RenderSize size, uint32_t id, uint32_t colors) {
+		return (uint64_t(kind) << 62) | (uint64_t(size) << 60) | (uint64_t(id & 0x0FFFFFFF) << 32) | colors;
+	}
+}
+
+ThumbnailAtlas::ThumbnailAtlas() :
+	generation(0),
+	paint(1),
+	delivery_pending(false) {
+	////
+}
+
+ThumbnailAtlas::~ThumbnailAtlas() {
+	if (pool) {
+		pool->wait();
+	}
+}
+
+int ThumbnailAtlas::getPixelSize(RenderSize size) {
+	return size == RENDER_SIZE_16x16 ? 16 : size == RENDER_SIZE_32x32 ? 32 : 64;
+}
+
+RenderSize ThumbnailAtlas::sizeFor(int draw_size) {
+	if (draw_size <= 16) {
+		return RENDER_SIZE_16x16;
+	}
+	return draw_size <= 32 ? RENDER_SIZE_32x32 : RENDER_SIZE_64x64;
+}
+
+bool ThumbnailAtlas::drawItem(wxDC& dc, wxWindow* window, int sprite_id, int x, int y, int draw_size) {
+	if (sprite_id <= 0 || g_gui.gfx.isUnloaded()) {
+		return false;
+	}
+
+	const RenderSize size = sizeFor(draw_size);
+	const uint64_t key = makeKey(KIND_ITEM, size, sprite_id, 0);
+	if (entries.find(key) == entries.end()) {
+		Sprite* sprite = g_gui.gfx.getSprite(sprite_id);
+		GameSprite* game_sprite = dynamic_cast<GameSprite*>(sprite);
+		if (!game_sprite) {
+			// Editor sprites are small fixed bitmaps already
+			if (sprite) {
+				sprite->DrawTo(&dc, size == RENDER_SIZE_16x16 ? SPRITE_SIZE_16x16 : SPRITE_SIZE_32x32, x, y, draw_size, draw_size);
+			}
+			return sprite != nullptr;
+		}
+		queue(key, size, game_sprite, nullptr);
+	}
+	return draw(dc, window, key, x, y, draw_size);
+}
+
+bool ThumbnailAtlas::drawCreature(wxDC& dc, wxWindow* window, const Outfit& outfit, int x, int y, int draw_size) {
+	if (outfit.lookType <= 0 || g_gui.gfx.isUnloaded()) {
+		return false;
+	}
+
+	const RenderSize size = sizeFor(draw_size);
+	const uint64_t key = makeKey(KIND_CREATURE, size, outfit.lookType, outfit.getColorHash());
+	if (entries.find(key) == entries.end()) {
+		GameSprite* sprite = g_gui.gfx.getCreatureSprite(outfit.lookType);
+		if (!sprite) {
+			return false;
+		}
+		queue(key, size, sprite, &outfit);
+	}
+	return draw(dc, window, key, x, y, draw_size);
+}
+
+bool ThumbnailAtlas::draw(wxDC& dc, wxWindow* window, uint64_t key, int x, int y, int draw_size) {
+	Entry& entry = entries[key];
+	entry.drawn = paint;
+	if (entry.slot < 0) {
+		if (window) {
+			waiting.insert(window);
+		}
+		return false;
+	}
+
+	const RenderSize size = RenderSize((key >> 60) & 3);
+	Layer& layer = layers[size];
+	layer.lru.splice(layer.lru.begin(), layer.lru, entry.lru);
+
+	const int cell = getPixelSize(size);
+	const int per_row = PageSize / cell;
+	const int per_page = per_row * per_row;
+	Page& page = *layer.pages[entry.slot / per_page];
+	const int index = entry.slot % per_page;
+	const int source_x = (index % per_row) * cell;
+	const int source_y = (index / per_row) * cell;
+	if (draw_size == cell) {
+		dc.Blit(x, y, cell, cell, &page.dc, source_x, source_y);
+	} else {
+		dc.StretchBlit(x, y, draw_size, draw_size, &page.dc, source_x, source_y, cell, cell);
+	}
+	return true;
+}
+
+void ThumbnailAtlas::queue(uint64_t key, RenderSize size, GameSprite* sprite, const Outfit* outfit) {
+	auto job = std::make_shared<Job>();
+	job->key = key;
+	job->generation = generation;
+	job->size = size;
+	job->side = std::max<int>(std::max<int>(sprite->width, sprite->height), 1) * SPRITE_PIXELS;
+	job->background = uint8_t(g_settings.getInteger(Config::ICON_BACKGROUND));
+
+	// Reading sprite data may hit the sprite file, which only the main thread may do, so the
+	// images are fetched here and only composed and scaled by the workers
+	if (outfit) {
+		const int direction = sprite->pattern_x >= 3 ? 2 : 0;
+		for (int w = 0; w < sprite->width; ++w) {
+			for (int h = 0; h < sprite->height; ++h) {
+				const int index = sprite->getIndex(w, h, 0, direction, 0, 0, 0);
+				job->parts.push_back({ (sprite->width - w - 1) * SPRITE_PIXELS, (sprite->height - h - 1) * SPRITE_PIXELS, std::unique_ptr<uint8_t[]>(sprite->getOutfitImageRGBA(index, *outfit)) });
+			}
+		}
+	} else {
+		for (int l = 0; l < sprite->layers; ++l) {
+			for (int w = 0; w < sprite->width; ++w) {
+				for (int h = 0; h < sprite->height; ++h) {
+					const int index = sprite->getIndex(w, h, l, 0, 0, 0, 0);
+					job->parts.push_back({ (sprite->width - w - 1) * SPRITE_PIXELS, (sprite->height - h - 1) * SPRITE_PIXELS, std::unique_ptr<uint8_t[]>(sprite->getImageRGBA(index)) });
+				}
+			}
+		}
+	}
+
+	entries[key] = Entry();
+	if (!pool) {
+		pool.reset(newd WorkerPool(std::max(1, g_settings.getInteger(Config::WORKER_THREADS))));
+	}
+	pool->submit([this, job]() {
+		render(*job);
+
+		std::lock_guard<std::mutex> lock(finished_mutex);
+		finished.push_back(job);
+		if (!delivery_pending) {
+			delivery_pending = true;
+			CallAfter(&ThumbnailAtlas::deliver);
+		}
+	});
+}
+
+void ThumbnailAtlas::render(Job& job) {
+	const int side = job.side;
+	std::vector<uint8_t> canvas(size_t(side) * side * 3, job.background);
+	for (const Part& part : job.parts) {
+		if (!part.rgba) {
+			continue;
+		}
+		for (int y = 0; y < SPRITE_PIXELS; ++y) {
+			const uint8_t* source = part.rgba.get() + y * SPRITE_PIXELS * 4;
+			uint8_t* target = canvas.data() + (size_t(part.y + y) * side + part.x) * 3;
+			for (int x = 0; x < SPRITE_PIXELS; ++x, source += 4, target += 3) {
+				const int alpha = source[3];
+				for (int c = 0; c < 3; ++c) {
+					target[c] = uint8_t((source[c] * alpha + target[c] * (255 - alpha)) / 255);
+				}
+			}
+		}
+	}
+
+	// Box filter when shrinking, nearest pixel when growing
+	const int cell = getPixelSize(job.size);
+	job.pixels.resize(size_t(cell) * cell * 3);
+	for (int y = 0; y < cell; ++y) {
+		const int y0 = y * side / cell;
+		const int y1 = std::max(y0 + 1, (y + 1) * side / cell);
+		for (int x = 0; x < cell; ++x) {
+			const int x0 = x * side / cell;
+			const int x1 = std::max(x0 + 1, (x + 1) * side / cell);
+			int sum[3] = { 0, 0, 0 };
+			for (int sy = y0; sy < y1; ++sy) {
+				const uint8_t* source = canvas.data() + (size_t(sy) * side + x0) * 3;
+				for (int sx = x0; sx < x1; ++sx, source += 3) {
+					sum[0] += source[0];
+					sum[1] += source[1];
+					sum[2] += source[2];
+				}
+			}
+			const int count = (y1 - y0) * (x1 - x0);
+			uint8_t* target = job.pixels.data() + (size_t(y) * cell + x) * 3;
+			for (int c = 0; c < 3; ++c) {
+				target[c] = uint8_t(sum[c] / count);
+			}
+		}
+	}
+}
+
+int ThumbnailAtlas::allocateSlot(RenderSize size) {
+	Layer& layer = layers[size];
+	if (layer.free_slots.empty()) {
+		const int cell = getPixelSize(size);
+		const int per_page = (PageSize / cell) * (PageSize / cell);
+		// Past MaxPages only while the cell drawn longest ago is still on screen
+		if (int(layer.pages.size()) < MaxPages || entries.find(layer.lru.back())->second.drawn == paint) {
+			auto page = std::make_unique<Page>();
+			page->pixels.assign(size_t(PageSize) * PageSize * 3, 0);
+			page->dirty = true;
+			const int first = int(layer.pages.size()) * per_page;
+			for (int slot = first + per_page - 1; slot >= first; --slot) {
+				layer.free_slots.push_back(slot);
+			}
+			layer.pages.push_back(std::move(page));
+		} else {
+			// Every cell is taken, reuse the one drawn longest ago
+			auto it = entries.find(layer.lru.back());
+			layer.lru.pop_back();
+			const int slot = it->second.slot;
+			entries.erase(it);
+			return slot;
+		}
+	}
+
+	const int slot = layer.free_slots.back();
+	layer.free_slots.pop_back();
+	return slot;
+}
+
+void ThumbnailAtlas::deliver() {
+	std::vector<std::shared_ptr<Job>> jobs;
+	{
+		std::lock_guard<std::mutex> lock(finished_mutex);
+		jobs.swap(finished);
+		delivery_pending = false;
+	}
+
+	for (const std::shared_ptr<Job>& job : jobs) {
+		auto it = entries.find(job->key);
+		if (job->generation != generation || it == entries.end() || it->second.slot >= 0) {
+			continue;
+		}
+
+		const RenderSize size = job->size;
+		const int slot = allocateSlot(size);
+		Layer& layer = layers[size];
+		const int cell = getPixelSize(size);
+		const int per_row = PageSize / cell;
+		const int per_page = per_row * per_row;
+		Page& page = *layer.pages[slot / per_page];
+		const int index = slot % per_page;
+		const int page_x = (index % per_row) * cell;
+		const int page_y = (index / per_row) * cell;
+		for (int y = 0; y < cell; ++y) {
+			std::copy_n(job->pixels.data() + size_t(y) * cell * 3, cell * 3, page.pixels.data() + (size_t(page_y + y) * PageSize + page_x) * 3);
+		}
+		page.dirty = true;
+
+		layer.lru.push_front(job->key);
+		it->second.slot = slot;
+		it->second.lru = layer.lru.begin();
+	}
+
+	// The refreshed windows draw again, what they don't draw this time may be evicted
+	++paint;
+
+	for (Layer& layer : layers) {
+		for (auto& page : layer.pages) {
+			if (page->dirty) {
+				page->dc.SelectObject(wxNullBitmap);
+				wxImage image(PageSize, PageSize, page->pixels.data(), true);
+				page->bitmap = wxBitmap(image);
+				page->dc.SelectObject(page->bitmap);
+				page->dirty = false;
+			}
+		}
+	}
+
+	std::set<wxWindow*> windows;
+	windows.swap(waiting);
+	for (wxWindow* window : windows) {
+		window->Refresh();
+	}
+}
+
+void ThumbnailAtlas::removeWindow(wxWindow* window) {
+	waiting.erase(window);
+}
+
+void ThumbnailAtlas::clear() {
+	if (pool) {
+		pool->wait();
+	}
+	{
+		std::lock_guard<std::mutex> lock(finished_mutex);
+		finished.clear();
+	}
+
+	++generation;
+	entries.clear();
+	for (Layer& layer : layers) {
+		for (auto& page : layer.pages) {
+			page->dc.SelectObject(wxNullBitmap);
+		}
+		layer.pages.clear();
+		layer.free_slots.clear();
+		layer.lru.clear();
+	}
+
+	// Whoever waited for a thumbnail has to ask again
+	std::set<wxWindow*> windows;
+	windows.swap(waiting);
+	for (wxWindow* window : windows) {
+		window->Refresh();
+	}
+}
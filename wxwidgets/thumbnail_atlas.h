@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_THUMBNAIL_ATLAS_H_
+#define RME_THUMBNAIL_ATLAS_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "dcbutton.h"
+#include "outfit.h"
+
+class GameSprite;
+class WorkerPool;
+
+// Palette thumbnails of item sprites and creature outfits, shared by every palette view.
+// Thumbnails are packed into PageSize x PageSize pages, one set of pages per RenderSize. Once a
+// size fills MaxPages pages, the least recently drawn thumbnail gives up its cell, unless it was
+// drawn by the paint that is waiting for the new ones; then the size gets another page, so views
+// showing more thumbnails than MaxPages pages hold don't evict what they are drawing. A thumbnail
+// that isn't there yet is composed and scaled on worker threads, and the windows that asked for it
+// are refreshed once it has been copied into its page.
+class ThumbnailAtlas : public wxEvtHandler {
+public:
+	static const int PageSize = 512;
+	static const int MaxPages = 8;
+
+	ThumbnailAtlas();
+	~ThumbnailAtlas();
+
+	// Draws the thumbnail of sprite 'sprite_id', 'draw_size' pixels wide, with its top left corner
+	// at x, y. Returns false if it isn't rendered yet; 'window' is refreshed once it is.
+	bool drawItem(wxDC& dc, wxWindow* window, int sprite_id, int x, int y, int draw_size);
+	// Same for a creature in 'outfit', facing south
+	bool drawCreature(wxDC& dc, wxWindow* window, const Outfit& outfit, int x, int y, int draw_size);
+
+	// Windows that draw thumbnails must call this when they are destroyed
+	void removeWindow(wxWindow* window);
+	// Drops every thumbnail, for when the sprites or the icon background change
+	void clear();
+
+	static int getPixelSize(RenderSize size);
+
+protected:
+	// One SPRITE_PIXELS square of a sprite and where it goes on the thumbnail
+	struct Part {
+		int x, y;
+		std::unique_ptr<uint8_t[]> rgba;
+	};
+
+	struct Job {
+		uint64_t key;
+		uint32_t generation;
+		RenderSize size;
+		int side; // of the unscaled sprite, in pixels
+		uint8_t background;
+		std::vector<Part> parts;
+		std::vector<uint8_t> pixels; // RGB result
+	};
+
+	struct Page {
+		std::vector<uint8_t> pixels; // RGB
+		wxBitmap bitmap;
+		wxMemoryDC dc;
+		bool dirty = false;
+	};
+
+	struct Entry {
+		int slot = -1; // -1 while it is being rendered
+		uint32_t drawn = 0; // 'paint' when it was last drawn
+		std::list<uint64_t>::iterator lru;
+	};
+
+	// The pages of one RenderSize
+	struct Layer {
+		std::vector<std::unique_ptr<Page>> pages;
+		std::vector<int> free_slots;
+		std::list<uint64_t> lru; // most recently drawn first
+	};
+
+	bool draw(wxDC& dc, wxWindow* window, uint64_t key, int x, int y, int draw_size);
+	void queue(uint64_t key, RenderSize size, GameSprite* sprite, const Outfit* outfit);
+	static void render(Job& job);
+	void deliver();
+	int allocateSlot(RenderSize size);
+
+	static RenderSize sizeFor(int draw_size);
+
+	Layer layers[3];
+	std::unordered_map<uint64_t, Entry> entries;
+	std::set<wxWindow*> waiting;
+	uint32_t generation;
+	uint32_t paint; // Advanced by every delivery, what was drawn since is on screen
+
+	std::unique_ptr<WorkerPool> pool;
+	std::mutex finished_mutex;
+	std::vector<std::shared_ptr<Job>> finished;
+	bool delivery_pending;
+};
+
+extern ThumbnailAtlas g_thumbnails;
+
+#endif
@@ -168,9 +168,6 @@ int Tile::size() const {
 		if (location->getHouseExits()) {
 			++sz;
 		}
-		if (location->getSpawnCount()) {
-			++sz;
-		}
 		if (location->getWaypointCount()) {
 			++sz;
 		}
@@ -220,6 +217,34 @@ void Tile::merge(Tile* other) {
 	other->items.clear();
 }
 
+void Tile::mergeCopy(const Tile* other) {
+	if (other->isPZ()) {
+		setPZ(true);
+	}
+	if (other->house_id) {
+		house_id = other->house_id;
+	}
+
+	if (other->ground) {
+		delete ground;
+		ground = other->ground->deepCopy();
+	}
+
+	if (other->creature) {
+		delete creature;
+		creature = other->creature->deepCopy();
+	}
+
+	if (other->spawn) {
+		delete spawn;
+		spawn = other->spawn->deepCopy();
+	}
+
+	for (ItemVector::const_iterator it = other->items.begin(); it != other->items.end(); ++it) {
+		addItem((*it)->deepCopy());
+	}
+}
+
 bool Tile::hasProperty(enum ITEMPROPERTY prop) const {
 	if (prop == PROTECTIONZONE && isPZ()) {
 		return true;
@@ -98,6 +98,8 @@ public:
 public: // Functions
 	// Absorb the other tile into this tile
 	void merge(Tile* other);
+	// Same as merge, but copies the contents of the other tile instead of taking them
+	void mergeCopy(const Tile* other);
 
 	// Has tile been modified since the map was loaded/created?
 	bool isModified() const {
@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t threads) :
+	busy(0),
+	stopping(false) {
+	if (threads == 0) {
+		threads = defaultThreadCount();
+	}
+
+	workers.reserve(threads);
+	for (size_t i = 0; i < threads; ++i) {
+		workers.emplace_back(&WorkerPool::workerLoop, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	task_cond.notify_all();
+
+	for (std::thread& worker : workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+size_t WorkerPool::defaultThreadCount() {
+	unsigned int count = std::thread::hardware_concurrency();
+	return count == 0 ? 2 : count;
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	task_cond.notify_one();
+}
+
+void WorkerPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle_cond.wait(lock, [this]() { return tasks.empty() && busy == 0; });
+}
+
+bool WorkerPool::waitFor(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(mutex);
+	return idle_cond.wait_for(lock, timeout, [this]() { return tasks.empty() && busy == 0; });
+}
+
+void WorkerPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			task_cond.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (tasks.empty()) {
+				// Only reached when stopping
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+			++busy;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--busy;
+			if (tasks.empty() && busy == 0) {
+				idle_cond.notify_all();
+			}
+		}
+	}
+}
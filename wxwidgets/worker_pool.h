@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_WORKER_POOL_H_
+#define RME_WORKER_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads consuming a FIFO of tasks.
+// Tasks must not touch wx GUI objects, only the main thread may do that.
+class WorkerPool {
+public:
+	// 0 threads means one per hardware thread
+	explicit WorkerPool(size_t threads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void submit(std::function<void()> task);
+	// Blocks until every submitted task has finished
+	void wait();
+	// Same as wait, but gives up after 'timeout', returns true if the pool is idle
+	bool waitFor(std::chrono::milliseconds timeout);
+
+	size_t size() const {
+		return workers.size();
+	}
+
+	// Runs fn(index) for index in [0, count) spread across the pool and waits for it
+	template <typename F>
+	void parallelFor(size_t count, F&& fn);
+
+	static size_t defaultThreadCount();
+
+protected:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable task_cond;
+	std::condition_variable idle_cond;
+	size_t busy;
+	bool stopping;
+};
+
+template <typename F>
+void WorkerPool::parallelFor(size_t count, F&& fn) {
+	if (count == 0) {
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	size_t jobs = std::min(count, size());
+	for (size_t job = 0; job < jobs; ++job) {
+		submit([&next, &fn, count]() {
+			for (size_t index = next++; index < count; index = next++) {
+				fn(index);
+			}
+		});
+	}
+	wait();
+}
+
+#endif